@@ -249,6 +249,28 @@ static TranslationBlock *tb_htable_lookup(CPUState *cpu, vaddr pc,
     return qht_lookup_custom(&tb_ctx.htable, &desc, h, tb_lookup_cmp);
 }
 
+/*
+ * @tb got hot and was retranslated as a trace, but the jump cache no
+ * longer holds the trace.  Find it again in the hash table, or count
+ * the entries into @tb again if it is gone.
+ */
+static TranslationBlock *tb_lookup_trace(CPUState *cpu, TranslationBlock *tb,
+                                         vaddr pc, uint32_t cflags)
+{
+    TranslationBlock *trace;
+    uint32_t threshold;
+
+    trace = tb_htable_lookup(cpu, pc, tb->cs_base, tb->flags,
+                             cflags | CF_TRACE);
+    if (trace) {
+        return trace;
+    }
+
+    threshold = qatomic_read(&tb_trace_threshold);
+    qatomic_set(&tb->trace_countdown, threshold ? threshold : -1);
+    return tb;
+}
+
 /* Might cause an exception, so have a longjmp destination ready */
 static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
                                           uint64_t cs_base, uint32_t flags,
@@ -264,12 +286,13 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
     hash = tb_jmp_cache_hash_func(pc);
     jc = cpu->tb_jmp_cache;
 
+    /* A trace is found here under the cflags of the TB it replaces */
     tb = qatomic_read(&jc->array[hash].tb);
     if (likely(tb &&
                jc->array[hash].pc == pc &&
                tb->cs_base == cs_base &&
                tb->flags == flags &&
-               tb_cflags(tb) == cflags)) {
+               (tb_cflags(tb) & ~CF_TRACE) == cflags)) {
         goto hit;
     }
 
@@ -277,6 +300,9 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
     if (tb == NULL) {
         return NULL;
     }
+    if (unlikely(qatomic_read(&tb->trace_countdown) == 0)) {
+        tb = tb_lookup_trace(cpu, tb, pc, cflags);
+    }
 
     jc->array[hash].pc = pc;
     qatomic_set(&jc->array[hash].tb, tb);
@@ -916,7 +942,7 @@ static inline bool cpu_handle_interrupt(CPUState *cpu,
 
 static inline void cpu_loop_exec_tb(CPUState *cpu, TranslationBlock *tb,
                                     vaddr pc, TranslationBlock **last_tb,
-                                    int *tb_exit)
+                                    TranslationBlock **hot_tb, int *tb_exit)
 {
     trace_exec_tb(tb, pc);
     tb = cpu_tb_exec(cpu, tb, tb_exit);
@@ -926,6 +952,12 @@ static inline void cpu_loop_exec_tb(CPUState *cpu, TranslationBlock *tb,
     }
 
     *last_tb = NULL;
+    if (cpu->neg.trace_exit) {
+        /* The TB became hot; the main loop will retranslate it. */
+        cpu->neg.trace_exit = false;
+        *hot_tb = tb;
+        return;
+    }
     if (cpu_loop_exit_requested(cpu)) {
         /* Something asked us to stop executing chained TBs; just
          * continue round the main loop. Whatever requested the exit
@@ -960,6 +992,36 @@ static inline void cpu_loop_exec_tb(CPUState *cpu, TranslationBlock *tb,
 #endif
 }
 
+/*
+ * Retranslate the hot @tb as a trace and make it the TB that this vCPU
+ * finds for @pc.  The trace is linked like any TB, so that writes to
+ * its code invalidate it, but lookups with the usual cflags never match
+ * it; once the jump cache forgets it, tb_lookup() looks for it with
+ * CF_TRACE because the countdown of @tb stays at zero.
+ */
+static TranslationBlock *tb_gen_trace(CPUState *cpu, TranslationBlock *tb,
+                                      vaddr pc, uint32_t cflags)
+{
+    CPUJumpCache *jc = cpu->tb_jmp_cache;
+    uint32_t h = tb_jmp_cache_hash_func(pc);
+    TranslationBlock *trace;
+
+    /* Only once, even if translation exits */
+    qatomic_set(&tb->trace_countdown, 0);
+
+    mmap_lock();
+    trace = tb_gen_code(cpu, pc, tb->cs_base, tb->flags, cflags | CF_TRACE);
+    mmap_unlock();
+
+    jc->array[h].pc = pc;
+    qatomic_set(&jc->array[h].tb, trace);
+
+    /* Make the TBs chained to @tb find the trace instead */
+    tb_jmp_unlink_incoming(tb);
+    qatomic_inc(&tb_ctx.tb_trace_count);
+    return trace;
+}
+
 /* main execution loop */
 
 static int __attribute__((noinline))
@@ -970,6 +1032,7 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
     /* if an exception is pending, we execute it here */
     while (!cpu_handle_exception(cpu, &ret)) {
         TranslationBlock *last_tb = NULL;
+        TranslationBlock *hot_tb = NULL;
         int tb_exit = 0;
 
         while (!cpu_handle_interrupt(cpu, &last_tb)) {
@@ -998,6 +1061,12 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                 break;
             }
 
+#ifndef CONFIG_USER_ONLY
+            if (unlikely(qatomic_read(&tcg_profile_active))) {
+                tcg_profile_cpu_exec(cpu);
+            }
+#endif
+
             tb = tb_lookup(cpu, pc, cs_base, flags, cflags);
             if (tb == NULL) {
                 CPUJumpCache *jc;
@@ -1015,7 +1084,10 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                 jc = cpu->tb_jmp_cache;
                 jc->array[h].pc = pc;
                 qatomic_set(&jc->array[h].tb, tb);
+            } else if (unlikely(tb == hot_tb)) {
+                tb = tb_gen_trace(cpu, tb, pc, cflags);
             }
+            hot_tb = NULL;
 
 #ifndef CONFIG_USER_ONLY
             /*
@@ -1033,7 +1105,7 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                 tb_add_jump(last_tb, tb_exit, tb);
             }
 
-            cpu_loop_exec_tb(cpu, tb, pc, &last_tb, &tb_exit);
+            cpu_loop_exec_tb(cpu, tb, pc, &last_tb, &hot_tb, &tb_exit);
 
             /* Try to align the host and virtual clocks
                if the guest is in advance */
@@ -1053,6 +1125,129 @@ static int cpu_exec_setjmp(CPUState *cpu, SyncClocks *sc)
     return cpu_exec_loop(cpu, sc);
 }
 
+#ifndef CONFIG_USER_ONLY
+/*
+ * Successors of the TBs that a vCPU translated recently.  They are
+ * translated ahead of time while the vCPU is halted, so that it does not
+ * stall on them once it runs again.  With MTTCG each vCPU has its own
+ * thread and thus its own queue; otherwise the queue follows whichever
+ * vCPU translated last.
+ */
+#define TB_SPEC_QUEUE_SIZE 16
+
+/* Bytes of code probed for a first insn that crosses a page boundary */
+#define TB_SPEC_INSN_MAX 16
+
+typedef struct TBSpecEntry {
+    vaddr pc;
+    uint64_t cs_base;
+    uint32_t flags;
+    uint32_t cflags;
+} TBSpecEntry;
+
+typedef struct TBSpecQueue {
+    CPUState *cpu;
+    unsigned int head;
+    unsigned int len;
+    TBSpecEntry entry[TB_SPEC_QUEUE_SIZE];
+} TBSpecQueue;
+
+static __thread TBSpecQueue tb_spec_queue;
+
+void tb_speculate_note(const TranslationBlock *tb, vaddr dest)
+{
+    TBSpecQueue *q = &tb_spec_queue;
+    uint32_t cflags = tb_cflags(tb) & ~CF_TRACE;
+
+    if (!qatomic_read(&tb_speculate_enabled) ||
+        (cflags & (CF_COUNT_MASK | CF_NOIRQ | CF_SINGLE_STEP))) {
+        return;
+    }
+
+    if (q->cpu != current_cpu) {
+        q->cpu = current_cpu;
+        q->len = 0;
+    }
+    if (q->len == TB_SPEC_QUEUE_SIZE) {
+        /* Drop the oldest entry */
+        q->head = (q->head + 1) % TB_SPEC_QUEUE_SIZE;
+        q->len--;
+    }
+    q->entry[(q->head + q->len) % TB_SPEC_QUEUE_SIZE] = (TBSpecEntry) {
+        .pc = dest,
+        .cs_base = tb->cs_base,
+        .flags = tb->flags,
+        .cflags = cflags,
+    };
+    q->len++;
+}
+
+/* Translation must not raise guest exceptions; check the code is there */
+static bool tb_speculate_probe(CPUState *cpu, vaddr pc, int mmu_idx)
+{
+    CPUTLBEntryFull *full;
+    void *host;
+    int flags;
+
+    flags = probe_access_full(cpu_env(cpu), pc, 1, MMU_INST_FETCH, mmu_idx,
+                              true, &host, &full, 0);
+    return !(flags & (TLB_INVALID_MASK | TLB_MMIO));
+}
+
+static void tb_speculate_run(CPUState *cpu)
+{
+    TBSpecQueue *q = &tb_spec_queue;
+    int budget = TB_SPEC_QUEUE_SIZE;
+    uint64_t cs_base;
+    uint32_t flags;
+    int mmu_idx;
+    vaddr pc;
+
+    if (q->cpu != cpu || !q->len) {
+        return;
+    }
+
+    RCU_READ_LOCK_GUARD();
+
+    if (sigsetjmp(cpu->jmp_env, 0) != 0) {
+        /* A fault we failed to foresee, or a full code buffer */
+        cpu_exec_longjmp_cleanup(cpu);
+        cpu->exception_index = -1;
+        q->len = 0;
+        return;
+    }
+
+    /*
+     * Code is fetched with the MMU index of the current CPU state, so
+     * only translate successors that were noted in that same state.
+     */
+    cpu_get_tb_cpu_state(cpu_env(cpu), &pc, &cs_base, &flags);
+    mmu_idx = cpu_mmu_index(cpu, true);
+    while (q->len && budget--) {
+        TBSpecEntry e = q->entry[q->head];
+        vaddr last = e.pc + TB_SPEC_INSN_MAX - 1;
+
+        q->head = (q->head + 1) % TB_SPEC_QUEUE_SIZE;
+        q->len--;
+
+        if (e.cs_base != cs_base || e.flags != flags ||
+            !tb_speculate_probe(cpu, e.pc, mmu_idx) ||
+            (((e.pc ^ last) & TARGET_PAGE_MASK) &&
+             !tb_speculate_probe(cpu, last, mmu_idx))) {
+            continue;
+        }
+        if (tb_htable_lookup(cpu, e.pc, e.cs_base, e.flags, e.cflags)) {
+            continue;
+        }
+
+        mmap_lock();
+        tb_gen_code(cpu, e.pc, e.cs_base, e.flags, e.cflags);
+        mmap_unlock();
+        qatomic_inc(&tb_ctx.tb_spec_count);
+    }
+}
+#endif /* !CONFIG_USER_ONLY */
+
 int cpu_exec(CPUState *cpu)
 {
     int ret;
@@ -1062,6 +1257,10 @@ int cpu_exec(CPUState *cpu)
     current_cpu = cpu;
 
     if (cpu_handle_halt(cpu)) {
+#ifndef CONFIG_USER_ONLY
+        /* Use the idle time to translate code the vCPU may need next */
+        tb_speculate_run(cpu);
+#endif
         return EXCP_HALTED;
     }
 
@@ -1078,6 +1277,13 @@ int cpu_exec(CPUState *cpu)
 
     ret = cpu_exec_setjmp(cpu, &sc);
 
+#ifndef CONFIG_USER_ONLY
+    /* Resolve the samples while their TBs are sure to exist */
+    if (unlikely(qatomic_read(&tcg_profile_active))) {
+        tcg_profile_cpu_exec(cpu);
+    }
+#endif
+
     cpu_exec_exit(cpu);
     return ret;
 }
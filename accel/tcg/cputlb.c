@@ -285,14 +285,14 @@ static void tlb_mmu_resize_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast,
     }
 }
 
-static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast)
+static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast,
+                                 size_t vsize)
 {
     desc->n_used_entries = 0;
-    desc->large_page_addr = -1;
-    desc->large_page_mask = -1;
+    desc->n_large_pages = 0;
     desc->vindex = 0;
     memset(fast->table, -1, sizeof_tlb(fast));
-    memset(desc->vtable, -1, sizeof(desc->vtable));
+    memset(desc->vtable, -1, vsize * sizeof(CPUTLBEntry));
 }
 
 static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
@@ -302,10 +302,11 @@ static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
     CPUTLBDescFast *fast = &cpu->neg.tlb.f[mmu_idx];
 
     tlb_mmu_resize_locked(desc, fast, now);
-    tlb_mmu_flush_locked(desc, fast);
+    tlb_mmu_flush_locked(desc, fast, cpu->neg.tlb.c.vsize);
 }
 
-static void tlb_mmu_init(CPUTLBDesc *desc, CPUTLBDescFast *fast, int64_t now)
+static void tlb_mmu_init(CPUTLBDesc *desc, CPUTLBDescFast *fast,
+                         size_t vsize, int64_t now)
 {
     size_t n_entries = 1 << CPU_TLB_DYN_DEFAULT_BITS;
 
@@ -314,7 +315,9 @@ static void tlb_mmu_init(CPUTLBDesc *desc, CPUTLBDescFast *fast, int64_t now)
     fast->mask = (n_entries - 1) << CPU_TLB_ENTRY_BITS;
     fast->table = g_new(CPUTLBEntry, n_entries);
     desc->fulltlb = g_new(CPUTLBEntryFull, n_entries);
-    tlb_mmu_flush_locked(desc, fast);
+    desc->vtable = g_new(CPUTLBEntry, vsize);
+    desc->vfulltlb = g_new(CPUTLBEntryFull, vsize);
+    tlb_mmu_flush_locked(desc, fast, vsize);
 }
 
 static inline void tlb_n_used_entries_inc(CPUState *cpu, uintptr_t mmu_idx)
@@ -336,9 +339,11 @@ void tlb_init(CPUState *cpu)
 
     /* All tlbs are initialized flushed. */
     cpu->neg.tlb.c.dirty = 0;
+    cpu->neg.tlb.c.vsize = tlb_victim_size;
 
     for (i = 0; i < NB_MMU_MODES; i++) {
-        tlb_mmu_init(&cpu->neg.tlb.d[i], &cpu->neg.tlb.f[i], now);
+        tlb_mmu_init(&cpu->neg.tlb.d[i], &cpu->neg.tlb.f[i],
+                     cpu->neg.tlb.c.vsize, now);
     }
 }
 
@@ -353,6 +358,8 @@ void tlb_destroy(CPUState *cpu)
 
         g_free(fast->table);
         g_free(desc->fulltlb);
+        g_free(desc->vtable);
+        g_free(desc->vfulltlb);
     }
 }
 
@@ -486,16 +493,38 @@ static inline bool tlb_flush_entry_locked(CPUTLBEntry *tlb_entry, vaddr page)
     return tlb_flush_entry_mask_locked(tlb_entry, page, -1);
 }
 
+/*
+ * Return the index of the first way of the victim tlb set for @page.
+ * There are never more sets than entries in the smallest tlb, so all
+ * the pages that share an entry of the tlb also share a victim set.
+ */
+static inline size_t vtlb_set(CPUState *cpu, vaddr page)
+{
+    size_t n_sets = cpu->neg.tlb.c.vsize / CPU_VTLB_WAYS;
+
+    QEMU_BUILD_BUG_ON(CPU_VTLB_MAX_SIZE / CPU_VTLB_WAYS >
+                      1 << CPU_TLB_DYN_MIN_BITS);
+
+    return ((page >> TARGET_PAGE_BITS) & (n_sets - 1)) * CPU_VTLB_WAYS;
+}
+
 /* Called with tlb_c.lock held */
 static void tlb_flush_vtlb_page_mask_locked(CPUState *cpu, int mmu_idx,
                                             vaddr page,
                                             vaddr mask)
 {
     CPUTLBDesc *d = &cpu->neg.tlb.d[mmu_idx];
-    int k;
+    size_t n_sets = cpu->neg.tlb.c.vsize / CPU_VTLB_WAYS;
+    size_t k = 0, end = cpu->neg.tlb.c.vsize;
 
     assert_cpu_is_self(cpu);
-    for (k = 0; k < CPU_VTLB_SIZE; k++) {
+
+    /* If @mask keeps all of the set index, only one set can match.  */
+    if (((mask >> TARGET_PAGE_BITS) & (n_sets - 1)) == n_sets - 1) {
+        k = vtlb_set(cpu, page);
+        end = k + CPU_VTLB_WAYS;
+    }
+    for (; k < end; k++) {
         if (tlb_flush_entry_mask_locked(&d->vtable[k], page, mask)) {
             tlb_n_used_entries_dec(cpu, mmu_idx);
         }
@@ -508,23 +537,73 @@ static inline void tlb_flush_vtlb_page_locked(CPUState *cpu, int mmu_idx,
     tlb_flush_vtlb_page_mask_locked(cpu, mmu_idx, page, -1);
 }
 
-static void tlb_flush_page_locked(CPUState *cpu, int midx, vaddr page)
+/**
+ * tlb_flush_large_page_locked:
+ * @cpu: cpu on which to flush
+ * @midx: mmu_idx to flush
+ * @i: index of the large page region within the CPUTLBDesc
+ *
+ * Flush every entry of @midx within large page region @i, and forget
+ * the region.  Called with tlb_c.lock held.
+ */
+static void tlb_flush_large_page_locked(CPUState *cpu, int midx, unsigned i)
 {
-    vaddr lp_addr = cpu->neg.tlb.d[midx].large_page_addr;
-    vaddr lp_mask = cpu->neg.tlb.d[midx].large_page_mask;
+    CPUTLBDesc *d = &cpu->neg.tlb.d[midx];
+    CPUTLBDescFast *f = &cpu->neg.tlb.f[midx];
+    vaddr lp_addr = d->large_page[i].addr;
+    vaddr lp_mask = d->large_page[i].mask;
+    vaddr lp_pages = -lp_mask >> TARGET_PAGE_BITS;
+    size_t n = tlb_n_entries(f);
 
-    /* Check if we need to flush due to large pages.  */
-    if ((page & lp_mask) == lp_addr) {
-        tlb_debug("forcing full flush midx %d (%016"
-                  VADDR_PRIx "/%016" VADDR_PRIx ")\n",
-                  midx, lp_addr, lp_mask);
-        tlb_flush_one_mmuidx_locked(cpu, midx, get_clock_realtime());
+    tlb_debug("flushing large pages midx %d (%016"
+              VADDR_PRIx "/%016" VADDR_PRIx ")\n",
+              midx, lp_addr, lp_mask);
+
+    /*
+     * Only visit the entries that the pages of the region map to,
+     * unless there are more pages than entries.
+     */
+    if (lp_mask != 0 && lp_pages < n) {
+        for (vaddr j = 0; j < lp_pages; j++) {
+            vaddr page = lp_addr + (j << TARGET_PAGE_BITS);
+
+            if (tlb_flush_entry_mask_locked(tlb_entry(cpu, midx, page),
+                                            lp_addr, lp_mask)) {
+                tlb_n_used_entries_dec(cpu, midx);
+            }
+        }
     } else {
-        if (tlb_flush_entry_locked(tlb_entry(cpu, midx, page), page)) {
-            tlb_n_used_entries_dec(cpu, midx);
+        for (size_t j = 0; j < n; j++) {
+            if (tlb_flush_entry_mask_locked(&f->table[j], lp_addr, lp_mask)) {
+                tlb_n_used_entries_dec(cpu, midx);
+            }
         }
-        tlb_flush_vtlb_page_locked(cpu, midx, page);
     }
+    tlb_flush_vtlb_page_mask_locked(cpu, midx, lp_addr, lp_mask);
+
+    d->large_page[i] = d->large_page[--d->n_large_pages];
+    qatomic_set(&cpu->neg.tlb.c.large_flush_count,
+                cpu->neg.tlb.c.large_flush_count + 1);
+}
+
+static void tlb_flush_page_locked(CPUState *cpu, int midx, vaddr page)
+{
+    CPUTLBDesc *d = &cpu->neg.tlb.d[midx];
+    unsigned i = 0;
+
+    /* Flush the entries of the large pages that contain the page.  */
+    while (i < d->n_large_pages) {
+        if ((page & d->large_page[i].mask) == d->large_page[i].addr) {
+            tlb_flush_large_page_locked(cpu, midx, i);
+        } else {
+            i++;
+        }
+    }
+
+    if (tlb_flush_entry_locked(tlb_entry(cpu, midx, page), page)) {
+        tlb_n_used_entries_dec(cpu, midx);
+    }
+    tlb_flush_vtlb_page_locked(cpu, midx, page);
 }
 
 /**
@@ -676,6 +755,7 @@ static void tlb_flush_range_locked(CPUState *cpu, int midx,
     CPUTLBDesc *d = &cpu->neg.tlb.d[midx];
     CPUTLBDescFast *f = &cpu->neg.tlb.f[midx];
     vaddr mask = MAKE_64BIT_MASK(0, bits);
+    unsigned i = 0;
 
     /*
      * If @bits is smaller than the tlb size, there may be multiple entries
@@ -695,17 +775,16 @@ static void tlb_flush_range_locked(CPUState *cpu, int midx,
         return;
     }
 
-    /*
-     * Check if we need to flush due to large pages.
-     * Because large_page_mask contains all 1's from the msb,
-     * we only need to test the end of the range.
-     */
-    if (((addr + len - 1) & d->large_page_mask) == d->large_page_addr) {
-        tlb_debug("forcing full flush midx %d ("
-                  "%016" VADDR_PRIx "/%016" VADDR_PRIx ")\n",
-                  midx, d->large_page_addr, d->large_page_mask);
-        tlb_flush_one_mmuidx_locked(cpu, midx, get_clock_realtime());
-        return;
+    /* Flush the entries of the large pages that overlap the range.  */
+    while (i < d->n_large_pages) {
+        vaddr lp_addr = d->large_page[i].addr;
+        vaddr lp_last = lp_addr | ~d->large_page[i].mask;
+
+        if (lp_addr <= addr + len - 1 && addr <= lp_last) {
+            tlb_flush_large_page_locked(cpu, midx, i);
+        } else {
+            i++;
+        }
     }
 
     for (vaddr i = 0; i < len; i += TARGET_PAGE_SIZE) {
@@ -946,7 +1025,7 @@ void tlb_reset_dirty(CPUState *cpu, ram_addr_t start1, ram_addr_t length)
                                          start1, length);
         }
 
-        for (i = 0; i < CPU_VTLB_SIZE; i++) {
+        for (i = 0; i < cpu->neg.tlb.c.vsize; i++) {
             tlb_reset_dirty_range_locked(&cpu->neg.tlb.d[mmu_idx].vtable[i],
                                          start1, length);
         }
@@ -978,36 +1057,56 @@ static void tlb_set_dirty(CPUState *cpu, vaddr addr)
     }
 
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        size_t set = vtlb_set(cpu, addr);
         int k;
-        for (k = 0; k < CPU_VTLB_SIZE; k++) {
-            tlb_set_dirty1_locked(&cpu->neg.tlb.d[mmu_idx].vtable[k], addr);
+        for (k = 0; k < CPU_VTLB_WAYS; k++) {
+            tlb_set_dirty1_locked(&cpu->neg.tlb.d[mmu_idx].vtable[set + k],
+                                  addr);
         }
     }
     qemu_spin_unlock(&cpu->neg.tlb.c.lock);
 }
 
-/* Our TLB does not support large pages, so remember the area covered by
-   large pages and trigger a full TLB flush if these are invalidated.  */
+/* Our TLB does not support large pages, so remember the areas covered by
+   large pages and flush all of their entries if these are invalidated.  */
 static void tlb_add_large_page(CPUState *cpu, int mmu_idx,
                                vaddr addr, uint64_t size)
 {
-    vaddr lp_addr = cpu->neg.tlb.d[mmu_idx].large_page_addr;
+    CPUTLBDesc *d = &cpu->neg.tlb.d[mmu_idx];
     vaddr lp_mask = ~(size - 1);
+    vaddr best_mask = 0;
+    unsigned i, best = 0;
+
+    for (i = 0; i < d->n_large_pages; i++) {
+        if ((addr & d->large_page[i].mask) == d->large_page[i].addr &&
+            d->large_page[i].mask <= lp_mask) {
+            /* Already covered.  */
+            return;
+        }
+    }
+    if (d->n_large_pages < CPU_TLB_LARGE_PAGES) {
+        i = d->n_large_pages++;
+        d->large_page[i].addr = addr & lp_mask;
+        d->large_page[i].mask = lp_mask;
+        return;
+    }
 
-    if (lp_addr == (vaddr)-1) {
-        /* No previous large page.  */
-        lp_addr = addr;
-    } else {
-        /* Extend the existing region to include the new page.
-           This is a compromise between unnecessary flushes and
-           the cost of maintaining a full variable size TLB.  */
-        lp_mask &= cpu->neg.tlb.d[mmu_idx].large_page_mask;
-        while (((lp_addr ^ addr) & lp_mask) != 0) {
-            lp_mask <<= 1;
+    /* Extend the region that grows the least to include the new page.
+       This is a compromise between unnecessary flushes and
+       the cost of maintaining a full variable size TLB.  */
+    for (i = 0; i < CPU_TLB_LARGE_PAGES; i++) {
+        vaddr mask = lp_mask & d->large_page[i].mask;
+
+        while (((d->large_page[i].addr ^ addr) & mask) != 0) {
+            mask <<= 1;
+        }
+        if (mask > best_mask) {
+            best = i;
+            best_mask = mask;
         }
     }
-    cpu->neg.tlb.d[mmu_idx].large_page_addr = lp_addr & lp_mask;
-    cpu->neg.tlb.d[mmu_idx].large_page_mask = lp_mask;
+    d->large_page[best].addr &= best_mask;
+    d->large_page[best].mask = best_mask;
 }
 
 static inline void tlb_set_compare(CPUTLBEntryFull *full, CPUTLBEntry *ent,
@@ -1143,8 +1242,18 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
      * different page; otherwise just overwrite the stale data.
      */
     if (!tlb_hit_page_anyprot(te, addr_page) && !tlb_entry_is_empty(te)) {
-        unsigned vidx = desc->vindex++ % CPU_VTLB_SIZE;
-        CPUTLBEntry *tv = &desc->vtable[vidx];
+        size_t set = vtlb_set(cpu, addr_page);
+        size_t vidx = set + desc->vindex++ % CPU_VTLB_WAYS;
+        CPUTLBEntry *tv;
+
+        /* Prefer a free way of the set to replacing a valid entry.  */
+        for (size_t k = set; k < set + CPU_VTLB_WAYS; k++) {
+            if (tlb_entry_is_empty(&desc->vtable[k])) {
+                vidx = k;
+                break;
+            }
+        }
+        tv = &desc->vtable[vidx];
 
         /* Evict the old entry into the victim tlb.  */
         copy_tlb_helper_locked(tv, te);
@@ -1298,10 +1407,11 @@ static void io_failed(CPUState *cpu, CPUTLBEntryFull *full, vaddr addr,
 static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
                            MMUAccessType access_type, vaddr page)
 {
+    size_t set = vtlb_set(cpu, page);
     size_t vidx;
 
     assert_cpu_is_self(cpu);
-    for (vidx = 0; vidx < CPU_VTLB_SIZE; ++vidx) {
+    for (vidx = set; vidx < set + CPU_VTLB_WAYS; ++vidx) {
         CPUTLBEntry *vtlb = &cpu->neg.tlb.d[mmu_idx].vtable[vidx];
         uint64_t cmp = tlb_read_idx(vtlb, access_type);
 
@@ -1319,9 +1429,12 @@ static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
             CPUTLBEntryFull *f2 = &cpu->neg.tlb.d[mmu_idx].vfulltlb[vidx];
             CPUTLBEntryFull tmpf;
             tmpf = *f1; *f1 = *f2; *f2 = tmpf;
+            qatomic_set(&cpu->neg.tlb.c.victim_hit_count,
+                        cpu->neg.tlb.c.victim_hit_count + 1);
             return true;
         }
     }
+    qatomic_set(&cpu->neg.tlb.c.miss_count, cpu->neg.tlb.c.miss_count + 1);
     return false;
 }
 
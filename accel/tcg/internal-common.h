@@ -16,6 +16,9 @@ extern int64_t max_delay;
 extern int64_t max_advance;
 
 extern bool one_insn_per_tb;
+extern uint32_t tb_trace_threshold;
+extern bool tb_speculate_enabled;
+extern size_t tlb_victim_size;
 
 /*
  * Return true if CS is not running in parallel with other cpus, either
@@ -50,12 +53,23 @@ void page_init(void);
 void tb_htable_init(void);
 void tb_reset_jump(TranslationBlock *tb, int n);
 TranslationBlock *tb_link_page(TranslationBlock *tb);
+void tb_evict(CPUState *cpu);
+void tb_jmp_unlink_incoming(TranslationBlock *tb);
 void cpu_restore_state_from_tb(CPUState *cpu, TranslationBlock *tb,
                                uintptr_t host_pc);
+bool tb_unwind_guest_pc(TranslationBlock *tb, uintptr_t host_pc, vaddr *pc);
 
 bool tcg_exec_realizefn(CPUState *cpu, Error **errp);
 void tcg_exec_unrealizefn(CPUState *cpu);
 
+#ifndef CONFIG_USER_ONLY
+extern bool tcg_profile_active;
+
+void tcg_profile_cpu_exec(CPUState *cpu);
+void tcg_profile_start(uint32_t frequency, Error **errp);
+struct TcgProfileInfo *tcg_profile_stop(const char *filename, Error **errp);
+#endif
+
 /* current cflags for hashing/comparison */
 uint32_t curr_cflags(CPUState *cpu);
 
@@ -126,19 +126,45 @@ static gboolean tb_tree_stats_iter(gpointer key, gpointer value, gpointer data)
     return false;
 }
 
-static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide)
+static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide,
+                             size_t *plarge)
 {
     CPUState *cpu;
-    size_t full = 0, part = 0, elide = 0;
+    size_t full = 0, part = 0, elide = 0, large = 0;
 
     CPU_FOREACH(cpu) {
         full += qatomic_read(&cpu->neg.tlb.c.full_flush_count);
         part += qatomic_read(&cpu->neg.tlb.c.part_flush_count);
         elide += qatomic_read(&cpu->neg.tlb.c.elide_flush_count);
+        large += qatomic_read(&cpu->neg.tlb.c.large_flush_count);
     }
     *pfull = full;
     *ppart = part;
     *pelide = elide;
+    *plarge = large;
+}
+
+static void dump_tlb_cpu_stats(GString *buf)
+{
+    CPUState *cpu;
+
+    g_string_append_printf(buf, "\nTLB statistics per vCPU:\n");
+    g_string_append_printf(buf, "%-6s %10s %10s %10s %10s %12s %12s\n",
+                           "vCPU", "full", "partial", "elided", "large",
+                           "victim hits", "misses");
+    CPU_FOREACH(cpu) {
+        CPUTLBCommon *c = &cpu->neg.tlb.c;
+
+        g_string_append_printf(buf, "%-6d %10zu %10zu %10zu %10zu "
+                               "%12zu %12zu\n",
+                               cpu->cpu_index,
+                               qatomic_read(&c->full_flush_count),
+                               qatomic_read(&c->part_flush_count),
+                               qatomic_read(&c->elide_flush_count),
+                               qatomic_read(&c->large_flush_count),
+                               qatomic_read(&c->victim_hit_count),
+                               qatomic_read(&c->miss_count));
+    }
 }
 
 static void tcg_dump_info(GString *buf)
@@ -150,7 +176,7 @@ static void dump_exec_info(GString *buf)
 {
     struct tb_tree_stats tst = {};
     struct qht_stats hst;
-    size_t nb_tbs, flush_full, flush_part, flush_elide;
+    size_t nb_tbs, flush_full, flush_part, flush_elide, flush_large;
 
     tcg_tb_foreach(tb_tree_stats_iter, &tst);
     nb_tbs = tst.nb_tbs;
@@ -189,13 +215,21 @@ static void dump_exec_info(GString *buf)
     g_string_append_printf(buf, "\nStatistics:\n");
     g_string_append_printf(buf, "TB flush count      %u\n",
                            qatomic_read(&tb_ctx.tb_flush_count));
+    g_string_append_printf(buf, "TB evict count      %u\n",
+                           qatomic_read(&tb_ctx.tb_evict_count));
+    g_string_append_printf(buf, "TB trace count      %u\n",
+                           qatomic_read(&tb_ctx.tb_trace_count));
+    g_string_append_printf(buf, "TB speculative count %u\n",
+                           qatomic_read(&tb_ctx.tb_spec_count));
     g_string_append_printf(buf, "TB invalidate count %u\n",
                            qatomic_read(&tb_ctx.tb_phys_invalidate_count));
 
-    tlb_flush_counts(&flush_full, &flush_part, &flush_elide);
+    tlb_flush_counts(&flush_full, &flush_part, &flush_elide, &flush_large);
     g_string_append_printf(buf, "TLB full flushes    %zu\n", flush_full);
     g_string_append_printf(buf, "TLB partial flushes %zu\n", flush_part);
     g_string_append_printf(buf, "TLB elided flushes  %zu\n", flush_elide);
+    g_string_append_printf(buf, "TLB large page flushes %zu\n", flush_large);
+    dump_tlb_cpu_stats(buf);
     tcg_dump_info(buf);
 }
 
@@ -215,6 +249,27 @@ HumanReadableText *qmp_x_query_jit(Error **errp)
     return human_readable_text_from_str(buf);
 }
 
+void qmp_x_tcg_profile_start(bool has_frequency, uint32_t frequency,
+                             Error **errp)
+{
+    if (!tcg_enabled()) {
+        error_setg(errp, "TCG profiling is only available with accel=tcg");
+        return;
+    }
+
+    tcg_profile_start(has_frequency ? frequency : 1000, errp);
+}
+
+TcgProfileInfo *qmp_x_tcg_profile_stop(const char *filename, Error **errp)
+{
+    if (!tcg_enabled()) {
+        error_setg(errp, "TCG profiling is only available with accel=tcg");
+        return NULL;
+    }
+
+    return tcg_profile_stop(filename, errp);
+}
+
 static void tcg_dump_op_count(GString *buf)
 {
     g_string_append_printf(buf, "[TCG profiler not compiled]\n");
@@ -221,6 +221,141 @@ static void gen_mem_cb(struct qemu_plugin_regular_cb *cb,
     tcg_temp_free_i32(cpu_index);
 }
 
+static void gen_mem_buffer_flush(struct qemu_plugin_buffer_cb *cb)
+{
+    TCGv_i32 cpu_index = gen_cpu_index();
+    tcg_gen_call2(cb->flush, cb->info, NULL,
+                  tcgv_i32_temp(cpu_index),
+                  tcgv_ptr_temp(tcg_constant_ptr(cb->buf)));
+    tcg_temp_free_i32(cpu_index);
+}
+
+/*
+ * Flush the buffer of the current vCPU unless it has room for the
+ * @n records that the instruction is about to append.
+ */
+static void gen_mem_buffer_reserve(struct qemu_plugin_buffer_cb *cb, size_t n)
+{
+    qemu_plugin_u64 entry = qemu_plugin_scoreboard_u64(cb->buf->score);
+    TCGv_ptr ptr = gen_plugin_u64_ptr(entry);
+    TCGv_i64 count = tcg_temp_ebb_new_i64();
+    TCGLabel *after_cb = gen_new_label();
+
+    tcg_gen_ld_i64(count, ptr, 0);
+    tcg_gen_brcondi_i64(TCG_COND_LEU, count, cb->buf->n_records - n, after_cb);
+    gen_mem_buffer_flush(cb);
+    gen_set_label(after_cb);
+
+    tcg_temp_free_i64(count);
+    tcg_temp_free_ptr(ptr);
+}
+
+/*
+ * Append a record to the buffer of the current vCPU. The access may be
+ * in the middle of a load/store expansion, so there must be no branch
+ * here: room for the record was made by gen_mem_buffer_reserve.
+ */
+static void gen_mem_buffer_cb(struct qemu_plugin_buffer_cb *cb,
+                              qemu_plugin_meminfo_t meminfo, TCGv_i64 addr)
+{
+    qemu_plugin_u64 entry = qemu_plugin_scoreboard_u64(cb->buf->score);
+    TCGv_ptr ptr = gen_plugin_u64_ptr(entry);
+    TCGv_ptr rec = tcg_temp_ebb_new_ptr();
+    TCGv_i64 count = tcg_temp_ebb_new_i64();
+    TCGv_i64 offset = tcg_temp_ebb_new_i64();
+
+    tcg_gen_ld_i64(count, ptr, 0);
+    tcg_gen_muli_i64(offset, count, sizeof(struct qemu_plugin_mem_record));
+    tcg_gen_trunc_i64_ptr(rec, offset);
+    tcg_gen_add_ptr(rec, rec, ptr);
+    tcg_gen_st_i64(addr, rec, PLUGIN_MEM_BUFFER_RECORDS +
+                   offsetof(struct qemu_plugin_mem_record, vaddr));
+    tcg_gen_st_i64(tcg_constant_i64(cb->pc), rec, PLUGIN_MEM_BUFFER_RECORDS +
+                   offsetof(struct qemu_plugin_mem_record, pc));
+    tcg_gen_st_i32(tcg_constant_i32(meminfo), rec, PLUGIN_MEM_BUFFER_RECORDS +
+                   offsetof(struct qemu_plugin_mem_record, info));
+    tcg_gen_addi_i64(count, count, 1);
+    tcg_gen_st_i64(count, ptr, 0);
+
+    tcg_temp_free_i64(offset);
+    tcg_temp_free_i64(count);
+    tcg_temp_free_ptr(rec);
+    tcg_temp_free_ptr(ptr);
+
+    /* the instruction alone overflows the buffer, deliver every record */
+    if (cb->flush_each) {
+        gen_mem_buffer_flush(cb);
+    }
+}
+
+/* Count the memory accesses of the instruction starting after @op */
+static void count_insn_mem_ops(TCGOp *op, size_t *n_r, size_t *n_w)
+{
+    *n_r = *n_w = 0;
+    for (op = QTAILQ_NEXT(op, link);
+         op && op->opc != INDEX_op_insn_start;
+         op = QTAILQ_NEXT(op, link)) {
+        if (op->opc == INDEX_op_plugin_mem_cb) {
+            if (qemu_plugin_mem_is_store(op->args[1])) {
+                (*n_w)++;
+            } else {
+                (*n_r)++;
+            }
+        }
+    }
+}
+
+/*
+ * Make room in each memory buffer for the records the instruction
+ * appends from the generated code. Accesses done by helpers are
+ * appended by qemu_plugin_vcpu_mem_cb, which keeps that room free.
+ */
+static void inject_mem_buffer_reserve(TCGOp *op, GArray *cbs)
+{
+    size_t n_r = 0, n_w = 0;
+    bool counted = false;
+    int i, j, n = cbs ? cbs->len : 0;
+
+    for (i = 0; i < n; i++) {
+        struct qemu_plugin_dyn_cb *cb =
+            &g_array_index(cbs, struct qemu_plugin_dyn_cb, i);
+        struct qemu_plugin_mem_buffer *buf;
+        bool first = true;
+        size_t records = 0;
+
+        if (cb->type != PLUGIN_CB_MEM_BUFFER) {
+            continue;
+        }
+        if (!counted) {
+            count_insn_mem_ops(op, &n_r, &n_w);
+            counted = true;
+        }
+        buf = cb->buffer.buf;
+
+        /* several callbacks may append to the same buffer */
+        for (j = 0; j < n; j++) {
+            struct qemu_plugin_dyn_cb *other =
+                &g_array_index(cbs, struct qemu_plugin_dyn_cb, j);
+
+            if (other->type != PLUGIN_CB_MEM_BUFFER ||
+                other->buffer.buf != buf) {
+                continue;
+            }
+            if (j < i) {
+                first = false;
+            }
+            records += (other->buffer.rw & QEMU_PLUGIN_MEM_R ? n_r : 0) +
+                       (other->buffer.rw & QEMU_PLUGIN_MEM_W ? n_w : 0);
+        }
+
+        cb->buffer.flush_each = records > buf->n_records;
+        cb->buffer.reserve = cb->buffer.flush_each ? 1 : records;
+        if (first && records) {
+            gen_mem_buffer_reserve(&cb->buffer, cb->buffer.reserve);
+        }
+    }
+}
+
 static void inject_cb(struct qemu_plugin_dyn_cb *cb)
 
 {
@@ -258,6 +393,11 @@ static void inject_mem_cb(struct qemu_plugin_dyn_cb *cb,
             inject_cb(cb);
         }
         break;
+    case PLUGIN_CB_MEM_BUFFER:
+        if (rw & cb->buffer.rw) {
+            gen_mem_buffer_cb(&cb->buffer, meminfo, addr);
+        }
+        break;
     default:
         g_assert_not_reached();
     }
@@ -332,6 +472,9 @@ static void plugin_gen_inject(struct qemu_plugin_tb *plugin_tb)
             case PLUGIN_GEN_FROM_INSN:
                 assert(insn != NULL);
 
+                /* sets the room to keep, which gen_enable_mem_helper copies */
+                inject_mem_buffer_reserve(op, insn->mem_cbs);
+
                 gen_enable_mem_helper(plugin_tb, insn);
 
                 cbs = insn->insn_cbs;
@@ -33,11 +33,14 @@ static inline void tb_lock_page1(tb_page_addr_t p0, tb_page_addr_t p1)
 
 static inline void tb_unlock_page1(tb_page_addr_t p0, tb_page_addr_t p1) { }
 static inline void tb_unlock_pages(TranslationBlock *tb) { }
+static inline void tb_speculate_note(const TranslationBlock *tb,
+                                     vaddr dest) { }
 #else
 void tb_lock_page0(tb_page_addr_t);
 void tb_lock_page1(tb_page_addr_t, tb_page_addr_t);
 void tb_unlock_page1(tb_page_addr_t, tb_page_addr_t);
 void tb_unlock_pages(TranslationBlock *);
+void tb_speculate_note(const TranslationBlock *tb, vaddr dest);
 #endif
 
 #ifdef CONFIG_SOFTMMU
@@ -759,17 +759,10 @@ static void tb_remove(TranslationBlock *tb)
 }
 #endif /* CONFIG_USER_ONLY */
 
-/* flush all the translation blocks */
-static void do_tb_flush(CPUState *cpu, run_on_cpu_data tb_flush_count)
+/* flush all the translation blocks; call with mmap_lock held */
+static void tb_flush__locked(void)
 {
-    bool did_flush = false;
-
-    mmap_lock();
-    /* If it is already been done on request of another CPU, just retry. */
-    if (tb_ctx.tb_flush_count != tb_flush_count.host_int) {
-        goto done;
-    }
-    did_flush = true;
+    CPUState *cpu;
 
     CPU_FOREACH(cpu) {
         tcg_flush_jmp_cache(cpu);
@@ -781,6 +774,19 @@ static void do_tb_flush(CPUState *cpu, run_on_cpu_data tb_flush_count)
     tcg_region_reset_all();
     /* XXX: flush processor icache at this point if cache flush is expensive */
     qatomic_inc(&tb_ctx.tb_flush_count);
+}
+
+static void do_tb_flush(CPUState *cpu, run_on_cpu_data tb_flush_count)
+{
+    bool did_flush = false;
+
+    mmap_lock();
+    /* If it is already been done on request of another CPU, just retry. */
+    if (tb_ctx.tb_flush_count != tb_flush_count.host_int) {
+        goto done;
+    }
+    did_flush = true;
+    tb_flush__locked();
 
 done:
     mmap_unlock();
@@ -879,6 +885,17 @@ static inline void tb_jmp_unlink(TranslationBlock *dest)
     qemu_spin_unlock(&dest->jmp_lock);
 }
 
+/*
+ * Unchain the TBs that jump to @tb, so that they look up their
+ * destination again, e.g. to find the trace that replaces @tb.
+ */
+void tb_jmp_unlink_incoming(TranslationBlock *tb)
+{
+    qemu_thread_jit_write();
+    tb_jmp_unlink(tb);
+    qemu_thread_jit_execute();
+}
+
 static void tb_jmp_cache_inval_tb(TranslationBlock *tb)
 {
     CPUState *cpu;
@@ -968,6 +985,68 @@ void tb_phys_invalidate(TranslationBlock *tb, tb_page_addr_t page_addr)
     }
 }
 
+static gboolean tb_evict_iter(gpointer key, gpointer value, gpointer data)
+{
+    TranslationBlock *tb = value;
+
+    tb_phys_invalidate(tb, -1);
+    return false;
+}
+
+/* make room in the code buffer by evicting its oldest region */
+static void do_tb_evict(CPUState *cpu, run_on_cpu_data tb_flush_count)
+{
+    bool did_flush = false;
+    int ret;
+
+    mmap_lock();
+    /* A flush on request of another CPU made room already. */
+    if (tb_ctx.tb_flush_count != tb_flush_count.host_int) {
+        goto done;
+    }
+
+    qemu_thread_jit_write();
+    ret = tcg_region_evict(tb_evict_iter, NULL);
+    qemu_thread_jit_execute();
+
+    if (ret > 0) {
+        /*
+         * One-insn TBs for non-RAM code are not in the region trees, but
+         * may still be in the jump caches; drop those too.
+         */
+        CPU_FOREACH(cpu) {
+            tcg_flush_jmp_cache(cpu);
+        }
+        qatomic_inc(&tb_ctx.tb_evict_count);
+    } else if (ret < 0) {
+        did_flush = true;
+        tb_flush__locked();
+    }
+
+done:
+    mmap_unlock();
+    if (did_flush) {
+        qemu_plugin_flush_cb();
+    }
+}
+
+/*
+ * Called when the code buffer is full.  Rather than flushing all the
+ * translation blocks, only those of the oldest region are dropped; the
+ * whole buffer is flushed only if no region can be evicted.
+ */
+void tb_evict(CPUState *cpu)
+{
+    unsigned tb_flush_count = qatomic_read(&tb_ctx.tb_flush_count);
+
+    if (cpu_in_serial_context(cpu)) {
+        do_tb_evict(cpu, RUN_ON_CPU_HOST_INT(tb_flush_count));
+    } else {
+        async_safe_run_on_cpu(cpu, do_tb_evict,
+                              RUN_ON_CPU_HOST_INT(tb_flush_count));
+    }
+}
+
 /*
  * Add a new TB and link it to the physical page tables.
  * Called with mmap_lock held for user-mode emulation.
@@ -35,6 +35,8 @@
 #include "qemu/atomic.h"
 #include "qapi/qapi-builtin-visit.h"
 #include "qemu/units.h"
+#include "qemu/host-utils.h"
+#include "hw/core/cpu.h"
 #if !defined(CONFIG_USER_ONLY)
 #include "hw/boards.h"
 #endif
@@ -47,6 +49,9 @@ struct TCGState {
     bool one_insn_per_tb;
     int splitwx_enabled;
     unsigned long tb_size;
+    uint32_t trace_threshold;
+    bool speculate;
+    uint32_t victim_tlb_size;
 };
 typedef struct TCGState TCGState;
 
@@ -95,10 +100,14 @@ static void tcg_accel_instance_init(Object *obj)
 #else
     s->splitwx_enabled = 0;
 #endif
+    s->victim_tlb_size = CPU_VTLB_DEFAULT_SIZE;
 }
 
 bool mttcg_enabled;
 bool one_insn_per_tb;
+uint32_t tb_trace_threshold;
+bool tb_speculate_enabled;
+size_t tlb_victim_size = CPU_VTLB_DEFAULT_SIZE;
 
 static int tcg_init_machine(MachineState *ms)
 {
@@ -111,6 +120,7 @@ static int tcg_init_machine(MachineState *ms)
 
     tcg_allowed = true;
     mttcg_enabled = s->mttcg_enabled;
+    tlb_victim_size = s->victim_tlb_size;
 
     page_init();
     tb_htable_init();
@@ -181,6 +191,79 @@ static void tcg_set_tb_size(Object *obj, Visitor *v,
     s->tb_size = value;
 }
 
+static void tcg_get_trace_threshold(Object *obj, Visitor *v,
+                                    const char *name, void *opaque,
+                                    Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value = s->trace_threshold;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_trace_threshold(Object *obj, Visitor *v,
+                                    const char *name, void *opaque,
+                                    Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (value > INT32_MAX) {
+        error_setg(errp, "trace-threshold must be at most %d", INT32_MAX);
+        return;
+    }
+
+    s->trace_threshold = value;
+    /* Applies to the TBs translated from now on */
+    qatomic_set(&tb_trace_threshold, value);
+}
+
+static bool tcg_get_speculate(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->speculate;
+}
+
+static void tcg_set_speculate(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->speculate = value;
+    qatomic_set(&tb_speculate_enabled, value);
+}
+
+static void tcg_get_victim_tlb_size(Object *obj, Visitor *v,
+                                    const char *name, void *opaque,
+                                    Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value = s->victim_tlb_size;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_victim_tlb_size(Object *obj, Visitor *v,
+                                    const char *name, void *opaque,
+                                    Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (value < CPU_VTLB_WAYS || value > CPU_VTLB_MAX_SIZE ||
+        !is_power_of_2(value)) {
+        error_setg(errp, "victim-tlb-size must be a power of 2 "
+                   "between %d and %d", CPU_VTLB_WAYS, CPU_VTLB_MAX_SIZE);
+        return;
+    }
+
+    s->victim_tlb_size = value;
+}
+
 static bool tcg_get_splitwx(Object *obj, Error **errp)
 {
     TCGState *s = TCG_STATE(obj);
@@ -252,6 +335,25 @@ static void tcg_accel_class_init(ObjectClass *oc, void *data)
                                    tcg_set_one_insn_per_tb);
     object_class_property_set_description(oc, "one-insn-per-tb",
         "Only put one guest insn in each translation block");
+
+    object_class_property_add(oc, "trace-threshold", "uint32",
+        tcg_get_trace_threshold, tcg_set_trace_threshold,
+        NULL, NULL);
+    object_class_property_set_description(oc, "trace-threshold",
+        "Retranslate translation blocks entered this many times as "
+        "traces across direct jumps (0 = never)");
+
+    object_class_property_add_bool(oc, "speculate",
+                                   tcg_get_speculate, tcg_set_speculate);
+    object_class_property_set_description(oc, "speculate",
+        "Translate the successors of new translation blocks while "
+        "the vCPU is halted");
+
+    object_class_property_add(oc, "victim-tlb-size", "uint32",
+        tcg_get_victim_tlb_size, tcg_set_victim_tlb_size,
+        NULL, NULL);
+    object_class_property_set_description(oc, "victim-tlb-size",
+        "Number of entries of the victim TLB of each MMU mode");
 }
 
 static const TypeInfo tcg_accel_type = {
@@ -0,0 +1,374 @@
+/*
+ * Sampling profiler for TCG generated code
+ *
+ * An interval timer delivers SIGPROF at a fixed rate of process CPU time.
+ * The signal handler only records the host pc into a ring owned by the
+ * vCPU that was running; the vCPU thread itself later maps the samples
+ * that fell into the code buffer back to their translation block and
+ * guest instruction, using the same insn start data that is used to
+ * restore the cpu state on exceptions.  This is done from cpu_exec(),
+ * where the TB cannot be flushed from under our feet.
+ *
+ * The profile is written in the "folded stacks" format understood by
+ * flamegraph.pl and similar tools, one line per guest instruction:
+ *
+ *     guest_function;0xTB_PC;0xPC count
+ *
+ * Samples taken while a vCPU thread runs QEMU code (helpers, the
+ * translator, device emulation) are reported as "[qemu]".
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/thread.h"
+#include "qapi/error.h"
+#include "qapi/qapi-types-machine.h"
+#include "hw/boards.h"
+#include "hw/core/cpu.h"
+#include "disas/disas.h"
+#include "exec/cpu-all.h"
+#include "exec/exec-all.h"
+#include "exec/translation-block.h"
+#include "tcg/tcg.h"
+#include "tb-context.h"
+#include "tb-jmp-cache.h"
+#include "internal-common.h"
+
+#ifdef CONFIG_LINUX
+#include <sys/time.h>
+#include <ucontext.h>
+#if defined(__x86_64__)
+# define HOST_SIGNAL_PC(uc)  ((uc)->uc_mcontext.gregs[REG_RIP])
+#elif defined(__i386__)
+# define HOST_SIGNAL_PC(uc)  ((uc)->uc_mcontext.gregs[REG_EIP])
+#elif defined(__aarch64__)
+# define HOST_SIGNAL_PC(uc)  ((uc)->uc_mcontext.pc)
+#elif defined(__arm__)
+# define HOST_SIGNAL_PC(uc)  ((uc)->uc_mcontext.arm_pc)
+#elif defined(__riscv)
+# define HOST_SIGNAL_PC(uc)  ((uc)->uc_mcontext.__gregs[REG_PC])
+#elif defined(__loongarch64)
+# define HOST_SIGNAL_PC(uc)  ((uc)->uc_mcontext.__pc)
+#elif defined(__s390x__)
+# define HOST_SIGNAL_PC(uc)  ((uc)->uc_mcontext.psw.addr)
+#elif defined(__powerpc64__)
+# include <asm/ptrace.h>
+# define HOST_SIGNAL_PC(uc)  ((uc)->uc_mcontext.gp_regs[PT_NIP])
+#endif
+#endif
+
+/* Must be a power of 2 */
+#define TCG_PROFILE_RING_SIZE  256
+
+typedef struct TCGProfileSample {
+    uintptr_t host_pc;
+    unsigned gen;
+    unsigned session;
+} TCGProfileSample;
+
+/*
+ * Samples are produced by the signal handler and consumed by the thread
+ * that it interrupted, so the ring needs no atomic read-modify-write.
+ */
+typedef struct TCGProfileRing {
+    TCGProfileSample sample[TCG_PROFILE_RING_SIZE];
+    unsigned head;
+    unsigned tail;
+} TCGProfileRing;
+
+typedef struct TCGProfileEntry {
+    uint64_t pc;        /* hash key */
+    uint64_t tb_pc;
+    uint64_t count;
+} TCGProfileEntry;
+
+bool tcg_profile_active;
+
+/* Allocated on the first start and never freed, as signals may be pending */
+static TCGProfileRing *profile_rings;
+static unsigned profile_nr_rings;
+static unsigned profile_session;
+
+static size_t profile_samples;
+static size_t profile_host_samples;
+static size_t profile_other_samples;
+static size_t profile_dropped;
+
+/* Protects the following */
+static QemuMutex profile_lock;
+static GHashTable *profile_entries;
+static size_t profile_guest_samples;
+
+#ifdef HOST_SIGNAL_PC
+static __thread bool profile_signal_unblocked;
+#endif
+
+/*
+ * A sample can only be resolved if the code buffer was not flushed and
+ * no region was evicted since it was taken.  Both counters only grow,
+ * so their sum changes whenever the TB may be gone.
+ */
+static unsigned profile_gen(void)
+{
+    return qatomic_read(&tb_ctx.tb_flush_count) +
+           qatomic_read(&tb_ctx.tb_evict_count);
+}
+
+#ifdef HOST_SIGNAL_PC
+static void tcg_profile_signal(int sig, siginfo_t *info, void *puc)
+{
+    uintptr_t pc = HOST_SIGNAL_PC((ucontext_t *)puc);
+    CPUState *cpu = current_cpu;
+    TCGProfileRing *ring;
+    unsigned head;
+
+    if (!qatomic_read(&tcg_profile_active)) {
+        return;
+    }
+    qatomic_inc(&profile_samples);
+
+    if (!cpu || cpu->cpu_index >= profile_nr_rings) {
+        qatomic_inc(&profile_other_samples);
+        return;
+    }
+    if (!in_code_gen_buffer((const void *)(pc - tcg_splitwx_diff))) {
+        qatomic_inc(&profile_host_samples);
+        return;
+    }
+
+    ring = &profile_rings[cpu->cpu_index];
+    head = ring->head;
+    if (head - qatomic_read(&ring->tail) >= TCG_PROFILE_RING_SIZE) {
+        qatomic_inc(&profile_dropped);
+        return;
+    }
+    ring->sample[head % TCG_PROFILE_RING_SIZE] = (TCGProfileSample) {
+        .host_pc = pc,
+        .gen = profile_gen(),
+        .session = qatomic_read(&profile_session),
+    };
+    barrier();
+    qatomic_set(&ring->head, head + 1);
+}
+#endif
+
+/*
+ * With CF_PCREL, the TB and the unwind data only know the offset in the
+ * page.  The virtual page is found in the jump cache, through which the
+ * TB was most likely entered; failing that, use the physical address.
+ */
+static vaddr tb_profile_pc(CPUState *cpu, TranslationBlock *tb)
+{
+    CPUJumpCache *jc = cpu->tb_jmp_cache;
+    int i;
+
+    if (!(tb_cflags(tb) & CF_PCREL)) {
+        return tb->pc;
+    }
+    for (i = 0; i < TB_JMP_CACHE_SIZE; i++) {
+        if (qatomic_read(&jc->array[i].tb) == tb) {
+            return jc->array[i].pc;
+        }
+    }
+    return tb_page_addr0(tb);
+}
+
+static void tcg_profile_resolve(CPUState *cpu, uintptr_t host_pc)
+{
+    TranslationBlock *tb = tcg_tb_lookup(host_pc);
+    TCGProfileEntry *e;
+    vaddr tb_pc, pc;
+
+    if (!tb) {
+        /* The prologue and epilogue are shared by all TBs */
+        qatomic_inc(&profile_host_samples);
+        return;
+    }
+
+    tb_pc = tb_profile_pc(cpu, tb);
+    if (!tb_unwind_guest_pc(tb, host_pc, &pc)) {
+        /* Out of line code at the end of the TB, e.g. softmmu slow paths */
+        pc = tb_pc;
+    } else if (tb_cflags(tb) & CF_PCREL) {
+        pc = (tb_pc & TARGET_PAGE_MASK) | (pc & ~TARGET_PAGE_MASK);
+    }
+
+    e = g_hash_table_lookup(profile_entries, &(uint64_t){ pc });
+    if (!e) {
+        e = g_new0(TCGProfileEntry, 1);
+        e->pc = pc;
+        e->tb_pc = tb_pc;
+        g_hash_table_insert(profile_entries, &e->pc, e);
+    }
+    e->count++;
+    profile_guest_samples++;
+}
+
+void tcg_profile_cpu_exec(CPUState *cpu)
+{
+    TCGProfileRing *ring;
+    unsigned head, tail, gen, session;
+
+#ifdef HOST_SIGNAL_PC
+    /* Threads created by QEMU start with all signals blocked */
+    if (unlikely(!profile_signal_unblocked)) {
+        sigset_t set;
+
+        sigemptyset(&set);
+        sigaddset(&set, SIGPROF);
+        pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+        profile_signal_unblocked = true;
+    }
+#endif
+
+    if (cpu->cpu_index >= profile_nr_rings) {
+        return;
+    }
+    ring = &profile_rings[cpu->cpu_index];
+    head = qatomic_read(&ring->head);
+    tail = ring->tail;
+    if (head == tail) {
+        return;
+    }
+
+    gen = profile_gen();
+    session = qatomic_read(&profile_session);
+    qemu_mutex_lock(&profile_lock);
+    for (; tail != head; tail++) {
+        TCGProfileSample *s = &ring->sample[tail % TCG_PROFILE_RING_SIZE];
+
+        /* Leftovers from an earlier session, or stopped meanwhile */
+        if (s->session != session || !profile_entries) {
+            continue;
+        }
+        if (s->gen == gen) {
+            tcg_profile_resolve(cpu, s->host_pc);
+        } else {
+            qatomic_inc(&profile_dropped);
+        }
+    }
+    qemu_mutex_unlock(&profile_lock);
+    qatomic_set(&ring->tail, tail);
+}
+
+void tcg_profile_start(uint32_t frequency, Error **errp)
+{
+#ifdef HOST_SIGNAL_PC
+    static bool initialized;
+    struct itimerval it = { };
+    unsigned long usec;
+
+    if (qatomic_read(&tcg_profile_active)) {
+        error_setg(errp, "TCG profiling is already running");
+        return;
+    }
+    if (frequency == 0 || frequency > 100000) {
+        error_setg(errp, "frequency must be between 1 and 100000 Hz");
+        return;
+    }
+
+    if (!initialized) {
+        struct sigaction act = { };
+
+        act.sa_sigaction = tcg_profile_signal;
+        act.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&act.sa_mask);
+        if (sigaction(SIGPROF, &act, NULL) < 0) {
+            error_setg_errno(errp, errno, "cannot install SIGPROF handler");
+            return;
+        }
+        qemu_mutex_init(&profile_lock);
+        profile_nr_rings = current_machine->smp.max_cpus;
+        profile_rings = g_new0(TCGProfileRing, profile_nr_rings);
+        initialized = true;
+    }
+
+    qemu_mutex_lock(&profile_lock);
+    profile_entries = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                            NULL, g_free);
+    profile_guest_samples = 0;
+    qemu_mutex_unlock(&profile_lock);
+    qatomic_set(&profile_samples, 0);
+    qatomic_set(&profile_host_samples, 0);
+    qatomic_set(&profile_other_samples, 0);
+    qatomic_set(&profile_dropped, 0);
+    qatomic_inc(&profile_session);
+
+    usec = 1000000 / frequency;
+    it.it_interval.tv_sec = usec / 1000000;
+    it.it_interval.tv_usec = usec % 1000000;
+    it.it_value = it.it_interval;
+    if (setitimer(ITIMER_PROF, &it, NULL) < 0) {
+        error_setg_errno(errp, errno, "cannot start profiling timer");
+        return;
+    }
+    qatomic_set(&tcg_profile_active, true);
+#else
+    error_setg(errp, "TCG profiling is not supported on this host");
+#endif
+}
+
+static gint profile_entry_compare(gconstpointer a, gconstpointer b)
+{
+    const TCGProfileEntry *ea = a;
+    const TCGProfileEntry *eb = b;
+
+    return ea->count < eb->count ? 1 : ea->count > eb->count ? -1 : 0;
+}
+
+static void profile_write(FILE *f)
+{
+    GList *entries = g_hash_table_get_values(profile_entries);
+    size_t host = qatomic_read(&profile_host_samples);
+    GList *l;
+
+    entries = g_list_sort(entries, profile_entry_compare);
+    for (l = entries; l; l = l->next) {
+        TCGProfileEntry *e = l->data;
+        const char *func = lookup_symbol(e->pc);
+
+        fprintf(f, "%s;0x%" PRIx64 ";0x%" PRIx64 " %" PRIu64 "\n",
+                *func ? func : "[unknown]", e->tb_pc, e->pc, e->count);
+    }
+    if (host) {
+        fprintf(f, "[qemu] %zu\n", host);
+    }
+    g_list_free(entries);
+}
+
+TcgProfileInfo *tcg_profile_stop(const char *filename, Error **errp)
+{
+    TcgProfileInfo *info;
+    FILE *f;
+
+    if (!qatomic_read(&tcg_profile_active)) {
+        error_setg(errp, "TCG profiling is not running");
+        return NULL;
+    }
+
+#ifdef HOST_SIGNAL_PC
+    setitimer(ITIMER_PROF, &(struct itimerval){ }, NULL);
+#endif
+    qatomic_set(&tcg_profile_active, false);
+
+    qemu_mutex_lock(&profile_lock);
+    f = fopen(filename, "w");
+    if (f) {
+        profile_write(f);
+        fclose(f);
+        info = g_new0(TcgProfileInfo, 1);
+        info->samples = qatomic_read(&profile_samples);
+        info->guest_samples = profile_guest_samples;
+        info->host_samples = qatomic_read(&profile_host_samples);
+        info->other_samples = qatomic_read(&profile_other_samples);
+        info->dropped = qatomic_read(&profile_dropped);
+    } else {
+        error_setg_file_open(errp, errno, filename);
+        info = NULL;
+    }
+    g_hash_table_destroy(profile_entries);
+    profile_entries = NULL;
+    qemu_mutex_unlock(&profile_lock);
+    return info;
+}
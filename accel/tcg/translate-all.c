@@ -223,6 +223,22 @@ void cpu_restore_state_from_tb(CPUState *cpu, TranslationBlock *tb,
     cpu->cc->tcg_ops->restore_state_to_opc(cpu, tb, data);
 }
 
+/*
+ * Find the guest pc of the instruction whose code contains 'host_pc',
+ * which is an address inside the code of 'tb' (and not a return address).
+ * With CF_PCREL only the offset of the pc within the page is known.
+ */
+bool tb_unwind_guest_pc(TranslationBlock *tb, uintptr_t host_pc, vaddr *pc)
+{
+    uint64_t data[TARGET_INSN_START_WORDS];
+
+    if (cpu_unwind_data_from_tb(tb, host_pc + GETPC_ADJ, data) < 0) {
+        return false;
+    }
+    *pc = data[0];
+    return true;
+}
+
 bool cpu_restore_state(CPUState *cpu, uintptr_t host_pc)
 {
     /*
@@ -320,10 +336,10 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     assert_no_pages_locked();
     tb = tcg_tb_alloc(tcg_ctx);
     if (unlikely(!tb)) {
-        /* flush must be done */
-        tb_flush(cpu);
+        /* eviction, or a flush, must be done */
+        tb_evict(cpu);
         mmap_unlock();
-        /* Make the execution loop process the flush as soon as possible.  */
+        /* Make the execution loop process the eviction as soon as possible. */
         cpu->exception_index = EXCP_INTERRUPT;
         cpu_loop_exit(cpu);
     }
@@ -336,6 +352,15 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     tb->cs_base = cs_base;
     tb->flags = flags;
     tb->cflags = cflags;
+    tb->trace_countdown = -1;
+    if (phys_pc != -1 && !(cflags & (CF_TRACE | CF_COUNT_MASK | CF_NOIRQ |
+                                     CF_NO_GOTO_TB | CF_USE_ICOUNT))) {
+        uint32_t threshold = qatomic_read(&tb_trace_threshold);
+
+        if (threshold) {
+            tb->trace_countdown = threshold;
+        }
+    }
     tb_set_page_addr0(tb, phys_pc);
     tb_set_page_addr1(tb, -1);
     if (phys_pc != -1) {
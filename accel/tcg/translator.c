@@ -83,6 +83,32 @@ static TCGOp *gen_tb_start(DisasContextBase *db, uint32_t cflags)
                          - offsetof(ArchCPU, env));
     }
 
+    /*
+     * Count entries into the TB, and leave it through the exit request
+     * path once it became hot so that it is retranslated as a trace.
+     * The counter is shared between vCPUs and not updated atomically, so
+     * it only drives the decision; the exit itself is flagged in the
+     * vCPU that takes it.  Stop counting at zero, so that racing updates
+     * cannot drive the counter negative and wrap around.
+     */
+    if (db->tb->trace_countdown > 0) {
+        TCGv_ptr countdown = tcg_constant_ptr(&db->tb->trace_countdown);
+        TCGv_i32 left = tcg_temp_new_i32();
+        TCGLabel *skip = gen_new_label();
+
+        tcg_debug_assert(tcg_ctx->exitreq_label);
+        tcg_gen_ld_i32(left, countdown, 0);
+        tcg_gen_brcondi_i32(TCG_COND_LE, left, 0, skip);
+        tcg_gen_subi_i32(left, left, 1);
+        tcg_gen_st_i32(left, countdown, 0);
+        tcg_gen_brcondi_i32(TCG_COND_NE, left, 0, skip);
+        tcg_gen_st8_i32(tcg_constant_i32(1), tcg_env,
+                        offsetof(ArchCPU, parent_obj.neg.trace_exit)
+                        - offsetof(ArchCPU, env));
+        tcg_gen_br(tcg_ctx->exitreq_label);
+        gen_set_label(skip);
+    }
+
     return icount_start_insn;
 }
 
@@ -117,7 +143,38 @@ bool translator_use_goto_tb(DisasContextBase *db, vaddr dest)
     }
 
     /* Check for the dest on the same page as the start of the TB.  */
-    return translator_is_same_page(db, dest);
+    if (!translator_is_same_page(db, dest)) {
+        return false;
+    }
+
+    /* A likely successor, worth translating ahead of time */
+    tb_speculate_note(db->tb, dest);
+    return true;
+}
+
+/* Maximum number of jumps followed by a trace */
+#define TRACE_MAX_JUMPS 8
+
+bool translator_trace_jump(DisasContextBase *db, vaddr next, vaddr dest)
+{
+    if (!(tb_cflags(db->tb) & CF_TRACE) || db->plugin_enabled ||
+        db->trace_jumps >= TRACE_MAX_JUMPS ||
+        db->num_insns >= db->max_insns || tcg_op_buf_full()) {
+        return false;
+    }
+
+    /*
+     * Stay within the code that the TB covers for invalidation: the
+     * first page, from the start of the TB onwards.
+     */
+    if (dest < db->pc_first || !translator_is_same_page(db, dest) ||
+        !translator_is_same_page(db, next - 1)) {
+        return false;
+    }
+
+    db->trace_jumps++;
+    db->trace_end = MAX(db->trace_end, next);
+    return true;
 }
 
 void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
@@ -142,6 +199,8 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
     db->host_addr[1] = NULL;
     db->record_start = 0;
     db->record_len = 0;
+    db->trace_jumps = 0;
+    db->trace_end = pc;
 
     ops->init_disas_context(db, cpu);
     tcg_debug_assert(db->is_jmp == DISAS_NEXT);  /* no early exit */
@@ -221,7 +280,7 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
     tcg_ctx->emit_before_op = NULL;
 
     /* May be used by disas_log or plugin callbacks. */
-    tb->size = db->pc_next - db->pc_first;
+    tb->size = MAX(db->pc_next, db->trace_end) - db->pc_first;
     tb->icount = db->num_insns;
 
     if (plugin_enabled) {
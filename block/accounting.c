@@ -26,6 +26,7 @@
 #include "qemu/osdep.h"
 #include "block/accounting.h"
 #include "block/block_int.h"
+#include "qemu/host-utils.h"
 #include "qemu/timer.h"
 #include "system/qtest.h"
 
@@ -110,6 +111,86 @@ void block_acct_start(BlockAcctStats *stats, BlockAcctCookie *cookie,
     cookie->bytes = bytes;
     cookie->start_time_ns = qemu_clock_get_ns(clock_type);
     cookie->type = type;
+
+    if (type != BLOCK_ACCT_NONE) {
+        unsigned depth = qatomic_fetch_inc(&stats->inflight) + 1;
+        unsigned peak = qatomic_read(&stats->inflight_peak);
+
+        while (depth > peak) {
+            unsigned old = qatomic_cmpxchg(&stats->inflight_peak, peak, depth);
+            if (old == peak) {
+                break;
+            }
+            peak = old;
+        }
+    }
+}
+
+static unsigned block_latency_log_index(uint64_t latency_ns)
+{
+    int shift;
+
+    if (latency_ns < (1 << BLOCK_LATENCY_LOG_SUB_BITS)) {
+        return latency_ns;
+    }
+
+    latency_ns = MIN(latency_ns, (1ULL << BLOCK_LATENCY_LOG_MAX_BITS) - 1);
+    shift = 63 - clz64(latency_ns) - BLOCK_LATENCY_LOG_SUB_BITS;
+
+    return ((shift + 1) << BLOCK_LATENCY_LOG_SUB_BITS) +
+        (latency_ns >> shift) - (1 << BLOCK_LATENCY_LOG_SUB_BITS);
+}
+
+/* Returns the highest latency that falls into bucket @index */
+static uint64_t block_latency_log_bucket_max(unsigned index)
+{
+    unsigned group = index >> BLOCK_LATENCY_LOG_SUB_BITS;
+    uint64_t sub = index & ((1 << BLOCK_LATENCY_LOG_SUB_BITS) - 1);
+    int shift;
+
+    if (group == 0) {
+        return sub;
+    }
+
+    shift = group - 1;
+    return (((1ULL << BLOCK_LATENCY_LOG_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+static void block_latency_log_histogram_account(BlockLatencyLogHistogram *hist,
+                                                int64_t latency_ns)
+{
+    uint64_t ns = MAX(latency_ns, 0);
+
+    hist->buckets[block_latency_log_index(ns)]++;
+    hist->count++;
+    hist->max = MAX(hist->max, ns);
+}
+
+/*
+ * Return the latency below which @ppm parts per million of the requests
+ * completed, rounded up to the end of its histogram bucket.  The result
+ * never exceeds the highest latency actually seen.
+ */
+uint64_t block_latency_log_histogram_percentile(BlockLatencyLogHistogram *hist,
+                                                uint32_t ppm)
+{
+    uint64_t target, sum = 0;
+    unsigned i;
+
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    assert(ppm <= 1000000);
+    target = MAX(DIV_ROUND_UP(hist->count * ppm, 1000000), 1);
+    for (i = 0; i < BLOCK_LATENCY_LOG_BUCKETS; i++) {
+        sum += hist->buckets[i];
+        if (sum >= target) {
+            return MIN(block_latency_log_bucket_max(i), hist->max);
+        }
+    }
+
+    return hist->max;
 }
 
 /* block_latency_histogram_compare_func:
@@ -200,6 +281,34 @@ void block_latency_histograms_clear(BlockAcctStats *stats)
     }
 }
 
+/*
+ * Move the peak queue depth of the seconds that have passed since the last
+ * call into the history.  Seconds without any completion get the current
+ * depth.  Called with stats->lock held.
+ */
+static void block_acct_depth_sample(BlockAcctStats *stats, int64_t now_ns)
+{
+    int64_t sec = now_ns / NANOSECONDS_PER_SECOND;
+    unsigned inflight = qatomic_read(&stats->inflight);
+    unsigned peak;
+    int64_t i;
+
+    if (sec == stats->depth_history_sec) {
+        return;
+    }
+
+    peak = qatomic_xchg(&stats->inflight_peak, inflight);
+    stats->depth_history[stats->depth_history_sec %
+                         BLOCK_ACCT_DEPTH_HISTORY] = peak;
+    stats->inflight_max = MAX(stats->inflight_max, peak);
+
+    for (i = MAX(stats->depth_history_sec + 1, sec - BLOCK_ACCT_DEPTH_HISTORY);
+         i < sec; i++) {
+        stats->depth_history[i % BLOCK_ACCT_DEPTH_HISTORY] = inflight;
+    }
+    stats->depth_history_sec = sec;
+}
+
 static void block_account_one_io(BlockAcctStats *stats, BlockAcctCookie *cookie,
                                  bool failed)
 {
@@ -227,6 +336,12 @@ static void block_account_one_io(BlockAcctStats *stats, BlockAcctCookie *cookie,
 
         block_latency_histogram_account(&stats->latency_histogram[cookie->type],
                                         latency_ns);
+        if (!failed) {
+            block_latency_log_histogram_account(
+                &stats->latency_log_histogram[cookie->type], latency_ns);
+        }
+        block_acct_depth_sample(stats, time_ns);
+        qatomic_dec(&stats->inflight);
 
         if (!failed || stats->account_failed) {
             stats->total_time_ns[cookie->type] += latency_ns;
@@ -251,6 +366,23 @@ void block_acct_failed(BlockAcctStats *stats, BlockAcctCookie *cookie)
     block_account_one_io(stats, cookie, true);
 }
 
+void block_acct_cancel(BlockAcctStats *stats, BlockAcctCookie *cookie)
+{
+    assert(cookie->type < BLOCK_MAX_IOTYPE);
+
+    if (cookie->type == BLOCK_ACCT_NONE) {
+        return;
+    }
+
+    /*
+     * The request is not going to complete with this cookie, e.g. it was
+     * canceled or is going to be restarted later.  Only drop it from the
+     * in-flight count so that the queue depth does not leak.
+     */
+    qatomic_dec(&stats->inflight);
+    cookie->type = BLOCK_ACCT_NONE;
+}
+
 void block_acct_invalid(BlockAcctStats *stats, enum BlockAcctType type)
 {
     assert(type < BLOCK_MAX_IOTYPE);
@@ -296,3 +428,31 @@ double block_acct_queue_depth(BlockAcctTimedStats *stats,
 
     return (double) sum / elapsed;
 }
+
+/*
+ * Return the number of requests currently in flight, the highest number
+ * ever seen and the peak of each of the last BLOCK_ACCT_DEPTH_HISTORY
+ * seconds, oldest first.  The last entry is the second in progress.
+ */
+void block_acct_queue_depth_history(BlockAcctStats *stats, unsigned *current,
+                                    unsigned *max,
+                                    unsigned history[BLOCK_ACCT_DEPTH_HISTORY])
+{
+    int64_t sec;
+    unsigned i;
+
+    qemu_mutex_lock(&stats->lock);
+    block_acct_depth_sample(stats, qemu_clock_get_ns(clock_type));
+    sec = stats->depth_history_sec;
+
+    for (i = 0; i < BLOCK_ACCT_DEPTH_HISTORY - 1; i++) {
+        int64_t s = sec - (BLOCK_ACCT_DEPTH_HISTORY - 1) + i;
+        history[i] = s < 0 ? 0 :
+            stats->depth_history[s % BLOCK_ACCT_DEPTH_HISTORY];
+    }
+    history[i] = qatomic_read(&stats->inflight_peak);
+
+    *current = qatomic_read(&stats->inflight);
+    *max = MAX(stats->inflight_max, history[i]);
+    qemu_mutex_unlock(&stats->lock);
+}
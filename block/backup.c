@@ -156,7 +156,7 @@ static int coroutine_fn backup_loop(BackupBlockJob *job)
         job->bg_bcs_call = s = block_copy_async(job->bcs, 0,
                 QEMU_ALIGN_UP(job->len, job->cluster_size),
                 job->perf.max_workers, job->perf.max_chunk,
-                backup_block_copy_callback, job);
+                job->perf.adaptive, backup_block_copy_callback, job);
 
         while (!block_copy_call_finished(s) &&
                !job_is_cancelled(&job->common.job))
@@ -336,6 +336,15 @@ static bool backup_cancel(Job *job, bool force)
     return true;
 }
 
+static void backup_query(BlockJob *job, BlockJobInfo *info)
+{
+    BackupBlockJob *s = container_of(job, BackupBlockJob, common);
+
+    info->u.backup = (BlockJobInfoBackup) {
+        .tuning = s->perf.adaptive ? block_copy_get_tuning(s->bcs) : NULL,
+    };
+}
+
 static const BlockJobDriver backup_job_driver = {
     .job_driver = {
         .instance_size          = sizeof(BackupBlockJob),
@@ -350,6 +359,7 @@ static const BlockJobDriver backup_job_driver = {
         .cancel                 = backup_cancel,
     },
     .set_speed = backup_set_speed,
+    .query = backup_query,
 };
 
 BlockJob *backup_job_create(const char *job_id, BlockDriverState *bs,
@@ -25,6 +25,7 @@
 #include "qemu/co-shared-resource.h"
 #include "qemu/coroutine.h"
 #include "qemu/ratelimit.h"
+#include "qemu/stats64.h"
 #include "block/aio_task.h"
 #include "qemu/error-report.h"
 #include "qemu/memalign.h"
@@ -36,6 +37,12 @@
 #define BLOCK_COPY_SLICE_TIME 100000000ULL /* ns */
 #define BLOCK_COPY_CLUSTER_SIZE_DEFAULT (1 << 16)
 
+/* Adaptive tuning: length of a measurement interval and starting point */
+#define BLOCK_COPY_TUNE_INTERVAL_NS 500000000LL
+#define BLOCK_COPY_TUNE_INITIAL_WORKERS 8
+/* Throughput changes below this percentage are considered noise */
+#define BLOCK_COPY_TUNE_THRESHOLD 5
+
 typedef enum {
     COPY_READ_WRITE_CLUSTER,
     COPY_READ_WRITE,
@@ -53,6 +60,7 @@ typedef struct BlockCopyCallState {
     int64_t bytes;
     int max_workers;
     int64_t max_chunk;
+    bool adaptive;
     bool ignore_ratelimit;
     BlockCopyAsyncCallbackFunc cb;
     void *cb_opaque;
@@ -98,6 +106,9 @@ typedef struct BlockCopyTask {
      */
     BlockCopyMethod method;
 
+    /* Realtime clock when the copy operation started, for adaptive tuning */
+    int64_t start_ns;
+
     /*
      * Generally, req is protected by lock in BlockCopyState, Still req.offset
      * is only set on task creation, so may be read concurrently after creation.
@@ -160,6 +171,26 @@ typedef struct BlockCopyState {
     ProgressMeter *progress;
     SharedResource *mem;
     RateLimit rate_limit;
+
+    /*
+     * Adaptive tuning of the background copying process, used by calls with
+     * @adaptive set.  Protected by lock; the fields reported to the user are
+     * written atomically so that block_copy_get_tuning() can read them
+     * without the lock.
+     */
+    bool tune_active;
+    int tune_workers;
+    int tune_chunk;
+    int64_t tune_max_chunk;
+    BlockCopyTuneAction tune_action;
+    int tune_throughput_change;
+    Stat64 tune_throughput;
+    Stat64 tune_latency_ns;
+    /* Statistics of the current measurement interval */
+    int64_t tune_interval_start_ns;
+    int64_t tune_interval_bytes;
+    int64_t tune_interval_latency_ns;
+    int tune_interval_tasks;
 } BlockCopyState;
 
 /* Called with lock held */
@@ -181,6 +212,157 @@ static int64_t block_copy_chunk_size(BlockCopyState *s)
     }
 }
 
+/*
+ * Start adaptive tuning for a block-copy call, with limits given by the call.
+ * Called with lock held.
+ */
+static void block_copy_tune_start(BlockCopyState *s,
+                                  BlockCopyCallState *call_state)
+{
+    int64_t max_chunk = MIN_NON_ZERO(call_state->max_chunk,
+                                     MIN(BLOCK_COPY_MAX_COPY_RANGE,
+                                         s->max_transfer));
+
+    max_chunk = MAX(QEMU_ALIGN_DOWN(max_chunk, s->cluster_size),
+                    s->cluster_size);
+
+    qatomic_set(&s->tune_active, true);
+    s->tune_max_chunk = max_chunk;
+    qatomic_set(&s->tune_workers, MIN(call_state->max_workers,
+                                      BLOCK_COPY_TUNE_INITIAL_WORKERS));
+    qatomic_set(&s->tune_chunk, MIN(block_copy_chunk_size(s), max_chunk));
+    qatomic_set(&s->tune_action, BLOCK_COPY_TUNE_ACTION_HOLD);
+    qatomic_set(&s->tune_throughput_change, 0);
+    stat64_set(&s->tune_throughput, 0);
+    stat64_set(&s->tune_latency_ns, 0);
+    s->tune_interval_start_ns = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    s->tune_interval_bytes = 0;
+    s->tune_interval_latency_ns = 0;
+    s->tune_interval_tasks = 0;
+}
+
+/*
+ * Apply @action to the tuning parameters of @s.  Returns the action that
+ * was actually taken, which is BLOCK_COPY_TUNE_ACTION_HOLD if a limit has
+ * been reached.  Called with lock held.
+ */
+static BlockCopyTuneAction block_copy_tune_apply(BlockCopyState *s,
+                                                 BlockCopyTuneAction action,
+                                                 int max_workers)
+{
+    int workers = s->tune_workers;
+    int chunk = s->tune_chunk;
+
+    switch (action) {
+    case BLOCK_COPY_TUNE_ACTION_GROW_WORKERS:
+        workers = MIN(workers * 2, max_workers);
+        break;
+    case BLOCK_COPY_TUNE_ACTION_SHRINK_WORKERS:
+        workers = MAX(workers / 2, 1);
+        break;
+    case BLOCK_COPY_TUNE_ACTION_GROW_CHUNK:
+        chunk = MIN(chunk * 2, s->tune_max_chunk);
+        break;
+    case BLOCK_COPY_TUNE_ACTION_SHRINK_CHUNK:
+        chunk = MAX(QEMU_ALIGN_DOWN(chunk / 2, s->cluster_size),
+                    s->cluster_size);
+        break;
+    default:
+        break;
+    }
+
+    if (workers == s->tune_workers && chunk == s->tune_chunk) {
+        return BLOCK_COPY_TUNE_ACTION_HOLD;
+    }
+
+    qatomic_set(&s->tune_workers, workers);
+    qatomic_set(&s->tune_chunk, chunk);
+    return action;
+}
+
+static BlockCopyTuneAction block_copy_tune_reverse(BlockCopyTuneAction action)
+{
+    switch (action) {
+    case BLOCK_COPY_TUNE_ACTION_GROW_WORKERS:
+        return BLOCK_COPY_TUNE_ACTION_SHRINK_WORKERS;
+    case BLOCK_COPY_TUNE_ACTION_SHRINK_WORKERS:
+        return BLOCK_COPY_TUNE_ACTION_GROW_WORKERS;
+    case BLOCK_COPY_TUNE_ACTION_GROW_CHUNK:
+        return BLOCK_COPY_TUNE_ACTION_SHRINK_CHUNK;
+    case BLOCK_COPY_TUNE_ACTION_SHRINK_CHUNK:
+        return BLOCK_COPY_TUNE_ACTION_GROW_CHUNK;
+    default:
+        /* Throughput dropped without us changing anything: back off */
+        return BLOCK_COPY_TUNE_ACTION_SHRINK_CHUNK;
+    }
+}
+
+/*
+ * Account a finished copy task and, at the end of each measurement interval,
+ * adjust the number of workers and the chunk size by hill climbing on the
+ * observed throughput: keep going in the same direction while throughput
+ * improves, go back when it drops, and hold when it does not change.
+ *
+ * Called with lock held.
+ */
+static void block_copy_tune_update(BlockCopyState *s, BlockCopyTask *task)
+{
+    int64_t now = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    int64_t elapsed = now - s->tune_interval_start_ns;
+    BlockCopyTuneAction action = s->tune_action;
+    uint64_t throughput, prev_throughput = stat64_get(&s->tune_throughput);
+    uint64_t latency_ns;
+    int change;
+
+    s->tune_interval_bytes += task->req.bytes;
+    s->tune_interval_latency_ns += now - task->start_ns;
+    s->tune_interval_tasks++;
+
+    if (elapsed < BLOCK_COPY_TUNE_INTERVAL_NS ||
+        s->tune_interval_tasks < s->tune_workers) {
+        return;
+    }
+
+    throughput = s->tune_interval_bytes * NANOSECONDS_PER_SECOND / elapsed;
+    latency_ns = s->tune_interval_latency_ns / s->tune_interval_tasks;
+    stat64_set(&s->tune_throughput, throughput);
+    stat64_set(&s->tune_latency_ns, latency_ns);
+
+    if (prev_throughput == 0 ||
+        throughput * 100 >
+        prev_throughput * (100 + BLOCK_COPY_TUNE_THRESHOLD)) {
+        change = 1;
+        if (action == BLOCK_COPY_TUNE_ACTION_HOLD) {
+            action = BLOCK_COPY_TUNE_ACTION_GROW_WORKERS;
+        }
+    } else if (throughput * 100 <
+               prev_throughput * (100 - BLOCK_COPY_TUNE_THRESHOLD)) {
+        change = -1;
+        action = block_copy_tune_reverse(action);
+    } else {
+        change = 0;
+        action = BLOCK_COPY_TUNE_ACTION_HOLD;
+    }
+
+    action = block_copy_tune_apply(s, action, task->call_state->max_workers);
+    if (action == BLOCK_COPY_TUNE_ACTION_HOLD && change > 0) {
+        /* Reached the worker limit while improving, try larger requests */
+        action = block_copy_tune_apply(s, BLOCK_COPY_TUNE_ACTION_GROW_CHUNK,
+                                       task->call_state->max_workers);
+    }
+
+    qatomic_set(&s->tune_action, action);
+    qatomic_set(&s->tune_throughput_change, change);
+    trace_block_copy_tune(s, throughput, latency_ns, change,
+                          BlockCopyTuneAction_str(action),
+                          s->tune_workers, s->tune_chunk);
+
+    s->tune_interval_start_ns = now;
+    s->tune_interval_bytes = 0;
+    s->tune_interval_latency_ns = 0;
+    s->tune_interval_tasks = 0;
+}
+
 /*
  * Search for the first dirty area in offset/bytes range and create task at
  * the beginning of it.
@@ -193,7 +375,16 @@ block_copy_task_create(BlockCopyState *s, BlockCopyCallState *call_state,
     int64_t max_chunk;
 
     QEMU_LOCK_GUARD(&s->lock);
-    max_chunk = MIN_NON_ZERO(block_copy_chunk_size(s), call_state->max_chunk);
+    if (call_state->adaptive && s->method != COPY_READ_WRITE_CLUSTER) {
+        max_chunk = s->tune_chunk;
+        if (s->method == COPY_READ_WRITE) {
+            /* Don't allocate bounce buffers above BLOCK_COPY_MAX_BUFFER */
+            max_chunk = MIN(max_chunk, block_copy_chunk_size(s));
+        }
+    } else {
+        max_chunk = MIN_NON_ZERO(block_copy_chunk_size(s),
+                                 call_state->max_chunk);
+    }
     if (!bdrv_dirty_bitmap_next_dirty_area(s->copy_bitmap,
                                            offset, offset + bytes,
                                            max_chunk, &offset, &bytes))
@@ -586,6 +777,7 @@ static coroutine_fn int block_copy_task_entry(AioTask *task)
     BlockCopyMethod method = t->method;
     int ret = -1;
 
+    t->start_ns = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
     WITH_GRAPH_RDLOCK_GUARD() {
         ret = block_copy_do_copy(s, t->req.offset, t->req.bytes, &method,
                                  &error_is_read);
@@ -596,6 +788,12 @@ static coroutine_fn int block_copy_task_entry(AioTask *task)
             s->method = method;
         }
 
+        /* Zero writes would skew the measured throughput */
+        if (ret == 0 && t->call_state->adaptive &&
+            t->method != COPY_WRITE_ZEROES) {
+            block_copy_tune_update(s, t);
+        }
+
         if (ret < 0) {
             if (!t->call_state->ret) {
                 t->call_state->ret = ret;
@@ -824,6 +1022,10 @@ block_copy_dirty_clusters(BlockCopyCallState *call_state)
         if (!aio && bytes) {
             aio = aio_task_pool_new(call_state->max_workers);
         }
+        if (aio && call_state->adaptive) {
+            aio_task_pool_set_max_busy_tasks(aio,
+                                             qatomic_read(&s->tune_workers));
+        }
 
         ret = block_copy_task_run(aio, task);
         if (ret < 0) {
@@ -874,6 +1076,9 @@ block_copy_common(BlockCopyCallState *call_state)
 
     qemu_co_mutex_lock(&s->lock);
     QLIST_INSERT_HEAD(&s->calls, call_state, list);
+    if (call_state->adaptive && !s->tune_active) {
+        block_copy_tune_start(s, call_state);
+    }
     qemu_co_mutex_unlock(&s->lock);
 
     do {
@@ -972,6 +1177,7 @@ int coroutine_fn block_copy(BlockCopyState *s, int64_t start, int64_t bytes,
 BlockCopyCallState *block_copy_async(BlockCopyState *s,
                                      int64_t offset, int64_t bytes,
                                      int max_workers, int64_t max_chunk,
+                                     bool adaptive,
                                      BlockCopyAsyncCallbackFunc cb,
                                      void *cb_opaque)
 {
@@ -983,6 +1189,7 @@ BlockCopyCallState *block_copy_async(BlockCopyState *s,
         .bytes = bytes,
         .max_workers = max_workers,
         .max_chunk = max_chunk,
+        .adaptive = adaptive,
         .cb = cb,
         .cb_opaque = cb_opaque,
 
@@ -1057,6 +1264,26 @@ int64_t block_copy_cluster_size(BlockCopyState *s)
     return s->cluster_size;
 }
 
+BlockCopyTuning *block_copy_get_tuning(BlockCopyState *s)
+{
+    BlockCopyTuning *info;
+
+    if (!qatomic_read(&s->tune_active)) {
+        return NULL;
+    }
+
+    info = g_new(BlockCopyTuning, 1);
+    *info = (BlockCopyTuning) {
+        .workers = qatomic_read(&s->tune_workers),
+        .chunk_size = qatomic_read(&s->tune_chunk),
+        .throughput = stat64_get(&s->tune_throughput),
+        .latency_ns = stat64_get(&s->tune_latency_ns),
+        .last_action = qatomic_read(&s->tune_action),
+        .throughput_change = qatomic_read(&s->tune_throughput_change),
+    };
+    return info;
+}
+
 void block_copy_set_skip_unallocated(BlockCopyState *s, bool skip)
 {
     qatomic_set(&s->skip_unallocated, skip);
@@ -23,17 +23,218 @@
 #include "qemu/osdep.h"
 #include "block/block-io.h"
 #include "block/block_int.h"
+#include "qemu/bitmap.h"
+#include "qemu/cutils.h"
+#include "qemu/error-report.h"
+#include "qemu/lockable.h"
 #include "qemu/module.h"
+#include "qemu/option.h"
 #include "qapi/error.h"
 #include "qapi/qmp/qdict.h"
 #include "block/copy-on-read.h"
+#include "trace.h"
 
+#define COR_OPT_PREFETCH_HINTS      "prefetch-hints"
+#define COR_OPT_PREFETCH_READAHEAD  "prefetch-readahead"
+#define COR_OPT_PREFETCH_RECORD     "prefetch-record"
+
+/* Maximum number of bytes copied up by a single prefetch request */
+#define COR_PREFETCH_CHUNK          (512 * KiB)
+
+/* Granularity of the map of prefetched data that feeds the hit counter */
+#define COR_PREFETCH_GRANULARITY    (64 * KiB)
+
+/* Readahead ranges pending at the same time; the oldest one is dropped */
+#define COR_READAHEAD_QUEUE         16
+
+/* Maximum number of ranges kept for prefetch-record */
+#define COR_RECORD_MAX              (64 * 1024)
+
+typedef struct CorPrefetchRange {
+    int64_t offset;
+    int64_t bytes;
+} CorPrefetchRange;
 
 typedef struct BDRVStateCOR {
     BlockDriverState *bottom_bs;
     bool chain_frozen;
+
+    /*
+     * Set if any of the prefetch options is given.  Guest reads are then
+     * classified as served from prefetched data or fetched on demand from
+     * the backing chain.
+     */
+    bool track;
+    int64_t readahead;
+    char *record_path;
+
+    /* Protects all fields below */
+    QemuMutex lock;
+    bool prefetch_running;
+    GArray *hints;              /* CorPrefetchRange, consumed in order */
+    guint hint_idx;
+    CorPrefetchRange readahead_queue[COR_READAHEAD_QUEUE];
+    unsigned readahead_head;
+    unsigned readahead_count;
+    GArray *record;             /* CorPrefetchRange, in first access order */
+
+    /* Granules copied up by prefetching that the guest has not read yet */
+    unsigned long *prefetched;
+    int64_t prefetched_nbits;
+
+    uint64_t prefetch_bytes;
+    uint64_t prefetch_hits;
+    uint64_t demand_fetches;
 } BDRVStateCOR;
 
+static QemuOptsList cor_runtime_opts = {
+    .name = "copy-on-read",
+    .head = QTAILQ_HEAD_INITIALIZER(cor_runtime_opts.head),
+    .desc = {
+        {
+            .name = COR_OPT_PREFETCH_HINTS,
+            .type = QEMU_OPT_STRING,
+            .help = "File listing ranges to copy up ahead of the guest",
+        },
+        {
+            .name = COR_OPT_PREFETCH_READAHEAD,
+            .type = QEMU_OPT_SIZE,
+            .help = "Bytes to copy up after each read that misses the "
+                    "top image",
+        },
+        {
+            .name = COR_OPT_PREFETCH_RECORD,
+            .type = QEMU_OPT_STRING,
+            .help = "File to save the ranges read from the backing chain to",
+        },
+        { /* end of list */ }
+    },
+};
+
+/*
+ * Parse a prefetch hint file.  Each line holds the offset and the length of
+ * a range in bytes, separated by white space.  Empty lines and lines
+ * starting with '#' are ignored.  This is the format that prefetch-record
+ * writes.
+ */
+static GArray *cor_load_hints(const char *filename, Error **errp)
+{
+    g_autofree char *contents = NULL;
+    g_autoptr(GError) gerr = NULL;
+    g_auto(GStrv) lines = NULL;
+    GArray *hints;
+    int i;
+
+    if (!g_file_get_contents(filename, &contents, NULL, &gerr)) {
+        error_setg(errp, "Could not read prefetch hints: %s", gerr->message);
+        return NULL;
+    }
+
+    hints = g_array_new(false, false, sizeof(CorPrefetchRange));
+    lines = g_strsplit(contents, "\n", -1);
+    for (i = 0; lines[i]; i++) {
+        const char *p = g_strstrip(lines[i]);
+        uint64_t offset, bytes;
+        CorPrefetchRange r;
+
+        if (!*p || *p == '#') {
+            continue;
+        }
+
+        if (qemu_strtou64(p, &p, 0, &offset) < 0 ||
+            qemu_strtou64(p, &p, 0, &bytes) < 0 || *p ||
+            offset > INT64_MAX || bytes > INT64_MAX - offset)
+        {
+            error_setg(errp, "%s:%d: Expected '<offset> <length>'",
+                       filename, i + 1);
+            g_array_free(hints, true);
+            return NULL;
+        }
+
+        if (bytes) {
+            r = (CorPrefetchRange) { .offset = offset, .bytes = bytes };
+            g_array_append_val(hints, r);
+        }
+    }
+
+    return hints;
+}
+
+static void cor_save_record(BDRVStateCOR *s)
+{
+    g_autoptr(GString) out = g_string_new("# offset length\n");
+    g_autoptr(GError) gerr = NULL;
+    guint i;
+
+    for (i = 0; i < s->record->len; i++) {
+        CorPrefetchRange *r = &g_array_index(s->record, CorPrefetchRange, i);
+        g_string_append_printf(out, "%" PRId64 " %" PRId64 "\n",
+                               r->offset, r->bytes);
+    }
+
+    if (!g_file_set_contents(s->record_path, out->str, out->len, &gerr)) {
+        warn_report("Could not save prefetch record to '%s': %s",
+                    s->record_path, gerr->message);
+    }
+}
+
+static int cor_open_prefetch(BDRVStateCOR *s, QDict *options, Error **errp)
+{
+    QemuOpts *opts = qemu_opts_create(&cor_runtime_opts, NULL, 0,
+                                      &error_abort);
+    const char *hints;
+    int ret = 0;
+
+    qemu_mutex_init(&s->lock);
+
+    if (!qemu_opts_absorb_qdict(opts, options, errp)) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    hints = qemu_opt_get(opts, COR_OPT_PREFETCH_HINTS);
+    if (hints) {
+        s->hints = cor_load_hints(hints, errp);
+        if (!s->hints) {
+            ret = -EINVAL;
+            goto out;
+        }
+    }
+
+    s->readahead = qemu_opt_get_size(opts, COR_OPT_PREFETCH_READAHEAD, 0);
+    if (s->readahead > INT32_MAX) {
+        error_setg(errp, COR_OPT_PREFETCH_READAHEAD " must not exceed %d",
+                   INT32_MAX);
+        ret = -EINVAL;
+        goto out;
+    }
+
+    s->record_path = g_strdup(qemu_opt_get(opts, COR_OPT_PREFETCH_RECORD));
+    if (s->record_path) {
+        s->record = g_array_new(false, false, sizeof(CorPrefetchRange));
+    }
+
+    s->track = s->hints || s->readahead || s->record_path;
+
+out:
+    qemu_opts_del(opts);
+    return ret;
+}
+
+static void cor_close_prefetch(BDRVStateCOR *s)
+{
+    if (s->record) {
+        cor_save_record(s);
+        g_array_free(s->record, true);
+    }
+    if (s->hints) {
+        g_array_free(s->hints, true);
+    }
+    g_free(s->record_path);
+    g_free(s->prefetched);
+    qemu_mutex_destroy(&s->lock);
+}
+
 
 static int GRAPH_UNLOCKED
 cor_open(BlockDriverState *bs, QDict *options, int flags, Error **errp)
@@ -42,12 +243,20 @@ cor_open(BlockDriverState *bs, QDict *options, int flags, Error **errp)
     BDRVStateCOR *state = bs->opaque;
     /* Find a bottom node name, if any */
     const char *bottom_node = qdict_get_try_str(options, "bottom");
+    int64_t len;
     int ret;
 
     GLOBAL_STATE_CODE();
 
+    ret = cor_open_prefetch(state, options, errp);
+    if (ret < 0) {
+        cor_close_prefetch(state);
+        return ret;
+    }
+
     ret = bdrv_open_file_child(NULL, options, "file", bs, errp);
     if (ret < 0) {
+        cor_close_prefetch(state);
         return ret;
     }
 
@@ -67,22 +276,26 @@ cor_open(BlockDriverState *bs, QDict *options, int flags, Error **errp)
         if (!bottom_bs) {
             error_setg(errp, "Bottom node '%s' not found", bottom_node);
             qdict_del(options, "bottom");
-            return -EINVAL;
+            ret = -EINVAL;
+            goto fail;
         }
         qdict_del(options, "bottom");
 
         if (!bottom_bs->drv) {
             error_setg(errp, "Bottom node '%s' not opened", bottom_node);
-            return -EINVAL;
+            ret = -EINVAL;
+            goto fail;
         }
 
         if (bottom_bs->drv->is_filter) {
             error_setg(errp, "Bottom node '%s' is a filter", bottom_node);
-            return -EINVAL;
+            ret = -EINVAL;
+            goto fail;
         }
 
         if (bdrv_freeze_backing_chain(bs, bottom_bs, errp) < 0) {
-            return -EINVAL;
+            ret = -EINVAL;
+            goto fail;
         }
         state->chain_frozen = true;
 
@@ -94,12 +307,26 @@ cor_open(BlockDriverState *bs, QDict *options, int flags, Error **errp)
     }
     state->bottom_bs = bottom_bs;
 
+    /*
+     * The map of prefetched data only feeds the hit counter, so an image
+     * whose length cannot be determined just goes without.
+     */
+    len = bdrv_getlength(bs->file->bs);
+    if (state->track && len > 0) {
+        state->prefetched_nbits = DIV_ROUND_UP(len, COR_PREFETCH_GRANULARITY);
+        state->prefetched = bitmap_new(state->prefetched_nbits);
+    }
+
     /*
      * We don't need to call bdrv_child_refresh_perms() now as the permissions
      * will be updated later when the filter node gets its parent.
      */
 
     return 0;
+
+fail:
+    cor_close_prefetch(state);
+    return ret;
 }
 
 
@@ -131,6 +358,221 @@ static int64_t coroutine_fn GRAPH_RDLOCK cor_co_getlength(BlockDriverState *bs)
 }
 
 
+static bool cor_has_prefetch_work(BDRVStateCOR *s)
+{
+    return s->readahead_count || (s->hints && s->hint_idx < s->hints->len);
+}
+
+/*
+ * Take the next chunk to prefetch, readahead first as it follows what the
+ * guest is doing right now.  Clears prefetch_running if there is nothing
+ * left, so that a later guest read can restart prefetching.
+ */
+static bool cor_prefetch_next(BDRVStateCOR *s, CorPrefetchRange *chunk)
+{
+    CorPrefetchRange *r;
+    bool readahead;
+
+    QEMU_LOCK_GUARD(&s->lock);
+
+    if (!cor_has_prefetch_work(s)) {
+        s->prefetch_running = false;
+        return false;
+    }
+
+    readahead = s->readahead_count;
+    if (readahead) {
+        r = &s->readahead_queue[s->readahead_head];
+    } else {
+        r = &g_array_index(s->hints, CorPrefetchRange, s->hint_idx);
+    }
+
+    chunk->offset = r->offset;
+    chunk->bytes = MIN(r->bytes, COR_PREFETCH_CHUNK);
+    r->offset += chunk->bytes;
+    r->bytes -= chunk->bytes;
+
+    if (!r->bytes) {
+        if (readahead) {
+            s->readahead_head = (s->readahead_head + 1) % COR_READAHEAD_QUEUE;
+            s->readahead_count--;
+        } else {
+            s->hint_idx++;
+        }
+    }
+
+    return true;
+}
+
+static void cor_mark_prefetched(BDRVStateCOR *s, int64_t offset,
+                                int64_t bytes)
+{
+    int64_t start = offset / COR_PREFETCH_GRANULARITY;
+    int64_t end = DIV_ROUND_UP(offset + bytes, COR_PREFETCH_GRANULARITY);
+
+    QEMU_LOCK_GUARD(&s->lock);
+
+    s->prefetch_bytes += bytes;
+    end = MIN(end, s->prefetched_nbits);
+    if (start < end) {
+        bitmap_set(s->prefetched, start, end - start);
+    }
+}
+
+/*
+ * Returns true if some of the given range was copied up by prefetching and
+ * has not been read by the guest before.
+ */
+static bool cor_clear_prefetched(BDRVStateCOR *s, int64_t offset,
+                                 int64_t bytes)
+{
+    int64_t start = offset / COR_PREFETCH_GRANULARITY;
+    int64_t end = DIV_ROUND_UP(offset + bytes, COR_PREFETCH_GRANULARITY);
+
+    QEMU_LOCK_GUARD(&s->lock);
+
+    end = MIN(end, s->prefetched_nbits);
+    if (start >= end || find_next_bit(s->prefetched, end, start) >= end) {
+        return false;
+    }
+
+    bitmap_clear(s->prefetched, start, end - start);
+    return true;
+}
+
+static void cor_account_guest_read(BDRVStateCOR *s, int64_t offset,
+                                   int64_t bytes, bool hit, bool demand)
+{
+    QEMU_LOCK_GUARD(&s->lock);
+
+    if (hit) {
+        s->prefetch_hits++;
+    }
+    if (!demand) {
+        return;
+    }
+    s->demand_fetches++;
+
+    if (s->readahead) {
+        unsigned idx;
+
+        if (s->readahead_count == COR_READAHEAD_QUEUE) {
+            s->readahead_head = (s->readahead_head + 1) % COR_READAHEAD_QUEUE;
+            s->readahead_count--;
+        }
+        idx = (s->readahead_head + s->readahead_count) % COR_READAHEAD_QUEUE;
+        s->readahead_queue[idx] = (CorPrefetchRange) {
+            .offset = offset + bytes,
+            .bytes = s->readahead,
+        };
+        s->readahead_count++;
+    }
+
+    if (s->record) {
+        CorPrefetchRange *last = s->record->len ?
+            &g_array_index(s->record, CorPrefetchRange, s->record->len - 1) :
+            NULL;
+
+        if (last && last->offset + last->bytes == offset) {
+            last->bytes += bytes;
+        } else if (s->record->len < COR_RECORD_MAX) {
+            CorPrefetchRange r = { .offset = offset, .bytes = bytes };
+            g_array_append_val(s->record, r);
+        }
+    }
+}
+
+/* Copy up whatever of the given range is not allocated in the top image */
+static void coroutine_fn GRAPH_RDLOCK
+cor_prefetch_range(BlockDriverState *bs, int64_t offset, int64_t bytes)
+{
+    BDRVStateCOR *s = bs->opaque;
+    int64_t align = bs->bl.request_alignment;
+    int64_t end = QEMU_ALIGN_UP(offset + bytes, align);
+    int64_t n;
+    int ret;
+
+    offset = QEMU_ALIGN_DOWN(offset, align);
+    while (offset < end) {
+        ret = bdrv_co_is_allocated(bs->file->bs, offset, end - offset, &n);
+        if (ret < 0 || n == 0) {
+            return;
+        }
+
+        if (!ret) {
+            ret = bdrv_co_is_allocated_above(bdrv_backing_chain_next(bs->file->bs),
+                                             s->bottom_bs, s->bottom_bs != NULL,
+                                             offset, n, &n);
+            if (ret < 0 || n == 0) {
+                return;
+            }
+            if (ret) {
+                trace_cor_prefetch(bs, offset, n);
+                ret = bdrv_co_preadv(bs->file, offset, n, NULL,
+                                     BDRV_REQ_PREFETCH | BDRV_REQ_COPY_ON_READ);
+                if (ret < 0) {
+                    return;
+                }
+                cor_mark_prefetched(s, offset, n);
+            }
+        }
+
+        offset += n;
+    }
+}
+
+/*
+ * Prefetching runs one chunk at a time and stops as soon as the node gets
+ * drained, leaving the rest of the work queued for the next guest read.
+ * The node is kept busy from cor_prefetch_kick() until the coroutine
+ * returns, so a drain waits for the current chunk and no chunk is started
+ * inside a drained section.
+ */
+static void coroutine_fn cor_prefetch_entry(void *opaque)
+{
+    BlockDriverState *bs = opaque;
+    BDRVStateCOR *s = bs->opaque;
+    CorPrefetchRange chunk;
+
+    for (;;) {
+        if (qatomic_read(&bs->quiesce_counter)) {
+            WITH_QEMU_LOCK_GUARD(&s->lock) {
+                s->prefetch_running = false;
+            }
+            break;
+        }
+
+        if (!cor_prefetch_next(s, &chunk)) {
+            break;
+        }
+
+        WITH_GRAPH_RDLOCK_GUARD() {
+            cor_prefetch_range(bs, chunk.offset, chunk.bytes);
+        }
+    }
+
+    /* Paired with the increment in cor_prefetch_kick() */
+    bdrv_dec_in_flight(bs);
+}
+
+static void cor_prefetch_kick(BlockDriverState *bs)
+{
+    BDRVStateCOR *s = bs->opaque;
+    Coroutine *co;
+
+    WITH_QEMU_LOCK_GUARD(&s->lock) {
+        if (s->prefetch_running || !cor_has_prefetch_work(s)) {
+            return;
+        }
+        s->prefetch_running = true;
+    }
+
+    bdrv_inc_in_flight(bs);
+    co = qemu_coroutine_create(cor_prefetch_entry, bs);
+    aio_co_enter(bdrv_get_aio_context(bs), co);
+}
+
+
 static int coroutine_fn GRAPH_RDLOCK
 cor_co_preadv_part(BlockDriverState *bs, int64_t offset, int64_t bytes,
                    QEMUIOVector *qiov, size_t qiov_offset,
@@ -140,8 +582,12 @@ cor_co_preadv_part(BlockDriverState *bs, int64_t offset, int64_t bytes,
     int local_flags;
     int ret;
     BDRVStateCOR *state = bs->opaque;
+    /* Requests with BDRV_REQ_PREFETCH come from jobs, not from the guest */
+    bool track = state->track && !(flags & BDRV_REQ_PREFETCH);
+    int64_t req_offset = offset, req_bytes = bytes;
+    bool hit = false, demand = false;
 
-    if (!state->bottom_bs) {
+    if (!state->bottom_bs && !track) {
         return bdrv_co_preadv_part(bs->file, offset, bytes, qiov, qiov_offset,
                                    flags | BDRV_REQ_COPY_ON_READ);
     }
@@ -153,15 +599,19 @@ cor_co_preadv_part(BlockDriverState *bs, int64_t offset, int64_t bytes,
         ret = bdrv_co_is_allocated(bs->file->bs, offset, bytes, &n);
         if (ret <= 0) {
             ret = bdrv_co_is_allocated_above(bdrv_backing_chain_next(bs->file->bs),
-                                             state->bottom_bs, true, offset,
-                                             n, &n);
+                                             state->bottom_bs,
+                                             state->bottom_bs != NULL,
+                                             offset, n, &n);
             if (ret > 0 || ret < 0) {
                 local_flags |= BDRV_REQ_COPY_ON_READ;
+                demand = true;
             }
             /* Finish earlier if the end of a backing file has been reached */
             if (n == 0) {
                 break;
             }
+        } else if (track && state->prefetched) {
+            hit |= cor_clear_prefetched(state, offset, n);
         }
 
         /* Skip if neither read nor write are needed */
@@ -179,6 +629,13 @@ cor_co_preadv_part(BlockDriverState *bs, int64_t offset, int64_t bytes,
         bytes -= n;
     }
 
+    if (state->track) {
+        if (track) {
+            cor_account_guest_read(state, req_offset, req_bytes, hit, demand);
+        }
+        cor_prefetch_kick(bs);
+    }
+
     return 0;
 }
 
@@ -245,6 +702,31 @@ static void GRAPH_UNLOCKED cor_close(BlockDriverState *bs)
     }
 
     bdrv_unref(s->bottom_bs);
+    cor_close_prefetch(s);
+}
+
+
+static BlockStatsSpecific *cor_get_specific_stats(BlockDriverState *bs)
+{
+    BDRVStateCOR *s = bs->opaque;
+    BlockStatsSpecific *stats;
+
+    if (!s->track) {
+        return NULL;
+    }
+
+    stats = g_new(BlockStatsSpecific, 1);
+    stats->driver = BLOCKDEV_DRIVER_COPY_ON_READ;
+
+    WITH_QEMU_LOCK_GUARD(&s->lock) {
+        stats->u.copy_on_read = (BlockStatsSpecificCopyOnRead) {
+            .prefetch_bytes = s->prefetch_bytes,
+            .prefetch_hits = s->prefetch_hits,
+            .demand_fetches = s->demand_fetches,
+        };
+    }
+
+    return stats;
 }
 
 
@@ -267,6 +749,8 @@ static BlockDriver bdrv_copy_on_read = {
     .bdrv_co_eject                      = cor_co_eject,
     .bdrv_co_lock_medium                = cor_co_lock_medium,
 
+    .bdrv_get_specific_stats            = cor_get_specific_stats,
+
     .is_filter                          = true,
 };
 
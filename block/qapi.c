@@ -491,11 +491,52 @@ bdrv_latency_histogram_stats(BlockLatencyHistogram *hist)
     return info;
 }
 
+static BlockLatencyPercentiles *
+bdrv_latency_percentiles(BlockLatencyLogHistogram *hist)
+{
+    BlockLatencyPercentiles *info;
+
+    if (!hist->count) {
+        return NULL;
+    }
+
+    info = g_new0(BlockLatencyPercentiles, 1);
+    info->count = hist->count;
+    info->p50 = block_latency_log_histogram_percentile(hist, 500000);
+    info->p90 = block_latency_log_histogram_percentile(hist, 900000);
+    info->p99 = block_latency_log_histogram_percentile(hist, 990000);
+    info->p999 = block_latency_log_histogram_percentile(hist, 999000);
+    info->max = hist->max;
+    return info;
+}
+
+static BlockQueueDepthInfo *bdrv_queue_depth_info(BlockAcctStats *stats)
+{
+    unsigned history[BLOCK_ACCT_DEPTH_HISTORY];
+    BlockQueueDepthInfo *info;
+    unsigned current, max;
+    int i;
+
+    block_acct_queue_depth_history(stats, &current, &max, history);
+    if (!max) {
+        return NULL;
+    }
+
+    info = g_new0(BlockQueueDepthInfo, 1);
+    info->current = current;
+    info->max = max;
+    for (i = BLOCK_ACCT_DEPTH_HISTORY - 1; i >= 0; i--) {
+        QAPI_LIST_PREPEND(info->history, history[i]);
+    }
+    return info;
+}
+
 static void bdrv_query_blk_stats(BlockDeviceStats *ds, BlockBackend *blk)
 {
     BlockAcctStats *stats = blk_get_stats(blk);
     BlockAcctTimedStats *ts = NULL;
     BlockLatencyHistogram *hgram;
+    BlockLatencyLogHistogram *lhist;
 
     ds->rd_bytes = stats->nr_bytes[BLOCK_ACCT_READ];
     ds->wr_bytes = stats->nr_bytes[BLOCK_ACCT_WRITE];
@@ -586,6 +627,17 @@ static void bdrv_query_blk_stats(BlockDeviceStats *ds, BlockBackend *blk)
         = bdrv_latency_histogram_stats(&hgram[BLOCK_ACCT_ZONE_APPEND]);
     ds->flush_latency_histogram
         = bdrv_latency_histogram_stats(&hgram[BLOCK_ACCT_FLUSH]);
+
+    lhist = stats->latency_log_histogram;
+    ds->rd_latency_percentiles
+        = bdrv_latency_percentiles(&lhist[BLOCK_ACCT_READ]);
+    ds->wr_latency_percentiles
+        = bdrv_latency_percentiles(&lhist[BLOCK_ACCT_WRITE]);
+    ds->zone_append_latency_percentiles
+        = bdrv_latency_percentiles(&lhist[BLOCK_ACCT_ZONE_APPEND]);
+    ds->flush_latency_percentiles
+        = bdrv_latency_percentiles(&lhist[BLOCK_ACCT_FLUSH]);
+    ds->queue_depth = bdrv_queue_depth_info(stats);
 }
 
 static BlockStats * GRAPH_RDLOCK
@@ -300,6 +300,7 @@ void qcow2_cache_depends_on_flush(Qcow2Cache *c)
 
 int qcow2_cache_empty(BlockDriverState *bs, Qcow2Cache *c)
 {
+    BDRVQcow2State *s = bs->opaque;
     int ret, i;
 
     ret = qcow2_cache_flush(bs, c);
@@ -307,6 +308,10 @@ int qcow2_cache_empty(BlockDriverState *bs, Qcow2Cache *c)
         return ret;
     }
 
+    if (c == s->l2_table_cache) {
+        qcow2_fast_map_invalidate(s);
+    }
+
     for (i = 0; i < c->size; i++) {
         assert(c->entries[i].ref == 0);
         c->entries[i].offset = 0;
@@ -347,6 +347,7 @@ static int GRAPH_RDLOCK l2_allocate(BlockDriverState *bs, int l1_index)
 
         trace_qcow2_l2_allocate_write_l2(bs, l1_index);
         qcow2_cache_entry_mark_dirty(s->l2_table_cache, l2_slice);
+        qcow2_fast_map_invalidate(s);
         qcow2_cache_put(s->l2_table_cache, (void **) &l2_slice);
     }
 
@@ -742,6 +743,115 @@ fail:
     return ret;
 }
 
+/*
+ * qcow2_fast_map_lookup
+ *
+ * Try to translate a guest offset into a host offset using only the
+ * lock-free translation cache.  This does not require s->lock, so it can
+ * be called concurrently from any number of threads.
+ *
+ * On a hit, returns true and stores the host offset in *host_offset; *bytes
+ * is reduced to the number of bytes that are contiguous in the host file and
+ * known to be QCOW2_SUBCLUSTER_NORMAL.  On a miss, returns false and the
+ * caller must fall back to qcow2_get_host_offset() under s->lock.
+ */
+bool qcow2_fast_map_lookup(BDRVQcow2State *s, uint64_t offset,
+                           unsigned int *bytes, uint64_t *host_offset)
+{
+    uint64_t guest_cluster = offset >> s->cluster_bits;
+    unsigned int offset_in_cluster = offset_into_cluster(s, offset);
+    uint64_t bytes_needed = (uint64_t) *bytes + offset_in_cluster;
+    uint64_t bytes_available, host_cluster_offset;
+    unsigned int seq;
+
+    do {
+        uint64_t gen;
+
+        seq = seqlock_read_begin(&s->fast_map_seqlock);
+        gen = s->fast_map_gen;
+        bytes_available = 0;
+        host_cluster_offset = 0;
+
+        while (bytes_available < bytes_needed) {
+            uint64_t idx = guest_cluster + (bytes_available >> s->cluster_bits);
+            Qcow2FastMapEntry e = s->fast_map[idx % QCOW2_FAST_MAP_SIZE];
+
+            if (e.gen != gen || e.guest_cluster != idx) {
+                break;
+            }
+            if (bytes_available == 0) {
+                host_cluster_offset = e.host_offset;
+            } else if (e.host_offset != host_cluster_offset + bytes_available) {
+                break;
+            }
+            bytes_available += s->cluster_size;
+        }
+    } while (seqlock_read_retry(&s->fast_map_seqlock, seq));
+
+    if (bytes_available == 0) {
+        return false;
+    }
+
+    if (bytes_available > bytes_needed) {
+        bytes_available = bytes_needed;
+    }
+    *bytes = bytes_available - offset_in_cluster;
+    *host_offset = host_cluster_offset + offset_in_cluster;
+    return true;
+}
+
+/*
+ * qcow2_fast_map_insert
+ *
+ * Record the result of a qcow2_get_host_offset() call that returned
+ * QCOW2_SUBCLUSTER_NORMAL in the lock-free translation cache.  @offset,
+ * @bytes and @host_offset are the values passed to and returned by
+ * qcow2_get_host_offset().
+ *
+ * Must be called with s->lock held.
+ */
+void qcow2_fast_map_insert(BDRVQcow2State *s, uint64_t offset,
+                           unsigned int bytes, uint64_t host_offset)
+{
+    unsigned int offset_in_cluster = offset_into_cluster(s, offset);
+    uint64_t guest_cluster = offset >> s->cluster_bits;
+    uint64_t host_cluster_offset = host_offset - offset_in_cluster;
+    uint64_t nb_clusters = size_to_clusters(s, bytes + offset_in_cluster);
+    uint64_t i;
+
+    /* With subclusters the type of each subcluster would need tracking */
+    if (has_subclusters(s)) {
+        return;
+    }
+
+    nb_clusters = MIN(nb_clusters, QCOW2_FAST_MAP_SIZE);
+
+    seqlock_write_begin(&s->fast_map_seqlock);
+    for (i = 0; i < nb_clusters; i++) {
+        uint64_t idx = guest_cluster + i;
+        Qcow2FastMapEntry *e = &s->fast_map[idx % QCOW2_FAST_MAP_SIZE];
+
+        e->guest_cluster = idx;
+        e->host_offset = host_cluster_offset + (i << s->cluster_bits);
+        e->gen = s->fast_map_gen;
+    }
+    seqlock_write_end(&s->fast_map_seqlock);
+}
+
+/*
+ * qcow2_fast_map_invalidate
+ *
+ * Drop all entries of the lock-free translation cache.  Must be called with
+ * s->lock held (or with no concurrent I/O) after L1 or L2 entries have been
+ * changed and before s->lock is released.
+ */
+void qcow2_fast_map_invalidate(BDRVQcow2State *s)
+{
+    seqlock_write_begin(&s->fast_map_seqlock);
+    s->fast_map_gen++;
+    seqlock_write_end(&s->fast_map_seqlock);
+}
+
 /*
  * get_cluster_table
  *
@@ -874,6 +984,7 @@ qcow2_alloc_compressed_cluster_offset(BlockDriverState *bs, uint64_t offset,
 
     BLKDBG_CO_EVENT(bs->file, BLKDBG_L2_UPDATE_COMPRESSED);
     qcow2_cache_entry_mark_dirty(s->l2_table_cache, l2_slice);
+    qcow2_fast_map_invalidate(s);
     set_l2_entry(s, l2_slice, l2_index, cluster_offset);
     if (has_subclusters(s)) {
         set_l2_bitmap(s, l2_slice, l2_index, 0);
@@ -1062,6 +1173,7 @@ int coroutine_fn qcow2_alloc_cluster_link_l2(BlockDriverState *bs,
         goto err;
     }
     qcow2_cache_entry_mark_dirty(s->l2_table_cache, l2_slice);
+    qcow2_fast_map_invalidate(s);
 
     assert(l2_index + m->nb_clusters <= s->l2_slice_size);
     assert(m->cow_end.offset + m->cow_end.nb_bytes <=
@@ -1582,6 +1694,57 @@ out:
     return ret;
 }
 
+/*
+ * Takes data clusters from the allocation reserve, refilling it with a single
+ * refcount update of s->cluster_alloc_batch bytes if it is empty.  This way
+ * consecutive small allocating writes only have to touch the refcount blocks
+ * once per batch.
+ *
+ * The parameters have the same meaning as for do_alloc_cluster_offset() below.
+ *
+ * Returns 1 if the clusters were taken from the reserve, 0 if the caller
+ * must allocate them itself and -errno in error cases.
+ */
+static int coroutine_fn GRAPH_RDLOCK
+alloc_from_reserve(BlockDriverState *bs, uint64_t *host_offset,
+                   uint64_t *nb_clusters)
+{
+    BDRVQcow2State *s = bs->opaque;
+    uint64_t batch_clusters = s->cluster_alloc_batch >> s->cluster_bits;
+
+    if (*host_offset != INV_OFFSET) {
+        /* Only extend an allocation that came from the reserve */
+        if (s->alloc_reserve_clusters == 0 ||
+            *host_offset != s->alloc_reserve_offset)
+        {
+            return 0;
+        }
+    } else if (s->alloc_reserve_clusters == 0) {
+        int64_t offset;
+
+        /* Large requests don't gain anything from batching */
+        if (*nb_clusters >= batch_clusters) {
+            return 0;
+        }
+
+        offset = qcow2_alloc_clusters(bs, batch_clusters << s->cluster_bits);
+        if (offset < 0) {
+            return offset;
+        }
+        s->alloc_reserve_offset = offset;
+        s->alloc_reserve_clusters = batch_clusters;
+    }
+
+    *nb_clusters = MIN(*nb_clusters, s->alloc_reserve_clusters);
+    *host_offset = s->alloc_reserve_offset;
+    s->alloc_reserve_offset += *nb_clusters << s->cluster_bits;
+    s->alloc_reserve_clusters -= *nb_clusters;
+
+    trace_qcow2_alloc_from_reserve(qemu_coroutine_self(), *host_offset,
+                                   *nb_clusters, s->alloc_reserve_clusters);
+    return 1;
+}
+
 /*
  * Allocates new clusters for the given guest_offset.
  *
@@ -1606,6 +1769,7 @@ do_alloc_cluster_offset(BlockDriverState *bs, uint64_t guest_offset,
                         uint64_t *host_offset, uint64_t *nb_clusters)
 {
     BDRVQcow2State *s = bs->opaque;
+    int ret;
 
     trace_qcow2_do_alloc_clusters_offset(qemu_coroutine_self(), guest_offset,
                                          *host_offset, *nb_clusters);
@@ -1617,6 +1781,11 @@ do_alloc_cluster_offset(BlockDriverState *bs, uint64_t guest_offset,
         return 0;
     }
 
+    ret = alloc_from_reserve(bs, host_offset, nb_clusters);
+    if (ret != 0) {
+        return ret < 0 ? ret : 0;
+    }
+
     /* Allocate new clusters */
     trace_qcow2_cluster_alloc_phys(qemu_coroutine_self());
     if (*host_offset == INV_OFFSET) {
@@ -1971,6 +2140,7 @@ discard_in_l2_slice(BlockDriverState *bs, uint64_t offset, uint64_t nb_clusters,
 
         /* First remove L2 entries */
         qcow2_cache_entry_mark_dirty(s->l2_table_cache, l2_slice);
+        qcow2_fast_map_invalidate(s);
         set_l2_entry(s, l2_slice, l2_index + i, new_l2_entry);
         if (has_subclusters(s)) {
             set_l2_bitmap(s, l2_slice, l2_index + i, new_l2_bitmap);
@@ -2083,6 +2253,7 @@ zero_in_l2_slice(BlockDriverState *bs, uint64_t offset,
 
         /* First update L2 entries */
         qcow2_cache_entry_mark_dirty(s->l2_table_cache, l2_slice);
+        qcow2_fast_map_invalidate(s);
         set_l2_entry(s, l2_slice, l2_index + i, new_l2_entry);
         if (has_subclusters(s)) {
             set_l2_bitmap(s, l2_slice, l2_index + i, new_l2_bitmap);
@@ -2145,6 +2316,7 @@ zero_l2_subclusters(BlockDriverState *bs, uint64_t offset,
     if (old_l2_bitmap != l2_bitmap) {
         set_l2_bitmap(s, l2_slice, l2_index, l2_bitmap);
         qcow2_cache_entry_mark_dirty(s->l2_table_cache, l2_slice);
+        qcow2_fast_map_invalidate(s);
     }
 
     ret = 0;
@@ -2415,6 +2587,7 @@ expand_zero_clusters_in_l1(BlockDriverState *bs, uint64_t *l1_table,
             if (is_active_l1) {
                 if (l2_dirty) {
                     qcow2_cache_entry_mark_dirty(s->l2_table_cache, l2_slice);
+                    qcow2_fast_map_invalidate(s);
                     qcow2_cache_depends_on_flush(s->l2_table_cache);
                 }
                 qcow2_cache_put(s->l2_table_cache, (void **) &l2_slice);
@@ -1065,6 +1065,27 @@ int64_t coroutine_fn qcow2_alloc_clusters_at(BlockDriverState *bs, uint64_t offs
     return i;
 }
 
+/*
+ * Return the clusters that have been allocated in advance for data writes
+ * (see s->alloc_reserve_offset) but not used yet.  This must be done before
+ * the refcounts are expected to exactly match the L2 tables, e.g. before
+ * closing the image or checking it.
+ */
+void qcow2_release_alloc_reserve(BlockDriverState *bs)
+{
+    BDRVQcow2State *s = bs->opaque;
+
+    if (s->alloc_reserve_clusters == 0) {
+        return;
+    }
+
+    qcow2_free_clusters(bs, s->alloc_reserve_offset,
+                        s->alloc_reserve_clusters << s->cluster_bits,
+                        QCOW2_DISCARD_NEVER);
+    s->alloc_reserve_offset = 0;
+    s->alloc_reserve_clusters = 0;
+}
+
 /* only used to allocate compressed sectors. We try to allocate
    contiguous sectors. size must be <= cluster_size */
 int64_t coroutine_fn GRAPH_RDLOCK qcow2_alloc_bytes(BlockDriverState *bs, int size)
@@ -1390,6 +1411,7 @@ int qcow2_update_snapshot_refcount(BlockDriverState *bs,
                         set_l2_entry(s, l2_slice, j, entry);
                         qcow2_cache_entry_mark_dirty(s->l2_table_cache,
                                                      l2_slice);
+                        qcow2_fast_map_invalidate(s);
                     }
                 }
 
@@ -876,6 +876,7 @@ int qcow2_snapshot_goto(BlockDriverState *bs, const char *snapshot_id)
     for(i = 0;i < s->l1_size; i++) {
         s->l1_table[i] = be64_to_cpu(sn_l1_table[i]);
     }
+    qcow2_fast_map_invalidate(s);
 
     if (ret < 0) {
         goto fail;
@@ -1071,6 +1072,7 @@ int qcow2_snapshot_load_tmp(BlockDriverState *bs,
     for(i = 0;i < s->l1_size; i++) {
         be64_to_cpus(&s->l1_table[i]);
     }
+    qcow2_fast_map_invalidate(s);
 
     return 0;
 }
@@ -651,6 +651,7 @@ qcow2_co_check(BlockDriverState *bs, BdrvCheckResult *result,
     int ret;
 
     qemu_co_mutex_lock(&s->lock);
+    qcow2_release_alloc_reserve(bs);
     ret = qcow2_co_check_locked(bs, result, fix);
     qemu_co_mutex_unlock(&s->lock);
     return ret;
@@ -685,6 +686,7 @@ static const char *const mutable_opts[] = {
     QCOW2_OPT_DISCARD_SNAPSHOT,
     QCOW2_OPT_DISCARD_OTHER,
     QCOW2_OPT_DISCARD_NO_UNREF,
+    QCOW2_OPT_CLUSTER_ALLOC_BATCH,
     QCOW2_OPT_OVERLAP,
     QCOW2_OPT_OVERLAP_TEMPLATE,
     QCOW2_OPT_OVERLAP_MAIN_HEADER,
@@ -734,6 +736,12 @@ static QemuOptsList qcow2_runtime_opts = {
             .type = QEMU_OPT_BOOL,
             .help = "Do not unreference discarded clusters",
         },
+        {
+            .name = QCOW2_OPT_CLUSTER_ALLOC_BATCH,
+            .type = QEMU_OPT_SIZE,
+            .help = "Allocate data clusters in batches of this size "
+                    "(0 = disabled)",
+        },
         {
             .name = QCOW2_OPT_OVERLAP,
             .type = QEMU_OPT_STRING,
@@ -978,6 +986,7 @@ typedef struct Qcow2ReopenState {
     int overlap_check;
     bool discard_passthrough[QCOW2_DISCARD_MAX];
     bool discard_no_unref;
+    uint64_t cluster_alloc_batch;
     uint64_t cache_clean_interval;
     QCryptoBlockOpenOptions *crypto_opts; /* Disk encryption runtime options */
 } Qcow2ReopenState;
@@ -1157,6 +1166,16 @@ qcow2_update_options_prepare(BlockDriverState *bs, Qcow2ReopenState *r,
         goto fail;
     }
 
+    r->cluster_alloc_batch = qemu_opt_get_size(opts,
+                                               QCOW2_OPT_CLUSTER_ALLOC_BATCH,
+                                               0);
+    if (r->cluster_alloc_batch > QCOW2_MAX_CLUSTER_ALLOC_BATCH) {
+        error_setg(errp, "cluster-alloc-batch must not exceed %" PRIu64,
+                   (uint64_t) QCOW2_MAX_CLUSTER_ALLOC_BATCH);
+        ret = -EINVAL;
+        goto fail;
+    }
+
     switch (s->crypt_method_header) {
     case QCOW_CRYPT_NONE:
         if (encryptfmt) {
@@ -1238,6 +1257,7 @@ static void qcow2_update_options_commit(BlockDriverState *bs,
     }
 
     s->discard_no_unref = r->discard_no_unref;
+    s->cluster_alloc_batch = r->cluster_alloc_batch;
 
     if (s->cache_clean_interval != r->cache_clean_interval) {
         cache_clean_timer_del(bs);
@@ -1611,6 +1631,7 @@ qcow2_do_open(BlockDriverState *bs, QDict *options, int flags,
             s->l1_table[i] = be64_to_cpu(s->l1_table[i]);
         }
     }
+    qcow2_fast_map_invalidate(s);
 
     /* Parse driver-specific options */
     ret = qcow2_update_options(bs, options, flags, errp);
@@ -2011,6 +2032,8 @@ qcow2_reopen_prepare(BDRVReopenState *state,BlockReopenQueue *queue,
             goto fail;
         }
 
+        qcow2_release_alloc_reserve(state->bs);
+
         ret = bdrv_flush(state->bs);
         if (ret < 0) {
             goto fail;
@@ -2403,12 +2426,19 @@ qcow2_co_preadv_part(BlockDriverState *bs, int64_t offset, int64_t bytes,
                             QCOW_MAX_CRYPT_CLUSTERS * s->cluster_size);
         }
 
-        qemu_co_mutex_lock(&s->lock);
-        ret = qcow2_get_host_offset(bs, offset, &cur_bytes,
-                                    &host_offset, &type);
-        qemu_co_mutex_unlock(&s->lock);
-        if (ret < 0) {
-            goto out;
+        if (qcow2_fast_map_lookup(s, offset, &cur_bytes, &host_offset)) {
+            type = QCOW2_SUBCLUSTER_NORMAL;
+        } else {
+            qemu_co_mutex_lock(&s->lock);
+            ret = qcow2_get_host_offset(bs, offset, &cur_bytes,
+                                        &host_offset, &type);
+            if (ret == 0 && type == QCOW2_SUBCLUSTER_NORMAL) {
+                qcow2_fast_map_insert(s, offset, cur_bytes, host_offset);
+            }
+            qemu_co_mutex_unlock(&s->lock);
+            if (ret < 0) {
+                goto out;
+            }
         }
 
         if (type == QCOW2_SUBCLUSTER_ZERO_PLAIN ||
@@ -2762,6 +2792,8 @@ static int GRAPH_RDLOCK qcow2_inactivate(BlockDriverState *bs)
     int ret, result = 0;
     Error *local_err = NULL;
 
+    qcow2_release_alloc_reserve(bs);
+
     qcow2_store_persistent_dirty_bitmaps(bs, true, &local_err);
     if (local_err != NULL) {
         result = -EINVAL;
@@ -4321,6 +4353,9 @@ qcow2_co_truncate(BlockDriverState *bs, int64_t offset, bool exact,
 
     qemu_co_mutex_lock(&s->lock);
 
+    /* Unused reserved clusters could prevent shrinking the image */
+    qcow2_release_alloc_reserve(bs);
+
     /*
      * Even though we store snapshot size for all images, it was not
      * required until v3, so it is not safe to proceed for v2.
@@ -5019,6 +5054,8 @@ static int GRAPH_RDLOCK qcow2_make_empty(BlockDriverState *bs)
     int step = QEMU_ALIGN_DOWN(INT_MAX, s->cluster_size);
     int l1_clusters, ret = 0;
 
+    qcow2_release_alloc_reserve(bs);
+
     l1_clusters = DIV_ROUND_UP(s->l1_size, s->cluster_size / L1E_SIZE);
 
     if (s->qcow_version >= 3 && !s->snapshots && !s->nb_bitmaps &&
@@ -27,6 +27,7 @@
 
 #include "crypto/block.h"
 #include "qemu/coroutine.h"
+#include "qemu/seqlock.h"
 #include "qemu/units.h"
 #include "block/block_int.h"
 
@@ -128,12 +129,15 @@
 
 #define DEFAULT_CLUSTER_SIZE 65536
 
+#define QCOW2_MAX_CLUSTER_ALLOC_BATCH (1 * GiB)
+
 #define QCOW2_OPT_DATA_FILE "data-file"
 #define QCOW2_OPT_LAZY_REFCOUNTS "lazy-refcounts"
 #define QCOW2_OPT_DISCARD_REQUEST "pass-discard-request"
 #define QCOW2_OPT_DISCARD_SNAPSHOT "pass-discard-snapshot"
 #define QCOW2_OPT_DISCARD_OTHER "pass-discard-other"
 #define QCOW2_OPT_DISCARD_NO_UNREF "discard-no-unref"
+#define QCOW2_OPT_CLUSTER_ALLOC_BATCH "cluster-alloc-batch"
 #define QCOW2_OPT_OVERLAP "overlap-check"
 #define QCOW2_OPT_OVERLAP_TEMPLATE "overlap-check.template"
 #define QCOW2_OPT_OVERLAP_MAIN_HEADER "overlap-check.main-header"
@@ -324,6 +328,20 @@ typedef struct Qcow2BitmapHeaderExt {
 
 #define QCOW2_MAX_THREADS 4
 
+/* Number of entries in the lock-free read translation cache (power of two) */
+#define QCOW2_FAST_MAP_SIZE 1024
+
+/*
+ * Entry of the read translation cache.  An entry is only valid if @gen
+ * matches BDRVQcow2State.fast_map_gen; bumping the generation therefore
+ * drops all cached translations at once.
+ */
+typedef struct Qcow2FastMapEntry {
+    uint64_t guest_cluster; /* guest offset >> cluster_bits */
+    uint64_t host_offset;   /* host offset of the data cluster */
+    uint64_t gen;
+} Qcow2FastMapEntry;
+
 typedef struct BDRVQcow2State {
     int cluster_bits;
     int cluster_size;
@@ -357,8 +375,27 @@ typedef struct BDRVQcow2State {
     uint64_t free_cluster_index;
     uint64_t free_byte_offset;
 
+    /*
+     * Data clusters that were allocated (refcount 1) in a single batch but
+     * are not referenced by any L2 entry yet.  Allocating writes take
+     * clusters from here without touching the refcount blocks.
+     */
+    uint64_t cluster_alloc_batch; /* bytes, 0 disables batching */
+    uint64_t alloc_reserve_offset;
+    uint64_t alloc_reserve_clusters;
+
     CoMutex lock;
 
+    /*
+     * Translations of fully allocated data clusters that readers can look up
+     * without taking s->lock.  Writers hold s->lock and update the entries
+     * inside fast_map_seqlock; any change to L1 or L2 tables must call
+     * qcow2_fast_map_invalidate().
+     */
+    QemuSeqLock fast_map_seqlock;
+    uint64_t fast_map_gen;
+    Qcow2FastMapEntry fast_map[QCOW2_FAST_MAP_SIZE];
+
     Qcow2CryptoHeaderExtension crypto_header; /* QCow2 header extension */
     QCryptoBlockOpenOptions *crypto_opts; /* Disk encryption runtime options */
     QCryptoBlock *crypto; /* Disk encryption format driver */
@@ -874,6 +911,7 @@ qcow2_alloc_clusters_at(BlockDriverState *bs, uint64_t offset,
                         int64_t nb_clusters);
 
 int64_t coroutine_fn GRAPH_RDLOCK qcow2_alloc_bytes(BlockDriverState *bs, int size);
+void GRAPH_RDLOCK qcow2_release_alloc_reserve(BlockDriverState *bs);
 void GRAPH_RDLOCK qcow2_free_clusters(BlockDriverState *bs,
                                       int64_t offset, int64_t size,
                                       enum qcow2_discard_type type);
@@ -932,6 +970,12 @@ qcow2_get_host_offset(BlockDriverState *bs, uint64_t offset,
                       unsigned int *bytes, uint64_t *host_offset,
                       QCow2SubclusterType *subcluster_type);
 
+bool qcow2_fast_map_lookup(BDRVQcow2State *s, uint64_t offset,
+                           unsigned int *bytes, uint64_t *host_offset);
+void qcow2_fast_map_insert(BDRVQcow2State *s, uint64_t offset,
+                           unsigned int bytes, uint64_t host_offset);
+void qcow2_fast_map_invalidate(BDRVQcow2State *s);
+
 int coroutine_fn GRAPH_RDLOCK
 qcow2_alloc_host_offset(BlockDriverState *bs, uint64_t offset,
                         unsigned int *bytes, uint64_t *host_offset,
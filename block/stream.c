@@ -258,6 +258,7 @@ void stream_start(const char *job_id, BlockDriverState *bs,
                   int creation_flags, int64_t speed,
                   BlockdevOnError on_error,
                   const char *filter_node_name,
+                  const char *prefetch_hints,
                   Error **errp)
 {
     StreamBlockJob *s = NULL;
@@ -339,6 +340,9 @@ void stream_start(const char *job_id, BlockDriverState *bs,
     if (filter_node_name) {
         qdict_put_str(opts, "node-name", filter_node_name);
     }
+    if (prefetch_hints) {
+        qdict_put_str(opts, "prefetch-hints", prefetch_hints);
+    }
 
     cor_filter_bs = bdrv_insert_node(bs, opts, BDRV_O_RDWR, errp);
     if (!cor_filter_bs) {
@@ -2286,6 +2286,7 @@ void qmp_block_stream(const char *job_id, const char *device,
                       bool has_speed, int64_t speed,
                       bool has_on_error, BlockdevOnError on_error,
                       const char *filter_node_name,
+                      const char *prefetch_hints,
                       bool has_auto_finalize, bool auto_finalize,
                       bool has_auto_dismiss, bool auto_dismiss,
                       Error **errp)
@@ -2410,7 +2411,7 @@ void qmp_block_stream(const char *job_id, const char *device,
     stream_start(job_id, bs, base_bs, backing_file,
                  backing_mask_protocol,
                  bottom_bs, job_flags, has_speed ? speed : 0, on_error,
-                 filter_node_name, &local_err);
+                 filter_node_name, prefetch_hints, &local_err);
     if (local_err) {
         error_propagate(errp, local_err);
         return;
@@ -2658,6 +2659,9 @@ static BlockJob *do_backup_common(BackupCommon *backup,
         if (backup->x_perf->has_min_cluster_size) {
             perf.min_cluster_size = backup->x_perf->min_cluster_size;
         }
+        if (backup->x_perf->has_adaptive) {
+            perf.adaptive = backup->x_perf->adaptive;
+        }
     }
 
     if ((backup->sync == MIRROR_SYNC_MODE_BITMAP) ||
@@ -35,6 +35,7 @@ void ebpf_rss_init(struct EBPFRSSContext *ctx)
         ctx->map_configuration = -1;
         ctx->map_toeplitz_key = -1;
         ctx->map_indirections_table = -1;
+        ctx->map_flow_table = -1;
 
         ctx->mmap_configuration = NULL;
         ctx->mmap_toeplitz_key = NULL;
@@ -134,6 +135,8 @@ bool ebpf_rss_load(struct EBPFRSSContext *ctx, Error **errp)
             rss_bpf_ctx->maps.tap_rss_map_indirection_table);
     ctx->map_toeplitz_key = bpf_map__fd(
             rss_bpf_ctx->maps.tap_rss_map_toeplitz_key);
+    ctx->map_flow_table = bpf_map__fd(
+            rss_bpf_ctx->maps.tap_rss_map_flow_table);
 
     trace_ebpf_rss_load(ctx,
                         ctx->program_fd,
@@ -152,6 +155,7 @@ error:
     ctx->map_configuration = -1;
     ctx->map_toeplitz_key = -1;
     ctx->map_indirections_table = -1;
+    ctx->map_flow_table = -1;
 
     return false;
 }
@@ -279,6 +283,37 @@ bool ebpf_rss_set_all(struct EBPFRSSContext *ctx, struct EBPFRSSConfig *config,
     return true;
 }
 
+bool ebpf_rss_has_flow_table(struct EBPFRSSContext *ctx)
+{
+    return ebpf_rss_is_loaded(ctx) && ctx->map_flow_table >= 0;
+}
+
+bool ebpf_rss_set_flow(struct EBPFRSSContext *ctx,
+                       const struct EBPFRSSFlowKey *key, uint16_t queue)
+{
+    if (!ebpf_rss_has_flow_table(ctx)) {
+        return false;
+    }
+
+    trace_ebpf_rss_set_flow(ctx, key->protocol, queue);
+    return !bpf_map_update_elem(ctx->map_flow_table, key, &queue, BPF_ANY);
+}
+
+void ebpf_rss_clear_flows(struct EBPFRSSContext *ctx)
+{
+    struct EBPFRSSFlowKey key;
+
+    if (!ebpf_rss_has_flow_table(ctx)) {
+        return;
+    }
+
+    while (!bpf_map_get_next_key(ctx->map_flow_table, NULL, &key)) {
+        if (bpf_map_delete_elem(ctx->map_flow_table, &key)) {
+            break;
+        }
+    }
+}
+
 void ebpf_rss_unload(struct EBPFRSSContext *ctx)
 {
     if (!ebpf_rss_is_loaded(ctx)) {
@@ -303,6 +338,7 @@ void ebpf_rss_unload(struct EBPFRSSContext *ctx)
     ctx->map_configuration = -1;
     ctx->map_toeplitz_key = -1;
     ctx->map_indirections_table = -1;
+    ctx->map_flow_table = -1;
 }
 
 ebpf_binary_init(EBPF_PROGRAM_ID_RSS, rss_bpf__elf_bytes)
@@ -24,6 +24,7 @@ struct EBPFRSSContext {
     int map_configuration;
     int map_toeplitz_key;
     int map_indirections_table;
+    int map_flow_table;         /* -1 if the program has no flow table */
 
     /* mapped eBPF maps for direct access to omit bpf_map_update_elem() */
     void *mmap_configuration;
@@ -39,6 +40,19 @@ struct EBPFRSSConfig {
     uint16_t default_queue;
 } __attribute__((packed));
 
+/*
+ * A TCP or UDP flow as seen on receive, in network byte order.  IPv4
+ * addresses use the first four bytes of @src and @dst.
+ */
+struct EBPFRSSFlowKey {
+    uint8_t src[16];
+    uint8_t dst[16];
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint8_t protocol;
+    uint8_t pad[3];
+} __attribute__((packed));
+
 void ebpf_rss_init(struct EBPFRSSContext *ctx);
 
 bool ebpf_rss_is_loaded(struct EBPFRSSContext *ctx);
@@ -53,6 +67,14 @@ bool ebpf_rss_set_all(struct EBPFRSSContext *ctx, struct EBPFRSSConfig *config,
                       uint16_t *indirections_table, uint8_t *toeplitz_key,
                       Error **errp);
 
+bool ebpf_rss_has_flow_table(struct EBPFRSSContext *ctx);
+
+/* Steer received packets of @key to @queue, ahead of the RSS hash */
+bool ebpf_rss_set_flow(struct EBPFRSSContext *ctx,
+                       const struct EBPFRSSFlowKey *key, uint16_t queue);
+
+void ebpf_rss_clear_flows(struct EBPFRSSContext *ctx);
+
 void ebpf_rss_unload(struct EBPFRSSContext *ctx);
 
 #endif /* QEMU_EBPF_RSS_H */
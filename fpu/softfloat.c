@@ -401,6 +401,187 @@ float64_gen2(float64 xa, float64 xb, float_status *s,
     return soft(ua.s, ub.s, s);
 }
 
+/*
+ * Hardfloat for float16 and bfloat16.  We cannot rely on the host having
+ * half precision arithmetic, so zero or normal operands are widened to
+ * float, which is exact, the operation is done in single precision and
+ * the result is narrowed with round-to-nearest-even.  Rounding twice is
+ * innocuous for add, sub, mul, div and sqrt, since the 24 bits of float
+ * are at least 2p + 2 for the p = 11 bits of float16 and 8 of bfloat16.
+ */
+
+typedef float16  (*soft_f16_op2_fn)(float16 a, float16 b, float_status *s);
+typedef bfloat16 (*soft_bf16_op2_fn)(bfloat16 a, bfloat16 b, float_status *s);
+
+/* Widen a zero or normal float16.  */
+static inline float32 f16_widen(float16 a)
+{
+    uint32_t sign = (uint32_t)(float16_val(a) & 0x8000) << 16;
+    uint32_t abs = float16_val(a) & 0x7fff;
+
+    if (abs == 0) {
+        return make_float32(sign);
+    }
+    /* Rebias the exponent from 15 to 127.  */
+    return make_float32(sign | ((abs + ((127 - 15) << 10)) << 13));
+}
+
+static inline float32 bf16_widen(bfloat16 a)
+{
+    return make_float32((uint32_t)a << 16);
+}
+
+/*
+ * Narrow @f to float16 with round-to-nearest-even, raising inexact if
+ * bits are lost.  Return false without raising anything if @f is not
+ * comfortably within the normal range of float16: a result that is tiny
+ * before rounding, or that overflows, is left to softfloat.
+ */
+static inline bool f16_narrow(float32 f, float16 *r, float_status *s)
+{
+    uint32_t abs = float32_val(f) & 0x7fffffff;
+    uint32_t h;
+
+    /* (2**-14, 2**16) */
+    if (abs <= 0x38800000 || abs >= 0x47800000) {
+        return false;
+    }
+    h = abs - ((127 - 15) << 23);
+    h = (h + 0xfff + ((h >> 13) & 1)) >> 13;
+    if (unlikely(h >= 0x7c00)) {
+        return false;
+    }
+    if (abs & 0x1fff) {
+        float_raise(float_flag_inexact, s);
+    }
+    *r = make_float16(h | ((float32_val(f) >> 16) & 0x8000));
+    return true;
+}
+
+static inline bool bf16_narrow(float32 f, bfloat16 *r, float_status *s)
+{
+    uint32_t abs = float32_val(f) & 0x7fffffff;
+    uint32_t h;
+
+    /* (FLT_MIN, infinity) */
+    if (abs <= 0x00800000 || abs >= 0x7f800000) {
+        return false;
+    }
+    h = (abs + 0x7fff + ((abs >> 16) & 1)) >> 16;
+    if (unlikely(h >= 0x7f80)) {
+        return false;
+    }
+    if (abs & 0xffff) {
+        float_raise(float_flag_inexact, s);
+    }
+    *r = h | ((float32_val(f) >> 16) & 0x8000);
+    return true;
+}
+
+static inline float16
+float16_gen2(float16 a, float16 b, float_status *s,
+             hard_f32_op2_fn hard, soft_f16_op2_fn soft,
+             f32_check_fn pre, f32_check_fn post)
+{
+    union_float32 ua, ub, ur;
+    float16 r;
+
+    if (unlikely(!can_use_fpu(s))) {
+        goto soft;
+    }
+    if (unlikely(!float16_is_zero_or_normal(a) ||
+                 !float16_is_zero_or_normal(b))) {
+        goto soft;
+    }
+
+    ua.s = f16_widen(a);
+    ub.s = f16_widen(b);
+    if (unlikely(!pre(ua, ub))) {
+        goto soft;
+    }
+
+    ur.h = hard(ua.h, ub.h);
+    if (likely(f16_narrow(ur.s, &r, s))) {
+        return r;
+    }
+    if (float32_is_zero(ur.s) && !post(ua, ub)) {
+        return make_float16(float32_val(ur.s) >> 16);
+    }
+
+ soft:
+    return soft(a, b, s);
+}
+
+static inline bfloat16
+bfloat16_gen2(bfloat16 a, bfloat16 b, float_status *s,
+              hard_f32_op2_fn hard, soft_bf16_op2_fn soft,
+              f32_check_fn pre, f32_check_fn post)
+{
+    union_float32 ua, ub, ur;
+    bfloat16 r;
+
+    if (unlikely(!can_use_fpu(s))) {
+        goto soft;
+    }
+    if (unlikely(!bfloat16_is_zero_or_normal(a) ||
+                 !bfloat16_is_zero_or_normal(b))) {
+        goto soft;
+    }
+
+    ua.s = bf16_widen(a);
+    ub.s = bf16_widen(b);
+    if (unlikely(!pre(ua, ub))) {
+        goto soft;
+    }
+
+    ur.h = hard(ua.h, ub.h);
+    if (likely(bf16_narrow(ur.s, &r, s))) {
+        return r;
+    }
+    if (float32_is_zero(ur.s) && !post(ua, ub)) {
+        return float32_val(ur.s) >> 16;
+    }
+
+ soft:
+    return soft(a, b, s);
+}
+
+/*
+ * Conversion to integer with the host FPU, for a float or double @a
+ * that is zero or normal.  Only round-to-nearest-even, the rounding mode
+ * of the host, and round-to-zero are handled; unlike the arithmetic
+ * above the inexact flag is computed, since it is cheap to do so.
+ * Return false if softfloat must be used, e.g. because the result
+ * does not fit between @min and -@min - 1.
+ */
+static inline bool hard_to_sint(double a, FloatRoundMode rmode,
+                                int64_t min, int64_t *ret, float_status *s)
+{
+    double r;
+
+    if (QEMU_NO_HARDFLOAT) {
+        return false;
+    }
+    switch (rmode) {
+    case float_round_nearest_even:
+        r = rint(a);
+        break;
+    case float_round_to_zero:
+        r = trunc(a);
+        break;
+    default:
+        return false;
+    }
+    if (unlikely(!(r >= (double)min && r < -(double)min))) {
+        return false;
+    }
+    if (r != a) {
+        float_raise(float_flag_inexact, s);
+    }
+    *ret = (int64_t)r;
+    return true;
+}
+
 /*
  * Classify a floating point number. Everything above float_class_qnan
  * is a NaN so cls >= float_class_qnan is any NaN.
@@ -1865,8 +2046,8 @@ static floatx80 floatx80_round_pack_canonical(FloatParts128 *p,
  * Addition and subtraction
  */
 
-static float16 QEMU_FLATTEN
-float16_addsub(float16 a, float16 b, float_status *status, bool subtract)
+static float16 QEMU_SOFTFLOAT_ATTR
+soft_f16_addsub(float16 a, float16 b, float_status *status, bool subtract)
 {
     FloatParts64 pa, pb, *pr;
 
@@ -1877,14 +2058,14 @@ float16_addsub(float16 a, float16 b, float_status *status, bool subtract)
     return float16_round_pack_canonical(pr, status);
 }
 
-float16 float16_add(float16 a, float16 b, float_status *status)
+static float16 soft_f16_add(float16 a, float16 b, float_status *status)
 {
-    return float16_addsub(a, b, status, false);
+    return soft_f16_addsub(a, b, status, false);
 }
 
-float16 float16_sub(float16 a, float16 b, float_status *status)
+static float16 soft_f16_sub(float16 a, float16 b, float_status *status)
 {
-    return float16_addsub(a, b, status, true);
+    return soft_f16_addsub(a, b, status, true);
 }
 
 static float32 QEMU_SOFTFLOAT_ATTR
@@ -2006,6 +2187,20 @@ float64_sub(float64 a, float64 b, float_status *s)
     return float64_addsub(a, b, s, hard_f64_sub, soft_f64_sub);
 }
 
+float16 QEMU_FLATTEN
+float16_add(float16 a, float16 b, float_status *s)
+{
+    return float16_gen2(a, b, s, hard_f32_add, soft_f16_add,
+                        f32_is_zon2, f32_addsubmul_post);
+}
+
+float16 QEMU_FLATTEN
+float16_sub(float16 a, float16 b, float_status *s)
+{
+    return float16_gen2(a, b, s, hard_f32_sub, soft_f16_sub,
+                        f32_is_zon2, f32_addsubmul_post);
+}
+
 static float64 float64r32_addsub(float64 a, float64 b, float_status *status,
                                  bool subtract)
 {
@@ -2028,8 +2223,8 @@ float64 float64r32_sub(float64 a, float64 b, float_status *status)
     return float64r32_addsub(a, b, status, true);
 }
 
-static bfloat16 QEMU_FLATTEN
-bfloat16_addsub(bfloat16 a, bfloat16 b, float_status *status, bool subtract)
+static bfloat16 QEMU_SOFTFLOAT_ATTR
+soft_bf16_addsub(bfloat16 a, bfloat16 b, float_status *status, bool subtract)
 {
     FloatParts64 pa, pb, *pr;
 
@@ -2040,14 +2235,28 @@ bfloat16_addsub(bfloat16 a, bfloat16 b, float_status *status, bool subtract)
     return bfloat16_round_pack_canonical(pr, status);
 }
 
-bfloat16 bfloat16_add(bfloat16 a, bfloat16 b, float_status *status)
+static bfloat16 soft_bf16_add(bfloat16 a, bfloat16 b, float_status *status)
+{
+    return soft_bf16_addsub(a, b, status, false);
+}
+
+static bfloat16 soft_bf16_sub(bfloat16 a, bfloat16 b, float_status *status)
 {
-    return bfloat16_addsub(a, b, status, false);
+    return soft_bf16_addsub(a, b, status, true);
 }
 
-bfloat16 bfloat16_sub(bfloat16 a, bfloat16 b, float_status *status)
+bfloat16 QEMU_FLATTEN
+bfloat16_add(bfloat16 a, bfloat16 b, float_status *s)
 {
-    return bfloat16_addsub(a, b, status, true);
+    return bfloat16_gen2(a, b, s, hard_f32_add, soft_bf16_add,
+                         f32_is_zon2, f32_addsubmul_post);
+}
+
+bfloat16 QEMU_FLATTEN
+bfloat16_sub(bfloat16 a, bfloat16 b, float_status *s)
+{
+    return bfloat16_gen2(a, b, s, hard_f32_sub, soft_bf16_sub,
+                         f32_is_zon2, f32_addsubmul_post);
 }
 
 static float128 QEMU_FLATTEN
@@ -2100,7 +2309,8 @@ floatx80 floatx80_sub(floatx80 a, floatx80 b, float_status *status)
  * Multiplication
  */
 
-float16 QEMU_FLATTEN float16_mul(float16 a, float16 b, float_status *status)
+static float16 QEMU_SOFTFLOAT_ATTR
+soft_f16_mul(float16 a, float16 b, float_status *status)
 {
     FloatParts64 pa, pb, *pr;
 
@@ -2159,6 +2369,13 @@ float64_mul(float64 a, float64 b, float_status *s)
                         f64_is_zon2, f64_addsubmul_post);
 }
 
+float16 QEMU_FLATTEN
+float16_mul(float16 a, float16 b, float_status *s)
+{
+    return float16_gen2(a, b, s, hard_f32_mul, soft_f16_mul,
+                        f32_is_zon2, f32_addsubmul_post);
+}
+
 float64 float64r32_mul(float64 a, float64 b, float_status *status)
 {
     FloatParts64 pa, pb, *pr;
@@ -2170,8 +2387,8 @@ float64 float64r32_mul(float64 a, float64 b, float_status *status)
     return float64r32_round_pack_canonical(pr, status);
 }
 
-bfloat16 QEMU_FLATTEN
-bfloat16_mul(bfloat16 a, bfloat16 b, float_status *status)
+static bfloat16 QEMU_SOFTFLOAT_ATTR
+soft_bf16_mul(bfloat16 a, bfloat16 b, float_status *status)
 {
     FloatParts64 pa, pb, *pr;
 
@@ -2182,6 +2399,13 @@ bfloat16_mul(bfloat16 a, bfloat16 b, float_status *status)
     return bfloat16_round_pack_canonical(pr, status);
 }
 
+bfloat16 QEMU_FLATTEN
+bfloat16_mul(bfloat16 a, bfloat16 b, float_status *s)
+{
+    return bfloat16_gen2(a, b, s, hard_f32_mul, soft_bf16_mul,
+                         f32_is_zon2, f32_addsubmul_post);
+}
+
 float128 QEMU_FLATTEN
 float128_mul(float128 a, float128 b, float_status *status)
 {
@@ -2444,7 +2668,8 @@ float128 QEMU_FLATTEN float128_muladd(float128 a, float128 b, float128 c,
  * Division
  */
 
-float16 float16_div(float16 a, float16 b, float_status *status)
+static float16 QEMU_SOFTFLOAT_ATTR
+soft_f16_div(float16 a, float16 b, float_status *status)
 {
     FloatParts64 pa, pb, *pr;
 
@@ -2537,6 +2762,13 @@ float64_div(float64 a, float64 b, float_status *s)
                         f64_div_pre, f64_div_post);
 }
 
+float16 QEMU_FLATTEN
+float16_div(float16 a, float16 b, float_status *s)
+{
+    return float16_gen2(a, b, s, hard_f32_div, soft_f16_div,
+                        f32_div_pre, f32_div_post);
+}
+
 float64 float64r32_div(float64 a, float64 b, float_status *status)
 {
     FloatParts64 pa, pb, *pr;
@@ -2548,8 +2780,8 @@ float64 float64r32_div(float64 a, float64 b, float_status *status)
     return float64r32_round_pack_canonical(pr, status);
 }
 
-bfloat16 QEMU_FLATTEN
-bfloat16_div(bfloat16 a, bfloat16 b, float_status *status)
+static bfloat16 QEMU_SOFTFLOAT_ATTR
+soft_bf16_div(bfloat16 a, bfloat16 b, float_status *status)
 {
     FloatParts64 pa, pb, *pr;
 
@@ -2560,6 +2792,13 @@ bfloat16_div(bfloat16 a, bfloat16 b, float_status *status)
     return bfloat16_round_pack_canonical(pr, status);
 }
 
+bfloat16 QEMU_FLATTEN
+bfloat16_div(bfloat16 a, bfloat16 b, float_status *s)
+{
+    return bfloat16_gen2(a, b, s, hard_f32_div, soft_bf16_div,
+                         f32_div_pre, f32_div_post);
+}
+
 float128 QEMU_FLATTEN
 float128_div(float128 a, float128 b, float_status *status)
 {
@@ -2756,6 +2995,11 @@ float32 float16_to_float32(float16 a, bool ieee, float_status *s)
     const FloatFmt *fmt16 = ieee ? &float16_params : &float16_params_ahp;
     FloatParts64 p;
 
+    /* Widening conversion can never produce inexact results.  */
+    if (likely(float16_is_zero_or_normal(a))) {
+        return f16_widen(a);
+    }
+
     float16a_unpack_canonical(&p, a, s, fmt16);
     parts_float_to_float(&p, s);
     return float32_round_pack_canonical(&p, s);
@@ -2766,6 +3010,14 @@ float64 float16_to_float64(float16 a, bool ieee, float_status *s)
     const FloatFmt *fmt16 = ieee ? &float16_params : &float16_params_ahp;
     FloatParts64 p;
 
+    if (likely(float16_is_zero_or_normal(a))) {
+        union_float32 uf;
+        union_float64 ud;
+        uf.s = f16_widen(a);
+        ud.h = uf.h;
+        return ud.s;
+    }
+
     float16a_unpack_canonical(&p, a, s, fmt16);
     parts_float_to_float(&p, s);
     return float64_round_pack_canonical(&p, s);
@@ -2775,6 +3027,16 @@ float16 float32_to_float16(float32 a, bool ieee, float_status *s)
 {
     FloatParts64 p;
     const FloatFmt *fmt;
+    float16 r;
+
+    if (likely(ieee && s->float_rounding_mode == float_round_nearest_even)) {
+        if (likely(f16_narrow(a, &r, s))) {
+            return r;
+        }
+        if (float32_is_zero(a)) {
+            return float16_set_sign(float16_zero, float32_is_neg(a));
+        }
+    }
 
     float32_unpack_canonical(&p, a, s);
     if (ieee) {
@@ -2829,7 +3091,8 @@ float16 float64_to_float16(float64 a, bool ieee, float_status *s)
     return float16a_round_pack_canonical(&p, s, fmt);
 }
 
-float32 float64_to_float32(float64 a, float_status *s)
+static float32 QEMU_SOFTFLOAT_ATTR
+soft_float64_to_float32(float64 a, float_status *s)
 {
     FloatParts64 p;
 
@@ -2838,10 +3101,45 @@ float32 float64_to_float32(float64 a, float_status *s)
     return float32_round_pack_canonical(&p, s);
 }
 
+float32 float64_to_float32(float64 a, float_status *s)
+{
+    union_float64 ua;
+    union_float32 ur;
+
+    if (QEMU_NO_HARDFLOAT ||
+        unlikely(s->float_rounding_mode != float_round_nearest_even)) {
+        goto soft;
+    }
+    if (likely(float64_is_normal(a))) {
+        ua.s = a;
+        ur.h = ua.h;
+        /*
+         * Leave overflow, and results that could be tiny before
+         * rounding, to softfloat.  Inexact is cheap to compute.
+         */
+        if (likely(fabsf(ur.h) > FLT_MIN && !f32_is_inf(ur))) {
+            if (ur.h != ua.h) {
+                float_raise(float_flag_inexact, s);
+            }
+            return ur.s;
+        }
+    } else if (float64_is_zero(a)) {
+        return float32_set_sign(float32_zero, float64_is_neg(a));
+    }
+
+ soft:
+    return soft_float64_to_float32(a, s);
+}
+
 float32 bfloat16_to_float32(bfloat16 a, float_status *s)
 {
     FloatParts64 p;
 
+    /* Widening conversion can never produce inexact results.  */
+    if (likely(bfloat16_is_zero_or_normal(a))) {
+        return bf16_widen(a);
+    }
+
     bfloat16_unpack_canonical(&p, a, s);
     parts_float_to_float(&p, s);
     return float32_round_pack_canonical(&p, s);
@@ -2851,6 +3149,14 @@ float64 bfloat16_to_float64(bfloat16 a, float_status *s)
 {
     FloatParts64 p;
 
+    if (likely(bfloat16_is_zero_or_normal(a))) {
+        union_float32 uf;
+        union_float64 ud;
+        uf.s = bf16_widen(a);
+        ud.h = uf.h;
+        return ud.s;
+    }
+
     bfloat16_unpack_canonical(&p, a, s);
     parts_float_to_float(&p, s);
     return float64_round_pack_canonical(&p, s);
@@ -2859,6 +3165,16 @@ float64 bfloat16_to_float64(bfloat16 a, float_status *s)
 bfloat16 float32_to_bfloat16(float32 a, float_status *s)
 {
     FloatParts64 p;
+    bfloat16 r;
+
+    if (likely(s->float_rounding_mode == float_round_nearest_even)) {
+        if (likely(bf16_narrow(a, &r, s))) {
+            return r;
+        }
+        if (float32_is_zero(a)) {
+            return bfloat16_set_sign(bfloat16_zero, float32_is_neg(a));
+        }
+    }
 
     float32_unpack_canonical(&p, a, s);
     parts_float_to_float(&p, s);
@@ -3069,6 +3385,16 @@ int32_t float16_to_int32_scalbn(float16 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    int64_t r;
+
+    if (likely(scale == 0) && likely(float16_is_zero_or_normal(a))) {
+        union_float32 ua;
+
+        ua.s = f16_widen(a);
+        if (likely(hard_to_sint(ua.h, rmode, INT32_MIN, &r, s))) {
+            return r;
+        }
+    }
 
     float16_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT32_MIN, INT32_MAX, s);
@@ -3078,6 +3404,16 @@ int64_t float16_to_int64_scalbn(float16 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    int64_t r;
+
+    if (likely(scale == 0) && likely(float16_is_zero_or_normal(a))) {
+        union_float32 ua;
+
+        ua.s = f16_widen(a);
+        if (likely(hard_to_sint(ua.h, rmode, INT64_MIN, &r, s))) {
+            return r;
+        }
+    }
 
     float16_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT64_MIN, INT64_MAX, s);
@@ -3096,6 +3432,16 @@ int32_t float32_to_int32_scalbn(float32 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    int64_t r;
+
+    if (likely(scale == 0) && likely(float32_is_zero_or_normal(a))) {
+        union_float32 ua;
+
+        ua.s = a;
+        if (likely(hard_to_sint(ua.h, rmode, INT32_MIN, &r, s))) {
+            return r;
+        }
+    }
 
     float32_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT32_MIN, INT32_MAX, s);
@@ -3105,6 +3451,16 @@ int64_t float32_to_int64_scalbn(float32 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    int64_t r;
+
+    if (likely(scale == 0) && likely(float32_is_zero_or_normal(a))) {
+        union_float32 ua;
+
+        ua.s = a;
+        if (likely(hard_to_sint(ua.h, rmode, INT64_MIN, &r, s))) {
+            return r;
+        }
+    }
 
     float32_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT64_MIN, INT64_MAX, s);
@@ -3123,6 +3479,16 @@ int32_t float64_to_int32_scalbn(float64 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    int64_t r;
+
+    if (likely(scale == 0) && likely(float64_is_zero_or_normal(a))) {
+        union_float64 ua;
+
+        ua.s = a;
+        if (likely(hard_to_sint(ua.h, rmode, INT32_MIN, &r, s))) {
+            return r;
+        }
+    }
 
     float64_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT32_MIN, INT32_MAX, s);
@@ -3132,6 +3498,16 @@ int64_t float64_to_int64_scalbn(float64 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    int64_t r;
+
+    if (likely(scale == 0) && likely(float64_is_zero_or_normal(a))) {
+        union_float64 ua;
+
+        ua.s = a;
+        if (likely(hard_to_sint(ua.h, rmode, INT64_MIN, &r, s))) {
+            return r;
+        }
+    }
 
     float64_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT64_MIN, INT64_MAX, s);
@@ -3845,6 +4221,21 @@ uint64_t bfloat16_to_uint64_round_to_zero(bfloat16 a, float_status *s)
 float16 int64_to_float16_scalbn(int64_t a, int scale, float_status *status)
 {
     FloatParts64 p;
+    float16 r;
+
+    /* Integers up to 2**24 are exact in float, leaving a single rounding. */
+    if (likely(scale == 0) && a >= -(1 << 24) && a <= (1 << 24) &&
+        likely(status->float_rounding_mode == float_round_nearest_even)) {
+        union_float32 ua;
+
+        ua.h = a;
+        if (likely(f16_narrow(ua.s, &r, status))) {
+            return r;
+        }
+        if (a == 0) {
+            return float16_zero;
+        }
+    }
 
     parts_sint_to_float(&p, a, scale, status);
     return float16_round_pack_canonical(&p, status);
@@ -3884,8 +4275,12 @@ float32 int64_to_float32_scalbn(int64_t a, int scale, float_status *status)
 {
     FloatParts64 p;
 
-    /* Without scaling, there are no overflow concerns. */
-    if (likely(scale == 0) && can_use_fpu(status)) {
+    /*
+     * Without scaling, there are no overflow concerns.  Integers up to
+     * 2**24 are exact, whatever the rounding mode and flags.
+     */
+    if (likely(scale == 0) &&
+        (can_use_fpu(status) || (a >= -(1 << 24) && a <= (1 << 24)))) {
         union_float32 ur;
         ur.h = a;
         return ur.s;
@@ -3924,8 +4319,13 @@ float64 int64_to_float64_scalbn(int64_t a, int scale, float_status *status)
 {
     FloatParts64 p;
 
-    /* Without scaling, there are no overflow concerns. */
-    if (likely(scale == 0) && can_use_fpu(status)) {
+    /*
+     * Without scaling, there are no overflow concerns.  Integers up to
+     * 2**53 are exact, whatever the rounding mode and flags.
+     */
+    if (likely(scale == 0) &&
+        (can_use_fpu(status) ||
+         (a >= -(INT64_C(1) << 53) && a <= (INT64_C(1) << 53)))) {
         union_float64 ur;
         ur.h = a;
         return ur.s;
@@ -3963,6 +4363,21 @@ float64 int16_to_float64(int16_t a, float_status *status)
 bfloat16 int64_to_bfloat16_scalbn(int64_t a, int scale, float_status *status)
 {
     FloatParts64 p;
+    bfloat16 r;
+
+    /* Integers up to 2**24 are exact in float, leaving a single rounding. */
+    if (likely(scale == 0) && a >= -(1 << 24) && a <= (1 << 24) &&
+        likely(status->float_rounding_mode == float_round_nearest_even)) {
+        union_float32 ua;
+
+        ua.h = a;
+        if (likely(bf16_narrow(ua.s, &r, status))) {
+            return r;
+        }
+        if (a == 0) {
+            return bfloat16_zero;
+        }
+    }
 
     parts_sint_to_float(&p, a, scale, status);
     return bfloat16_round_pack_canonical(&p, status);
@@ -4104,8 +4519,11 @@ float32 uint64_to_float32_scalbn(uint64_t a, int scale, float_status *status)
 {
     FloatParts64 p;
 
-    /* Without scaling, there are no overflow concerns. */
-    if (likely(scale == 0) && can_use_fpu(status)) {
+    /*
+     * Without scaling, there are no overflow concerns.  Integers up to
+     * 2**24 are exact, whatever the rounding mode and flags.
+     */
+    if (likely(scale == 0) && (can_use_fpu(status) || a <= (1 << 24))) {
         union_float32 ur;
         ur.h = a;
         return ur.s;
@@ -4144,8 +4562,11 @@ float64 uint64_to_float64_scalbn(uint64_t a, int scale, float_status *status)
 {
     FloatParts64 p;
 
-    /* Without scaling, there are no overflow concerns. */
-    if (likely(scale == 0) && can_use_fpu(status)) {
+    /*
+     * Without scaling, there are no overflow concerns.  Integers up to
+     * 2**53 are exact, whatever the rounding mode and flags.
+     */
+    if (likely(scale == 0) && (can_use_fpu(status) || a <= (UINT64_C(1) << 53))) {
         union_float64 ur;
         ur.h = a;
         return ur.s;
@@ -4260,10 +4681,46 @@ float128 uint128_to_float128(Int128 a, float_status *status)
  * Minimum and maximum
  */
 
+/*
+ * When neither operand is a NaN or denormal, parts_minmax only compares
+ * the operands and returns one of them unchanged, which can be done on
+ * the sign-magnitude encodings directly.
+ */
+static inline uint64_t minmax_bits(uint64_t a, uint64_t b, int sign_bit,
+                                   int flags)
+{
+    uint64_t sign = 1ULL << sign_bit;
+    uint64_t a_mag = a & ~sign;
+    uint64_t b_mag = b & ~sign;
+    int cmp = (a_mag > b_mag) - (a_mag < b_mag);
+
+    /* As in parts_minmax.  */
+    if (!(flags & minmax_ismag) || cmp == 0) {
+        bool a_sign = a & sign;
+        bool b_sign = b & sign;
+
+        if (a_sign != b_sign) {
+            cmp = a_sign ? -1 : 1;
+        } else if (a_sign) {
+            cmp = -cmp;
+        }
+    }
+
+    if (flags & minmax_ismin) {
+        cmp = -cmp;
+    }
+    return cmp < 0 ? b : a;
+}
+
 static float16 float16_minmax(float16 a, float16 b, float_status *s, int flags)
 {
     FloatParts64 pa, pb, *pr;
 
+    if (likely(!float16_is_any_nan(a) && !float16_is_denormal(a) &&
+               !float16_is_any_nan(b) && !float16_is_denormal(b))) {
+        return minmax_bits(float16_val(a), float16_val(b), 15, flags);
+    }
+
     float16_unpack_canonical(&pa, a, s);
     float16_unpack_canonical(&pb, b, s);
     pr = parts_minmax(&pa, &pb, s, flags);
@@ -4276,6 +4733,11 @@ static bfloat16 bfloat16_minmax(bfloat16 a, bfloat16 b,
 {
     FloatParts64 pa, pb, *pr;
 
+    if (likely(!bfloat16_is_any_nan(a) && !bfloat16_is_denormal(a) &&
+               !bfloat16_is_any_nan(b) && !bfloat16_is_denormal(b))) {
+        return minmax_bits(a, b, 15, flags);
+    }
+
     bfloat16_unpack_canonical(&pa, a, s);
     bfloat16_unpack_canonical(&pb, b, s);
     pr = parts_minmax(&pa, &pb, s, flags);
@@ -4287,6 +4749,11 @@ static float32 float32_minmax(float32 a, float32 b, float_status *s, int flags)
 {
     FloatParts64 pa, pb, *pr;
 
+    if (likely(!float32_is_any_nan(a) && !float32_is_denormal(a) &&
+               !float32_is_any_nan(b) && !float32_is_denormal(b))) {
+        return minmax_bits(float32_val(a), float32_val(b), 31, flags);
+    }
+
     float32_unpack_canonical(&pa, a, s);
     float32_unpack_canonical(&pb, b, s);
     pr = parts_minmax(&pa, &pb, s, flags);
@@ -4298,6 +4765,11 @@ static float64 float64_minmax(float64 a, float64 b, float_status *s, int flags)
 {
     FloatParts64 pa, pb, *pr;
 
+    if (likely(!float64_is_any_nan(a) && !float64_is_denormal(a) &&
+               !float64_is_any_nan(b) && !float64_is_denormal(b))) {
+        return minmax_bits(float64_val(a), float64_val(b), 63, flags);
+    }
+
     float64_unpack_canonical(&pa, a, s);
     float64_unpack_canonical(&pb, b, s);
     pr = parts_minmax(&pa, &pb, s, flags);
@@ -4344,7 +4816,7 @@ MINMAX_2(float128)
  * Floating point compare
  */
 
-static FloatRelation QEMU_FLATTEN
+static FloatRelation QEMU_SOFTFLOAT_ATTR
 float16_do_compare(float16 a, float16 b, float_status *s, bool is_quiet)
 {
     FloatParts64 pa, pb;
@@ -4354,14 +4826,41 @@ float16_do_compare(float16 a, float16 b, float_status *s, bool is_quiet)
     return parts_compare(&pa, &pb, s, is_quiet);
 }
 
+static FloatRelation QEMU_FLATTEN
+float16_hs_compare(float16 a, float16 b, float_status *s, bool is_quiet)
+{
+    union_float32 ua, ub;
+
+    if (QEMU_NO_HARDFLOAT) {
+        goto soft;
+    }
+    if (unlikely(!float16_is_zero_or_normal(a) ||
+                 !float16_is_zero_or_normal(b))) {
+        goto soft;
+    }
+
+    ua.s = f16_widen(a);
+    ub.s = f16_widen(b);
+    if (isgreater(ua.h, ub.h)) {
+        return float_relation_greater;
+    }
+    if (isless(ua.h, ub.h)) {
+        return float_relation_less;
+    }
+    return float_relation_equal;
+
+ soft:
+    return float16_do_compare(a, b, s, is_quiet);
+}
+
 FloatRelation float16_compare(float16 a, float16 b, float_status *s)
 {
-    return float16_do_compare(a, b, s, false);
+    return float16_hs_compare(a, b, s, false);
 }
 
 FloatRelation float16_compare_quiet(float16 a, float16 b, float_status *s)
 {
-    return float16_do_compare(a, b, s, true);
+    return float16_hs_compare(a, b, s, true);
 }
 
 static FloatRelation QEMU_SOFTFLOAT_ATTR
@@ -4464,7 +4963,7 @@ FloatRelation float64_compare_quiet(float64 a, float64 b, float_status *s)
     return float64_hs_compare(a, b, s, true);
 }
 
-static FloatRelation QEMU_FLATTEN
+static FloatRelation QEMU_SOFTFLOAT_ATTR
 bfloat16_do_compare(bfloat16 a, bfloat16 b, float_status *s, bool is_quiet)
 {
     FloatParts64 pa, pb;
@@ -4474,14 +4973,41 @@ bfloat16_do_compare(bfloat16 a, bfloat16 b, float_status *s, bool is_quiet)
     return parts_compare(&pa, &pb, s, is_quiet);
 }
 
+static FloatRelation QEMU_FLATTEN
+bfloat16_hs_compare(bfloat16 a, bfloat16 b, float_status *s, bool is_quiet)
+{
+    union_float32 ua, ub;
+
+    if (QEMU_NO_HARDFLOAT) {
+        goto soft;
+    }
+    if (unlikely(!bfloat16_is_zero_or_normal(a) ||
+                 !bfloat16_is_zero_or_normal(b))) {
+        goto soft;
+    }
+
+    ua.s = bf16_widen(a);
+    ub.s = bf16_widen(b);
+    if (isgreater(ua.h, ub.h)) {
+        return float_relation_greater;
+    }
+    if (isless(ua.h, ub.h)) {
+        return float_relation_less;
+    }
+    return float_relation_equal;
+
+ soft:
+    return bfloat16_do_compare(a, b, s, is_quiet);
+}
+
 FloatRelation bfloat16_compare(bfloat16 a, bfloat16 b, float_status *s)
 {
-    return bfloat16_do_compare(a, b, s, false);
+    return bfloat16_hs_compare(a, b, s, false);
 }
 
 FloatRelation bfloat16_compare_quiet(bfloat16 a, bfloat16 b, float_status *s)
 {
-    return bfloat16_do_compare(a, b, s, true);
+    return bfloat16_hs_compare(a, b, s, true);
 }
 
 static FloatRelation QEMU_FLATTEN
@@ -4590,7 +5116,8 @@ floatx80 floatx80_scalbn(floatx80 a, int n, float_status *status)
  * Square Root
  */
 
-float16 QEMU_FLATTEN float16_sqrt(float16 a, float_status *status)
+static float16 QEMU_SOFTFLOAT_ATTR
+soft_f16_sqrt(float16 a, float_status *status)
 {
     FloatParts64 p;
 
@@ -4599,6 +5126,23 @@ float16 QEMU_FLATTEN float16_sqrt(float16 a, float_status *status)
     return float16_round_pack_canonical(&p, status);
 }
 
+float16 QEMU_FLATTEN float16_sqrt(float16 a, float_status *s)
+{
+    union_float32 ua, ur;
+    float16 r;
+
+    /* The square root of a normal float16 is always a normal float16.  */
+    if (likely(can_use_fpu(s)) && float16_is_normal(a) &&
+        !float16_is_neg(a)) {
+        ua.s = f16_widen(a);
+        ur.h = sqrtf(ua.h);
+        if (likely(f16_narrow(ur.s, &r, s))) {
+            return r;
+        }
+    }
+    return soft_f16_sqrt(a, s);
+}
+
 static float32 QEMU_SOFTFLOAT_ATTR
 soft_f32_sqrt(float32 a, float_status *status)
 {
@@ -4682,7 +5226,8 @@ float64 float64r32_sqrt(float64 a, float_status *status)
     return float64r32_round_pack_canonical(&p, status);
 }
 
-bfloat16 QEMU_FLATTEN bfloat16_sqrt(bfloat16 a, float_status *status)
+static bfloat16 QEMU_SOFTFLOAT_ATTR
+soft_bf16_sqrt(bfloat16 a, float_status *status)
 {
     FloatParts64 p;
 
@@ -4691,6 +5236,22 @@ bfloat16 QEMU_FLATTEN bfloat16_sqrt(bfloat16 a, float_status *status)
     return bfloat16_round_pack_canonical(&p, status);
 }
 
+bfloat16 QEMU_FLATTEN bfloat16_sqrt(bfloat16 a, float_status *s)
+{
+    union_float32 ua, ur;
+    bfloat16 r;
+
+    if (likely(can_use_fpu(s)) && bfloat16_is_normal(a) &&
+        !bfloat16_is_neg(a)) {
+        ua.s = bf16_widen(a);
+        ur.h = sqrtf(ua.h);
+        if (likely(bf16_narrow(ur.s, &r, s))) {
+            return r;
+        }
+    }
+    return soft_bf16_sqrt(a, s);
+}
+
 float128 QEMU_FLATTEN float128_sqrt(float128 a, float_status *status)
 {
     FloatParts128 p;
@@ -1024,6 +1024,8 @@ static void ncq_cb(void *opaque, int ret)
         if (action == BLOCK_ERROR_ACTION_STOP) {
             ncq_tfs->halt = true;
             ide_state->bus->error_status = IDE_RETRY_HBA;
+            /* The command is started again, with a new cookie, on resume */
+            block_acct_cancel(blk_get_stats(ide_state->blk), &ncq_tfs->acct);
         } else if (action == BLOCK_ERROR_ACTION_REPORT) {
             ncq_err(ncq_tfs);
         }
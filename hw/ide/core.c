@@ -862,6 +862,8 @@ int ide_handle_rw_error(IDEState *s, int error, int op)
     if (action == BLOCK_ERROR_ACTION_STOP) {
         assert(s->bus->retry_unit == s->unit);
         s->bus->error_status = op;
+        /* The request is started again, with a new cookie, on resume */
+        block_acct_cancel(blk_get_stats(s->blk), &s->acct);
     } else if (action == BLOCK_ERROR_ACTION_REPORT) {
         block_acct_failed(blk_get_stats(s->blk), &s->acct);
         if (IS_IDE_RETRY_DMA(op)) {
@@ -985,13 +987,9 @@ eot:
     ide_set_inactive(s, stay_active);
 }
 
-static void ide_sector_start_dma(IDEState *s, enum ide_dma_cmd dma_cmd)
+static void ide_sector_acct_start(IDEState *s)
 {
-    s->status = READY_STAT | SEEK_STAT | DRQ_STAT;
-    s->io_buffer_size = 0;
-    s->dma_cmd = dma_cmd;
-
-    switch (dma_cmd) {
+    switch (s->dma_cmd) {
     case IDE_DMA_READ:
         block_acct_start(blk_get_stats(s->blk), &s->acct,
                          s->nsector * BDRV_SECTOR_SIZE, BLOCK_ACCT_READ);
@@ -1003,7 +1001,14 @@ static void ide_sector_start_dma(IDEState *s, enum ide_dma_cmd dma_cmd)
     default:
         break;
     }
+}
 
+static void ide_sector_start_dma(IDEState *s, enum ide_dma_cmd dma_cmd)
+{
+    s->status = READY_STAT | SEEK_STAT | DRQ_STAT;
+    s->io_buffer_size = 0;
+    s->dma_cmd = dma_cmd;
+    ide_sector_acct_start(s);
     ide_start_dma(s, ide_dma_cb);
 }
 
@@ -2717,6 +2722,8 @@ static void ide_restart_dma(IDEState *s, enum ide_dma_cmd dma_cmd)
     s->bus->dma->ops->restart_dma(s->bus->dma);
     s->io_buffer_size = 0;
     s->dma_cmd = dma_cmd;
+    /* the cookie of the stopped request was dropped by ide_handle_rw_error */
+    ide_sector_acct_start(s);
     ide_start_dma(s, ide_dma_cb);
 }
 
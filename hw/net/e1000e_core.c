@@ -62,6 +62,20 @@ union e1000_rx_desc_union {
     union e1000_rx_desc_packet_split packet_split;
 };
 
+/* Maximum number of TX descriptors fetched with a single DMA read */
+#define E1000E_TX_DESC_BATCH    (32)
+
+/*
+ * Adaptive interrupt moderation, used for a vector whose ITR/EITR is 0:
+ * after E1000E_AITR_BURST_LEN interrupts less than E1000E_AITR_BURST_NS
+ * apart, further interrupts are held back for E1000E_AITR_INTERVAL_NS,
+ * which caps the rate at about 20000 per second under load while a
+ * lightly loaded link keeps per-packet interrupts.
+ */
+#define E1000E_AITR_BURST_NS    (100 * SCALE_US)
+#define E1000E_AITR_BURST_LEN   (8)
+#define E1000E_AITR_INTERVAL_NS (50 * SCALE_US)
+
 static ssize_t
 e1000e_receive_internal(E1000ECore *core, const struct iovec *iov, int iovcnt,
                         bool has_vnet);
@@ -762,9 +776,13 @@ e1000e_rx_wb_interrupt_cause(E1000ECore *core, int queue_idx,
     return (queue_idx == 0) ? E1000_ICR_RXQ0 : E1000_ICR_RXQ1;
 }
 
+/*
+ * Set DD in the descriptor if it needs to be written back; the caller
+ * writes back the descriptors of a batch with a single DMA write.
+ */
 static uint32_t
-e1000e_txdesc_writeback(E1000ECore *core, dma_addr_t base,
-                        struct e1000_tx_desc *dp, bool *ide, int queue_idx)
+e1000e_txdesc_writeback(E1000ECore *core, struct e1000_tx_desc *dp,
+                        bool *ide, int queue_idx)
 {
     uint32_t txd_upper, txd_lower = le32_to_cpu(dp->lower.data);
 
@@ -778,8 +796,6 @@ e1000e_txdesc_writeback(E1000ECore *core, dma_addr_t base,
     txd_upper = le32_to_cpu(dp->upper.data) | E1000_TXD_STAT_DD;
 
     dp->upper.data = cpu_to_le32(txd_upper);
-    pci_dma_write(core->owner, base + ((char *)&dp->upper - (char *)dp),
-                  &dp->upper, sizeof(dp->upper));
     return e1000e_tx_wb_interrupt_cause(core, queue_idx);
 }
 
@@ -842,6 +858,24 @@ e1000e_ring_free_descr_num(E1000ECore *core, const E1000ERingInfo *r)
     g_assert_not_reached();
 }
 
+/*
+ * Number of descriptors from the head that the guest has made available,
+ * without wrapping around the end of the ring, and at most @max.
+ */
+static inline uint32_t
+e1000e_ring_contig_descr_num(E1000ECore *core, const E1000ERingInfo *r,
+                             uint32_t max)
+{
+    uint32_t ring_size = core->mac[r->dlen] / E1000_RING_DESC_LEN;
+    uint32_t num = e1000e_ring_free_descr_num(core, r);
+
+    if (core->mac[r->dh] < ring_size) {
+        num = MIN(num, ring_size - core->mac[r->dh]);
+    }
+
+    return MIN(num, max);
+}
+
 static inline bool
 e1000e_ring_enabled(E1000ECore *core, const E1000ERingInfo *r)
 {
@@ -900,10 +934,11 @@ static void
 e1000e_start_xmit(E1000ECore *core, const E1000E_TxRing *txr)
 {
     dma_addr_t base;
-    struct e1000_tx_desc desc;
+    struct e1000_tx_desc desc[E1000E_TX_DESC_BATCH];
     bool ide = false;
     const E1000ERingInfo *txi = txr->i;
     uint32_t cause = E1000_ICS_TXQE;
+    uint32_t count, i, wb_first, wb_last, wb_cause;
 
     if (!(core->mac[TCTL] & E1000_TCTL_EN)) {
         trace_e1000e_tx_disabled();
@@ -912,16 +947,38 @@ e1000e_start_xmit(E1000ECore *core, const E1000E_TxRing *txr)
 
     while (!e1000e_ring_empty(core, txi)) {
         base = e1000e_ring_head_descr(core, txi);
+        count = e1000e_ring_contig_descr_num(core, txi, E1000E_TX_DESC_BATCH);
+
+        pci_dma_read(core->owner, base, desc, count * sizeof(desc[0]));
+        trace_e1000e_tx_descr_batch(txi->idx, count, base);
+
+        wb_first = count;
+        wb_last = 0;
+        for (i = 0; i < count; i++) {
+            trace_e1000e_tx_descr((void *)(intptr_t)desc[i].buffer_addr,
+                                  desc[i].lower.data, desc[i].upper.data);
+
+            e1000e_process_tx_desc(core, txr->tx, &desc[i], txi->idx);
+            wb_cause = e1000e_txdesc_writeback(core, &desc[i], &ide, txi->idx);
+            if (wb_cause) {
+                cause |= wb_cause;
+                wb_first = MIN(wb_first, i);
+                wb_last = i;
+            }
 
-        pci_dma_read(core->owner, base, &desc, sizeof(desc));
-
-        trace_e1000e_tx_descr((void *)(intptr_t)desc.buffer_addr,
-                              desc.lower.data, desc.upper.data);
-
-        e1000e_process_tx_desc(core, txr->tx, &desc, txi->idx);
-        cause |= e1000e_txdesc_writeback(core, base, &desc, &ide, txi->idx);
+            e1000e_ring_advance(core, txi, 1);
+        }
 
-        e1000e_ring_advance(core, txi, 1);
+        /*
+         * Descriptors between the head and the tail belong to the device,
+         * so the ones in between that need no write back can be written
+         * with their unchanged contents.
+         */
+        if (wb_first < count) {
+            pci_dma_write(core->owner, base + wb_first * sizeof(desc[0]),
+                          &desc[wb_first],
+                          (wb_last - wb_first + 1) * sizeof(desc[0]));
+        }
     }
 
     if (!ide || !e1000e_intrmgr_delay_tx_causes(core, &cause)) {
@@ -1478,12 +1535,71 @@ e1000e_do_ps(E1000ECore *core, struct NetRxPkt *pkt, size_t *hdr_len)
     return true;
 }
 
+static void
+e1000e_rx_desc_cache_reset(E1000ECore *core)
+{
+    int i;
+
+    for (i = 0; i < E1000E_NUM_QUEUES; i++) {
+        core->rx_desc_cache[i].avail = 0;
+    }
+}
+
+/* Drop prefetched descriptors when the guest sets up an RX ring again */
+static void
+e1000e_rx_desc_cache_check_write(E1000ECore *core, int index)
+{
+    switch (index) {
+    case RCTL:
+    case RFCTL:
+    case RDBAL0:
+    case RDBAH0:
+    case RDLEN0:
+    case RDH0:
+    case RDBAL1:
+    case RDBAH1:
+    case RDLEN1:
+    case RDH1:
+        e1000e_rx_desc_cache_reset(core);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Read the RX descriptor at the head of the ring, fetching the following
+ * descriptors the guest has made available along with it.
+ */
+static void
+e1000e_rx_desc_fetch(E1000ECore *core, const E1000ERingInfo *rxi,
+                     dma_addr_t base, union e1000_rx_desc_union *desc)
+{
+    E1000ERxDescCache *cache = &core->rx_desc_cache[rxi->idx];
+    uint32_t len = core->rx_desc_len;
+
+    if (cache->avail < len || cache->next != base) {
+        uint32_t num = e1000e_ring_contig_descr_num(core, rxi,
+                                                    E1000E_RX_DESC_PREFETCH);
+
+        cache->avail = MAX(num * E1000_RING_DESC_LEN / len, 1) * len;
+        cache->offset = 0;
+        cache->next = base;
+        pci_dma_read(core->owner, base, cache->buf, cache->avail);
+        trace_e1000e_rx_descr_prefetch(rxi->idx, cache->avail, base);
+    }
+
+    memcpy(desc, cache->buf + cache->offset, len);
+    cache->offset += len;
+    cache->avail -= len;
+    cache->next += len;
+}
+
 static void
 e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
                              const E1000E_RxRing *rxr,
                              const E1000E_RSSInfo *rss_info)
 {
-    PCIDevice *d = core->owner;
     dma_addr_t base;
     union e1000_rx_desc_union desc;
     size_t desc_size;
@@ -1517,7 +1633,7 @@ e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
 
         base = e1000e_ring_head_descr(core, rxi);
 
-        pci_dma_read(d, base, &desc, core->rx_desc_len);
+        e1000e_rx_desc_fetch(core, rxi, base, &desc);
 
         trace_e1000e_rx_descr(rxi->idx, base, core->rx_desc_len);
 
@@ -1946,6 +2062,26 @@ void(*e1000e_phyreg_writeops[E1000E_PHY_PAGES][E1000E_PHY_PAGE_SIZE])
     }
 };
 
+static void
+e1000e_intrmgr_adaptive_timer(E1000IntrDelayTimer *timer)
+{
+    int64_t now = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+
+    if (now - timer->last_irq_ns < E1000E_AITR_BURST_NS) {
+        timer->burst++;
+    } else {
+        timer->burst = 0;
+    }
+    timer->last_irq_ns = now;
+
+    if (timer->burst >= E1000E_AITR_BURST_LEN) {
+        trace_e1000e_irq_adaptive_timer(timer->delay_reg << 2,
+                                        E1000E_AITR_INTERVAL_NS);
+        timer_mod(timer->timer, now + E1000E_AITR_INTERVAL_NS);
+        timer->running = true;
+    }
+}
+
 static inline bool
 e1000e_postpone_interrupt(E1000IntrDelayTimer *timer)
 {
@@ -1957,6 +2093,8 @@ e1000e_postpone_interrupt(E1000IntrDelayTimer *timer)
 
     if (timer->core->mac[timer->delay_reg] != 0) {
         e1000e_intrmgr_rearm_timer(timer);
+    } else if (timer->core->adaptive_itr) {
+        e1000e_intrmgr_adaptive_timer(timer);
     }
 
     return false;
@@ -3280,6 +3418,7 @@ e1000e_core_write(E1000ECore *core, hwaddr addr, uint64_t val, unsigned size)
         }
         trace_e1000e_core_write(index << 2, size, val);
         e1000e_macreg_writeops[index](core, index, val);
+        e1000e_rx_desc_cache_check_write(core, index);
     } else if (index < E1000E_NREADOPS && e1000e_macreg_readops[index]) {
         trace_e1000e_wrn_regs_write_ro(index << 2, size, val);
     } else {
@@ -3455,6 +3594,7 @@ static void e1000e_reset(E1000ECore *core, bool sw)
     timer_del(core->autoneg_timer);
 
     e1000e_intrmgr_reset(core);
+    e1000e_rx_desc_cache_reset(core);
 
     memset(core->phy, 0, sizeof core->phy);
     memcpy(core->phy, e1000e_phy_reg_init, sizeof e1000e_phy_reg_init);
@@ -3527,6 +3667,7 @@ e1000e_core_post_load(E1000ECore *core)
      */
     e1000e_intrmgr_resume(core);
     e1000e_autoneg_resume(core);
+    e1000e_rx_desc_cache_reset(core);
 
     return 0;
 }
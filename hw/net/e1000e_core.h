@@ -42,6 +42,7 @@
 #define E1000E_EEPROM_SIZE      (64)
 #define E1000E_MSIX_VEC_NUM     (5)
 #define E1000E_NUM_QUEUES       (2)
+#define E1000E_RX_DESC_PREFETCH (32)
 
 typedef struct E1000Core E1000ECore;
 
@@ -56,8 +57,25 @@ typedef struct E1000IntrDelayTimer_st {
     uint32_t delay_reg;
     uint32_t delay_resolution_ns;
     E1000ECore *core;
+
+    /* Adaptive moderation state, used while the delay register is 0 */
+    int64_t last_irq_ns;
+    uint32_t burst;
 } E1000IntrDelayTimer;
 
+/*
+ * RX descriptors read ahead of the head pointer.  Only descriptors the
+ * guest has already handed to the device are fetched, and each is used
+ * once, so the cache only needs to be dropped when the ring is set up
+ * again.
+ */
+typedef struct E1000ERxDescCache {
+    uint8_t buf[E1000E_RX_DESC_PREFETCH * E1000_RING_DESC_LEN];
+    dma_addr_t next;
+    uint32_t offset;
+    uint32_t avail;
+} E1000ERxDescCache;
+
 struct E1000Core {
     uint32_t mac[E1000E_MAC_SIZE];
     uint16_t phy[E1000E_PHY_PAGES][E1000E_PHY_PAGE_SIZE];
@@ -80,11 +98,13 @@ struct E1000Core {
     } tx[E1000E_NUM_QUEUES];
 
     struct NetRxPkt *rx_pkt;
+    E1000ERxDescCache rx_desc_cache[E1000E_NUM_QUEUES];
 
     bool has_vnet;
     int max_queue_num;
 
     /* Interrupt moderation management */
+    bool adaptive_itr;
     uint32_t delayed_causes;
 
     E1000IntrDelayTimer radv;
@@ -594,6 +594,7 @@ static const VMStateDescription igb_vmstate = {
 static const Property igb_properties[] = {
     DEFINE_NIC_PROPERTIES(IGBState, conf),
     DEFINE_PROP_BOOL("x-pcie-flr-init", IGBState, has_flr, true),
+    DEFINE_PROP_BOOL("adaptive-itr", IGBState, core.adaptive_itr, true),
 };
 
 static void igb_class_init(ObjectClass *class, void *data)
@@ -90,6 +90,20 @@ typedef struct PTP2 {
     uint8_t log_message_period;
 } PTP2;
 
+/* Maximum number of TX descriptors fetched with a single DMA read */
+#define IGB_TX_DESC_BATCH       (32)
+
+/*
+ * Adaptive interrupt moderation, used for a vector whose EITR is 0:
+ * after IGB_AITR_BURST_LEN interrupts less than IGB_AITR_BURST_NS apart,
+ * further interrupts are held back for IGB_AITR_INTERVAL_NS, which caps
+ * the rate at about 20000 per second under load while a lightly loaded
+ * link keeps per-packet interrupts.
+ */
+#define IGB_AITR_BURST_NS       (100 * SCALE_US)
+#define IGB_AITR_BURST_LEN      (8)
+#define IGB_AITR_INTERVAL_NS    (50 * SCALE_US)
+
 static ssize_t
 igb_receive_internal(IGBCore *core, const struct iovec *iov, int iovcnt,
                      bool has_vnet, bool *external_tx);
@@ -748,6 +762,24 @@ igb_ring_free_descr_num(IGBCore *core, const E1000ERingInfo *r)
     g_assert_not_reached();
 }
 
+/*
+ * Number of descriptors from the head that the guest has made available,
+ * without wrapping around the end of the ring, and at most @max.
+ */
+static inline uint32_t
+igb_ring_contig_descr_num(IGBCore *core, const E1000ERingInfo *r,
+                          uint32_t max)
+{
+    uint32_t ring_size = core->mac[r->dlen] / E1000_RING_DESC_LEN;
+    uint32_t num = igb_ring_free_descr_num(core, r);
+
+    if (core->mac[r->dh] < ring_size) {
+        num = MIN(num, ring_size - core->mac[r->dh]);
+    }
+
+    return MIN(num, max);
+}
+
 static inline bool
 igb_ring_enabled(IGBCore *core, const E1000ERingInfo *r)
 {
@@ -824,39 +856,40 @@ igb_rx_ring_init(IGBCore *core, E1000E_RxRing *rxr, int idx)
     rxr->i      = &i[idx];
 }
 
-static uint32_t
-igb_txdesc_writeback(IGBCore *core, dma_addr_t base,
-                     union e1000_adv_tx_desc *tx_desc,
-                     const E1000ERingInfo *txi)
+static inline uint64_t
+igb_tx_wb_addr(IGBCore *core, const E1000ERingInfo *txi)
 {
-    PCIDevice *d;
-    uint32_t cmd_type_len = le32_to_cpu(tx_desc->read.cmd_type_len);
     uint64_t tdwba;
 
     tdwba = core->mac[E1000_TDWBAL(txi->idx) >> 2];
     tdwba |= (uint64_t)core->mac[E1000_TDWBAH(txi->idx) >> 2] << 32;
 
-    if (!(cmd_type_len & E1000_TXD_CMD_RS)) {
-        return 0;
-    }
+    return tdwba;
+}
 
-    d = pcie_sriov_get_vf_at_index(core->owner, txi->idx % 8);
-    if (!d) {
-        d = core->owner;
+/*
+ * Return whether the descriptor needs a write back and set DD in it
+ * unless the head is written back instead.  The caller does the DMA
+ * once per batch of descriptors.
+ */
+static bool
+igb_txdesc_writeback(IGBCore *core, union e1000_adv_tx_desc *tx_desc,
+                     const E1000ERingInfo *txi, uint32_t *eic)
+{
+    uint32_t cmd_type_len = le32_to_cpu(tx_desc->read.cmd_type_len);
+
+    if (!(cmd_type_len & E1000_TXD_CMD_RS)) {
+        return false;
     }
 
-    if (tdwba & 1) {
-        uint32_t buffer = cpu_to_le32(core->mac[txi->dh]);
-        pci_dma_write(d, tdwba & ~3, &buffer, sizeof(buffer));
-    } else {
+    if (!(igb_tx_wb_addr(core, txi) & 1)) {
         uint32_t status = le32_to_cpu(tx_desc->wb.status) | E1000_TXD_STAT_DD;
 
         tx_desc->wb.status = cpu_to_le32(status);
-        pci_dma_write(d, base + offsetof(union e1000_adv_tx_desc, wb),
-            &tx_desc->wb, sizeof(tx_desc->wb));
     }
 
-    return igb_tx_wb_eic(core, txi->idx);
+    *eic |= igb_tx_wb_eic(core, txi->idx);
+    return true;
 }
 
 static inline bool
@@ -876,9 +909,12 @@ igb_start_xmit(IGBCore *core, const IGB_TxRing *txr)
 {
     PCIDevice *d;
     dma_addr_t base;
-    union e1000_adv_tx_desc desc;
+    union e1000_adv_tx_desc desc[IGB_TX_DESC_BATCH];
     const E1000ERingInfo *txi = txr->i;
     uint32_t eic = 0;
+    uint64_t tdwba = igb_tx_wb_addr(core, txi);
+    bool head_wb = false;
+    uint32_t count, i, wb_first, wb_last;
 
     if (!igb_tx_enabled(core, txi)) {
         trace_e1000e_tx_disabled();
@@ -892,15 +928,46 @@ igb_start_xmit(IGBCore *core, const IGB_TxRing *txr)
 
     while (!igb_ring_empty(core, txi)) {
         base = igb_ring_head_descr(core, txi);
+        count = igb_ring_contig_descr_num(core, txi, IGB_TX_DESC_BATCH);
+
+        pci_dma_read(d, base, desc, count * sizeof(desc[0]));
+        trace_e1000e_tx_descr_batch(txi->idx, count, base);
+
+        wb_first = count;
+        wb_last = 0;
+        for (i = 0; i < count; i++) {
+            trace_e1000e_tx_descr((void *)(intptr_t)desc[i].read.buffer_addr,
+                                  desc[i].read.cmd_type_len,
+                                  desc[i].wb.status);
+
+            igb_process_tx_desc(core, d, txr->tx, &desc[i], txi->idx);
+            igb_ring_advance(core, txi, 1);
+            if (!igb_txdesc_writeback(core, &desc[i], txi, &eic)) {
+                continue;
+            }
+            if (tdwba & 1) {
+                head_wb = true;
+            } else {
+                wb_first = MIN(wb_first, i);
+                wb_last = i;
+            }
+        }
 
-        pci_dma_read(d, base, &desc, sizeof(desc));
-
-        trace_e1000e_tx_descr((void *)(intptr_t)desc.read.buffer_addr,
-                              desc.read.cmd_type_len, desc.wb.status);
+        /*
+         * Descriptors between the head and the tail belong to the device,
+         * so the ones in between that need no write back can be written
+         * with their unchanged contents.
+         */
+        if (wb_first < count) {
+            pci_dma_write(d, base + wb_first * sizeof(desc[0]),
+                          &desc[wb_first],
+                          (wb_last - wb_first + 1) * sizeof(desc[0]));
+        }
+    }
 
-        igb_process_tx_desc(core, d, txr->tx, &desc, txi->idx);
-        igb_ring_advance(core, txi, 1);
-        eic |= igb_txdesc_writeback(core, base, &desc, txi);
+    if (head_wb) {
+        uint32_t buffer = cpu_to_le32(core->mac[txi->dh]);
+        pci_dma_write(d, tdwba & ~3, &buffer, sizeof(buffer));
     }
 
     if (eic) {
@@ -1889,6 +1956,67 @@ igb_write_to_rx_buffers(IGBCore *core,
     igb_write_payload_to_rx_buffers(core, pkt, d, pdma_st, &copy_size);
 }
 
+static void
+igb_rx_desc_cache_reset(IGBCore *core)
+{
+    int i;
+
+    for (i = 0; i < IGB_NUM_QUEUES; i++) {
+        core->rx_desc_cache[i].avail = 0;
+    }
+}
+
+/* Drop prefetched descriptors when the guest sets up an RX ring again */
+static void
+igb_rx_desc_cache_check_write(IGBCore *core, int index)
+{
+    E1000E_RxRing rxr;
+    int i;
+
+    if (index == RCTL || index == RFCTL) {
+        igb_rx_desc_cache_reset(core);
+        return;
+    }
+
+    for (i = 0; i < IGB_NUM_QUEUES; i++) {
+        igb_rx_ring_init(core, &rxr, i);
+        if (index == rxr.i->dbal || index == rxr.i->dbah ||
+            index == rxr.i->dlen || index == rxr.i->dh ||
+            index == E1000_SRRCTL(i) >> 2 || index == RXDCTL0 + i * 16) {
+            core->rx_desc_cache[i].avail = 0;
+            return;
+        }
+    }
+}
+
+/*
+ * Read the RX descriptor at the head of the ring, fetching the following
+ * descriptors the guest has made available along with it.
+ */
+static void
+igb_rx_desc_fetch(IGBCore *core, PCIDevice *d, const E1000ERingInfo *rxi,
+                  dma_addr_t base, union e1000_rx_desc_union *desc)
+{
+    IGBRxDescCache *cache = &core->rx_desc_cache[rxi->idx];
+    uint32_t len = core->rx_desc_len;
+
+    if (cache->avail < len || cache->next != base) {
+        uint32_t num = igb_ring_contig_descr_num(core, rxi,
+                                                 IGB_RX_DESC_PREFETCH);
+
+        cache->avail = MAX(num * E1000_RING_DESC_LEN / len, 1) * len;
+        cache->offset = 0;
+        cache->next = base;
+        pci_dma_read(d, base, cache->buf, cache->avail);
+        trace_e1000e_rx_descr_prefetch(rxi->idx, cache->avail, base);
+    }
+
+    memcpy(desc, cache->buf + cache->offset, len);
+    cache->offset += len;
+    cache->avail -= len;
+    cache->next += len;
+}
+
 static void
 igb_write_packet_to_guest(IGBCore *core, struct NetRxPkt *pkt,
                           const E1000E_RxRing *rxr,
@@ -1927,7 +2055,7 @@ igb_write_packet_to_guest(IGBCore *core, struct NetRxPkt *pkt,
         }
 
         base = igb_ring_head_descr(core, rxi);
-        pci_dma_read(d, base, &desc, rx_desc_len);
+        igb_rx_desc_fetch(core, d, rxi, base, &desc);
         trace_e1000e_rx_descr(rxi->idx, base, rx_desc_len);
 
         igb_read_rx_descr(core, &desc, &pdma_st, rxi);
@@ -2237,6 +2365,26 @@ igb_set_rx_control(IGBCore *core, int index, uint32_t val)
     }
 }
 
+static void
+igb_intrmgr_adaptive_timer(IGBIntrDelayTimer *timer)
+{
+    int64_t now = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+
+    if (now - timer->last_irq_ns < IGB_AITR_BURST_NS) {
+        timer->burst++;
+    } else {
+        timer->burst = 0;
+    }
+    timer->last_irq_ns = now;
+
+    if (timer->burst >= IGB_AITR_BURST_LEN) {
+        trace_e1000e_irq_adaptive_timer(timer->delay_reg << 2,
+                                        IGB_AITR_INTERVAL_NS);
+        timer_mod(timer->timer, now + IGB_AITR_INTERVAL_NS);
+        timer->running = true;
+    }
+}
+
 static inline bool
 igb_postpone_interrupt(IGBIntrDelayTimer *timer)
 {
@@ -2248,6 +2396,8 @@ igb_postpone_interrupt(IGBIntrDelayTimer *timer)
 
     if (timer->core->mac[timer->delay_reg] != 0) {
         igb_intrmgr_rearm_timer(timer);
+    } else if (timer->core->adaptive_itr) {
+        igb_intrmgr_adaptive_timer(timer);
     }
 
     return false;
@@ -2469,6 +2619,8 @@ void igb_core_vf_reset(IGBCore *core, uint16_t vfn)
     core->mac[RXDCTL0 + (qn1 * 16)] &= ~E1000_RXDCTL_QUEUE_ENABLE;
     core->mac[TXDCTL0 + (qn0 * 16)] &= ~E1000_TXDCTL_QUEUE_ENABLE;
     core->mac[TXDCTL0 + (qn1 * 16)] &= ~E1000_TXDCTL_QUEUE_ENABLE;
+    core->rx_desc_cache[qn0].avail = 0;
+    core->rx_desc_cache[qn1].avail = 0;
     core->mac[VFRE] &= ~BIT(vfn);
     core->mac[VFTE] &= ~BIT(vfn);
     /* indicate VF reset to PF */
@@ -4244,6 +4396,7 @@ igb_core_write(IGBCore *core, hwaddr addr, uint64_t val, unsigned size)
         }
         trace_e1000e_core_write(index << 2, size, val);
         igb_macreg_writeops[index](core, index, val);
+        igb_rx_desc_cache_check_write(core, index);
     } else if (index < IGB_NREADOPS && igb_macreg_readops[index]) {
         trace_e1000e_wrn_regs_write_ro(index << 2, size, val);
     } else {
@@ -4467,6 +4620,7 @@ static void igb_reset(IGBCore *core, bool sw)
     timer_del(core->autoneg_timer);
 
     igb_intrmgr_reset(core);
+    igb_rx_desc_cache_reset(core);
 
     memset(core->phy, 0, sizeof core->phy);
     memcpy(core->phy, igb_phy_reg_init, sizeof igb_phy_reg_init);
@@ -4546,6 +4700,7 @@ igb_core_post_load(IGBCore *core)
      */
     igb_intrmgr_resume(core);
     igb_autoneg_resume(core);
+    igb_rx_desc_cache_reset(core);
 
     return 0;
 }
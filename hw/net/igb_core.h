@@ -48,6 +48,7 @@
 #define IGBVF_MSIX_VEC_NUM      (3)
 #define IGB_NUM_QUEUES          (16)
 #define IGB_NUM_VM_POOLS        (8)
+#define IGB_RX_DESC_PREFETCH    (32)
 
 typedef struct IGBCore IGBCore;
 
@@ -61,8 +62,25 @@ typedef struct IGBIntrDelayTimer_st {
     uint32_t delay_reg;
     uint32_t delay_resolution_ns;
     IGBCore *core;
+
+    /* Adaptive moderation state, used while the delay register is 0 */
+    int64_t last_irq_ns;
+    uint32_t burst;
 } IGBIntrDelayTimer;
 
+/*
+ * RX descriptors read ahead of the head pointer.  Only descriptors the
+ * guest has already handed to the device are fetched, and each is used
+ * once, so the cache only needs to be dropped when the ring is set up
+ * again.
+ */
+typedef struct IGBRxDescCache {
+    uint8_t buf[IGB_RX_DESC_PREFETCH * E1000_RING_DESC_LEN];
+    dma_addr_t next;
+    uint32_t offset;
+    uint32_t avail;
+} IGBRxDescCache;
+
 struct IGBCore {
     uint32_t mac[E1000E_MAC_SIZE];
     uint16_t phy[MAX_PHY_REG_ADDRESS + 1];
@@ -84,10 +102,12 @@ struct IGBCore {
     } tx[IGB_NUM_QUEUES];
 
     struct NetRxPkt *rx_pkt;
+    IGBRxDescCache rx_desc_cache[IGB_NUM_QUEUES];
 
     bool has_vnet;
     int max_queue_num;
 
+    bool adaptive_itr;
     IGBIntrDelayTimer eitr[IGB_INTR_NUM];
 
     uint32_t eitr_guest_value[IGB_INTR_NUM];
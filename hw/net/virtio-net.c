@@ -34,6 +34,8 @@
 #include "qapi/error.h"
 #include "qapi/qapi-events-net.h"
 #include "hw/qdev-properties.h"
+#include "hw/qdev-properties-system.h"
+#include "hw/virtio/iothread-vq-mapping.h"
 #include "qapi/qapi-types-migration.h"
 #include "qapi/qapi-events-migration.h"
 #include "hw/virtio/virtio-access.h"
@@ -374,14 +376,33 @@ static void virtio_net_vnet_endian_status(VirtIONet *n, uint8_t status)
     }
 }
 
+/*
+ * Queue pairs running in an IOThread cannot use virtio_notify() since it may
+ * inject the interrupt from outside the BQL; go through the irqfd instead.
+ */
+static void virtio_net_notify(VirtIONetQueue *q, VirtQueue *vq)
+{
+    VirtIODevice *vdev = VIRTIO_DEVICE(q->n);
+
+    if (q->ctx) {
+        virtio_notify_irqfd(vdev, vq);
+    } else {
+        virtio_notify(vdev, vq);
+    }
+}
+
 static void virtio_net_drop_tx_queue_data(VirtIODevice *vdev, VirtQueue *vq)
 {
+    VirtIONet *n = VIRTIO_NET(vdev);
     unsigned int dropped = virtqueue_drop_all(vq);
     if (dropped) {
-        virtio_notify(vdev, vq);
+        virtio_net_notify(&n->vqs[vq2q(virtio_get_queue_index(vq))], vq);
     }
 }
 
+static void virtio_net_dataplane_start(VirtIONet *n, uint8_t status);
+static void virtio_net_dataplane_stop(VirtIONet *n);
+
 static void virtio_net_set_status(struct VirtIODevice *vdev, uint8_t status)
 {
     VirtIONet *n = VIRTIO_NET(vdev);
@@ -389,6 +410,9 @@ static void virtio_net_set_status(struct VirtIODevice *vdev, uint8_t status)
     int i;
     uint8_t queue_status;
 
+    /* Everything below runs with the queue pairs back in the main loop */
+    virtio_net_dataplane_stop(n);
+
     virtio_net_vnet_endian_status(n, status);
     virtio_net_vhost_status(n, status);
 
@@ -437,6 +461,8 @@ static void virtio_net_set_status(struct VirtIODevice *vdev, uint8_t status)
             }
         }
     }
+
+    virtio_net_dataplane_start(n, status);
 }
 
 static void virtio_net_set_link_status(NetClientState *nc)
@@ -791,6 +817,14 @@ static uint64_t virtio_net_get_features(VirtIODevice *vdev, uint64_t features,
         virtio_clear_feature(&features, VIRTIO_NET_F_GUEST_USO6);
     }
 
+    /*
+     * A virtqueue is reset from the vCPU thread, while the IOThread of its
+     * queue pair may be using it.
+     */
+    if (n->iothread_vq_mapping_list) {
+        virtio_clear_feature(&features, VIRTIO_F_RING_RESET);
+    }
+
     if (!get_vhost_net(nc->peer)) {
         return features;
     }
@@ -1283,6 +1317,107 @@ static void virtio_net_detach_ebpf_rss(VirtIONet *n)
     virtio_net_attach_ebpf_to_backend(n->nic, -1);
 }
 
+#define VIRTIO_NET_FLOW_CACHE_BITS      10
+/* Pinned flows are refreshed at this interval, the kernel table is LRU */
+#define VIRTIO_NET_FLOW_REFRESH_NS      (100 * SCALE_MS)
+
+static void virtio_net_update_flow_steering(VirtIONet *n)
+{
+    bool active = n->rss_flow_steering && n->rss_data.enabled &&
+                  !n->rss_data.enabled_software_rss &&
+                  ebpf_rss_has_flow_table(&n->ebpf_rss);
+    int i;
+
+    /* Queue pairs are stopped, or processed with the BQL held */
+    ebpf_rss_clear_flows(&n->ebpf_rss);
+    for (i = 0; i < n->max_queue_pairs; i++) {
+        VirtIONetQueue *q = &n->vqs[i];
+
+        if (q->flow_cache) {
+            memset(q->flow_cache, 0, sizeof(VirtIONetFlowCacheEntry) <<
+                   VIRTIO_NET_FLOW_CACHE_BITS);
+        } else if (active) {
+            q->flow_cache = g_new0(VirtIONetFlowCacheEntry,
+                                   1 << VIRTIO_NET_FLOW_CACHE_BITS);
+        }
+    }
+    n->flow_steering_active = active;
+}
+
+/*
+ * Pin the reverse flow of a packet that the guest transmits on queue
+ * pair @index, so that replies are received on the same queue pair.
+ */
+static void virtio_net_learn_flow(VirtIONetQueue *q, int index,
+                                  const struct iovec *iov, unsigned iov_cnt,
+                                  int64_t now)
+{
+    VirtIONet *n = q->n;
+    uint8_t buf[ETH_HLEN + 4 + 60 + 4];
+    struct EBPFRSSFlowKey key = { 0 };
+    VirtIONetFlowCacheEntry *entry;
+    size_t len, l3 = ETH_HLEN, l4;
+    uint16_t type;
+    uint32_t hash;
+    uint8_t proto;
+
+    len = iov_to_buf(iov, iov_cnt, n->host_hdr_len, buf, sizeof(buf));
+    if (len < ETH_HLEN) {
+        return;
+    }
+
+    type = lduw_be_p(buf + 12);
+    if (type == ETH_P_VLAN) {
+        if (len < l3 + 4) {
+            return;
+        }
+        type = lduw_be_p(buf + 16);
+        l3 += 4;
+    }
+
+    if (type == ETH_P_IP) {
+        if (len < l3 + sizeof(struct ip_header) ||
+            (lduw_be_p(buf + l3 + 6) & (IP_MF | IP_OFFMASK))) {
+            return;
+        }
+        proto = buf[l3 + 9];
+        l4 = l3 + ((buf[l3] & 0xf) << 2);
+        memcpy(key.src, buf + l3 + 16, 4);
+        memcpy(key.dst, buf + l3 + 12, 4);
+    } else if (type == ETH_P_IPV6) {
+        if (len < l3 + sizeof(struct ip6_header)) {
+            return;
+        }
+        proto = buf[l3 + 6];
+        l4 = l3 + sizeof(struct ip6_header);
+        memcpy(key.src, buf + l3 + 24, 16);
+        memcpy(key.dst, buf + l3 + 8, 16);
+    } else {
+        return;
+    }
+
+    if ((proto != IP_PROTO_TCP && proto != IP_PROTO_UDP) || len < l4 + 4) {
+        return;
+    }
+    key.protocol = proto;
+    memcpy(&key.src_port, buf + l4 + 2, 2);
+    memcpy(&key.dst_port, buf + l4, 2);
+
+    hash = ldl_he_p(key.src) ^ ldl_he_p(key.src + 12) ^
+           ldl_he_p(key.dst) ^ ldl_he_p(key.dst + 12) ^
+           ((uint32_t)key.src_port << 16 | key.dst_port);
+    hash = (hash * 0x9e3779b1) >> (32 - VIRTIO_NET_FLOW_CACHE_BITS);
+    entry = &q->flow_cache[hash];
+
+    if (entry->expire > now && !memcmp(&entry->key, &key, sizeof(key))) {
+        return;
+    }
+    if (ebpf_rss_set_flow(&n->ebpf_rss, &key, index)) {
+        entry->key = key;
+        entry->expire = now + VIRTIO_NET_FLOW_REFRESH_NS;
+    }
+}
+
 static void virtio_net_commit_rss_config(VirtIONet *n)
 {
     if (n->rss_data.enabled) {
@@ -1306,6 +1441,8 @@ static void virtio_net_commit_rss_config(VirtIONet *n)
         virtio_net_detach_ebpf_rss(n);
         trace_virtio_net_rss_disable(n);
     }
+
+    virtio_net_update_flow_steering(n);
 }
 
 static void virtio_net_disable_rss(VirtIONet *n)
@@ -1590,8 +1727,16 @@ size_t virtio_net_handle_ctrl_iov(VirtIODevice *vdev,
 
 static void virtio_net_handle_ctrl(VirtIODevice *vdev, VirtQueue *vq)
 {
+    VirtIONet *n = VIRTIO_NET(vdev);
     VirtQueueElement *elem;
 
+    /*
+     * Control commands touch filtering, offload and queue pair state that the
+     * IOThreads read without locking, so bring the queue pairs home first.
+     */
+    n->dataplane_paused++;
+    virtio_net_dataplane_stop(n);
+
     for (;;) {
         size_t written;
         elem = virtqueue_pop(vq, sizeof(VirtQueueElement));
@@ -1611,6 +1756,10 @@ static void virtio_net_handle_ctrl(VirtIODevice *vdev, VirtQueue *vq)
             break;
         }
     }
+
+    if (--n->dataplane_paused == 0) {
+        virtio_net_dataplane_start(n, vdev->status);
+    }
 }
 
 /* RX */
@@ -2040,7 +2189,11 @@ static ssize_t virtio_net_receive_rcu(NetClientState *nc, const uint8_t *buf,
     }
 
     virtqueue_flush(q->rx_vq, i);
-    virtio_notify(vdev, q->rx_vq);
+    if (q->rx_batch) {
+        q->rx_notify_pending = true;
+    } else {
+        virtio_net_notify(q, q->rx_vq);
+    }
 
     return size;
 
@@ -2686,11 +2839,10 @@ static void virtio_net_tx_complete(NetClientState *nc, ssize_t len)
 {
     VirtIONet *n = qemu_get_nic_opaque(nc);
     VirtIONetQueue *q = virtio_net_get_subqueue(nc);
-    VirtIODevice *vdev = VIRTIO_DEVICE(n);
     int ret;
 
     virtqueue_push(q->tx_vq, q->async_tx.elem, 0);
-    virtio_notify(vdev, q->tx_vq);
+    virtio_net_notify(q, q->tx_vq);
 
     g_free(q->async_tx.elem);
     q->async_tx.elem = NULL;
@@ -2715,13 +2867,14 @@ static void virtio_net_tx_complete(NetClientState *nc, ssize_t len)
 }
 
 /* TX */
-static int32_t virtio_net_flush_tx(VirtIONetQueue *q)
+static int32_t virtio_net_do_flush_tx(VirtIONetQueue *q)
 {
     VirtIONet *n = q->n;
     VirtIODevice *vdev = VIRTIO_DEVICE(n);
     VirtQueueElement *elem;
     int32_t num_packets = 0;
     int queue_index = vq2q(virtio_get_queue_index(q->tx_vq));
+    int64_t now = n->flow_steering_active ? get_clock() : 0;
     if (!(vdev->status & VIRTIO_CONFIG_S_DRIVER_OK)) {
         return num_packets;
     }
@@ -2792,6 +2945,10 @@ static int32_t virtio_net_flush_tx(VirtIONetQueue *q)
             }
         }
 
+        if (n->flow_steering_active) {
+            virtio_net_learn_flow(q, queue_index, out_sg, out_num, now);
+        }
+
         ret = qemu_sendv_packet_async(qemu_get_subqueue(n->nic, queue_index),
                                       out_sg, out_num, virtio_net_tx_complete);
         if (ret == 0) {
@@ -2802,7 +2959,7 @@ static int32_t virtio_net_flush_tx(VirtIONetQueue *q)
 
 drop:
         virtqueue_push(q->tx_vq, elem, 0);
-        virtio_notify(vdev, q->tx_vq);
+        virtio_net_notify(q, q->tx_vq);
         g_free(elem);
 
         if (++num_packets >= n->tx_burst) {
@@ -2817,6 +2974,18 @@ detach:
     return -EINVAL;
 }
 
+/* Let the backend batch its writes, e.g. into a single system call */
+static int32_t virtio_net_flush_tx(VirtIONetQueue *q)
+{
+    NetClientState *nc = qemu_get_subqueue(q->n->nic, q - q->n->vqs);
+    int32_t ret;
+
+    qemu_net_begin_batch(nc);
+    ret = virtio_net_do_flush_tx(q);
+    qemu_net_end_batch(nc);
+    return ret;
+}
+
 static void virtio_net_tx_timer(void *opaque);
 
 static void virtio_net_handle_tx_timer(VirtIODevice *vdev, VirtQueue *vq)
@@ -2973,6 +3142,219 @@ static void virtio_net_tx_bh(void *opaque)
     }
 }
 
+/*
+ * Move the tx timer or bottom half of a queue pair to @ctx, or back to the
+ * main loop if @ctx is NULL.  Pending work is not carried over; callers
+ * reschedule it if q->tx_waiting is set.
+ */
+static void virtio_net_queue_set_aio_context(VirtIONetQueue *q,
+                                             AioContext *ctx)
+{
+    MemReentrancyGuard *guard = &DEVICE(q->n)->mem_reentrancy_guard;
+
+    if (q->tx_timer) {
+        timer_free(q->tx_timer);
+        if (ctx) {
+            q->tx_timer = aio_timer_new(ctx, QEMU_CLOCK_VIRTUAL, SCALE_NS,
+                                        virtio_net_tx_timer, q);
+        } else {
+            q->tx_timer = timer_new_ns(QEMU_CLOCK_VIRTUAL,
+                                       virtio_net_tx_timer, q);
+        }
+    } else {
+        qemu_bh_delete(q->tx_bh);
+        if (ctx) {
+            q->tx_bh = aio_bh_new_guarded(ctx, virtio_net_tx_bh, q, guard);
+        } else {
+            q->tx_bh = qemu_bh_new_guarded(virtio_net_tx_bh, q, guard);
+        }
+    }
+    q->ctx = ctx;
+}
+
+static void virtio_net_queue_resched_tx(VirtIONetQueue *q)
+{
+    if (!q->tx_waiting) {
+        return;
+    }
+    if (q->tx_timer) {
+        timer_mod(q->tx_timer,
+                  qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) + q->n->tx_timeout);
+    } else {
+        qemu_bh_schedule(q->tx_bh);
+    }
+}
+
+/* Context: BQL held */
+static bool virtio_net_dataplane_allowed(VirtIONet *n, uint8_t status)
+{
+    int i;
+
+    if (!n->qp_aio_context || !n->ioeventfd_started || n->dataplane_paused) {
+        return false;
+    }
+    if (!virtio_net_started(n, status) || n->vhost_started) {
+        return false;
+    }
+    /* Software RSS hands packets to other queue pairs */
+    if (n->rss_data.enabled && n->rss_data.enabled_software_rss) {
+        return false;
+    }
+    for (i = 0; i < n->curr_queue_pairs; i++) {
+        NetClientState *nc = qemu_get_subqueue(n->nic, i);
+
+        if (!QTAILQ_EMPTY(&nc->filters) ||
+            !QTAILQ_EMPTY(&nc->peer->filters)) {
+            warn_report_once("%s: net filters are attached, queue pairs are "
+                             "processed in the main loop", nc->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Context: queue pair's IOThread */
+static void virtio_net_dataplane_start_bh(void *opaque)
+{
+    VirtIONetQueue *q = opaque;
+
+    virtio_queue_aio_attach_host_notifier(q->rx_vq, q->ctx);
+    virtio_queue_aio_attach_host_notifier(q->tx_vq, q->ctx);
+    virtio_net_queue_resched_tx(q);
+}
+
+/* Context: queue pair's IOThread */
+static void virtio_net_dataplane_stop_bh(void *opaque)
+{
+    VirtIONetQueue *q = opaque;
+    NetClientState *nc = qemu_get_subqueue(q->n->nic, q - q->n->vqs);
+
+    virtio_queue_aio_detach_host_notifier(q->rx_vq, q->ctx);
+    virtio_queue_aio_detach_host_notifier(q->tx_vq, q->ctx);
+    qemu_set_net_aio_context(nc->peer, NULL);
+
+    if (q->tx_timer) {
+        timer_del(q->tx_timer);
+    } else {
+        qemu_bh_cancel(q->tx_bh);
+    }
+}
+
+/*
+ * Hand the active queue pairs to their IOThreads.  Each pair's host notifiers,
+ * tx timer or bottom half and backend file descriptors move together, so a
+ * pair is only ever processed by one thread.
+ *
+ * Context: BQL held
+ */
+static void virtio_net_dataplane_start(VirtIONet *n, uint8_t status)
+{
+    int i;
+
+    if (n->dataplane_started || !virtio_net_dataplane_allowed(n, status)) {
+        return;
+    }
+
+    for (i = 0; i < n->curr_queue_pairs; i++) {
+        VirtIONetQueue *q = &n->vqs[i];
+        NetClientState *nc = qemu_get_subqueue(n->nic, i);
+        AioContext *ctx = n->qp_aio_context[i];
+
+        event_notifier_set_handler(virtio_queue_get_host_notifier(q->rx_vq),
+                                   NULL);
+        event_notifier_set_handler(virtio_queue_get_host_notifier(q->tx_vq),
+                                   NULL);
+        virtio_net_queue_set_aio_context(q, ctx);
+        qemu_set_net_aio_context(nc->peer, ctx);
+        aio_wait_bh_oneshot(ctx, virtio_net_dataplane_start_bh, q);
+    }
+    n->dataplane_started = true;
+    trace_virtio_net_dataplane(n, true, n->curr_queue_pairs);
+}
+
+/* Context: BQL held */
+static void virtio_net_dataplane_stop(VirtIONet *n)
+{
+    int i;
+
+    if (!n->dataplane_started) {
+        return;
+    }
+
+    for (i = 0; i < n->max_queue_pairs; i++) {
+        VirtIONetQueue *q = &n->vqs[i];
+        EventNotifier *rx_notifier, *tx_notifier;
+
+        if (!q->ctx) {
+            continue;
+        }
+
+        aio_wait_bh_oneshot(q->ctx, virtio_net_dataplane_stop_bh, q);
+        virtio_net_queue_set_aio_context(q, NULL);
+
+        /* Detaching may have left notifications disabled */
+        virtio_queue_set_notification(q->rx_vq, 1);
+        if (!q->tx_waiting) {
+            virtio_queue_set_notification(q->tx_vq, 1);
+        }
+
+        rx_notifier = virtio_queue_get_host_notifier(q->rx_vq);
+        tx_notifier = virtio_queue_get_host_notifier(q->tx_vq);
+        event_notifier_set_handler(rx_notifier,
+                                   virtio_queue_host_notifier_read);
+        event_notifier_set_handler(tx_notifier,
+                                   virtio_queue_host_notifier_read);
+        /* Pick up kicks that arrived while switching over */
+        event_notifier_set(rx_notifier);
+        event_notifier_set(tx_notifier);
+        virtio_net_queue_resched_tx(q);
+    }
+    n->dataplane_started = false;
+    trace_virtio_net_dataplane(n, false, n->max_queue_pairs);
+}
+
+static int virtio_net_start_ioeventfd(VirtIODevice *vdev)
+{
+    VirtIONet *n = VIRTIO_NET(vdev);
+    BusState *qbus = qdev_get_parent_bus(DEVICE(vdev));
+    VirtioBusClass *k = VIRTIO_BUS_GET_CLASS(qbus);
+    int r;
+
+    r = virtio_device_start_ioeventfd_impl(vdev);
+    if (r < 0 || !n->qp_aio_context) {
+        return r;
+    }
+
+    /* IOThreads notify the guest through irqfds */
+    r = k->set_guest_notifiers(qbus->parent, virtio_get_num_queues(vdev),
+                               true);
+    if (r < 0) {
+        warn_report("%s: failed to set guest notifiers (%d), queue pairs are "
+                    "processed in the main loop",
+                    qemu_get_queue(n->nic)->name, -r);
+        return 0;
+    }
+
+    n->ioeventfd_started = true;
+    virtio_net_dataplane_start(n, vdev->status);
+    return 0;
+}
+
+static void virtio_net_stop_ioeventfd(VirtIODevice *vdev)
+{
+    VirtIONet *n = VIRTIO_NET(vdev);
+    BusState *qbus = qdev_get_parent_bus(DEVICE(vdev));
+    VirtioBusClass *k = VIRTIO_BUS_GET_CLASS(qbus);
+
+    if (n->ioeventfd_started) {
+        virtio_net_dataplane_stop(n);
+        n->ioeventfd_started = false;
+        k->set_guest_notifiers(qbus->parent, virtio_get_num_queues(vdev),
+                               false);
+    }
+    virtio_device_stop_ioeventfd_impl(vdev);
+}
+
 static void virtio_net_add_queue(VirtIONet *n, int index)
 {
     VirtIODevice *vdev = VIRTIO_DEVICE(n);
@@ -3016,6 +3398,8 @@ static void virtio_net_del_queue(VirtIONet *n, int index)
         q->tx_bh = NULL;
     }
     q->tx_waiting = 0;
+    g_free(q->flow_cache);
+    q->flow_cache = NULL;
     virtio_del_queue(vdev, index * 2 + 1);
 }
 
@@ -3393,6 +3777,25 @@ static const VMStateDescription vmstate_virtio_net_device = {
     }
 };
 
+/* Coalesce rx notifications while the backend delivers a burst */
+static void virtio_net_begin_batch(NetClientState *nc)
+{
+    VirtIONetQueue *q = virtio_net_get_subqueue(nc);
+
+    q->rx_batch++;
+}
+
+static void virtio_net_end_batch(NetClientState *nc)
+{
+    VirtIONetQueue *q = virtio_net_get_subqueue(nc);
+
+    assert(q->rx_batch > 0);
+    if (--q->rx_batch == 0 && q->rx_notify_pending) {
+        q->rx_notify_pending = false;
+        virtio_net_notify(q, q->rx_vq);
+    }
+}
+
 static NetClientInfo net_virtio_info = {
     .type = NET_CLIENT_DRIVER_NIC,
     .size = sizeof(NICState),
@@ -3401,6 +3804,8 @@ static NetClientInfo net_virtio_info = {
     .link_status_changed = virtio_net_set_link_status,
     .query_rx_filter = virtio_net_query_rxfilter,
     .announce = virtio_net_announce,
+    .begin_batch = virtio_net_begin_batch,
+    .end_batch = virtio_net_end_batch,
 };
 
 static bool virtio_net_guest_notifier_pending(VirtIODevice *vdev, int idx)
@@ -3631,6 +4036,70 @@ static bool failover_hide_primary_device(DeviceListener *listener,
     return qatomic_read(&n->failover_primary_hidden);
 }
 
+/*
+ * iothread-vq-mapping vqs entries are queue pair indices; the control
+ * virtqueue always stays in the main loop.
+ */
+static bool virtio_net_iothread_init(VirtIONet *n, Error **errp)
+{
+    VirtIODevice *vdev = VIRTIO_DEVICE(n);
+    BusState *qbus = qdev_get_parent_bus(DEVICE(n));
+    VirtioBusClass *k = VIRTIO_BUS_GET_CLASS(qbus);
+    int i;
+
+    if (!k->set_guest_notifiers || !k->ioeventfd_assign) {
+        error_setg(errp, "device is incompatible with iothread "
+                   "(transport does not support notifiers)");
+        return false;
+    }
+    if (!virtio_device_ioeventfd_enabled(vdev)) {
+        error_setg(errp, "ioeventfd is required for iothread");
+        return false;
+    }
+    if (replay_mode != REPLAY_MODE_NONE) {
+        error_setg(errp, "iothread-vq-mapping is not supported with "
+                   "record/replay");
+        return false;
+    }
+    if (virtio_has_feature(n->host_features, VIRTIO_NET_F_RSC_EXT)) {
+        error_setg(errp, "iothread-vq-mapping is not supported with "
+                   "guest_rsc_ext");
+        return false;
+    }
+
+    for (i = 0; i < n->max_queue_pairs; i++) {
+        NetClientState *peer = n->nic_conf.peers.ncs[i];
+
+        if (!peer) {
+            error_setg(errp, "iothread-vq-mapping requires a netdev");
+            return false;
+        }
+        if (get_vhost_net(peer)) {
+            error_setg(errp, "iothread-vq-mapping is not supported with "
+                       "vhost");
+            return false;
+        }
+        if (!qemu_can_set_net_aio_context(peer)) {
+            error_setg(errp, "netdev '%s' cannot run in an IOThread",
+                       peer->name);
+            return false;
+        }
+    }
+
+    n->qp_aio_context = g_new(AioContext *, n->max_queue_pairs);
+    if (!iothread_vq_mapping_apply(n->iothread_vq_mapping_list,
+                                   n->qp_aio_context, n->max_queue_pairs,
+                                   errp)) {
+        g_free(n->qp_aio_context);
+        n->qp_aio_context = NULL;
+        return false;
+    }
+
+    /* Guest notifiers are used as plain irqfds, never masked by the device */
+    vdev->use_guest_notifier_mask = false;
+    return true;
+}
+
 static void virtio_net_device_realize(DeviceState *dev, Error **errp)
 {
     VirtIODevice *vdev = VIRTIO_DEVICE(dev);
@@ -3725,6 +4194,12 @@ static void virtio_net_device_realize(DeviceState *dev, Error **errp)
         virtio_cleanup(vdev);
         return;
     }
+
+    if (n->iothread_vq_mapping_list && !virtio_net_iothread_init(n, errp)) {
+        virtio_cleanup(vdev);
+        return;
+    }
+
     n->vqs = g_new0(VirtIONetQueue, n->max_queue_pairs);
     n->curr_queue_pairs = 1;
     n->tx_timeout = n->net_conf.txtimer;
@@ -3862,6 +4337,11 @@ static void virtio_net_device_unrealize(DeviceState *dev)
     virtio_net_rsc_cleanup(n);
     g_free(n->rss_data.indirections_table);
     net_rx_pkt_uninit(n->rx_pkt);
+    if (n->qp_aio_context) {
+        iothread_vq_mapping_cleanup(n->iothread_vq_mapping_list);
+        g_free(n->qp_aio_context);
+        n->qp_aio_context = NULL;
+    }
     virtio_cleanup(vdev);
 }
 
@@ -4032,6 +4512,8 @@ static const Property virtio_net_properties[] = {
                     VIRTIO_NET_F_HASH_REPORT, false),
     DEFINE_PROP_ARRAY("ebpf-rss-fds", VirtIONet, nr_ebpf_rss_fds,
                       ebpf_rss_fds, qdev_prop_string, char*),
+    DEFINE_PROP_BOOL("rss-flow-steering", VirtIONet, rss_flow_steering,
+                     false),
     DEFINE_PROP_BIT64("guest_rsc_ext", VirtIONet, host_features,
                     VIRTIO_NET_F_RSC_EXT, false),
     DEFINE_PROP_UINT32("rsc_interval", VirtIONet, rsc_timeout,
@@ -4057,6 +4539,8 @@ static const Property virtio_net_properties[] = {
                       VIRTIO_NET_F_GUEST_USO6, true),
     DEFINE_PROP_BIT64("host_uso", VirtIONet, host_features,
                       VIRTIO_NET_F_HOST_USO, true),
+    DEFINE_PROP_IOTHREAD_VQ_MAPPING_LIST("iothread-vq-mapping", VirtIONet,
+                                         iothread_vq_mapping_list),
 };
 
 static void virtio_net_class_init(ObjectClass *klass, void *data)
@@ -4078,6 +4562,8 @@ static void virtio_net_class_init(ObjectClass *klass, void *data)
     vdc->queue_reset = virtio_net_queue_reset;
     vdc->queue_enable = virtio_net_queue_enable;
     vdc->set_status = virtio_net_set_status;
+    vdc->start_ioeventfd = virtio_net_start_ioeventfd;
+    vdc->stop_ioeventfd = virtio_net_stop_ioeventfd;
     vdc->guest_notifier_mask = virtio_net_guest_notifier_mask;
     vdc->guest_notifier_pending = virtio_net_guest_notifier_pending;
     vdc->legacy_features |= (0x1 << VIRTIO_NET_F_GSO);
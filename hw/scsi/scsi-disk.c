@@ -289,6 +289,8 @@ static bool scsi_handle_rw_error(SCSIDiskReq *r, int ret, bool acct_failed)
     case BLOCK_ERROR_ACTION_REPORT:
         if (acct_failed) {
             block_acct_failed(blk_get_stats(s->qdev.conf.blk), &r->acct);
+        } else {
+            block_acct_cancel(blk_get_stats(s->qdev.conf.blk), &r->acct);
         }
         if (req_has_sense) {
             sdc->update_sense(&r->req);
@@ -302,6 +304,8 @@ static bool scsi_handle_rw_error(SCSIDiskReq *r, int ret, bool acct_failed)
         return false;
 
     case BLOCK_ERROR_ACTION_STOP:
+        /* The request is started again, with a new cookie, on resume */
+        block_acct_cancel(blk_get_stats(s->qdev.conf.blk), &r->acct);
         scsi_req_retry(&r->req);
         return true;
 
@@ -313,6 +317,9 @@ static bool scsi_handle_rw_error(SCSIDiskReq *r, int ret, bool acct_failed)
 static bool scsi_disk_req_check_error(SCSIDiskReq *r, int ret, bool acct_failed)
 {
     if (r->req.io_canceled) {
+        SCSIDiskState *s = DO_UPCAST(SCSIDiskState, qdev, r->req.dev);
+
+        block_acct_cancel(blk_get_stats(s->qdev.conf.blk), &r->acct);
         scsi_req_cancel_complete(&r->req);
         return true;
     }
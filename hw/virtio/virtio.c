@@ -4020,7 +4020,7 @@ static const Property virtio_properties[] = {
                      disable_legacy_check, false),
 };
 
-static int virtio_device_start_ioeventfd_impl(VirtIODevice *vdev)
+int virtio_device_start_ioeventfd_impl(VirtIODevice *vdev)
 {
     VirtioBusState *qbus = VIRTIO_BUS(qdev_get_parent_bus(DEVICE(vdev)));
     int i, n, r, err;
@@ -4090,7 +4090,7 @@ int virtio_device_start_ioeventfd(VirtIODevice *vdev)
     return virtio_bus_start_ioeventfd(vbus);
 }
 
-static void virtio_device_stop_ioeventfd_impl(VirtIODevice *vdev)
+void virtio_device_stop_ioeventfd_impl(VirtIODevice *vdev)
 {
     VirtioBusState *qbus = VIRTIO_BUS(qdev_get_parent_bus(DEVICE(vdev)));
     int n, r;
@@ -79,6 +79,29 @@ typedef struct BlockLatencyHistogram {
     uint64_t *bins;
 } BlockLatencyHistogram;
 
+/*
+ * Always-on log-linear latency histogram used for percentiles.  Latencies
+ * below 2^BLOCK_LATENCY_LOG_SUB_BITS ns get a bucket each; above that, every
+ * power of two is split into 2^BLOCK_LATENCY_LOG_SUB_BITS buckets, so a
+ * bucket is never wider than 1/16 (6.25%) of its lower bound.  Latencies of
+ * 2^BLOCK_LATENCY_LOG_MAX_BITS ns (about 68 seconds) and more all end up in
+ * the last bucket.
+ */
+#define BLOCK_LATENCY_LOG_SUB_BITS 4
+#define BLOCK_LATENCY_LOG_MAX_BITS 36
+#define BLOCK_LATENCY_LOG_BUCKETS \
+    ((BLOCK_LATENCY_LOG_MAX_BITS - BLOCK_LATENCY_LOG_SUB_BITS + 1) << \
+     BLOCK_LATENCY_LOG_SUB_BITS)
+
+typedef struct BlockLatencyLogHistogram {
+    uint64_t count;
+    uint64_t max;
+    uint64_t buckets[BLOCK_LATENCY_LOG_BUCKETS];
+} BlockLatencyLogHistogram;
+
+/* Number of one-second queue depth samples kept for query-blockstats */
+#define BLOCK_ACCT_DEPTH_HISTORY 60
+
 struct BlockAcctStats {
     QemuMutex lock;
     uint64_t nr_bytes[BLOCK_MAX_IOTYPE];
@@ -92,6 +115,20 @@ struct BlockAcctStats {
     bool account_invalid;
     bool account_failed;
     BlockLatencyHistogram latency_histogram[BLOCK_MAX_IOTYPE];
+    BlockLatencyLogHistogram latency_log_histogram[BLOCK_MAX_IOTYPE];
+
+    /*
+     * Number of requests between block_acct_start() and their completion,
+     * and the highest such number since the last one-second sample.  Both
+     * are updated atomically without holding @lock.
+     */
+    unsigned inflight;
+    unsigned inflight_peak;
+    /* Highest number of requests in flight ever seen */
+    unsigned inflight_max;
+    /* Per-second peaks, indexed by second modulo BLOCK_ACCT_DEPTH_HISTORY */
+    int64_t depth_history_sec;
+    unsigned depth_history[BLOCK_ACCT_DEPTH_HISTORY];
 };
 
 typedef struct BlockAcctCookie {
@@ -111,12 +148,18 @@ void block_acct_start(BlockAcctStats *stats, BlockAcctCookie *cookie,
                       int64_t bytes, enum BlockAcctType type);
 void block_acct_done(BlockAcctStats *stats, BlockAcctCookie *cookie);
 void block_acct_failed(BlockAcctStats *stats, BlockAcctCookie *cookie);
+void block_acct_cancel(BlockAcctStats *stats, BlockAcctCookie *cookie);
 void block_acct_invalid(BlockAcctStats *stats, enum BlockAcctType type);
 void block_acct_merge_done(BlockAcctStats *stats, enum BlockAcctType type,
                            int num_requests);
 int64_t block_acct_idle_time_ns(BlockAcctStats *stats);
 double block_acct_queue_depth(BlockAcctTimedStats *stats,
                               enum BlockAcctType type);
+void block_acct_queue_depth_history(BlockAcctStats *stats, unsigned *current,
+                                    unsigned *max,
+                                    unsigned history[BLOCK_ACCT_DEPTH_HISTORY]);
+uint64_t block_latency_log_histogram_percentile(BlockLatencyLogHistogram *hist,
+                                                uint32_t ppm);
 int block_latency_histogram_set(BlockAcctStats *stats, enum BlockAcctType type,
                                 uint64List *boundaries);
 void block_latency_histograms_clear(BlockAcctStats *stats);
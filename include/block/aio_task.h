@@ -37,6 +37,13 @@ struct AioTask {
 AioTaskPool *coroutine_fn aio_task_pool_new(int max_busy_tasks);
 void aio_task_pool_free(AioTaskPool *);
 
+/*
+ * Change the maximum number of parallel tasks.  Already running tasks are not
+ * affected; if the limit is lowered, new tasks are only started once enough
+ * of them have finished.
+ */
+void aio_task_pool_set_max_busy_tasks(AioTaskPool *pool, int max_busy_tasks);
+
 /* error code of failed task or 0 if all is OK */
 int aio_task_pool_status(AioTaskPool *pool);
 
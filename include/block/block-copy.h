@@ -59,10 +59,15 @@ int coroutine_fn block_copy(BlockCopyState *s, int64_t offset, int64_t bytes,
  * must be > 0.
  *
  * @max_chunk means maximum length for one IO operation. Zero means unlimited.
+ *
+ * @adaptive means that the number of parallel coroutines and the length of IO
+ * operations are tuned at runtime based on the observed throughput, with
+ * @max_workers and @max_chunk as upper limits.
  */
 BlockCopyCallState *block_copy_async(BlockCopyState *s,
                                      int64_t offset, int64_t bytes,
                                      int max_workers, int64_t max_chunk,
+                                     bool adaptive,
                                      BlockCopyAsyncCallbackFunc cb,
                                      void *cb_opaque);
 
@@ -101,4 +106,11 @@ BdrvDirtyBitmap *block_copy_dirty_bitmap(BlockCopyState *s);
 int64_t block_copy_cluster_size(BlockCopyState *s);
 void block_copy_set_skip_unallocated(BlockCopyState *s, bool skip);
 
+/*
+ * Return the current state of adaptive tuning, or NULL if no adaptive
+ * block-copy call has been started.  The caller must free the result with
+ * qapi_free_BlockCopyTuning().
+ */
+BlockCopyTuning *block_copy_get_tuning(BlockCopyState *s);
+
 #endif /* BLOCK_COPY_H */
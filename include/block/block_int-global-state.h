@@ -55,6 +55,8 @@
  * @filter_node_name: The node name that should be assigned to the filter
  *                    driver that the stream job inserts into the graph above
  *                    @bs. NULL means that a node name should be autogenerated.
+ * @prefetch_hints: File listing ranges that the filter driver copies up
+ *                  ahead of guest reads, or NULL.
  * @errp: Error object.
  *
  * Start a streaming operation on @bs.  Clusters that are unallocated
@@ -71,6 +73,7 @@ void stream_start(const char *job_id, BlockDriverState *bs,
                   int creation_flags, int64_t speed,
                   BlockdevOnError on_error,
                   const char *filter_node_name,
+                  const char *prefetch_hints,
                   Error **errp);
 
 /**
@@ -80,6 +80,7 @@ struct TranslationBlock {
 #define CF_NOIRQ         0x00010000 /* Generate an uninterruptible TB */
 #define CF_PCREL         0x00020000 /* Opcodes in TB are PC-relative */
 #define CF_BP_PAGE       0x00040000 /* Breakpoint present in code page */
+#define CF_TRACE         0x00080000 /* Hot trace following direct jumps */
 #define CF_CLUSTER_MASK  0xff000000 /* Top 8 bits are cluster ID */
 #define CF_CLUSTER_SHIFT 24
 
@@ -143,6 +144,14 @@ struct TranslationBlock {
     uintptr_t jmp_list_head;
     uintptr_t jmp_list_next[2];
     uintptr_t jmp_dest[2];
+
+    /*
+     * Entries left until the TB is retranslated as a trace, counted down
+     * by the TB itself without atomics, so only approximately; zero once
+     * it got hot and its trace may exist, negative if the TB does not
+     * count its entries.
+     */
+    int32_t trace_countdown;
 };
 
 /* The alignment given to TranslationBlock during allocation. */
@@ -61,6 +61,9 @@ typedef enum DisasJumpType {
  * @fake_insn: True if translator_fake_ldb used.
  * @insn_start: The last op emitted by the insn_start hook,
  *              which is expected to be INDEX_op_insn_start.
+ * @trace_jumps: Number of jumps followed while building a trace.
+ * @trace_end: End of the guest code translated before the last jump
+ *             followed, see translator_trace_jump().
  *
  * Architecture-agnostic disassembly context.
  */
@@ -75,6 +78,8 @@ struct DisasContextBase {
     bool fake_insn;
     struct TCGOp *insn_start;
     void *host_addr[2];
+    int trace_jumps;
+    vaddr trace_end;
 
     /*
      * Record insn data that we cannot read directly from host memory.
@@ -158,6 +163,20 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
  */
 bool translator_use_goto_tb(DisasContextBase *db, vaddr dest);
 
+/**
+ * translator_trace_jump
+ * @db: Disassembly context
+ * @next: pc of the instruction following the jump
+ * @dest: target pc of an unconditional direct jump
+ *
+ * When retranslating a hot TB as a trace (CF_TRACE), return true if
+ * translation should continue at @dest instead of ending the TB with
+ * a goto_tb.  The caller must then emit no exit, and arrange for the
+ * next instruction to be decoded from @dest.  Guest values stay in
+ * host registers across the jump.
+ */
+bool translator_trace_jump(DisasContextBase *db, vaddr next, vaddr dest);
+
 /**
  * translator_io_start
  * @db: Disassembly context
@@ -198,8 +198,21 @@ struct CPUClass {
  */
 #define NB_MMU_MODES 16
 
-/* Use a fully associative victim tlb of 8 entries. */
-#define CPU_VTLB_SIZE 8
+/*
+ * The victim tlb is set associative, with CPU_VTLB_WAYS entries per set.
+ * Its total size is chosen with "-accel tcg,victim-tlb-size=N".  A size
+ * of CPU_VTLB_WAYS is a single fully associative set; larger sizes add
+ * sets, indexed by the low bits of the page number.
+ */
+#define CPU_VTLB_WAYS           8
+#define CPU_VTLB_DEFAULT_SIZE   64
+#define CPU_VTLB_MAX_SIZE       512
+
+/*
+ * Number of separate regions of large pages tracked for each MMU mode
+ * before neighbouring regions start being merged.
+ */
+#define CPU_TLB_LARGE_PAGES     8
 
 /*
  * The full TLB entry, which is not accessed by generated TCG code,
@@ -270,23 +283,27 @@ struct CPUTLBEntryFull {
  */
 typedef struct CPUTLBDesc {
     /*
-     * Describe a region covering all of the large pages allocated
-     * into the tlb.  When any page within this region is flushed,
-     * we must flush the entire tlb.  The region is matched if
-     * (addr & large_page_mask) == large_page_addr.
+     * Describe regions covering all of the large pages allocated
+     * into the tlb.  When any page within a region is flushed, we
+     * must flush every entry within that region.  A region is matched
+     * if (addr & mask) == addr of the region.  Once all slots are in
+     * use, a new large page is merged into the closest region.
      */
-    vaddr large_page_addr;
-    vaddr large_page_mask;
+    struct {
+        vaddr addr;
+        vaddr mask;
+    } large_page[CPU_TLB_LARGE_PAGES];
+    unsigned n_large_pages;
     /* host time (in ns) at the beginning of the time window */
     int64_t window_begin_ns;
     /* maximum number of entries observed in the window */
     size_t window_max_entries;
     size_t n_used_entries;
-    /* The next index to use in the tlb victim table.  */
+    /* Used to pick the way to replace within a set of the victim table.  */
     size_t vindex;
-    /* The tlb victim table, in two parts.  */
-    CPUTLBEntry vtable[CPU_VTLB_SIZE];
-    CPUTLBEntryFull vfulltlb[CPU_VTLB_SIZE];
+    /* The tlb victim table, in two parts, of CPUTLBCommon.vsize entries.  */
+    CPUTLBEntry *vtable;
+    CPUTLBEntryFull *vfulltlb;
     CPUTLBEntryFull *fulltlb;
 } CPUTLBDesc;
 
@@ -302,6 +319,8 @@ typedef struct CPUTLBCommon {
      * Protected by tlb_c.lock.
      */
     uint16_t dirty;
+    /* Number of entries of each victim table, a multiple of CPU_VTLB_WAYS. */
+    size_t vsize;
     /*
      * Statistics.  These are not lock protected, but are read and
      * written atomically.  This allows the monitor to print a snapshot
@@ -310,6 +329,9 @@ typedef struct CPUTLBCommon {
     size_t full_flush_count;
     size_t part_flush_count;
     size_t elide_flush_count;
+    size_t large_flush_count;
+    size_t victim_hit_count;
+    size_t miss_count;
 } CPUTLBCommon;
 
 /*
@@ -366,6 +388,8 @@ typedef struct CPUNegativeOffsetState {
 #endif
     IcountDecr icount_decr;
     bool can_do_io;
+    /* Set by a TB that exits because it became hot (see trace_countdown) */
+    bool trace_exit;
 } CPUNegativeOffsetState;
 
 struct KVMState;
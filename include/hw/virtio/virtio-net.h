@@ -20,6 +20,7 @@
 #include "net/announce.h"
 #include "qemu/option_int.h"
 #include "qom/object.h"
+#include "qapi/qapi-types-virtio.h"
 
 #include "ebpf/ebpf_rss.h"
 
@@ -151,6 +152,12 @@ typedef struct VirtioNetRssData {
     uint16_t default_queue;
 } VirtioNetRssData;
 
+/* Flow recently pinned to a queue in the eBPF RSS flow table */
+typedef struct VirtIONetFlowCacheEntry {
+    struct EBPFRSSFlowKey key;
+    int64_t expire;
+} VirtIONetFlowCacheEntry;
+
 typedef struct VirtIONetQueue {
     VirtQueue *rx_vq;
     VirtQueue *tx_vq;
@@ -161,6 +168,13 @@ typedef struct VirtIONetQueue {
         VirtQueueElement *elem;
     } async_tx;
     struct VirtIONet *n;
+    /* IOThread processing this queue pair, NULL for the main loop */
+    AioContext *ctx;
+    /* Nesting depth of backend rx batches, notification deferred until 0 */
+    unsigned rx_batch;
+    bool rx_notify_pending;
+    /* Flows this queue transmitted, to limit eBPF flow table updates */
+    VirtIONetFlowCacheEntry *flow_cache;
 } VirtIONetQueue;
 
 struct VirtIONet {
@@ -227,6 +241,14 @@ struct VirtIONet {
     struct EBPFRSSContext ebpf_rss;
     uint32_t nr_ebpf_rss_fds;
     char **ebpf_rss_fds;
+    bool rss_flow_steering;
+    bool flow_steering_active;
+    /* iothread-vq-mapping, indexed by queue pair */
+    IOThreadVirtQueueMappingList *iothread_vq_mapping_list;
+    AioContext **qp_aio_context;
+    bool ioeventfd_started;
+    bool dataplane_started;
+    unsigned dataplane_paused;
 };
 
 size_t virtio_net_handle_ctrl_iov(VirtIODevice *vdev,
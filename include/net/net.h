@@ -67,6 +67,8 @@ typedef void (SocketReadStateFinalize)(SocketReadState *rs);
 typedef void (NetAnnounce)(NetClientState *);
 typedef bool (SetSteeringEBPF)(NetClientState *, int);
 typedef bool (NetCheckPeerType)(NetClientState *, ObjectClass *, Error **);
+typedef void (NetSetAioContext)(NetClientState *, AioContext *);
+typedef void (NetBatch)(NetClientState *);
 
 typedef struct NetClientInfo {
     NetClientDriver type;
@@ -92,6 +94,9 @@ typedef struct NetClientInfo {
     NetAnnounce *announce;
     SetSteeringEBPF *set_steering_ebpf;
     NetCheckPeerType *check_peer_type;
+    NetSetAioContext *set_aio_context;
+    NetBatch *begin_batch;
+    NetBatch *end_batch;
 } NetClientInfo;
 
 struct NetClientState {
@@ -113,6 +118,8 @@ struct NetClientState {
     bool do_not_pad; /* do not pad to the minimum ethernet frame length */
     bool is_datapath;
     QTAILQ_HEAD(, NetFilterState) filters;
+    /* Where the event handlers run, NULL for the main loop */
+    AioContext *aio_context;
 };
 
 typedef QTAILQ_HEAD(NetClientStateList, NetClientState) NetClientStateList;
@@ -191,6 +198,10 @@ int qemu_get_vnet_hdr_len(NetClientState *nc);
 void qemu_set_vnet_hdr_len(NetClientState *nc, int len);
 int qemu_set_vnet_le(NetClientState *nc, bool is_le);
 int qemu_set_vnet_be(NetClientState *nc, bool is_be);
+bool qemu_can_set_net_aio_context(NetClientState *nc);
+void qemu_set_net_aio_context(NetClientState *nc, AioContext *ctx);
+void qemu_net_begin_batch(NetClientState *nc);
+void qemu_net_end_batch(NetClientState *nc);
 void qemu_macaddr_default_if_unset(MACAddr *macaddr);
 /**
  * qemu_find_nic_info: Obtain NIC configuration information
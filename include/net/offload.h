@@ -0,0 +1,104 @@
+/*
+ * Software GRO/GSO for net backends without host offloads
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef QEMU_NET_OFFLOAD_H
+#define QEMU_NET_OFFLOAD_H
+
+#include "net/net.h"
+
+/*
+ * A backend that talks to the wire in MTU sized frames can embed a
+ * NetOffload to offer its peer the same interface as a tap device with
+ * IFF_VNET_HDR: packets carry a virtio_net_hdr, and TCP flows move as
+ * super-packets of up to 64 KiB.  Consecutive TCP segments read from the
+ * wire are merged (GRO) before they are sent to the peer, and super-packets
+ * received from the peer are segmented (GSO) just before they go out.
+ *
+ * The header is only used once the peer has called set_vnet_hdr_len, and
+ * merging only happens for the offloads the peer enabled with set_offload.
+ */
+
+/* Emit one frame; returns false if the backend has no room for it. */
+typedef bool (NetGsoOutput)(void *opaque, const uint8_t *buf, size_t size);
+
+typedef struct NetOffload {
+    NetClientState *nc;
+    NetPacketSent *sent_cb;
+    bool using_vnet_hdr;
+    int vnet_hdr_len;
+    bool csum;
+    bool tso4;
+    bool tso6;
+
+    /* Super-packet being merged, a complete frame without vnet header */
+    uint8_t *gro_buf;
+    size_t gro_len;
+    size_t gro_l3_off;
+    size_t gro_l4_off;
+    size_t gro_hdr_len;
+    bool gro_ipv6;
+    uint32_t gro_next_seq;
+    uint16_t gro_mss;
+    unsigned gro_segs;
+
+    /* Scratch frames for segmentation */
+    uint8_t *gso_in;
+    uint8_t *gso_out;
+} NetOffload;
+
+void net_offload_init(NetOffload *o, NetClientState *nc,
+                      NetPacketSent *sent_cb);
+void net_offload_cleanup(NetOffload *o);
+bool net_offload_has_vnet_hdr_len(NetOffload *o, int len);
+void net_offload_set_vnet_hdr_len(NetOffload *o, int len);
+void net_offload_set_offload(NetOffload *o, int csum, int tso4, int tso6);
+
+/**
+ * net_gro_receive:
+ * @o: offload state of the backend
+ * @buf: Ethernet frame read from the wire
+ * @size: length of @buf
+ *
+ * Merge @buf into the pending super-packet or send it to the peer.
+ * @buf is not referenced after the call returns.  The backend must call
+ * net_gro_flush() at the end of each burst of received frames.
+ *
+ * Returns: like qemu_send_packet_async(); 0 means the peer queued a
+ * packet and the backend should stop reading until sent_cb is called.
+ */
+ssize_t net_gro_receive(NetOffload *o, const uint8_t *buf, size_t size);
+
+/**
+ * net_gro_flush:
+ * @o: offload state of the backend
+ *
+ * Send the pending super-packet, if any, to the peer.
+ *
+ * Returns: like qemu_send_packet_async(), or 1 if nothing was pending.
+ */
+ssize_t net_gro_flush(NetOffload *o);
+
+/**
+ * net_gso_send:
+ * @o: offload state of the backend
+ * @iov: packet from the peer, starting with the vnet header if in use
+ * @iovcnt: number of elements in @iov
+ * @output: called for every frame to transmit
+ * @opaque: passed to @output
+ *
+ * Complete a partial checksum and split a super-packet into MSS sized
+ * frames.  Frames after the first that @output has no room for are
+ * dropped, as the wire would have done.
+ *
+ * Returns: the size of the packet, or 0 if @output had no room for the
+ * first frame and the peer should queue the packet.
+ */
+ssize_t net_gso_send(NetOffload *o, const struct iovec *iov, int iovcnt,
+                     NetGsoOutput *output, void *opaque);
+
+#endif /* QEMU_NET_OFFLOAD_H */
@@ -30,6 +30,12 @@ typedef struct NetQueue NetQueue;
 
 typedef void (NetPacketSent) (NetClientState *sender, ssize_t ret);
 
+typedef struct NetQueueStats {
+    uint64_t queued;            /* packets the receiver could not take */
+    uint64_t dropped;           /* packets dropped because the queue was full */
+    uint64_t pool_exhausted;    /* packets queued after the pool ran out */
+} NetQueueStats;
+
 #define QEMU_NET_PACKET_FLAG_NONE  0
 #define QEMU_NET_PACKET_FLAG_RAW  (1<<0)
 
@@ -73,6 +79,8 @@ ssize_t qemu_net_queue_send_iov(NetQueue *queue,
                                 int iovcnt,
                                 NetPacketSent *sent_cb);
 
+void qemu_net_queue_get_stats(NetQueue *queue, NetQueueStats *stats);
+
 void qemu_net_queue_purge(NetQueue *queue, NetClientState *from);
 bool qemu_net_queue_flush(NetQueue *queue);
 
@@ -72,6 +72,7 @@ enum plugin_dyn_cb_type {
     PLUGIN_CB_MEM_REGULAR,
     PLUGIN_CB_INLINE_ADD_U64,
     PLUGIN_CB_INLINE_STORE_U64,
+    PLUGIN_CB_MEM_BUFFER,
 };
 
 struct qemu_plugin_regular_cb {
@@ -87,6 +88,19 @@ struct qemu_plugin_inline_cb {
     enum qemu_plugin_mem_rw rw;
 };
 
+struct qemu_plugin_buffer_cb {
+    /* helper that delivers the records of the vCPU, called with @buf */
+    qemu_plugin_vcpu_udata_cb_t flush;
+    TCGHelperInfo *info;
+    struct qemu_plugin_mem_buffer *buf;
+    uint64_t pc;
+    enum qemu_plugin_mem_rw rw;
+    /* set at injection if the records of the insn do not fit in @buf */
+    bool flush_each;
+    /* set at injection to the room kept for the records of the insn */
+    size_t reserve;
+};
+
 struct qemu_plugin_conditional_cb {
     union qemu_plugin_cb_sig f;
     TCGHelperInfo *info;
@@ -107,6 +121,7 @@ struct qemu_plugin_dyn_cb {
         struct qemu_plugin_regular_cb regular;
         struct qemu_plugin_conditional_cb cond;
         struct qemu_plugin_inline_cb inline_insn;
+        struct qemu_plugin_buffer_cb buffer;
     };
 };
 
@@ -128,6 +143,21 @@ struct qemu_plugin_scoreboard {
     QLIST_ENTRY(qemu_plugin_scoreboard) entry;
 };
 
+/*
+ * A memory buffer is a scoreboard whose entries are a uint64_t count
+ * followed by @n_records struct qemu_plugin_mem_record.
+ */
+struct qemu_plugin_mem_buffer {
+    struct qemu_plugin_scoreboard *score;
+    size_t n_records;
+    qemu_plugin_vcpu_mem_buffer_cb_t cb;
+    void *userdata;
+    QLIST_ENTRY(qemu_plugin_mem_buffer) entry;
+};
+
+/* Offset of the records in an entry of a memory buffer */
+#define PLUGIN_MEM_BUFFER_RECORDS sizeof(uint64_t)
+
 /* Internal context for this TranslationBlock */
 struct qemu_plugin_tb {
     GPtrArray *insns;
@@ -65,11 +65,15 @@ typedef uint64_t qemu_plugin_id_t;
  *
  * version 4:
  * - added qemu_plugin_read_memory_vaddr
+ *
+ * version 5:
+ * - added qemu_plugin_mem_buffer_{new,free,flush} and
+ *   qemu_plugin_register_vcpu_mem_buffer
  */
 
 extern QEMU_PLUGIN_EXPORT int qemu_plugin_version;
 
-#define QEMU_PLUGIN_VERSION 4
+#define QEMU_PLUGIN_VERSION 5
 
 /**
  * struct qemu_info_t - system information for plugins
@@ -701,6 +705,102 @@ void qemu_plugin_register_vcpu_mem_inline_per_vcpu(
     qemu_plugin_u64 entry,
     uint64_t imm);
 
+/**
+ * struct qemu_plugin_mem_record - a buffered memory access
+ * @vaddr: the virtual address of the transaction
+ * @pc: the virtual address of the instruction performing the access
+ * @info: handle for the size, direction and endianness of the access
+ *
+ * @info can be queried with qemu_plugin_mem_size_shift() and friends.
+ * It is only a record of the access, so qemu_plugin_get_hwaddr() and
+ * qemu_plugin_mem_get_value() cannot be used on it.
+ */
+struct qemu_plugin_mem_record {
+    uint64_t vaddr;
+    uint64_t pc;
+    qemu_plugin_meminfo_t info;
+};
+
+/** struct qemu_plugin_mem_buffer - Opaque handle for a memory buffer */
+struct qemu_plugin_mem_buffer;
+
+/**
+ * typedef qemu_plugin_vcpu_mem_buffer_cb_t - memory buffer callback type
+ * @vcpu_index: the vCPU that performed the accesses
+ * @records: the accesses, oldest first
+ * @n: number of entries in @records
+ * @userdata: any user data attached to the buffer
+ *
+ * @records is only valid for the duration of the callback.
+ */
+typedef void (*qemu_plugin_vcpu_mem_buffer_cb_t)(
+    unsigned int vcpu_index,
+    const struct qemu_plugin_mem_record *records,
+    size_t n,
+    void *userdata);
+
+/**
+ * qemu_plugin_mem_buffer_new() - alloc a new memory buffer
+ * @n_records: number of records each vCPU can hold before delivery
+ * @cb: callback of type qemu_plugin_vcpu_mem_buffer_cb_t
+ * @userdata: opaque pointer for userdata
+ *
+ * Each vCPU gets its own buffer of @n_records entries. Instrumented
+ * accesses are appended to it by the generated code, and @cb is called
+ * on the vCPU thread when an instruction needs more room than is left
+ * in the buffer, when the vCPU goes idle or exits, and at exit before
+ * the plugin's atexit callback. Records are not delivered at the end
+ * of each block; a plugin that needs that can call
+ * qemu_plugin_mem_buffer_flush() from a TB execution callback.
+ *
+ * Returns a pointer to a new buffer. It must be freed using
+ * qemu_plugin_mem_buffer_free.
+ */
+QEMU_PLUGIN_API
+struct qemu_plugin_mem_buffer *
+qemu_plugin_mem_buffer_new(size_t n_records,
+                           qemu_plugin_vcpu_mem_buffer_cb_t cb,
+                           void *userdata);
+
+/**
+ * qemu_plugin_mem_buffer_free() - free a memory buffer
+ * @buf: buffer to free
+ *
+ * Records that were not delivered yet are dropped. Generated code may
+ * still refer to @buf, so this should only be called at exit.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf);
+
+/**
+ * qemu_plugin_mem_buffer_flush() - deliver the pending records of a vCPU
+ * @buf: buffer to flush
+ * @vcpu_index: vCPU whose records are delivered
+ *
+ * Calls the callback of @buf if @vcpu_index has pending records. This
+ * must be called from a callback running on @vcpu_index, or when no
+ * vCPU is running.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_mem_buffer_flush(struct qemu_plugin_mem_buffer *buf,
+                                  unsigned int vcpu_index);
+
+/**
+ * qemu_plugin_register_vcpu_mem_buffer() - record memory accesses in a buffer
+ * @insn: handle for instruction to instrument
+ * @rw: record reads, writes or both
+ * @buf: buffer to append the records to
+ *
+ * This appends a record to @buf for every memory access generated by
+ * the instruction. Unlike qemu_plugin_register_vcpu_mem_cb() no call is
+ * made for each access, which makes it much cheaper when most accesses
+ * of a TB are instrumented.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_register_vcpu_mem_buffer(struct qemu_plugin_insn *insn,
+                                          enum qemu_plugin_mem_rw rw,
+                                          struct qemu_plugin_mem_buffer *buf);
+
 /**
  * qemu_plugin_request_time_control() - request the ability to control time
  *
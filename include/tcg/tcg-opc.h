@@ -309,6 +309,11 @@ DEF(last_generic, 0, 0, 0, TCG_OPF_NOT_PRESENT)
 /* These opcodes are only for use between the tci generator and interpreter. */
 DEF(tci_movi, 1, 0, 1, TCG_OPF_NOT_PRESENT)
 DEF(tci_movl, 1, 0, 1, TCG_OPF_NOT_PRESENT)
+/* Superinstructions: the next insn is always add, resp. brcond on TMP. */
+DEF(tci_ld32_add, 1, 1, 1, TCG_OPF_NOT_PRESENT)
+DEF(tci_ld64_add, 1, 1, 1, TCG_OPF_NOT_PRESENT)
+DEF(tci_brcond_i32, 1, 2, 1, TCG_OPF_NOT_PRESENT)
+DEF(tci_brcond_i64, 1, 2, 1, TCG_OPF_NOT_PRESENT)
 #endif
 
 #undef DATA64_ARGS
@@ -742,6 +742,7 @@ void tcg_pool_reset(TCGContext *s);
 TranslationBlock *tcg_tb_alloc(TCGContext *s);
 
 void tcg_region_reset_all(void);
+int tcg_region_evict(GTraverseFunc func, gpointer user_data);
 
 size_t tcg_code_size(void);
 size_t tcg_code_capacity(void);
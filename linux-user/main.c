@@ -72,6 +72,7 @@ char *exec_path;
 char real_exec_path[PATH_MAX];
 
 static bool opt_one_insn_per_tb;
+static uint32_t opt_trace_threshold;
 static const char *argv0;
 static const char *gdbstub;
 static envlist_t *envlist;
@@ -425,6 +426,17 @@ static void handle_arg_one_insn_per_tb(const char *arg)
     opt_one_insn_per_tb = true;
 }
 
+static void handle_arg_trace_threshold(const char *arg)
+{
+    unsigned int val;
+
+    if (qemu_strtoui(arg, NULL, 0, &val) || val > INT32_MAX) {
+        fprintf(stderr, "Invalid trace threshold: %s\n", arg);
+        exit(EXIT_FAILURE);
+    }
+    opt_trace_threshold = val;
+}
+
 static void handle_arg_strace(const char *arg)
 {
     enable_strace = true;
@@ -517,6 +529,9 @@ static const struct qemu_argument arg_table[] = {
     {"one-insn-per-tb",
                    "QEMU_ONE_INSN_PER_TB",  false, handle_arg_one_insn_per_tb,
      "",           "run with one guest instruction per emulated TB"},
+    {"trace-threshold",
+                   "QEMU_TRACE_THRESHOLD", true, handle_arg_trace_threshold,
+     "count",      "retranslate TBs entered 'count' times as traces"},
     {"strace",     "QEMU_STRACE",      false, handle_arg_strace,
      "",           "log system calls"},
     {"seed",       "QEMU_RAND_SEED",   true,  handle_arg_seed,
@@ -808,6 +823,8 @@ int main(int argc, char **argv, char **envp)
         accel_init_interfaces(ac);
         object_property_set_bool(OBJECT(accel), "one-insn-per-tb",
                                  opt_one_insn_per_tb, &error_abort);
+        object_property_set_uint(OBJECT(accel), "trace-threshold",
+                                 opt_trace_threshold, &error_abort);
         ac->init_machine(NULL);
     }
 
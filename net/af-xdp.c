@@ -21,12 +21,15 @@
 #include "clients.h"
 #include "monitor/monitor.h"
 #include "net/net.h"
+#include "net/offload.h"
 #include "qapi/error.h"
 #include "qemu/cutils.h"
 #include "qemu/error-report.h"
 #include "qemu/iov.h"
 #include "qemu/main-loop.h"
 #include "qemu/memalign.h"
+#include "qom/object.h"
+#include "system/hostmem.h"
 
 
 typedef struct AFXDPState {
@@ -48,10 +51,18 @@ typedef struct AFXDPState {
     uint32_t             n_pool;
     char                 *buffer;
     struct xsk_umem      *umem;
+    /* Backend that @buffer is a slice of, NULL if allocated by us */
+    HostMemoryBackend    *memdev;
+    /* Queues using @memdev, shared by all of them; the last one unmaps it */
+    unsigned             *memdev_users;
 
     uint32_t             n_queues;
     uint32_t             xdp_flags;
     bool                 inhibit;
+
+    /* Software checksum, GRO and GSO, see net/offload.h */
+    bool                 offload_enabled;
+    NetOffload           offload;
 } AFXDPState;
 
 #define AF_XDP_BATCH_SIZE 64
@@ -60,12 +71,23 @@ static void af_xdp_send(void *opaque);
 static void af_xdp_writable(void *opaque);
 
 /* Set the event-loop handlers for the af-xdp backend. */
+static void af_xdp_set_fd_handler(AFXDPState *s, AioContext *ctx,
+                                  bool enable)
+{
+    IOHandler *fd_read = enable && s->read_poll ? af_xdp_send : NULL;
+    IOHandler *fd_write = enable && s->write_poll ? af_xdp_writable : NULL;
+
+    if (ctx) {
+        aio_set_fd_handler(ctx, xsk_socket__fd(s->xsk), fd_read, fd_write,
+                           NULL, NULL, s);
+    } else {
+        qemu_set_fd_handler(xsk_socket__fd(s->xsk), fd_read, fd_write, s);
+    }
+}
+
 static void af_xdp_update_fd_handler(AFXDPState *s)
 {
-    qemu_set_fd_handler(xsk_socket__fd(s->xsk),
-                        s->read_poll ? af_xdp_send : NULL,
-                        s->write_poll ? af_xdp_writable : NULL,
-                        s);
+    af_xdp_set_fd_handler(s, s->nc.aio_context, true);
 }
 
 /* Update the read handler. */
@@ -139,10 +161,14 @@ static void af_xdp_writable(void *opaque)
     qemu_flush_queued_packets(&s->nc);
 }
 
-static ssize_t af_xdp_receive(NetClientState *nc,
-                              const uint8_t *buf, size_t size)
+/*
+ * Copy the packet straight from the peer's scatter-gather list, which is
+ * guest memory for virtio-net, into a UMEM frame.  Returns false if there
+ * is no room in the tx ring; packets that are too big are dropped.
+ */
+static bool af_xdp_xmit(AFXDPState *s, const struct iovec *iov, int iovcnt)
 {
-    AFXDPState *s = DO_UPCAST(AFXDPState, nc, nc);
+    size_t size = iov_size(iov, iovcnt);
     struct xdp_desc *desc;
     uint32_t idx;
     void *data;
@@ -152,7 +178,7 @@ static ssize_t af_xdp_receive(NetClientState *nc,
 
     if (size > XSK_UMEM__DEFAULT_FRAME_SIZE) {
         /* We can't transmit packet this size... */
-        return size;
+        return true;
     }
 
     if (!s->n_pool || !xsk_ring_prod__reserve(&s->tx, 1, &idx)) {
@@ -161,7 +187,7 @@ static ssize_t af_xdp_receive(NetClientState *nc,
          * This will also kick the Tx, if it was waiting on CQ.
          */
         af_xdp_write_poll(s, true);
-        return 0;
+        return false;
     }
 
     desc = xsk_ring_prod__tx_desc(&s->tx, idx);
@@ -169,7 +195,7 @@ static ssize_t af_xdp_receive(NetClientState *nc,
     desc->len = size;
 
     data = xsk_umem__get_data(s->buffer, desc->addr);
-    memcpy(data, buf, size);
+    iov_to_buf(iov, iovcnt, 0, data, size);
 
     xsk_ring_prod__submit(&s->tx, 1);
     s->outstanding_tx++;
@@ -178,7 +204,40 @@ static ssize_t af_xdp_receive(NetClientState *nc,
         af_xdp_write_poll(s, true);
     }
 
-    return size;
+    return true;
+}
+
+static bool af_xdp_gso_output(void *opaque, const uint8_t *buf, size_t size)
+{
+    struct iovec iov = {
+        .iov_base = (void *)buf,
+        .iov_len = size,
+    };
+
+    return af_xdp_xmit(opaque, &iov, 1);
+}
+
+static ssize_t af_xdp_receive_iov(NetClientState *nc,
+                                  const struct iovec *iov, int iovcnt)
+{
+    AFXDPState *s = DO_UPCAST(AFXDPState, nc, nc);
+
+    if (s->offload_enabled) {
+        return net_gso_send(&s->offload, iov, iovcnt, af_xdp_gso_output, s);
+    }
+
+    return af_xdp_xmit(s, iov, iovcnt) ? iov_size(iov, iovcnt) : 0;
+}
+
+static ssize_t af_xdp_receive(NetClientState *nc,
+                              const uint8_t *buf, size_t size)
+{
+    struct iovec iov = {
+        .iov_base = (void *)buf,
+        .iov_len = size,
+    };
+
+    return af_xdp_receive_iov(nc, &iov, 1);
 }
 
 /*
@@ -229,6 +288,7 @@ static void af_xdp_send(void *opaque)
     for (i = 0; i < n_rx; i++) {
         const struct xdp_desc *desc;
         struct iovec iov;
+        ssize_t ret;
 
         desc = xsk_ring_cons__rx_desc(&s->rx, idx++);
 
@@ -237,8 +297,13 @@ static void af_xdp_send(void *opaque)
 
         s->pool[s->n_pool++] = desc->addr;
 
-        if (!qemu_sendv_packet_async(&s->nc, &iov, 1,
-                                     af_xdp_send_completed)) {
+        if (s->offload_enabled) {
+            ret = net_gro_receive(&s->offload, iov.iov_base, iov.iov_len);
+        } else {
+            ret = qemu_sendv_packet_async(&s->nc, &iov, 1,
+                                          af_xdp_send_completed);
+        }
+        if (!ret) {
             /*
              * The peer does not receive anymore.  Packet is queued, stop
              * reading from the backend until af_xdp_send_completed().
@@ -252,6 +317,11 @@ static void af_xdp_send(void *opaque)
         }
     }
 
+    /* The last merged packet of the batch is still pending. */
+    if (s->offload_enabled && !net_gro_flush(&s->offload)) {
+        af_xdp_read_poll(s, false);
+    }
+
     /* Release actually sent descriptors and try to re-fill. */
     xsk_ring_cons__release(&s->rx, n_rx);
     af_xdp_fq_refill(s, AF_XDP_BATCH_SIZE);
@@ -272,9 +342,22 @@ static void af_xdp_cleanup(NetClientState *nc)
     s->pool = NULL;
     xsk_umem__delete(s->umem);
     s->umem = NULL;
-    qemu_vfree(s->buffer);
+    if (s->memdev) {
+        if (--*s->memdev_users == 0) {
+            host_memory_backend_set_mapped(s->memdev, false);
+            g_free(s->memdev_users);
+        }
+        s->memdev_users = NULL;
+        s->memdev = NULL;
+    } else {
+        qemu_vfree(s->buffer);
+    }
     s->buffer = NULL;
 
+    if (s->offload_enabled) {
+        net_offload_cleanup(&s->offload);
+    }
+
     /* Remove the program if it's the last open queue. */
     if (!s->inhibit && nc->queue_index == s->n_queues - 1 && s->xdp_flags
         && bpf_xdp_detach(s->ifindex, s->xdp_flags, NULL) != 0) {
@@ -284,7 +367,23 @@ static void af_xdp_cleanup(NetClientState *nc)
     }
 }
 
-static int af_xdp_umem_create(AFXDPState *s, int sock_fd, Error **errp)
+/* UMEM size of a single queue. */
+static uint64_t af_xdp_umem_size(void)
+{
+    /* Number of descriptors if all 4 queues (rx, tx, cq, fq) are full. */
+    return (XSK_RING_PROD__DEFAULT_NUM_DESCS
+            + XSK_RING_CONS__DEFAULT_NUM_DESCS) * 2
+           * XSK_UMEM__DEFAULT_FRAME_SIZE;
+}
+
+/*
+ * Queue @i uses the @i-th UMEM sized slice of @memdev, or a private
+ * allocation if @memdev is NULL.  @memdev_users counts the queues that
+ * use @memdev; it is marked as mapped while there is at least one.
+ */
+static int af_xdp_umem_create(AFXDPState *s, HostMemoryBackend *memdev,
+                              unsigned *memdev_users, int sock_fd,
+                              Error **errp)
 {
     struct xsk_umem_config config = {
         .fill_size = XSK_RING_PROD__DEFAULT_NUM_DESCS,
@@ -297,13 +396,18 @@ static int af_xdp_umem_create(AFXDPState *s, int sock_fd, Error **errp)
     int64_t i;
     int ret;
 
-    /* Number of descriptors if all 4 queues (rx, tx, cq, fq) are full. */
-    n_descs = (XSK_RING_PROD__DEFAULT_NUM_DESCS
-               + XSK_RING_CONS__DEFAULT_NUM_DESCS) * 2;
-    size = n_descs * XSK_UMEM__DEFAULT_FRAME_SIZE;
+    size = af_xdp_umem_size();
+    n_descs = size / XSK_UMEM__DEFAULT_FRAME_SIZE;
+
+    if (memdev) {
+        MemoryRegion *mr = host_memory_backend_get_memory(memdev);
 
-    s->buffer = qemu_memalign(qemu_real_host_page_size(), size);
-    memset(s->buffer, 0, size);
+        s->buffer = (char *)memory_region_get_ram_ptr(mr)
+                    + s->nc.queue_index * size;
+    } else {
+        s->buffer = qemu_memalign(qemu_real_host_page_size(), size);
+        memset(s->buffer, 0, size);
+    }
 
     if (sock_fd < 0) {
         ret = xsk_umem__create(&s->umem, s->buffer, size,
@@ -314,13 +418,24 @@ static int af_xdp_umem_create(AFXDPState *s, int sock_fd, Error **errp)
     }
 
     if (ret) {
-        qemu_vfree(s->buffer);
+        if (!memdev) {
+            qemu_vfree(s->buffer);
+        }
+        s->buffer = NULL;
         error_setg_errno(errp, errno,
                          "failed to create umem for %s queue_index: %d",
                          s->ifname, s->nc.queue_index);
         return -1;
     }
 
+    if (memdev) {
+        if ((*memdev_users)++ == 0) {
+            host_memory_backend_set_mapped(memdev, true);
+        }
+        s->memdev = memdev;
+        s->memdev_users = memdev_users;
+    }
+
     s->pool = g_new(uint64_t, n_descs);
     /* Fill the pool in the opposite order, because it's a LIFO queue. */
     for (i = n_descs; i >= 0; i--) {
@@ -353,6 +468,9 @@ static int af_xdp_socket_create(AFXDPState *s,
     if (opts->has_force_copy && opts->force_copy) {
         cfg.bind_flags |= XDP_COPY;
     }
+    if (opts->has_zero_copy && opts->zero_copy) {
+        cfg.bind_flags |= XDP_ZEROCOPY;
+    }
 
     queue_id = s->nc.queue_index;
     if (opts->has_start_queue && opts->start_queue > 0) {
@@ -396,13 +514,61 @@ static int af_xdp_socket_create(AFXDPState *s,
     return 0;
 }
 
+/* Move the event-loop handlers to an IOThread or back to the main loop. */
+static void af_xdp_set_aio_context(NetClientState *nc, AioContext *ctx)
+{
+    AFXDPState *s = DO_UPCAST(AFXDPState, nc, nc);
+
+    af_xdp_set_fd_handler(s, nc->aio_context, false);
+    af_xdp_set_fd_handler(s, ctx, true);
+}
+
+static bool af_xdp_has_vnet_hdr(NetClientState *nc)
+{
+    AFXDPState *s = DO_UPCAST(AFXDPState, nc, nc);
+
+    return s->offload_enabled;
+}
+
+static bool af_xdp_has_vnet_hdr_len(NetClientState *nc, int len)
+{
+    AFXDPState *s = DO_UPCAST(AFXDPState, nc, nc);
+
+    return s->offload_enabled &&
+           net_offload_has_vnet_hdr_len(&s->offload, len);
+}
+
+static void af_xdp_set_vnet_hdr_len(NetClientState *nc, int len)
+{
+    AFXDPState *s = DO_UPCAST(AFXDPState, nc, nc);
+
+    assert(s->offload_enabled);
+    net_offload_set_vnet_hdr_len(&s->offload, len);
+}
+
+static void af_xdp_set_offload(NetClientState *nc, int csum, int tso4,
+                               int tso6, int ecn, int ufo, int uso4, int uso6)
+{
+    AFXDPState *s = DO_UPCAST(AFXDPState, nc, nc);
+
+    if (s->offload_enabled) {
+        net_offload_set_offload(&s->offload, csum, tso4, tso6);
+    }
+}
+
 /* NetClientInfo methods. */
 static NetClientInfo net_af_xdp_info = {
     .type = NET_CLIENT_DRIVER_AF_XDP,
     .size = sizeof(AFXDPState),
     .receive = af_xdp_receive,
+    .receive_iov = af_xdp_receive_iov,
     .poll = af_xdp_poll,
     .cleanup = af_xdp_cleanup,
+    .set_aio_context = af_xdp_set_aio_context,
+    .has_vnet_hdr = af_xdp_has_vnet_hdr,
+    .has_vnet_hdr_len = af_xdp_has_vnet_hdr_len,
+    .set_vnet_hdr_len = af_xdp_set_vnet_hdr_len,
+    .set_offload = af_xdp_set_offload,
 };
 
 static int *parse_socket_fds(const char *sock_fds_str,
@@ -447,6 +613,8 @@ int net_init_af_xdp(const Netdev *netdev,
     unsigned int ifindex;
     uint32_t prog_id = 0;
     g_autofree int *sock_fds = NULL;
+    HostMemoryBackend *memdev = NULL;
+    unsigned *memdev_users = NULL;
     int64_t i, queues;
     Error *err = NULL;
     AFXDPState *s;
@@ -470,6 +638,40 @@ int net_init_af_xdp(const Netdev *netdev,
         return -1;
     }
 
+    if (opts->has_force_copy && opts->force_copy &&
+        opts->has_zero_copy && opts->zero_copy) {
+        error_setg(errp, "'force-copy=on' and 'zero-copy=on' are exclusive");
+        return -1;
+    }
+
+    if (opts->memdev) {
+        Object *obj = object_resolve_path_type(opts->memdev,
+                                               TYPE_MEMORY_BACKEND, NULL);
+        uint64_t size;
+
+        if (!obj) {
+            error_setg(errp, "memory backend '%s' not found", opts->memdev);
+            return -1;
+        }
+        memdev = MEMORY_BACKEND(obj);
+        /*
+         * The kernel and the NIC write packets anywhere in the UMEM, so it
+         * must not be guest RAM or used by anything else.
+         */
+        if (host_memory_backend_is_mapped(memdev)) {
+            error_setg(errp, "memory backend '%s' is already in use",
+                       opts->memdev);
+            return -1;
+        }
+        size = memory_region_size(host_memory_backend_get_memory(memdev));
+        if (size < queues * af_xdp_umem_size()) {
+            error_setg(errp, "memory backend '%s' is too small, %" PRIi64
+                       " queues need %" PRIu64 " bytes", opts->memdev,
+                       queues, queues * af_xdp_umem_size());
+            return -1;
+        }
+    }
+
     if (opts->sock_fds) {
         sock_fds = parse_socket_fds(opts->sock_fds, queues, errp);
         if (!sock_fds) {
@@ -477,6 +679,10 @@ int net_init_af_xdp(const Netdev *netdev,
         }
     }
 
+    if (memdev) {
+        memdev_users = g_new0(unsigned, 1);
+    }
+
     for (i = 0; i < queues; i++) {
         nc = qemu_new_net_client(&net_af_xdp_info, peer, "af-xdp", name);
         qemu_set_info_str(nc, "af-xdp%"PRIi64" to %s", i, opts->ifname);
@@ -492,7 +698,13 @@ int net_init_af_xdp(const Netdev *netdev,
         s->ifindex = ifindex;
         s->n_queues = queues;
 
-        if (af_xdp_umem_create(s, sock_fds ? sock_fds[i] : -1, errp)
+        if (opts->has_offload && opts->offload) {
+            s->offload_enabled = true;
+            net_offload_init(&s->offload, nc, af_xdp_send_completed);
+        }
+
+        if (af_xdp_umem_create(s, memdev, memdev_users,
+                               sock_fds ? sock_fds[i] : -1, errp)
             || af_xdp_socket_create(s, opts, errp)) {
             /* Make sure the XDP program will be removed. */
             s->n_queues = i;
@@ -516,6 +728,10 @@ int net_init_af_xdp(const Netdev *netdev,
     return 0;
 
 err:
+    /* Otherwise freed with the last queue that uses it */
+    if (memdev_users && !*memdev_users) {
+        g_free(memdev_users);
+    }
     if (nc0) {
         qemu_del_net_client(nc0);
     }
@@ -32,6 +32,9 @@
 
 #include "block/aio-wait.h"
 #include "qemu/coroutine.h"
+#include "qemu/stats64.h"
+#include "qemu/thread.h"
+#include "qapi/qapi-visit-net.h"
 
 #define TYPE_COLO_COMPARE "colo-compare"
 typedef struct CompareState CompareState;
@@ -52,6 +55,7 @@ static NotifierList colo_compare_notifiers =
 
 #define REGULAR_PACKET_CHECK_MS 1000
 #define DEFAULT_TIME_OUT_MS 3000
+#define MAX_COMPARE_WORKERS 64
 
 /* #define DEBUG_COLO_PACKETS */
 
@@ -101,6 +105,48 @@ typedef struct SendEntry {
     uint8_t *buf;
 } SendEntry;
 
+/*
+ * Connections are split into shards by the hash of their connection key,
+ * so both the primary and the secondary packets of a connection always
+ * end up in the same shard.  Without workers there is a single shard that
+ * is compared in the iothread.  With workers every shard is compared in
+ * its own thread; packets released by a worker are passed back to the
+ * iothread in order, which keeps the output of each connection in order.
+ */
+typedef struct CompareShard {
+    CompareState *s;
+    unsigned int index;
+
+    /*
+     * Record the connection that through the NIC
+     * Element type: Connection
+     */
+    GQueue conn_list;
+    /* Record the connection without repetition */
+    GHashTable *connection_track_table;
+
+    /* The fields below are only used when the shard has a worker thread */
+    bool threaded;
+    QemuThread thread;
+    QemuMutex lock;
+    QemuCond cond;
+    QemuCond flush_cond;
+    QEMUBH *out_bh;
+    /* Protected by lock */
+    GQueue pri_in;
+    GQueue sec_in;
+    GQueue out_list;
+    bool notify;
+    bool check_old;
+    bool flush;
+    bool stop;
+
+    Stat64 packets;
+    Stat64 released;
+    Stat64 mismatches;
+    uint32_t connections;
+} CompareShard;
+
 struct CompareState {
     Object parent;
 
@@ -120,14 +166,10 @@ struct CompareState {
     bool vnet_hdr;
     uint64_t compare_timeout;
     uint32_t expired_scan_cycle;
+    uint32_t workers;
 
-    /*
-     * Record the connection that through the NIC
-     * Element type: Connection
-     */
-    GQueue conn_list;
-    /* Record the connection without repetition */
-    GHashTable *connection_track_table;
+    CompareShard *shards;
+    unsigned int nr_shards;
 
     IOThread *iothread;
     GMainContext *worker_context;
@@ -192,6 +234,21 @@ static void colo_compare_inconsistency_notify(CompareState *s)
     }
 }
 
+static void colo_compare_shard_notify(CompareShard *sh)
+{
+    stat64_add(&sh->mismatches, 1);
+    if (!sh->threaded) {
+        colo_compare_inconsistency_notify(sh->s);
+        return;
+    }
+
+    /* The notification is sent from the iothread, see colo_shard_output() */
+    qemu_mutex_lock(&sh->lock);
+    sh->notify = true;
+    qemu_mutex_unlock(&sh->lock);
+    qemu_bh_schedule(sh->out_bh);
+}
+
 /* Use restricted to colo_insert_packet() */
 static gint seq_sorter(Packet *a, Packet *b, gpointer data)
 {
@@ -238,15 +295,12 @@ static int colo_insert_packet(GQueue *queue, Packet *pkt, uint32_t *max_ack)
 }
 
 /*
- * Return 0 on success, if return -1 means the pkt
+ * Return the new packet, if return NULL means the pkt
  * is unsupported(arp and ipv6) and will be sent later
  */
-static int packet_enqueue(CompareState *s, int mode, Connection **con)
+static Packet *packet_parse(CompareState *s, int mode)
 {
-    ConnectionKey key;
     Packet *pkt = NULL;
-    Connection *conn;
-    int ret;
 
     if (mode == PRIMARY_IN) {
         pkt = packet_new(s->pri_rs.buf,
@@ -260,17 +314,26 @@ static int packet_enqueue(CompareState *s, int mode, Connection **con)
 
     if (parse_packet_early(pkt)) {
         packet_destroy(pkt, NULL);
-        pkt = NULL;
-        return -1;
+        return NULL;
     }
+
+    return pkt;
+}
+
+static Connection *packet_enqueue(CompareShard *sh, int mode, Packet *pkt)
+{
+    ConnectionKey key;
+    Connection *conn;
+    int ret;
+
     fill_connection_key(pkt, &key, false);
 
-    conn = connection_get(s->connection_track_table,
+    conn = connection_get(sh->connection_track_table,
                           &key,
-                          &s->conn_list);
+                          &sh->conn_list);
 
     if (!conn->processing) {
-        g_queue_push_tail(&s->conn_list, conn);
+        g_queue_push_tail(&sh->conn_list, conn);
         conn->processing = true;
     }
 
@@ -287,9 +350,7 @@ static int packet_enqueue(CompareState *s, int mode, Connection **con)
         pkt = NULL;
     }
 
-    *con = conn;
-
-    return 0;
+    return conn;
 }
 
 static inline bool after(uint32_t seq1, uint32_t seq2)
@@ -297,7 +358,7 @@ static inline bool after(uint32_t seq1, uint32_t seq2)
         return (int32_t)(seq1 - seq2) > 0;
 }
 
-static void colo_release_primary_pkt(CompareState *s, Packet *pkt)
+static void colo_send_primary_pkt(CompareState *s, Packet *pkt)
 {
     int ret;
     ret = compare_chr_send(s,
@@ -309,10 +370,29 @@ static void colo_release_primary_pkt(CompareState *s, Packet *pkt)
     if (ret < 0) {
         error_report("colo send primary packet failed");
     }
-    trace_colo_compare_main("packet same and release packet");
     packet_destroy_partial(pkt, NULL);
 }
 
+static void colo_output_primary_pkt(CompareShard *sh, Packet *pkt)
+{
+    stat64_add(&sh->released, 1);
+    if (!sh->threaded) {
+        colo_send_primary_pkt(sh->s, pkt);
+        return;
+    }
+
+    qemu_mutex_lock(&sh->lock);
+    g_queue_push_tail(&sh->out_list, pkt);
+    qemu_mutex_unlock(&sh->lock);
+    qemu_bh_schedule(sh->out_bh);
+}
+
+static void colo_release_primary_pkt(CompareShard *sh, Packet *pkt)
+{
+    trace_colo_compare_main("packet same and release packet");
+    colo_output_primary_pkt(sh, pkt);
+}
+
 /*
  * The IP packets sent by primary and secondary
  * will be compared in here
@@ -396,7 +476,7 @@ static bool colo_mark_tcp_pkt(Packet *ppkt, Packet *spkt,
     return false;
 }
 
-static void colo_compare_tcp(CompareState *s, Connection *conn)
+static void colo_compare_tcp(CompareShard *sh, Connection *conn)
 {
     Packet *ppkt = NULL, *spkt = NULL;
     int8_t mark;
@@ -427,13 +507,13 @@ sec:
     spkt = g_queue_pop_tail(&conn->secondary_list);
 
     if (ppkt->tcp_seq == ppkt->seq_end) {
-        colo_release_primary_pkt(s, ppkt);
+        colo_release_primary_pkt(sh, ppkt);
         ppkt = NULL;
     }
 
     if (ppkt && conn->compare_seq && !after(ppkt->seq_end, conn->compare_seq)) {
         trace_colo_compare_main("pri: this packet has compared");
-        colo_release_primary_pkt(s, ppkt);
+        colo_release_primary_pkt(sh, ppkt);
         ppkt = NULL;
     }
 
@@ -473,7 +553,7 @@ sec:
 
         if (mark == COLO_COMPARE_FREE_PRIMARY) {
             conn->compare_seq = ppkt->seq_end;
-            colo_release_primary_pkt(s, ppkt);
+            colo_release_primary_pkt(sh, ppkt);
             g_queue_push_tail(&conn->secondary_list, spkt);
             goto pri;
         } else if (mark == COLO_COMPARE_FREE_SECONDARY) {
@@ -482,7 +562,7 @@ sec:
             goto sec;
         } else if (mark == (COLO_COMPARE_FREE_PRIMARY | COLO_COMPARE_FREE_SECONDARY)) {
             conn->compare_seq = ppkt->seq_end;
-            colo_release_primary_pkt(s, ppkt);
+            colo_release_primary_pkt(sh, ppkt);
             packet_destroy(spkt, NULL);
             goto pri;
         }
@@ -495,7 +575,7 @@ sec:
         qemu_hexdump(stderr, "colo-compare spkt", spkt->data, spkt->size);
 #endif
 
-        colo_compare_inconsistency_notify(s);
+        colo_compare_shard_notify(sh);
     }
 }
 
@@ -620,8 +700,10 @@ void colo_compare_unregister_notifier(Notifier *notify)
 }
 
 static int colo_old_packet_check_one_conn(Connection *conn,
-                                          CompareState *s)
+                                          CompareShard *sh)
 {
+    CompareState *s = sh->s;
+
     if (!g_queue_is_empty(&conn->primary_list)) {
         if (g_queue_find_custom(&conn->primary_list,
                                 &s->compare_timeout,
@@ -640,7 +722,7 @@ static int colo_old_packet_check_one_conn(Connection *conn,
 
 out:
     /* Do checkpoint will flush old packet */
-    colo_compare_inconsistency_notify(s);
+    colo_compare_shard_notify(sh);
     return 0;
 }
 
@@ -649,19 +731,36 @@ out:
  * if we have some then we have to checkpoint to wake
  * the secondary up.
  */
-static void colo_old_packet_check(void *opaque)
+static void colo_old_packet_check_shard(CompareShard *sh)
 {
-    CompareState *s = opaque;
-
     /*
      * If we find one old packet, stop finding job and notify
      * COLO frame do checkpoint.
      */
-    g_queue_find_custom(&s->conn_list, s,
+    g_queue_find_custom(&sh->conn_list, sh,
                         (GCompareFunc)colo_old_packet_check_one_conn);
 }
 
-static void colo_compare_packet(CompareState *s, Connection *conn,
+static void colo_old_packet_check(void *opaque)
+{
+    CompareState *s = opaque;
+    unsigned int i;
+
+    for (i = 0; i < s->nr_shards; i++) {
+        CompareShard *sh = &s->shards[i];
+
+        if (!sh->threaded) {
+            colo_old_packet_check_shard(sh);
+            continue;
+        }
+        qemu_mutex_lock(&sh->lock);
+        sh->check_old = true;
+        qemu_cond_signal(&sh->cond);
+        qemu_mutex_unlock(&sh->lock);
+    }
+}
+
+static void colo_compare_packet(CompareShard *sh, Connection *conn,
                                 int (*HandlePacket)(Packet *spkt,
                                 Packet *ppkt))
 {
@@ -675,7 +774,7 @@ static void colo_compare_packet(CompareState *s, Connection *conn,
                  pkt, (GCompareFunc)HandlePacket);
 
         if (result) {
-            colo_release_primary_pkt(s, pkt);
+            colo_release_primary_pkt(sh, pkt);
             packet_destroy(result->data, NULL);
             g_queue_delete_link(&conn->secondary_list, result);
         } else {
@@ -688,7 +787,7 @@ static void colo_compare_packet(CompareState *s, Connection *conn,
             trace_colo_compare_main("packet different");
             g_queue_push_tail(&conn->primary_list, pkt);
 
-            colo_compare_inconsistency_notify(s);
+            colo_compare_shard_notify(sh);
             break;
         }
     }
@@ -702,25 +801,35 @@ static void colo_compare_packet(CompareState *s, Connection *conn,
  */
 static void colo_compare_connection(void *opaque, void *user_data)
 {
-    CompareState *s = user_data;
+    CompareShard *sh = user_data;
     Connection *conn = opaque;
 
     switch (conn->ip_proto) {
     case IPPROTO_TCP:
-        colo_compare_tcp(s, conn);
+        colo_compare_tcp(sh, conn);
         break;
     case IPPROTO_UDP:
-        colo_compare_packet(s, conn, colo_packet_compare_udp);
+        colo_compare_packet(sh, conn, colo_packet_compare_udp);
         break;
     case IPPROTO_ICMP:
-        colo_compare_packet(s, conn, colo_packet_compare_icmp);
+        colo_compare_packet(sh, conn, colo_packet_compare_icmp);
         break;
     default:
-        colo_compare_packet(s, conn, colo_packet_compare_other);
+        colo_compare_packet(sh, conn, colo_packet_compare_other);
         break;
     }
 }
 
+static void colo_compare_shard_packet(CompareShard *sh, int mode, Packet *pkt)
+{
+    Connection *conn = packet_enqueue(sh, mode, pkt);
+
+    qatomic_set(&sh->connections,
+                g_hash_table_size(sh->connection_track_table));
+    /* compare packet in the specified connection */
+    colo_compare_connection(conn, sh);
+}
+
 static void coroutine_fn _compare_chr_send(void *opaque)
 {
     SendCo *sendco = opaque;
@@ -884,6 +993,144 @@ static void compare_notify_chr(void *opaque, const uint8_t *buf, int size)
     }
 }
 
+static void colo_flush_packets(void *opaque, void *user_data);
+
+/*
+ * Called from the iothread to send the packets released by a worker
+ * and the checkpoint request it made, if any.
+ */
+static void colo_shard_output(void *opaque)
+{
+    CompareShard *sh = opaque;
+    GQueue out_list;
+    Packet *pkt;
+    bool notify;
+
+    qemu_mutex_lock(&sh->lock);
+    out_list = sh->out_list;
+    g_queue_init(&sh->out_list);
+    notify = sh->notify;
+    sh->notify = false;
+    qemu_mutex_unlock(&sh->lock);
+
+    while ((pkt = g_queue_pop_head(&out_list))) {
+        colo_send_primary_pkt(sh->s, pkt);
+    }
+
+    if (notify) {
+        colo_compare_inconsistency_notify(sh->s);
+    }
+}
+
+static void *colo_compare_worker(void *opaque)
+{
+    CompareShard *sh = opaque;
+    Packet *ppkt, *spkt;
+
+    qemu_mutex_lock(&sh->lock);
+    for (;;) {
+        ppkt = g_queue_pop_head(&sh->pri_in);
+        spkt = g_queue_pop_head(&sh->sec_in);
+        if (ppkt || spkt) {
+            qemu_mutex_unlock(&sh->lock);
+            if (ppkt) {
+                colo_compare_shard_packet(sh, PRIMARY_IN, ppkt);
+            }
+            if (spkt) {
+                colo_compare_shard_packet(sh, SECONDARY_IN, spkt);
+            }
+            qemu_mutex_lock(&sh->lock);
+        } else if (sh->check_old) {
+            sh->check_old = false;
+            qemu_mutex_unlock(&sh->lock);
+            colo_old_packet_check_shard(sh);
+            qemu_mutex_lock(&sh->lock);
+        } else if (sh->flush) {
+            qemu_mutex_unlock(&sh->lock);
+            g_queue_foreach(&sh->conn_list, colo_flush_packets, sh);
+            qemu_mutex_lock(&sh->lock);
+            sh->flush = false;
+            qemu_cond_broadcast(&sh->flush_cond);
+        } else if (sh->stop) {
+            break;
+        } else {
+            qemu_cond_wait(&sh->cond, &sh->lock);
+        }
+    }
+    qemu_mutex_unlock(&sh->lock);
+
+    return NULL;
+}
+
+static void colo_compare_dispatch(CompareState *s, int mode, Packet *pkt)
+{
+    CompareShard *sh = &s->shards[0];
+    GQueue *in;
+
+    if (s->nr_shards > 1) {
+        ConnectionKey key;
+
+        fill_connection_key(pkt, &key, false);
+        sh = &s->shards[connection_key_hash(&key) % s->nr_shards];
+    }
+
+    stat64_add(&sh->packets, 1);
+    if (!sh->threaded) {
+        colo_compare_shard_packet(sh, mode, pkt);
+        return;
+    }
+
+    in = mode == PRIMARY_IN ? &sh->pri_in : &sh->sec_in;
+    qemu_mutex_lock(&sh->lock);
+    if (g_queue_get_length(in) > max_queue_size) {
+        qemu_mutex_unlock(&sh->lock);
+        trace_colo_compare_drop_packet(colo_mode[mode],
+            "worker queue too big, drop packet");
+        packet_destroy(pkt, NULL);
+        return;
+    }
+    g_queue_push_tail(in, pkt);
+    qemu_cond_signal(&sh->cond);
+    qemu_mutex_unlock(&sh->lock);
+}
+
+/*
+ * Flush primary packets and remove secondary packets of all
+ * connections, waiting for the workers to do so for their shards.
+ * Called from the iothread.
+ */
+static void colo_compare_flush(CompareState *s)
+{
+    unsigned int i;
+
+    for (i = 0; i < s->nr_shards; i++) {
+        CompareShard *sh = &s->shards[i];
+
+        if (!sh->threaded) {
+            g_queue_foreach(&sh->conn_list, colo_flush_packets, sh);
+            continue;
+        }
+        qemu_mutex_lock(&sh->lock);
+        sh->flush = true;
+        qemu_cond_signal(&sh->cond);
+        qemu_mutex_unlock(&sh->lock);
+    }
+
+    for (i = 0; i < s->nr_shards; i++) {
+        CompareShard *sh = &s->shards[i];
+
+        if (!sh->threaded) {
+            continue;
+        }
+        qemu_mutex_lock(&sh->lock);
+        while (sh->flush) {
+            qemu_cond_wait(&sh->flush_cond, &sh->lock);
+        }
+        qemu_mutex_unlock(&sh->lock);
+        colo_shard_output(sh);
+    }
+}
+
 /*
  * Check old packet regularly so it can watch for any packets
  * that the secondary hasn't produced equivalents of.
@@ -943,15 +1190,13 @@ static void colo_compare_timer_del(CompareState *s)
     }
  }
 
-static void colo_flush_packets(void *opaque, void *user_data);
-
 static void colo_compare_handle_event(void *opaque)
 {
     CompareState *s = opaque;
 
     switch (s->event) {
     case COLO_EVENT_CHECKPOINT:
-        g_queue_foreach(&s->conn_list, colo_flush_packets, s);
+        colo_compare_flush(s);
         break;
     case COLO_EVENT_FAILOVER:
         break;
@@ -1120,6 +1365,62 @@ static void compare_set_expired_scan_cycle(Object *obj, Visitor *v,
     s->expired_scan_cycle = value;
 }
 
+static void compare_get_workers(Object *obj, Visitor *v,
+                                const char *name, void *opaque,
+                                Error **errp)
+{
+    CompareState *s = COLO_COMPARE(obj);
+    uint32_t value = s->workers;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void compare_set_workers(Object *obj, Visitor *v,
+                                const char *name, void *opaque,
+                                Error **errp)
+{
+    CompareState *s = COLO_COMPARE(obj);
+    uint32_t value;
+
+    if (s->shards) {
+        error_setg(errp, "Property '%s.%s' can't be changed after creation",
+                   object_get_typename(obj), name);
+        return;
+    }
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (value > MAX_COMPARE_WORKERS) {
+        error_setg(errp, "Property '%s.%s' must not exceed %d",
+                   object_get_typename(obj), name, MAX_COMPARE_WORKERS);
+        return;
+    }
+    s->workers = value;
+}
+
+static void compare_get_stats(Object *obj, Visitor *v,
+                              const char *name, void *opaque,
+                              Error **errp)
+{
+    CompareState *s = COLO_COMPARE(obj);
+    g_autoptr(ColoCompareStats) stats = g_new0(ColoCompareStats, 1);
+    ColoCompareWorkerStatsList **tail = &stats->workers;
+    unsigned int i;
+
+    for (i = 0; i < s->nr_shards; i++) {
+        CompareShard *sh = &s->shards[i];
+        ColoCompareWorkerStats *w = g_new0(ColoCompareWorkerStats, 1);
+
+        w->packets = stat64_get(&sh->packets);
+        w->released = stat64_get(&sh->released);
+        w->mismatches = stat64_get(&sh->mismatches);
+        w->connections = qatomic_read(&sh->connections);
+        QAPI_LIST_APPEND(tail, w);
+    }
+
+    visit_type_ColoCompareStats(v, name, &stats, errp);
+}
+
 static void get_max_queue_size(Object *obj, Visitor *v,
                                const char *name, void *opaque,
                                Error **errp)
@@ -1149,9 +1450,9 @@ static void set_max_queue_size(Object *obj, Visitor *v,
 static void compare_pri_rs_finalize(SocketReadState *pri_rs)
 {
     CompareState *s = container_of(pri_rs, CompareState, pri_rs);
-    Connection *conn = NULL;
+    Packet *pkt = packet_parse(s, PRIMARY_IN);
 
-    if (packet_enqueue(s, PRIMARY_IN, &conn)) {
+    if (!pkt) {
         trace_colo_compare_main("primary: unsupported packet in");
         compare_chr_send(s,
                          pri_rs->buf,
@@ -1160,21 +1461,19 @@ static void compare_pri_rs_finalize(SocketReadState *pri_rs)
                          false,
                          false);
     } else {
-        /* compare packet in the specified connection */
-        colo_compare_connection(conn, s);
+        colo_compare_dispatch(s, PRIMARY_IN, pkt);
     }
 }
 
 static void compare_sec_rs_finalize(SocketReadState *sec_rs)
 {
     CompareState *s = container_of(sec_rs, CompareState, sec_rs);
-    Connection *conn = NULL;
+    Packet *pkt = packet_parse(s, SECONDARY_IN);
 
-    if (packet_enqueue(s, SECONDARY_IN, &conn)) {
+    if (!pkt) {
         trace_colo_compare_main("secondary: unsupported packet in");
     } else {
-        /* compare packet in the specified connection */
-        colo_compare_connection(conn, s);
+        colo_compare_dispatch(s, SECONDARY_IN, pkt);
     }
 }
 
@@ -1196,7 +1495,7 @@ static void compare_notify_rs_finalize(SocketReadState *notify_rs)
                                   notify_rs->buf,
                                   notify_rs->packet_len)) {
         /* colo-compare do checkpoint, flush pri packet and remove sec packet */
-        g_queue_foreach(&s->conn_list, colo_flush_packets, s);
+        colo_compare_flush(s);
     } else {
         error_report("COLO compare got unsupported instruction");
     }
@@ -1232,6 +1531,71 @@ static int find_and_check_chardev(Chardev **chr,
     return 0;
 }
 
+static void colo_compare_shards_init(CompareState *s)
+{
+    AioContext *ctx = iothread_get_aio_context(s->iothread);
+    unsigned int i;
+    char *name;
+
+    s->nr_shards = MAX(s->workers, 1);
+    s->shards = g_new0(CompareShard, s->nr_shards);
+
+    for (i = 0; i < s->nr_shards; i++) {
+        CompareShard *sh = &s->shards[i];
+
+        sh->s = s;
+        sh->index = i;
+        g_queue_init(&sh->conn_list);
+        sh->connection_track_table = g_hash_table_new_full(connection_key_hash,
+                                                           connection_key_equal,
+                                                           g_free,
+                                                           NULL);
+        if (!s->workers) {
+            continue;
+        }
+
+        sh->threaded = true;
+        qemu_mutex_init(&sh->lock);
+        qemu_cond_init(&sh->cond);
+        qemu_cond_init(&sh->flush_cond);
+        g_queue_init(&sh->pri_in);
+        g_queue_init(&sh->sec_in);
+        g_queue_init(&sh->out_list);
+        sh->out_bh = aio_bh_new(ctx, colo_shard_output, sh);
+        name = g_strdup_printf("colo-compare-%u", sh->index);
+        qemu_thread_create(&sh->thread, name, colo_compare_worker,
+                           sh, QEMU_THREAD_JOINABLE);
+        g_free(name);
+    }
+}
+
+/*
+ * Stop the workers; whatever they released is sent from the iothread,
+ * and what is left in their shards is flushed by the caller.
+ */
+static void colo_compare_shards_stop(CompareState *s)
+{
+    AioContext *ctx = iothread_get_aio_context(s->iothread);
+    unsigned int i;
+
+    for (i = 0; i < s->nr_shards; i++) {
+        CompareShard *sh = &s->shards[i];
+
+        if (!sh->threaded) {
+            continue;
+        }
+        qemu_mutex_lock(&sh->lock);
+        sh->stop = true;
+        qemu_cond_signal(&sh->cond);
+        qemu_mutex_unlock(&sh->lock);
+        qemu_thread_join(&sh->thread);
+
+        aio_wait_bh_oneshot(ctx, colo_shard_output, sh);
+        qemu_bh_delete(sh->out_bh);
+        sh->threaded = false;
+    }
+}
+
 /*
  * Called from the main thread on the primary
  * to setup colo-compare.
@@ -1311,13 +1675,7 @@ static void colo_compare_complete(UserCreatable *uc, Error **errp)
         g_queue_init(&s->notify_sendco.send_list);
     }
 
-    g_queue_init(&s->conn_list);
-
-    s->connection_track_table = g_hash_table_new_full(connection_key_hash,
-                                                      connection_key_equal,
-                                                      g_free,
-                                                      NULL);
-
+    colo_compare_shards_init(s);
     colo_compare_iothread(s);
 
     qemu_mutex_lock(&colo_compare_mutex);
@@ -1334,19 +1692,13 @@ static void colo_compare_complete(UserCreatable *uc, Error **errp)
 
 static void colo_flush_packets(void *opaque, void *user_data)
 {
-    CompareState *s = user_data;
+    CompareShard *sh = user_data;
     Connection *conn = opaque;
     Packet *pkt = NULL;
 
     while (!g_queue_is_empty(&conn->primary_list)) {
         pkt = g_queue_pop_tail(&conn->primary_list);
-        compare_chr_send(s,
-                         pkt->data,
-                         pkt->size,
-                         pkt->vnet_hdr_len,
-                         false,
-                         true);
-        packet_destroy_partial(pkt, NULL);
+        colo_output_primary_pkt(sh, pkt);
     }
     while (!g_queue_is_empty(&conn->secondary_list)) {
         pkt = g_queue_pop_tail(&conn->secondary_list);
@@ -1391,6 +1743,13 @@ static void colo_compare_init(Object *obj)
                         get_max_queue_size,
                         set_max_queue_size, NULL, NULL);
 
+    object_property_add(obj, "workers", "uint32",
+                        compare_get_workers,
+                        compare_set_workers, NULL, NULL);
+
+    object_property_add(obj, "stats", "ColoCompareStats",
+                        compare_get_stats, NULL, NULL, NULL);
+
     s->vnet_hdr = false;
     object_property_add_bool(obj, "vnet_hdr_support", compare_get_vnet_hdr,
                              compare_set_vnet_hdr);
@@ -1410,6 +1769,7 @@ static void colo_compare_finalize(Object *obj)
 {
     CompareState *s = COLO_COMPARE(obj);
     CompareState *tmp = NULL;
+    unsigned int i;
 
     qemu_mutex_lock(&colo_compare_mutex);
     QTAILQ_FOREACH(tmp, &net_compares, next) {
@@ -1442,19 +1802,32 @@ static void colo_compare_finalize(Object *obj)
         AIO_WAIT_WHILE(ctx, !s->notify_sendco.done);
     }
 
+    colo_compare_shards_stop(s);
+
     /* Release all unhandled packets after compare thead exited */
-    g_queue_foreach(&s->conn_list, colo_flush_packets, s);
+    for (i = 0; i < s->nr_shards; i++) {
+        g_queue_foreach(&s->shards[i].conn_list, colo_flush_packets,
+                        &s->shards[i]);
+    }
     AIO_WAIT_WHILE(NULL, !s->out_sendco.done);
 
-    g_queue_clear(&s->conn_list);
     g_queue_clear(&s->out_sendco.send_list);
     if (s->notify_dev) {
         g_queue_clear(&s->notify_sendco.send_list);
     }
 
-    if (s->connection_track_table) {
-        g_hash_table_destroy(s->connection_track_table);
+    for (i = 0; i < s->nr_shards; i++) {
+        CompareShard *sh = &s->shards[i];
+
+        g_queue_clear(&sh->conn_list);
+        g_hash_table_destroy(sh->connection_track_table);
+        if (s->workers) {
+            qemu_mutex_destroy(&sh->lock);
+            qemu_cond_destroy(&sh->cond);
+            qemu_cond_destroy(&sh->flush_cond);
+        }
     }
+    g_free(s->shards);
 
     object_unref(OBJECT(s->iothread));
 
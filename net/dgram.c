@@ -26,6 +26,7 @@
 #include "qemu/osdep.h"
 
 #include "net/net.h"
+#include "net/offload.h"
 #include "clients.h"
 #include "monitor/monitor.h"
 #include "qapi/error.h"
@@ -45,8 +46,15 @@ typedef struct NetDgramState {
     /* contains destination iff connectionless */
     struct sockaddr *dest_addr;
     socklen_t dest_len;
+
+    /* Software checksum, GRO and GSO, see net/offload.h */
+    bool offload_enabled;
+    NetOffload offload;
 } NetDgramState;
 
+/* Datagrams read in one go, so that GRO has something to merge */
+#define NET_DGRAM_BURST 64
+
 static void net_dgram_send(void *opaque);
 static void net_dgram_writable(void *opaque);
 
@@ -79,10 +87,9 @@ static void net_dgram_writable(void *opaque)
     qemu_flush_queued_packets(&s->nc);
 }
 
-static ssize_t net_dgram_receive(NetClientState *nc,
-                                 const uint8_t *buf, size_t size)
+static ssize_t net_dgram_xmit(NetDgramState *s, const uint8_t *buf,
+                              size_t size)
 {
-    NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
     ssize_t ret;
 
     do {
@@ -100,6 +107,29 @@ static ssize_t net_dgram_receive(NetClientState *nc,
     return ret;
 }
 
+static bool net_dgram_gso_output(void *opaque, const uint8_t *buf,
+                                 size_t size)
+{
+    return net_dgram_xmit(opaque, buf, size) != 0;
+}
+
+static ssize_t net_dgram_receive(NetClientState *nc,
+                                 const uint8_t *buf, size_t size)
+{
+    NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
+
+    if (s->offload_enabled) {
+        struct iovec iov = {
+            .iov_base = (void *)buf,
+            .iov_len = size,
+        };
+
+        return net_gso_send(&s->offload, &iov, 1, net_dgram_gso_output, s);
+    }
+
+    return net_dgram_xmit(s, buf, size);
+}
+
 static void net_dgram_send_completed(NetClientState *nc, ssize_t len)
 {
     NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
@@ -123,21 +153,36 @@ static void net_dgram_rs_finalize(SocketReadState *rs)
 static void net_dgram_send(void *opaque)
 {
     NetDgramState *s = opaque;
+    int packets = 0;
+    ssize_t ret;
     int size;
 
-    size = recv(s->fd, s->rs.buf, sizeof(s->rs.buf), 0);
-    if (size < 0) {
-        return;
+    do {
+        size = recv(s->fd, s->rs.buf, sizeof(s->rs.buf), 0);
+        if (size <= 0) {
+            break;
+        }
+        if (s->offload_enabled) {
+            ret = net_gro_receive(&s->offload, s->rs.buf, size);
+        } else {
+            ret = qemu_send_packet_async(&s->nc, s->rs.buf, size,
+                                         net_dgram_send_completed);
+        }
+        if (ret == 0) {
+            net_dgram_read_poll(s, false);
+            break;
+        }
+    } while (s->offload_enabled && ++packets < NET_DGRAM_BURST);
+
+    /* The last merged packet of the burst is still pending */
+    if (s->offload_enabled && net_gro_flush(&s->offload) == 0) {
+        net_dgram_read_poll(s, false);
     }
+
     if (size == 0) {
         /* end of connection */
         net_dgram_read_poll(s, false);
         net_dgram_write_poll(s, false);
-        return;
-    }
-    if (qemu_send_packet_async(&s->nc, s->rs.buf, size,
-                               net_dgram_send_completed) == 0) {
-        net_dgram_read_poll(s, false);
     }
 }
 
@@ -247,6 +292,43 @@ static void net_dgram_cleanup(NetClientState *nc)
     g_free(s->dest_addr);
     s->dest_addr = NULL;
     s->dest_len = 0;
+    if (s->offload_enabled) {
+        net_offload_cleanup(&s->offload);
+    }
+}
+
+static bool net_dgram_has_vnet_hdr(NetClientState *nc)
+{
+    NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
+
+    return s->offload_enabled;
+}
+
+static bool net_dgram_has_vnet_hdr_len(NetClientState *nc, int len)
+{
+    NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
+
+    return s->offload_enabled &&
+           net_offload_has_vnet_hdr_len(&s->offload, len);
+}
+
+static void net_dgram_set_vnet_hdr_len(NetClientState *nc, int len)
+{
+    NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
+
+    assert(s->offload_enabled);
+    net_offload_set_vnet_hdr_len(&s->offload, len);
+}
+
+static void net_dgram_set_offload(NetClientState *nc, int csum, int tso4,
+                                  int tso6, int ecn, int ufo, int uso4,
+                                  int uso6)
+{
+    NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
+
+    if (s->offload_enabled) {
+        net_offload_set_offload(&s->offload, csum, tso4, tso6);
+    }
 }
 
 static NetClientInfo net_dgram_socket_info = {
@@ -254,12 +336,16 @@ static NetClientInfo net_dgram_socket_info = {
     .size = sizeof(NetDgramState),
     .receive = net_dgram_receive,
     .cleanup = net_dgram_cleanup,
+    .has_vnet_hdr = net_dgram_has_vnet_hdr,
+    .has_vnet_hdr_len = net_dgram_has_vnet_hdr_len,
+    .set_vnet_hdr_len = net_dgram_set_vnet_hdr_len,
+    .set_offload = net_dgram_set_offload,
 };
 
 static NetDgramState *net_dgram_fd_init(NetClientState *peer,
                                         const char *model,
                                         const char *name,
-                                        int fd,
+                                        int fd, bool offload,
                                         Error **errp)
 {
     NetClientState *nc;
@@ -270,6 +356,10 @@ static NetDgramState *net_dgram_fd_init(NetClientState *peer,
     s = DO_UPCAST(NetDgramState, nc, nc);
 
     s->fd = fd;
+    if (offload) {
+        s->offload_enabled = true;
+        net_offload_init(&s->offload, nc, net_dgram_send_completed);
+    }
     net_socket_rs_init(&s->rs, net_dgram_rs_finalize, false);
     net_dgram_read_poll(s, true);
 
@@ -281,6 +371,7 @@ static int net_dgram_mcast_init(NetClientState *peer,
                                 const char *name,
                                 SocketAddress *remote,
                                 SocketAddress *local,
+                                bool offload,
                                 Error **errp)
 {
     NetDgramState *s;
@@ -382,7 +473,7 @@ static int net_dgram_mcast_init(NetClientState *peer,
         }
     }
 
-    s = net_dgram_fd_init(peer, model, name, fd, errp);
+    s = net_dgram_fd_init(peer, model, name, fd, offload, errp);
     if (!s) {
         g_free(saddr);
         return -1;
@@ -428,11 +519,13 @@ int net_init_dgram(const Netdev *netdev, const char *name,
     struct sockaddr_in laddr_in, raddr_in;
     struct sockaddr_un laddr_un, raddr_un;
     socklen_t dest_len;
+    bool offload;
 
     assert(netdev->type == NET_CLIENT_DRIVER_DGRAM);
 
     remote = netdev->u.dgram.remote;
     local = netdev->u.dgram.local;
+    offload = netdev->u.dgram.has_offload && netdev->u.dgram.offload;
 
     /* detect multicast address */
     if (remote && remote->type == SOCKET_ADDRESS_TYPE_INET) {
@@ -445,7 +538,7 @@ int net_init_dgram(const Netdev *netdev, const char *name,
 
         if (IN_MULTICAST(ntohl(mcastaddr.sin_addr.s_addr))) {
             return net_dgram_mcast_init(peer, "dram", name, remote, local,
-                                           errp);
+                                        offload, errp);
         }
     }
 
@@ -576,7 +669,7 @@ int net_init_dgram(const Netdev *netdev, const char *name,
         return -1;
     }
 
-    s = net_dgram_fd_init(peer, "dgram", name, fd, errp);
+    s = net_dgram_fd_init(peer, "dgram", name, fd, offload, errp);
     if (!s) {
         return -1;
     }
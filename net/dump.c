@@ -25,19 +25,42 @@
 #include "qemu/osdep.h"
 #include "clients.h"
 #include "qapi/error.h"
+#include "qemu/atomic.h"
 #include "qemu/error-report.h"
 #include "qemu/iov.h"
 #include "qemu/module.h"
+#include "qemu/stats64.h"
+#include "qemu/thread.h"
 #include "qemu/timer.h"
+#include "qemu/units.h"
 #include "qapi/visitor.h"
 #include "net/filter.h"
 #include "qom/object.h"
 #include "system/rtc.h"
 
+/*
+ * Packets are staged in a single-producer, single-consumer ring and
+ * written to the file by a separate thread, so that a slow disk never
+ * stalls the datapath.  When the ring is full the packet is not captured
+ * and only counted.  The producer is the filter's receive_iov hook, which
+ * only runs with the BQL held.
+ */
+#define DUMP_RING_SIZE (8 * MiB)
+
 typedef struct DumpState {
     int64_t start_ts;
     int fd;
     int pcap_caplen;
+    bool pcapng;
+
+    uint8_t *ring;
+    size_t head;                /* written by the producer only */
+    size_t tail;                /* written by the writer thread only */
+    QemuThread thread;
+    QemuEvent event;
+    bool stop;
+    bool failed;
+    Stat64 dropped;
 } DumpState;
 
 #define PCAP_MAGIC 0xa1b2c3d4
@@ -61,51 +84,235 @@ struct pcap_sf_pkthdr {
     uint32_t len;
 };
 
+/* pcapng blocks, written in host byte order */
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+#define PCAPNG_BT_SHB           0x0a0d0d0a
+#define PCAPNG_BT_IDB           0x00000001
+#define PCAPNG_BT_EPB           0x00000006
+#define PCAPNG_OPT_IF_TSRESOL   9
+
+struct pcapng_shb {
+    uint32_t block_type;
+    uint32_t block_len;
+    uint32_t byte_order_magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int64_t section_len;
+    uint32_t block_len_trailer;
+} QEMU_PACKED;
+
+struct pcapng_idb {
+    uint32_t block_type;
+    uint32_t block_len;
+    uint16_t linktype;
+    uint16_t reserved;
+    uint32_t snaplen;
+    /* if_tsresol = 9, timestamps are in nanoseconds */
+    uint16_t tsresol_code;
+    uint16_t tsresol_len;
+    uint8_t tsresol[4];
+    uint32_t endofopt;
+    uint32_t block_len_trailer;
+} QEMU_PACKED;
+
+struct pcapng_epb {
+    uint32_t block_type;
+    uint32_t block_len;
+    uint32_t interface_id;
+    uint32_t ts_high;
+    uint32_t ts_low;
+    uint32_t caplen;
+    uint32_t len;
+};
+
+/* Copy @len bytes of @iov starting at @offset into the ring at @pos */
+static void dump_ring_put(DumpState *s, size_t pos, const struct iovec *iov,
+                          int cnt, size_t offset, size_t len)
+{
+    size_t idx = pos & (DUMP_RING_SIZE - 1);
+    size_t first = MIN(len, DUMP_RING_SIZE - idx);
+
+    iov_to_buf(iov, cnt, offset, s->ring + idx, first);
+    if (len > first) {
+        iov_to_buf(iov, cnt, offset + first, s->ring, len - first);
+    }
+}
+
+static void dump_ring_put_buf(DumpState *s, size_t pos, const void *buf,
+                              size_t len)
+{
+    struct iovec iov = {
+        .iov_base = (void *)buf,
+        .iov_len = len,
+    };
+
+    dump_ring_put(s, pos, &iov, 1, 0, len);
+}
+
 static ssize_t dump_receive_iov(DumpState *s, const struct iovec *iov, int cnt,
                                 int offset)
 {
-    struct pcap_sf_pkthdr hdr;
-    int64_t ts;
-    int caplen;
+    static const uint8_t zero[3];
     size_t size = iov_size(iov, cnt) - offset;
-    g_autofree struct iovec *dumpiov = g_new(struct iovec, cnt + 1);
+    size_t head, tail, caplen, hdr_len, rec_len;
+    union {
+        struct pcap_sf_pkthdr pcap;
+        struct pcapng_epb epb;
+    } hdr;
+    int64_t ts;
 
     /* Early return in case of previous error. */
-    if (s->fd < 0) {
+    if (s->fd < 0 || qatomic_read(&s->failed)) {
         return size;
     }
 
-    ts = qemu_clock_get_us(QEMU_CLOCK_VIRTUAL);
-    caplen = size > s->pcap_caplen ? s->pcap_caplen : size;
+    ts = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+    caplen = MIN(size, s->pcap_caplen);
+
+    if (s->pcapng) {
+        uint64_t ts_ns = s->start_ts * NANOSECONDS_PER_SECOND + ts;
+
+        hdr_len = sizeof(hdr.epb);
+        rec_len = hdr_len + ROUND_UP(caplen, 4) + sizeof(uint32_t);
+        hdr.epb.block_type = PCAPNG_BT_EPB;
+        hdr.epb.block_len = rec_len;
+        hdr.epb.interface_id = 0;
+        hdr.epb.ts_high = ts_ns >> 32;
+        hdr.epb.ts_low = ts_ns;
+        hdr.epb.caplen = caplen;
+        hdr.epb.len = size;
+    } else {
+        hdr_len = sizeof(hdr.pcap);
+        rec_len = hdr_len + caplen;
+        hdr.pcap.ts.tv_sec = ts / NANOSECONDS_PER_SECOND + s->start_ts;
+        hdr.pcap.ts.tv_usec = (ts % NANOSECONDS_PER_SECOND) / SCALE_US;
+        hdr.pcap.caplen = caplen;
+        hdr.pcap.len = size;
+    }
 
-    hdr.ts.tv_sec = ts / 1000000 + s->start_ts;
-    hdr.ts.tv_usec = ts % 1000000;
-    hdr.caplen = caplen;
-    hdr.len = size;
+    head = s->head;
+    tail = qatomic_load_acquire(&s->tail);
+    if (rec_len > DUMP_RING_SIZE - (head - tail)) {
+        stat64_add(&s->dropped, 1);
+        return size;
+    }
 
-    dumpiov[0].iov_base = &hdr;
-    dumpiov[0].iov_len = sizeof(hdr);
-    cnt = iov_copy(&dumpiov[1], cnt, iov, cnt, offset, caplen);
+    dump_ring_put_buf(s, head, &hdr, hdr_len);
+    dump_ring_put(s, head + hdr_len, iov, cnt, offset, caplen);
+    if (s->pcapng) {
+        uint32_t block_len = rec_len;
 
-    if (writev(s->fd, dumpiov, cnt + 1) != sizeof(hdr) + caplen) {
-        error_report("network dump write error - stopping dump");
-        close(s->fd);
-        s->fd = -1;
+        dump_ring_put_buf(s, head + hdr_len + caplen, zero,
+                          ROUND_UP(caplen, 4) - caplen);
+        dump_ring_put_buf(s, head + rec_len - sizeof(block_len),
+                          &block_len, sizeof(block_len));
     }
 
+    qatomic_store_release(&s->head, head + rec_len);
+    qemu_event_set(&s->event);
+
     return size;
 }
 
+static void *dump_writer_thread(void *opaque)
+{
+    DumpState *s = opaque;
+
+    for (;;) {
+        size_t tail = s->tail;
+        size_t head = qatomic_load_acquire(&s->head);
+        size_t idx, len;
+
+        if (head == tail) {
+            if (qatomic_read(&s->stop)) {
+                break;
+            }
+            qemu_event_reset(&s->event);
+            /* Check again so that a wakeup between the two is not lost */
+            if (qatomic_load_acquire(&s->head) == tail &&
+                !qatomic_read(&s->stop)) {
+                qemu_event_wait(&s->event);
+            }
+            continue;
+        }
+
+        idx = tail & (DUMP_RING_SIZE - 1);
+        len = MIN(head - tail, DUMP_RING_SIZE - idx);
+        if (!qatomic_read(&s->failed) &&
+            qemu_write_full(s->fd, s->ring + idx, len) != len) {
+            error_report("network dump write error - stopping dump");
+            qatomic_set(&s->failed, true);
+        }
+        qatomic_store_release(&s->tail, tail + len);
+    }
+
+    return NULL;
+}
+
 static void dump_cleanup(DumpState *s)
 {
+    if (s->ring) {
+        /* The writer drains the ring before it exits */
+        qatomic_set(&s->stop, true);
+        qemu_event_set(&s->event);
+        qemu_thread_join(&s->thread);
+        qemu_event_destroy(&s->event);
+        g_free(s->ring);
+        s->ring = NULL;
+    }
     close(s->fd);
     s->fd = -1;
 }
 
+static int dump_write_file_hdr(DumpState *s, int fd, int len)
+{
+    if (s->pcapng) {
+        struct pcapng_shb shb = {
+            .block_type = PCAPNG_BT_SHB,
+            .block_len = sizeof(shb),
+            .byte_order_magic = PCAPNG_BYTE_ORDER_MAGIC,
+            .version_major = 1,
+            .version_minor = 0,
+            .section_len = -1,
+            .block_len_trailer = sizeof(shb),
+        };
+        struct pcapng_idb idb = {
+            .block_type = PCAPNG_BT_IDB,
+            .block_len = sizeof(idb),
+            .linktype = 1,
+            .snaplen = len,
+            .tsresol_code = PCAPNG_OPT_IF_TSRESOL,
+            .tsresol_len = 1,
+            .tsresol = { 9 },
+            .block_len_trailer = sizeof(idb),
+        };
+
+        if (qemu_write_full(fd, &shb, sizeof(shb)) != sizeof(shb) ||
+            qemu_write_full(fd, &idb, sizeof(idb)) != sizeof(idb)) {
+            return -1;
+        }
+    } else {
+        struct pcap_file_hdr hdr;
+
+        hdr.magic = PCAP_MAGIC;
+        hdr.version_major = 2;
+        hdr.version_minor = 4;
+        hdr.thiszone = 0;
+        hdr.sigfigs = 0;
+        hdr.snaplen = len;
+        hdr.linktype = 1;
+
+        if (write(fd, &hdr, sizeof(hdr)) < sizeof(hdr)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
 static int net_dump_state_init(DumpState *s, const char *filename,
                                int len, Error **errp)
 {
-    struct pcap_file_hdr hdr;
     struct tm tm;
     int fd;
 
@@ -115,15 +322,7 @@ static int net_dump_state_init(DumpState *s, const char *filename,
         return -1;
     }
 
-    hdr.magic = PCAP_MAGIC;
-    hdr.version_major = 2;
-    hdr.version_minor = 4;
-    hdr.thiszone = 0;
-    hdr.sigfigs = 0;
-    hdr.snaplen = len;
-    hdr.linktype = 1;
-
-    if (write(fd, &hdr, sizeof(hdr)) < sizeof(hdr)) {
+    if (dump_write_file_hdr(s, fd, len) < 0) {
         error_setg_errno(errp, errno, "net dump write error");
         close(fd);
         return -1;
@@ -135,6 +334,13 @@ static int net_dump_state_init(DumpState *s, const char *filename,
     qemu_get_timedate(&tm, 0);
     s->start_ts = mktime(&tm);
 
+    s->ring = g_malloc(DUMP_RING_SIZE);
+    s->head = s->tail = 0;
+    s->stop = s->failed = false;
+    qemu_event_init(&s->event, false);
+    qemu_thread_create(&s->thread, "net-dump", dump_writer_thread, s,
+                       QEMU_THREAD_JOINABLE);
+
     return 0;
 }
 
@@ -178,6 +384,34 @@ static void filter_dump_setup(NetFilterState *nf, Error **errp)
     net_dump_state_init(&nfds->ds, nfds->filename, nfds->maxlen, errp);
 }
 
+static void filter_dump_get_dropped(Object *obj, Visitor *v, const char *name,
+                                    void *opaque, Error **errp)
+{
+    NetFilterDumpState *nfds = FILTER_DUMP(obj);
+    uint64_t value = stat64_get(&nfds->ds.dropped);
+
+    visit_type_uint64(v, name, &value, errp);
+}
+
+static bool filter_dump_get_pcapng(Object *obj, Error **errp)
+{
+    NetFilterDumpState *nfds = FILTER_DUMP(obj);
+
+    return nfds->ds.pcapng;
+}
+
+static void filter_dump_set_pcapng(Object *obj, bool value, Error **errp)
+{
+    NetFilterDumpState *nfds = FILTER_DUMP(obj);
+
+    if (nfds->ds.fd >= 0) {
+        error_setg(errp, "Property '%s.pcapng' can't be changed while "
+                   "dumping", object_get_typename(obj));
+        return;
+    }
+    nfds->ds.pcapng = value;
+}
+
 static void filter_dump_get_maxlen(Object *obj, Visitor *v, const char *name,
                                    void *opaque, Error **errp)
 {
@@ -224,6 +458,7 @@ static void filter_dump_instance_init(Object *obj)
     NetFilterDumpState *nfds = FILTER_DUMP(obj);
 
     nfds->maxlen = 65536;
+    nfds->ds.fd = -1;
 }
 
 static void filter_dump_instance_finalize(Object *obj)
@@ -241,6 +476,10 @@ static void filter_dump_class_init(ObjectClass *oc, void *data)
                               filter_dump_set_maxlen, NULL, NULL);
     object_class_property_add_str(oc, "file", file_dump_get_filename,
                                   file_dump_set_filename);
+    object_class_property_add_bool(oc, "pcapng", filter_dump_get_pcapng,
+                                   filter_dump_set_pcapng);
+    object_class_property_add(oc, "dropped", "uint64",
+                              filter_dump_get_dropped, NULL, NULL, NULL);
 
     nfc->setup = filter_dump_setup;
     nfc->cleanup = filter_dump_cleanup;
@@ -245,6 +245,11 @@ static void netfilter_complete(UserCreatable *uc, Error **errp)
         return;
     }
 
+    if (ncs[0]->aio_context) {
+        error_setg(errp, "Netdevs running in an IOThread are not supported");
+        return;
+    }
+
     if (strcmp(nf->position, "head") && strcmp(nf->position, "tail")) {
         Object *container;
         Object *obj;
@@ -27,6 +27,7 @@
 #include <linux/ip.h>
 #include <netdb.h>
 #include "net/net.h"
+#include "net/offload.h"
 #include "clients.h"
 #include "qapi/error.h"
 #include "qemu/error-report.h"
@@ -130,6 +131,11 @@ typedef struct NetL2TPV3State {
     bool cookie;
     bool cookie_is_64;
 
+    /* Software checksum, GRO and GSO, see net/offload.h */
+
+    bool offload_enabled;
+    NetOffload offload;
+
 } NetL2TPV3State;
 
 static void net_l2tpv3_send(void *opaque);
@@ -213,12 +219,10 @@ static void l2tpv3_form_header(NetL2TPV3State *s)
     }
 }
 
-static ssize_t net_l2tpv3_receive_dgram_iov(NetClientState *nc,
+static ssize_t net_l2tpv3_xmit(NetL2TPV3State *s,
                     const struct iovec *iov,
                     int iovcnt)
 {
-    NetL2TPV3State *s = DO_UPCAST(NetL2TPV3State, nc, nc);
-
     struct msghdr message;
     int ret;
 
@@ -259,6 +263,30 @@ static ssize_t net_l2tpv3_receive_dgram_iov(NetClientState *nc,
     return ret;
 }
 
+static bool net_l2tpv3_gso_output(void *opaque, const uint8_t *buf,
+                                  size_t size)
+{
+    struct iovec iov = {
+        .iov_base = (void *)buf,
+        .iov_len = size,
+    };
+
+    return net_l2tpv3_xmit(opaque, &iov, 1) != 0;
+}
+
+static ssize_t net_l2tpv3_receive_dgram_iov(NetClientState *nc,
+                    const struct iovec *iov,
+                    int iovcnt)
+{
+    NetL2TPV3State *s = DO_UPCAST(NetL2TPV3State, nc, nc);
+
+    if (s->offload_enabled) {
+        return net_gso_send(&s->offload, iov, iovcnt,
+                            net_l2tpv3_gso_output, s);
+    }
+    return net_l2tpv3_xmit(s, iov, iovcnt);
+}
+
 static ssize_t net_l2tpv3_receive_dgram(NetClientState *nc,
                     const uint8_t *buf,
                     size_t size)
@@ -362,12 +390,17 @@ static void net_l2tpv3_process_queue(NetL2TPV3State *s)
                      * switch to using our own ring as a queueing mechanism
                      * at a later date
                      */
-                    size = qemu_send_packet_async(
-                            &s->nc,
-                            vec->iov_base,
-                            data_size,
-                            l2tpv3_send_completed
-                        );
+                    if (s->offload_enabled) {
+                        size = net_gro_receive(&s->offload, vec->iov_base,
+                                               data_size);
+                    } else {
+                        size = qemu_send_packet_async(
+                                &s->nc,
+                                vec->iov_base,
+                                data_size,
+                                l2tpv3_send_completed
+                            );
+                    }
                     if (size == 0) {
                         l2tpv3_read_poll(s, false);
                     }
@@ -443,6 +476,11 @@ static void net_l2tpv3_send(void *opaque)
         s->queue_depth += count;
     }
     net_l2tpv3_process_queue(s);
+
+    /* The last merged packet of the batch is still pending */
+    if (s->offload_enabled && net_gro_flush(&s->offload) == 0) {
+        l2tpv3_read_poll(s, false);
+    }
 }
 
 static void destroy_vector(struct mmsghdr *msgvec, int count, int iovcount)
@@ -506,6 +544,42 @@ static void net_l2tpv3_cleanup(NetClientState *nc)
     g_free(s->vec);
     g_free(s->header_buf);
     g_free(s->dgram_dst);
+    if (s->offload_enabled) {
+        net_offload_cleanup(&s->offload);
+    }
+}
+
+static bool l2tpv3_has_vnet_hdr(NetClientState *nc)
+{
+    NetL2TPV3State *s = DO_UPCAST(NetL2TPV3State, nc, nc);
+
+    return s->offload_enabled;
+}
+
+static bool l2tpv3_has_vnet_hdr_len(NetClientState *nc, int len)
+{
+    NetL2TPV3State *s = DO_UPCAST(NetL2TPV3State, nc, nc);
+
+    return s->offload_enabled &&
+           net_offload_has_vnet_hdr_len(&s->offload, len);
+}
+
+static void l2tpv3_set_vnet_hdr_len(NetClientState *nc, int len)
+{
+    NetL2TPV3State *s = DO_UPCAST(NetL2TPV3State, nc, nc);
+
+    assert(s->offload_enabled);
+    net_offload_set_vnet_hdr_len(&s->offload, len);
+}
+
+static void l2tpv3_set_offload(NetClientState *nc, int csum, int tso4,
+                               int tso6, int ecn, int ufo, int uso4, int uso6)
+{
+    NetL2TPV3State *s = DO_UPCAST(NetL2TPV3State, nc, nc);
+
+    if (s->offload_enabled) {
+        net_offload_set_offload(&s->offload, csum, tso4, tso6);
+    }
 }
 
 static NetClientInfo net_l2tpv3_info = {
@@ -515,6 +589,10 @@ static NetClientInfo net_l2tpv3_info = {
     .receive_iov = net_l2tpv3_receive_dgram_iov,
     .poll = l2tpv3_poll,
     .cleanup = net_l2tpv3_cleanup,
+    .has_vnet_hdr = l2tpv3_has_vnet_hdr,
+    .has_vnet_hdr_len = l2tpv3_has_vnet_hdr_len,
+    .set_vnet_hdr_len = l2tpv3_set_vnet_hdr_len,
+    .set_offload = l2tpv3_set_offload,
 };
 
 int net_init_l2tpv3(const Netdev *netdev,
@@ -709,6 +787,11 @@ int net_init_l2tpv3(const Netdev *netdev,
     s->vec = g_new(struct iovec, MAX_L2TPV3_IOVCNT);
     s->header_buf = g_malloc(s->header_size);
 
+    if (l2tpv3->has_offload && l2tpv3->offload) {
+        s->offload_enabled = true;
+        net_offload_init(&s->offload, nc, l2tpv3_send_completed);
+    }
+
     qemu_socket_set_nonblock(fd);
 
     s->fd = fd;
@@ -589,6 +589,48 @@ int qemu_set_vnet_be(NetClientState *nc, bool is_be)
 #endif
 }
 
+bool qemu_can_set_net_aio_context(NetClientState *nc)
+{
+    return nc && nc->info->set_aio_context;
+}
+
+/*
+ * Move the event handlers of @nc to @ctx, or back to the main loop if @ctx
+ * is NULL.  Must be called from the AioContext that @nc currently runs in,
+ * so that none of its handlers can be running at the same time.  Packets
+ * that @nc sends are then delivered to its peer in @ctx as well.
+ */
+void qemu_set_net_aio_context(NetClientState *nc, AioContext *ctx)
+{
+    assert(qemu_can_set_net_aio_context(nc));
+
+    nc->info->set_aio_context(nc, ctx);
+    nc->aio_context = ctx;
+}
+
+/*
+ * Tell the peer of @nc that a burst of packets follows, so that it can defer
+ * per-packet work such as notifications or system calls until
+ * qemu_net_end_batch().  Calls nest and must be balanced.
+ */
+void qemu_net_begin_batch(NetClientState *nc)
+{
+    NetClientState *peer = nc->peer;
+
+    if (peer && peer->info->begin_batch) {
+        peer->info->begin_batch(peer);
+    }
+}
+
+void qemu_net_end_batch(NetClientState *nc)
+{
+    NetClientState *peer = nc->peer;
+
+    if (peer && peer->info->end_batch) {
+        peer->info->end_batch(peer);
+    }
+}
+
 int qemu_can_receive_packet(NetClientState *nc)
 {
     if (nc->receive_disabled) {
@@ -754,8 +796,42 @@ ssize_t qemu_receive_packet(NetClientState *nc, const uint8_t *buf, int size)
     return qemu_net_queue_receive(nc->incoming_queue, buf, size);
 }
 
+typedef struct NetRawPacket {
+    NetClientState *nc;
+    int size;
+    uint8_t buf[];
+} NetRawPacket;
+
+static void qemu_send_packet_raw_bh(void *opaque)
+{
+    NetRawPacket *pkt = opaque;
+
+    qemu_send_packet_async_with_flags(pkt->nc, QEMU_NET_PACKET_FLAG_RAW,
+                                      pkt->buf, pkt->size, NULL);
+    g_free(pkt);
+}
+
 ssize_t qemu_send_packet_raw(NetClientState *nc, const uint8_t *buf, int size)
 {
+    AioContext *ctx = nc->peer ? nc->peer->aio_context : NULL;
+
+    /*
+     * The peer's queue is only touched from the AioContext it runs in.  Raw
+     * packets such as self-announcements come from the main loop, so hand
+     * them over to the peer's IOThread.  Moving the peer back to the main
+     * loop is done with a bottom half in the same AioContext, which only
+     * runs after this one.
+     */
+    if (ctx && ctx != qemu_get_current_aio_context()) {
+        NetRawPacket *pkt = g_malloc(sizeof(*pkt) + size);
+
+        pkt->nc = nc;
+        pkt->size = size;
+        memcpy(pkt->buf, buf, size);
+        aio_bh_schedule_oneshot(ctx, qemu_send_packet_raw_bh, pkt);
+        return size;
+    }
+
     return qemu_send_packet_async_with_flags(nc, QEMU_NET_PACKET_FLAG_RAW,
                                              buf, size, NULL);
 }
@@ -1519,6 +1595,16 @@ void print_net_client(Monitor *mon, NetClientState *nc)
                        object_get_typename(OBJECT(nf)));
         netfilter_print_info(mon, nf);
     }
+    if (nc->incoming_queue) {
+        NetQueueStats stats;
+
+        qemu_net_queue_get_stats(nc->incoming_queue, &stats);
+        if (stats.queued || stats.dropped) {
+            monitor_printf(mon, "queue: queued=%" PRIu64 ",dropped=%" PRIu64
+                           ",pool-exhausted=%" PRIu64 "\n", stats.queued,
+                           stats.dropped, stats.pool_exhausted);
+        }
+    }
 }
 
 RxFilterInfoList *qmp_query_rx_filter(const char *name, Error **errp)
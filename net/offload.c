@@ -0,0 +1,449 @@
+/*
+ * Software GRO/GSO for net backends without host offloads
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/bswap.h"
+#include "qemu/iov.h"
+#include "net/checksum.h"
+#include "net/eth.h"
+#include "net/offload.h"
+#include "standard-headers/linux/virtio_net.h"
+
+#define NET_GRO_MAX_IP_LEN 0xffff
+
+/* Offsets into the IPv4, IPv6 and TCP headers */
+#define IP4_TOT_LEN     2
+#define IP4_ID          4
+#define IP4_FRAG        6
+#define IP4_PROTO       9
+#define IP4_CSUM        10
+#define IP4_ADDRS       12
+#define IP6_PLEN        4
+#define IP6_NXT         6
+#define IP6_ADDRS       8
+#define TCP_SEQ         4
+#define TCP_ACK         8
+#define TCP_DOFF        12
+#define TCP_FLAGS       13
+#define TCP_WIN         14
+#define TCP_CSUM        16
+
+typedef struct NetTcpSeg {
+    bool ipv6;
+    size_t l3_off;
+    size_t l4_off;
+    size_t hdr_len;
+    size_t end;             /* end of the IP packet, without padding */
+    uint32_t seq;
+    uint8_t flags;
+} NetTcpSeg;
+
+void net_offload_init(NetOffload *o, NetClientState *nc,
+                      NetPacketSent *sent_cb)
+{
+    memset(o, 0, sizeof(*o));
+    o->nc = nc;
+    o->sent_cb = sent_cb;
+    o->vnet_hdr_len = sizeof(struct virtio_net_hdr);
+    o->gro_buf = g_malloc(NET_BUFSIZE);
+    o->gso_in = g_malloc(NET_BUFSIZE);
+    o->gso_out = g_malloc(NET_BUFSIZE);
+}
+
+void net_offload_cleanup(NetOffload *o)
+{
+    g_free(o->gro_buf);
+    g_free(o->gso_in);
+    g_free(o->gso_out);
+    o->gro_buf = o->gso_in = o->gso_out = NULL;
+}
+
+bool net_offload_has_vnet_hdr_len(NetOffload *o, int len)
+{
+    return len == sizeof(struct virtio_net_hdr) ||
+           len == sizeof(struct virtio_net_hdr_mrg_rxbuf);
+}
+
+void net_offload_set_vnet_hdr_len(NetOffload *o, int len)
+{
+    assert(net_offload_has_vnet_hdr_len(o, len));
+
+    o->vnet_hdr_len = len;
+    o->using_vnet_hdr = true;
+}
+
+void net_offload_set_offload(NetOffload *o, int csum, int tso4, int tso6)
+{
+    o->csum = csum;
+    o->tso4 = tso4;
+    o->tso6 = tso6;
+}
+
+/* Sum of the TCP pseudo header of the IP packet at @ip */
+static uint32_t net_offload_pseudo_sum(uint8_t *ip, bool ipv6, size_t l4_len)
+{
+    uint32_t sum;
+
+    if (ipv6) {
+        sum = net_checksum_add(32, ip + IP6_ADDRS);
+    } else {
+        sum = net_checksum_add(8, ip + IP4_ADDRS);
+    }
+    return sum + IP_PROTO_TCP + l4_len;
+}
+
+/*
+ * Parse a TCP segment that is a candidate for merging: untagged, IPv4
+ * without options and not fragmented or IPv6 without extension headers.
+ */
+static bool net_gro_parse(const uint8_t *buf, size_t size, NetTcpSeg *seg)
+{
+    const uint8_t *ip = buf + ETH_HLEN;
+    size_t thlen;
+
+    if (size < ETH_HLEN) {
+        return false;
+    }
+
+    switch (lduw_be_p(buf + 12)) {
+    case ETH_P_IP:
+        if (size < ETH_HLEN + sizeof(struct ip_header) ||
+            ip[0] != 0x45 || ip[IP4_PROTO] != IP_PROTO_TCP ||
+            (lduw_be_p(ip + IP4_FRAG) & (IP_MF | IP_OFFMASK))) {
+            return false;
+        }
+        seg->ipv6 = false;
+        seg->l4_off = ETH_HLEN + sizeof(struct ip_header);
+        seg->end = ETH_HLEN + lduw_be_p(ip + IP4_TOT_LEN);
+        break;
+    case ETH_P_IPV6:
+        if (size < ETH_HLEN + sizeof(struct ip6_header) ||
+            (ip[0] >> 4) != 6 || ip[IP6_NXT] != IP_PROTO_TCP) {
+            return false;
+        }
+        seg->ipv6 = true;
+        seg->l4_off = ETH_HLEN + sizeof(struct ip6_header);
+        seg->end = seg->l4_off + lduw_be_p(ip + IP6_PLEN);
+        break;
+    default:
+        return false;
+    }
+
+    if (seg->end > size || seg->end < seg->l4_off + sizeof(struct tcp_header)) {
+        return false;
+    }
+    thlen = (buf[seg->l4_off + TCP_DOFF] >> 4) << 2;
+    if (thlen < sizeof(struct tcp_header) || seg->l4_off + thlen > seg->end) {
+        return false;
+    }
+
+    seg->l3_off = ETH_HLEN;
+    seg->hdr_len = seg->l4_off + thlen;
+    seg->seq = ldl_be_p(buf + seg->l4_off + TCP_SEQ);
+    seg->flags = buf[seg->l4_off + TCP_FLAGS];
+    return true;
+}
+
+static bool net_gro_csum_ok(const uint8_t *buf, const NetTcpSeg *seg)
+{
+    size_t l4_len = seg->end - seg->l4_off;
+    uint32_t sum;
+
+    sum = net_offload_pseudo_sum((uint8_t *)buf + seg->l3_off, seg->ipv6,
+                                 l4_len);
+    sum += net_checksum_add(l4_len, (uint8_t *)buf + seg->l4_off);
+    return net_checksum_finish(sum) == 0;
+}
+
+/* Can @seg be appended to the pending super-packet? */
+static bool net_gro_match(NetOffload *o, const uint8_t *buf,
+                          const NetTcpSeg *seg)
+{
+    const uint8_t *ip = buf + seg->l3_off, *gro_ip = o->gro_buf + seg->l3_off;
+    const uint8_t *tcp = buf + seg->l4_off;
+    const uint8_t *gro_tcp = o->gro_buf + seg->l4_off;
+    size_t payload = seg->end - seg->hdr_len;
+
+    if (seg->ipv6 != o->gro_ipv6 || seg->hdr_len != o->gro_hdr_len ||
+        seg->seq != o->gro_next_seq || payload > o->gro_mss ||
+        o->gro_len - o->gro_l3_off + payload > NET_GRO_MAX_IP_LEN) {
+        return false;
+    }
+
+    /* Same MAC addresses */
+    if (memcmp(buf, o->gro_buf, ETH_HLEN)) {
+        return false;
+    }
+
+    /* Same IP header apart from the fields that change per packet */
+    if (seg->ipv6) {
+        if (memcmp(ip, gro_ip, IP6_PLEN) ||
+            memcmp(ip + IP6_NXT, gro_ip + IP6_NXT,
+                   sizeof(struct ip6_header) - IP6_NXT)) {
+            return false;
+        }
+    } else {
+        if (memcmp(ip, gro_ip, IP4_TOT_LEN) ||
+            memcmp(ip + IP4_FRAG, gro_ip + IP4_FRAG, IP4_CSUM - IP4_FRAG) ||
+            memcmp(ip + IP4_ADDRS, gro_ip + IP4_ADDRS,
+                   sizeof(struct ip_header) - IP4_ADDRS)) {
+            return false;
+        }
+    }
+
+    /* Same ports, ack, header length and options */
+    return !memcmp(tcp, gro_tcp, TCP_SEQ) &&
+           !memcmp(tcp + TCP_ACK, gro_tcp + TCP_ACK, TCP_FLAGS - TCP_ACK) &&
+           !memcmp(tcp + sizeof(struct tcp_header),
+                   gro_tcp + sizeof(struct tcp_header),
+                   seg->hdr_len - seg->l4_off - sizeof(struct tcp_header));
+}
+
+static ssize_t net_offload_deliver(NetOffload *o, struct virtio_net_hdr *hdr,
+                                   const uint8_t *buf, size_t size)
+{
+    struct virtio_net_hdr_mrg_rxbuf vhdr = { .hdr = *hdr };
+    struct iovec iov[2] = {
+        { .iov_base = &vhdr, .iov_len = o->vnet_hdr_len },
+        { .iov_base = (void *)buf, .iov_len = size },
+    };
+
+    return qemu_sendv_packet_async(o->nc, iov, 2, o->sent_cb);
+}
+
+ssize_t net_gro_flush(NetOffload *o)
+{
+    struct virtio_net_hdr hdr = { 0 };
+    uint8_t *ip = o->gro_buf + o->gro_l3_off;
+    uint8_t *tcp = o->gro_buf + o->gro_l4_off;
+    size_t l4_len = o->gro_len - o->gro_l4_off;
+    uint16_t csum;
+
+    if (!o->gro_segs) {
+        return 1;
+    }
+
+    if (o->gro_segs == 1) {
+        /* Nothing was merged, the checksum was verified on arrival */
+        hdr.flags = o->csum ? VIRTIO_NET_HDR_F_DATA_VALID : 0;
+    } else {
+        if (o->gro_ipv6) {
+            stw_be_p(ip + IP6_PLEN, o->gro_len - o->gro_l4_off);
+        } else {
+            stw_be_p(ip + IP4_TOT_LEN, o->gro_len - o->gro_l3_off);
+            stw_be_p(ip + IP4_CSUM, 0);
+            csum = net_raw_checksum(ip, sizeof(struct ip_header));
+            stw_be_p(ip + IP4_CSUM, csum);
+        }
+
+        /* Leave the pseudo header sum for the receiver to complete */
+        csum = ~net_checksum_finish(net_offload_pseudo_sum(ip, o->gro_ipv6,
+                                                           l4_len));
+        stw_be_p(tcp + TCP_CSUM, csum);
+
+        hdr.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        hdr.gso_type = o->gro_ipv6 ? VIRTIO_NET_HDR_GSO_TCPV6
+                                   : VIRTIO_NET_HDR_GSO_TCPV4;
+        hdr.hdr_len = o->gro_hdr_len;
+        hdr.gso_size = o->gro_mss;
+        hdr.csum_start = o->gro_l4_off;
+        hdr.csum_offset = TCP_CSUM;
+    }
+
+    o->gro_segs = 0;
+    return net_offload_deliver(o, &hdr, o->gro_buf, o->gro_len);
+}
+
+/* Start a new super-packet with @seg */
+static void net_gro_start(NetOffload *o, const uint8_t *buf,
+                          const NetTcpSeg *seg)
+{
+    size_t payload = seg->end - seg->hdr_len;
+
+    memcpy(o->gro_buf, buf, seg->end);
+    o->gro_len = seg->end;
+    o->gro_l3_off = seg->l3_off;
+    o->gro_l4_off = seg->l4_off;
+    o->gro_hdr_len = seg->hdr_len;
+    o->gro_ipv6 = seg->ipv6;
+    o->gro_next_seq = seg->seq + payload;
+    o->gro_mss = payload;
+    o->gro_segs = 1;
+}
+
+static void net_gro_append(NetOffload *o, const uint8_t *buf,
+                           const NetTcpSeg *seg)
+{
+    size_t payload = seg->end - seg->hdr_len;
+    uint8_t *tcp = o->gro_buf + o->gro_l4_off;
+
+    memcpy(o->gro_buf + o->gro_len, buf + seg->hdr_len, payload);
+    o->gro_len += payload;
+    o->gro_next_seq += payload;
+    o->gro_segs++;
+
+    tcp[TCP_FLAGS] |= seg->flags & TH_PUSH;
+    memcpy(tcp + TCP_WIN, buf + seg->l4_off + TCP_WIN, 2);
+}
+
+ssize_t net_gro_receive(NetOffload *o, const uint8_t *buf, size_t size)
+{
+    struct virtio_net_hdr hdr = { 0 };
+    NetTcpSeg seg;
+    size_t payload;
+    ssize_t ret;
+
+    if (!o->using_vnet_hdr) {
+        return qemu_send_packet_async(o->nc, buf, size, o->sent_cb);
+    }
+
+    if (!o->csum || !net_gro_parse(buf, size, &seg) ||
+        !(seg.ipv6 ? o->tso6 : o->tso4) ||
+        (seg.flags & ~TH_PUSH) != TH_ACK ||
+        seg.end == seg.hdr_len || !net_gro_csum_ok(buf, &seg)) {
+        net_gro_flush(o);
+        return net_offload_deliver(o, &hdr, buf, size);
+    }
+
+    payload = seg.end - seg.hdr_len;
+    if (o->gro_segs && net_gro_match(o, buf, &seg)) {
+        net_gro_append(o, buf, &seg);
+        ret = size;
+    } else {
+        ret = net_gro_flush(o);
+        net_gro_start(o, buf, &seg);
+    }
+
+    /* A short or pushed segment ends the burst of the sender */
+    if ((seg.flags & TH_PUSH) || payload < o->gro_mss) {
+        if (net_gro_flush(o) == 0) {
+            ret = 0;
+        }
+    }
+    return ret == 0 ? 0 : size;
+}
+
+/* Complete the checksum at @start + @offset over the rest of the frame */
+static void net_gso_csum(uint8_t *buf, size_t size, size_t start,
+                         size_t offset)
+{
+    uint32_t sum;
+
+    if (start + offset + 2 > size) {
+        return;
+    }
+    sum = net_checksum_add(size - start, buf + start);
+    stw_be_p(buf + start + offset, net_checksum_finish_nozero(sum));
+}
+
+ssize_t net_gso_send(NetOffload *o, const struct iovec *iov, int iovcnt,
+                     NetGsoOutput *output, void *opaque)
+{
+    size_t total = iov_size(iov, iovcnt);
+    struct virtio_net_hdr hdr;
+    size_t len, l3_off, l4_off, hdr_len, off, chunk;
+    uint8_t *ip, *tcp;
+    uint32_t seq, sum;
+    uint16_t ip_id;
+    uint8_t flags;
+    bool ipv6;
+    unsigned i;
+
+    if (!o->using_vnet_hdr) {
+        if (total > NET_BUFSIZE) {
+            return total;
+        }
+        iov_to_buf(iov, iovcnt, 0, o->gso_in, total);
+        return output(opaque, o->gso_in, total) ? total : 0;
+    }
+
+    if (total < o->vnet_hdr_len || total - o->vnet_hdr_len > NET_BUFSIZE) {
+        return total;
+    }
+    iov_to_buf(iov, iovcnt, 0, &hdr, sizeof(hdr));
+    len = total - o->vnet_hdr_len;
+    iov_to_buf(iov, iovcnt, o->vnet_hdr_len, o->gso_in, len);
+
+    switch (hdr.gso_type & ~VIRTIO_NET_HDR_GSO_ECN) {
+    case VIRTIO_NET_HDR_GSO_NONE:
+        if (hdr.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
+            net_gso_csum(o->gso_in, len, hdr.csum_start, hdr.csum_offset);
+        }
+        return output(opaque, o->gso_in, len) ? total : 0;
+    case VIRTIO_NET_HDR_GSO_TCPV4:
+        ipv6 = false;
+        break;
+    case VIRTIO_NET_HDR_GSO_TCPV6:
+        ipv6 = true;
+        break;
+    default:
+        /* UDP fragmentation offload is not negotiated with the peer */
+        return total;
+    }
+
+    if (len < ETH_HLEN || !hdr.gso_size) {
+        return total;
+    }
+    l3_off = eth_get_l2_hdr_length(o->gso_in);
+    l4_off = hdr.csum_start;
+    if (l4_off < l3_off + (ipv6 ? sizeof(struct ip6_header)
+                                 : sizeof(struct ip_header)) ||
+        l4_off + sizeof(struct tcp_header) > len) {
+        return total;
+    }
+    hdr_len = l4_off + ((o->gso_in[l4_off + TCP_DOFF] >> 4) << 2);
+    if (hdr_len > len) {
+        return total;
+    }
+
+    ip = o->gso_out + l3_off;
+    tcp = o->gso_out + l4_off;
+    seq = ldl_be_p(o->gso_in + l4_off + TCP_SEQ);
+    ip_id = lduw_be_p(o->gso_in + l3_off + IP4_ID);
+    flags = o->gso_in[l4_off + TCP_FLAGS];
+
+    for (off = hdr_len, i = 0; off < len; off += chunk, i++) {
+        chunk = MIN(hdr.gso_size, len - off);
+        memcpy(o->gso_out, o->gso_in, hdr_len);
+        memcpy(o->gso_out + hdr_len, o->gso_in + off, chunk);
+
+        if (ipv6) {
+            stw_be_p(ip + IP6_PLEN,
+                     hdr_len + chunk - l3_off - sizeof(struct ip6_header));
+        } else {
+            stw_be_p(ip + IP4_TOT_LEN, hdr_len + chunk - l3_off);
+            stw_be_p(ip + IP4_ID, ip_id + i);
+            stw_be_p(ip + IP4_CSUM, 0);
+            stw_be_p(ip + IP4_CSUM, net_raw_checksum(ip, l4_off - l3_off));
+        }
+
+        stl_be_p(tcp + TCP_SEQ, seq + (off - hdr_len));
+        tcp[TCP_FLAGS] = flags;
+        if (off + chunk < len) {
+            tcp[TCP_FLAGS] &= ~(TH_FIN | TH_PUSH);
+        }
+        if (i) {
+            tcp[TCP_FLAGS] &= ~TH_CWR;
+        }
+
+        stw_be_p(tcp + TCP_CSUM, 0);
+        sum = net_offload_pseudo_sum(ip, ipv6, hdr_len + chunk - l4_off);
+        sum += net_checksum_add(hdr_len + chunk - l4_off, tcp);
+        stw_be_p(tcp + TCP_CSUM, net_checksum_finish(sum));
+
+        if (!output(opaque, o->gso_out, hdr_len + chunk)) {
+            if (i == 0) {
+                return 0;
+            }
+            /* The wire drops what does not fit */
+            break;
+        }
+    }
+
+    return total;
+}
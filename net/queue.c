@@ -40,15 +40,28 @@
  * unbounded queueing.
  */
 
+/*
+ * Packets up to NET_QUEUE_POOL_BUFSIZE bytes, which covers an Ethernet
+ * frame with a vnet header, are copied into one of NET_QUEUE_POOL_SIZE
+ * preallocated buffers instead of a fresh allocation.  The pool is only
+ * created once the queue first has to hold a packet.
+ */
+#define NET_QUEUE_POOL_SIZE     256
+#define NET_QUEUE_POOL_BUFSIZE  2048
+
 struct NetPacket {
     QTAILQ_ENTRY(NetPacket) entry;
     NetClientState *sender;
     unsigned flags;
     int size;
     NetPacketSent *sent_cb;
+    bool pooled;
     uint8_t data[];
 };
 
+#define NET_QUEUE_POOL_STRIDE \
+    QEMU_ALIGN_UP(sizeof(NetPacket) + NET_QUEUE_POOL_BUFSIZE, 64)
+
 struct NetQueue {
     void *opaque;
     uint32_t nq_maxlen;
@@ -57,6 +70,10 @@ struct NetQueue {
 
     QTAILQ_HEAD(, NetPacket) packets;
 
+    uint8_t *pool;
+    QTAILQ_HEAD(, NetPacket) free_packets;
+    NetQueueStats stats;
+
     unsigned delivering : 1;
 };
 
@@ -72,24 +89,73 @@ NetQueue *qemu_new_net_queue(NetQueueDeliverFunc *deliver, void *opaque)
     queue->deliver = deliver;
 
     QTAILQ_INIT(&queue->packets);
+    QTAILQ_INIT(&queue->free_packets);
 
     queue->delivering = 0;
 
     return queue;
 }
 
+static NetPacket *qemu_net_queue_alloc_packet(NetQueue *queue, size_t size)
+{
+    NetPacket *packet;
+    int i;
+
+    if (size > NET_QUEUE_POOL_BUFSIZE) {
+        packet = g_malloc(sizeof(NetPacket) + size);
+        packet->pooled = false;
+        return packet;
+    }
+
+    if (!queue->pool) {
+        queue->pool = g_malloc(NET_QUEUE_POOL_SIZE * NET_QUEUE_POOL_STRIDE);
+        for (i = 0; i < NET_QUEUE_POOL_SIZE; i++) {
+            packet = (NetPacket *)(queue->pool + i * NET_QUEUE_POOL_STRIDE);
+            packet->pooled = true;
+            QTAILQ_INSERT_TAIL(&queue->free_packets, packet, entry);
+        }
+    }
+
+    packet = QTAILQ_FIRST(&queue->free_packets);
+    if (packet) {
+        QTAILQ_REMOVE(&queue->free_packets, packet, entry);
+        return packet;
+    }
+
+    queue->stats.pool_exhausted++;
+    packet = g_malloc(sizeof(NetPacket) + NET_QUEUE_POOL_BUFSIZE);
+    packet->pooled = false;
+    return packet;
+}
+
+static void qemu_net_queue_free_packet(NetQueue *queue, NetPacket *packet)
+{
+    if (packet->pooled) {
+        /* LIFO, so that the next packet reuses a cache-hot buffer */
+        QTAILQ_INSERT_HEAD(&queue->free_packets, packet, entry);
+    } else {
+        g_free(packet);
+    }
+}
+
 void qemu_del_net_queue(NetQueue *queue)
 {
     NetPacket *packet, *next;
 
     QTAILQ_FOREACH_SAFE(packet, &queue->packets, entry, next) {
         QTAILQ_REMOVE(&queue->packets, packet, entry);
-        g_free(packet);
+        qemu_net_queue_free_packet(queue, packet);
     }
 
+    g_free(queue->pool);
     g_free(queue);
 }
 
+void qemu_net_queue_get_stats(NetQueue *queue, NetQueueStats *stats)
+{
+    *stats = queue->stats;
+}
+
 static void qemu_net_queue_append(NetQueue *queue,
                                   NetClientState *sender,
                                   unsigned flags,
@@ -100,15 +166,17 @@ static void qemu_net_queue_append(NetQueue *queue,
     NetPacket *packet;
 
     if (queue->nq_count >= queue->nq_maxlen && !sent_cb) {
+        queue->stats.dropped++;
         return; /* drop if queue full and no callback */
     }
-    packet = g_malloc(sizeof(NetPacket) + size);
+    packet = qemu_net_queue_alloc_packet(queue, size);
     packet->sender = sender;
     packet->flags = flags;
     packet->size = size;
     packet->sent_cb = sent_cb;
     memcpy(packet->data, buf, size);
 
+    queue->stats.queued++;
     queue->nq_count++;
     QTAILQ_INSERT_TAIL(&queue->packets, packet, entry);
 }
@@ -125,13 +193,14 @@ void qemu_net_queue_append_iov(NetQueue *queue,
     int i;
 
     if (queue->nq_count >= queue->nq_maxlen && !sent_cb) {
+        queue->stats.dropped++;
         return; /* drop if queue full and no callback */
     }
     for (i = 0; i < iovcnt; i++) {
         max_len += iov[i].iov_len;
     }
 
-    packet = g_malloc(sizeof(NetPacket) + max_len);
+    packet = qemu_net_queue_alloc_packet(queue, max_len);
     packet->sender = sender;
     packet->sent_cb = sent_cb;
     packet->flags = flags;
@@ -144,6 +213,7 @@ void qemu_net_queue_append_iov(NetQueue *queue,
         packet->size += len;
     }
 
+    queue->stats.queued++;
     queue->nq_count++;
     QTAILQ_INSERT_TAIL(&queue->packets, packet, entry);
 }
@@ -254,7 +324,7 @@ void qemu_net_queue_purge(NetQueue *queue, NetClientState *from)
             if (packet->sent_cb) {
                 packet->sent_cb(packet->sender, 0);
             }
-            g_free(packet);
+            qemu_net_queue_free_packet(queue, packet);
         }
     }
 }
@@ -287,7 +357,7 @@ bool qemu_net_queue_flush(NetQueue *queue)
             packet->sent_cb(packet->sender, ret);
         }
 
-        g_free(packet);
+        qemu_net_queue_free_packet(queue, packet);
     }
     return true;
 }
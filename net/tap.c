@@ -42,11 +42,46 @@
 #include "qemu/error-report.h"
 #include "qemu/main-loop.h"
 #include "qemu/sockets.h"
+#include "qemu/iov.h"
 
 #include "net/tap.h"
 
 #include "net/vhost_net.h"
 
+#ifdef CONFIG_LINUX_IO_URING
+#include <liburing.h>
+
+#define TAP_BATCH_MAX 256
+
+/*
+ * Batched I/O through io_uring: up to @size reads are kept posted on the tap
+ * fd, each into its own buffer, and writes issued inside a peer's batch are
+ * copied into slots and submitted together when the batch ends.
+ *
+ * Write slots are used as a ring starting at @tx_head.  The first
+ * @tx_inflight of the @tx_count occupied slots have been submitted as one
+ * linked chain; a slot is only released once its packet has been written.
+ */
+typedef struct TapUring {
+    unsigned size;
+    struct io_uring rx_ring;
+    uint8_t *rx_bufs;
+    unsigned *rx_idle;
+    unsigned rx_nidle;
+    struct io_uring tx_ring;
+    uint8_t *tx_bufs;
+    unsigned *tx_len;
+    int *tx_res;
+    unsigned tx_head;
+    unsigned tx_count;
+    unsigned tx_inflight;
+    unsigned tx_done;
+    unsigned tx_batch;
+    bool tx_stalled;    /* waiting for the tap fd to become writable */
+    bool tx_blocked;    /* a packet was refused and is queued in the peer */
+} TapUring;
+#endif
+
 typedef struct TAPState {
     NetClientState nc;
     int fd;
@@ -62,6 +97,9 @@ typedef struct TAPState {
     VHostNetState *vhost_net;
     unsigned host_vnet_hdr_len;
     Notifier exit;
+#ifdef CONFIG_LINUX_IO_URING
+    TapUring *uring;
+#endif
 } TAPState;
 
 static void launch_script(const char *setup_script, const char *ifname,
@@ -69,13 +107,46 @@ static void launch_script(const char *setup_script, const char *ifname,
 
 static void tap_send(void *opaque);
 static void tap_writable(void *opaque);
+#ifdef CONFIG_LINUX_IO_URING
+static void tap_uring_fd_read(void *opaque);
+static void tap_uring_cq_read(void *opaque);
+static void tap_uring_tx_cq_read(void *opaque);
+static void tap_uring_submit_tx(TAPState *s);
+#endif
+
+static void tap_set_handler(AioContext *ctx, int fd, IOHandler *fd_read,
+                            IOHandler *fd_write, void *opaque)
+{
+    if (ctx) {
+        aio_set_fd_handler(ctx, fd, fd_read, fd_write, NULL, NULL, opaque);
+    } else {
+        qemu_set_fd_handler(fd, fd_read, fd_write, opaque);
+    }
+}
+
+static void tap_set_fd_handler(TAPState *s, AioContext *ctx, bool enable)
+{
+    IOHandler *fd_read = enable && s->read_poll ? tap_send : NULL;
+    IOHandler *fd_write = enable && s->write_poll ? tap_writable : NULL;
+
+#ifdef CONFIG_LINUX_IO_URING
+    if (s->uring) {
+        /* Completions may be left over from a previous round, watch both */
+        tap_set_handler(ctx, s->uring->rx_ring.ring_fd,
+                        fd_read ? tap_uring_cq_read : NULL, NULL, s);
+        tap_set_handler(ctx, s->uring->tx_ring.ring_fd,
+                        enable ? tap_uring_tx_cq_read : NULL, NULL, s);
+        if (fd_read) {
+            fd_read = tap_uring_fd_read;
+        }
+    }
+#endif
+    tap_set_handler(ctx, s->fd, fd_read, fd_write, s);
+}
 
 static void tap_update_fd_handler(TAPState *s)
 {
-    qemu_set_fd_handler(s->fd,
-                        s->read_poll && s->enabled ? tap_send : NULL,
-                        s->write_poll && s->enabled ? tap_writable : NULL,
-                        s);
+    tap_set_fd_handler(s, s->nc.aio_context, s->enabled);
 }
 
 static void tap_read_poll(TAPState *s, bool enable)
@@ -96,6 +167,13 @@ static void tap_writable(void *opaque)
 
     tap_write_poll(s, false);
 
+#ifdef CONFIG_LINUX_IO_URING
+    if (s->uring && s->uring->tx_stalled) {
+        s->uring->tx_stalled = false;
+        tap_uring_submit_tx(s);
+    }
+#endif
+
     qemu_flush_queued_packets(&s->nc);
 }
 
@@ -113,6 +191,160 @@ static ssize_t tap_write_packet(TAPState *s, const struct iovec *iov, int iovcnt
     return len;
 }
 
+#ifdef CONFIG_LINUX_IO_URING
+static uint8_t *tap_uring_tx_buf(TapUring *u, unsigned slot)
+{
+    return u->tx_bufs + (size_t)slot * NET_BUFSIZE;
+}
+
+/*
+ * Submit the occupied write slots as one linked chain, so that the tap
+ * device sees the packets in order: a write that fails cancels the ones
+ * after it, and they are all written again.  For the same reason there is
+ * only one chain in flight; slots filled meanwhile go with the next one.
+ */
+static void tap_uring_submit_tx(TAPState *s)
+{
+    TapUring *u = s->uring;
+    unsigned i;
+    int ret;
+
+    if (u->tx_stalled) {
+        return;
+    }
+
+    if (!u->tx_inflight) {
+        for (i = 0; i < u->tx_count; i++) {
+            unsigned slot = (u->tx_head + i) % u->size;
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&u->tx_ring);
+
+            /* The ring has an entry per slot and nothing else in flight */
+            assert(sqe);
+            io_uring_prep_write(sqe, s->fd, tap_uring_tx_buf(u, slot),
+                                u->tx_len[slot], 0);
+            io_uring_sqe_set_data(sqe, (void *)(uintptr_t)slot);
+            if (i + 1 < u->tx_count) {
+                sqe->flags |= IOSQE_IO_LINK;
+            }
+        }
+        u->tx_inflight = u->tx_count;
+    }
+
+    /* Entries the kernel did not take last time are still in the ring */
+    if (io_uring_sq_ready(&u->tx_ring)) {
+        ret = io_uring_submit(&u->tx_ring);
+        if (ret < 0) {
+            error_report_once("tap: failed to submit batched writes: %s",
+                              strerror(-ret));
+            u->tx_stalled = true;
+            tap_write_poll(s, true);
+        }
+    }
+}
+
+/*
+ * Copy a packet into a write slot.  Returns -1 if it can be written
+ * directly, and 0 if it must be queued by the peer until slots are free.
+ */
+static ssize_t tap_uring_write(TAPState *s, const struct iovec *iov,
+                               int iovcnt)
+{
+    TapUring *u = s->uring;
+    size_t hdr_len = 0;
+    size_t size = iov_size(iov, iovcnt);
+    unsigned slot;
+    uint8_t *buf;
+
+    /* Nothing to keep the order with */
+    if (!u->tx_batch && !u->tx_count && !u->tx_blocked) {
+        return -1;
+    }
+    if (s->host_vnet_hdr_len && !s->using_vnet_hdr) {
+        hdr_len = s->host_vnet_hdr_len;
+    }
+    if (hdr_len + size > NET_BUFSIZE) {
+        if (!u->tx_count && !u->tx_blocked) {
+            return -1;
+        }
+        u->tx_blocked = true;
+        return 0;
+    }
+    /* Packets refused earlier go first, from qemu_flush_queued_packets() */
+    if (u->tx_blocked || u->tx_count == u->size) {
+        u->tx_blocked = true;
+        return 0;
+    }
+
+    slot = (u->tx_head + u->tx_count) % u->size;
+    buf = tap_uring_tx_buf(u, slot);
+    memset(buf, 0, hdr_len);
+    iov_to_buf(iov, iovcnt, 0, buf + hdr_len, size);
+    u->tx_len[slot] = hdr_len + size;
+    u->tx_count++;
+
+    if (!u->tx_batch) {
+        tap_uring_submit_tx(s);
+    }
+    return size;
+}
+
+static void tap_uring_tx_cq_read(void *opaque)
+{
+    TAPState *s = opaque;
+    TapUring *u = s->uring;
+    struct io_uring_cqe *cqe;
+
+    while (io_uring_peek_cqe(&u->tx_ring, &cqe) == 0) {
+        unsigned slot = (uintptr_t)io_uring_cqe_get_data(cqe);
+
+        u->tx_res[slot] = cqe->res;
+        io_uring_cqe_seen(&u->tx_ring, cqe);
+        u->tx_done++;
+    }
+    if (u->tx_done < u->tx_inflight) {
+        tap_uring_submit_tx(s);
+        return;
+    }
+
+    /* The chain is complete, release the slots that were written */
+    for (; u->tx_inflight; u->tx_inflight--) {
+        unsigned slot = u->tx_head;
+        int res = u->tx_res[slot];
+
+        /*
+         * A tap device takes whole packets, so neither a short write nor
+         * EAGAIN has queued anything.  Keep this packet and the ones after
+         * it and write them again once the tap fd is writable.
+         */
+        if (res == -EAGAIN || res == -ECANCELED ||
+            (res >= 0 && res < u->tx_len[slot])) {
+            u->tx_stalled = true;
+            break;
+        }
+        if (res < 0) {
+            /* Same as a failed writev() on the direct path */
+            error_report_once("tap: failed to write packet: %s",
+                              strerror(-res));
+        }
+        u->tx_head = (u->tx_head + 1) % u->size;
+        u->tx_count--;
+    }
+    u->tx_inflight = 0;
+    u->tx_done = 0;
+
+    if (u->tx_stalled) {
+        tap_write_poll(s, true);
+        return;
+    }
+
+    tap_uring_submit_tx(s);
+    if (u->tx_blocked) {
+        u->tx_blocked = false;
+        qemu_flush_queued_packets(&s->nc);
+    }
+}
+#endif
+
 static ssize_t tap_receive_iov(NetClientState *nc, const struct iovec *iov,
                                int iovcnt)
 {
@@ -121,6 +353,16 @@ static ssize_t tap_receive_iov(NetClientState *nc, const struct iovec *iov,
     g_autofree struct iovec *iov_copy = NULL;
     struct virtio_net_hdr hdr = { };
 
+#ifdef CONFIG_LINUX_IO_URING
+    if (s->uring) {
+        ssize_t ret = tap_uring_write(s, iov, iovcnt);
+
+        if (ret >= 0) {
+            return ret;
+        }
+    }
+#endif
+
     if (s->host_vnet_hdr_len && !s->using_vnet_hdr) {
         iov_copy = g_new(struct iovec, iovcnt + 1);
         iov_copy[0].iov_base = &hdr;
@@ -156,35 +398,41 @@ static void tap_send_completed(NetClientState *nc, ssize_t len)
     tap_read_poll(s, true);
 }
 
+/* Forward a packet read from the tap fd to the peer */
+static ssize_t tap_send_packet(TAPState *s, uint8_t *buf, int size)
+{
+    uint8_t min_pkt[ETH_ZLEN];
+    size_t min_pktsz = sizeof(min_pkt);
+
+    if (s->host_vnet_hdr_len && !s->using_vnet_hdr) {
+        buf  += s->host_vnet_hdr_len;
+        size -= s->host_vnet_hdr_len;
+    }
+
+    if (net_peer_needs_padding(&s->nc)) {
+        if (eth_pad_short_frame(min_pkt, &min_pktsz, buf, size)) {
+            buf = min_pkt;
+            size = min_pktsz;
+        }
+    }
+
+    return qemu_send_packet_async(&s->nc, buf, size, tap_send_completed);
+}
+
 static void tap_send(void *opaque)
 {
     TAPState *s = opaque;
     int size;
     int packets = 0;
 
+    qemu_net_begin_batch(&s->nc);
     while (true) {
-        uint8_t *buf = s->buf;
-        uint8_t min_pkt[ETH_ZLEN];
-        size_t min_pktsz = sizeof(min_pkt);
-
         size = tap_read_packet(s->fd, s->buf, sizeof(s->buf));
         if (size <= 0) {
             break;
         }
 
-        if (s->host_vnet_hdr_len && !s->using_vnet_hdr) {
-            buf  += s->host_vnet_hdr_len;
-            size -= s->host_vnet_hdr_len;
-        }
-
-        if (net_peer_needs_padding(&s->nc)) {
-            if (eth_pad_short_frame(min_pkt, &min_pktsz, buf, size)) {
-                buf = min_pkt;
-                size = min_pktsz;
-            }
-        }
-
-        size = qemu_send_packet_async(&s->nc, buf, size, tap_send_completed);
+        size = tap_send_packet(s, s->buf, size);
         if (size == 0) {
             tap_read_poll(s, false);
             break;
@@ -203,8 +451,194 @@ static void tap_send(void *opaque)
             break;
         }
     }
+    qemu_net_end_batch(&s->nc);
+}
+
+#ifdef CONFIG_LINUX_IO_URING
+/* Post reads into all idle buffers; returns false if there was none */
+static bool tap_uring_submit_reads(TAPState *s)
+{
+    TapUring *u = s->uring;
+    struct io_uring_sqe *sqe;
+
+    if (!u->rx_nidle) {
+        return false;
+    }
+
+    while (u->rx_nidle) {
+        unsigned slot = u->rx_idle[u->rx_nidle - 1];
+
+        sqe = io_uring_get_sqe(&u->rx_ring);
+        if (!sqe) {
+            break;
+        }
+        io_uring_prep_read(sqe, s->fd, u->rx_bufs + (size_t)slot * NET_BUFSIZE,
+                           NET_BUFSIZE, 0);
+        io_uring_sqe_set_data(sqe, (void *)(uintptr_t)slot);
+        u->rx_nidle--;
+    }
+
+    /* Reads of queued packets complete inline, within this one syscall */
+    return io_uring_submit(&u->rx_ring) > 0;
+}
+
+/*
+ * Deliver completed reads in completion order, which is the order in which
+ * the packets were dequeued from the tap device.  @submit posts reads into
+ * idle buffers first; it is set when the tap fd is readable.  Reads that
+ * found no packet only get reposted on the next readiness event, so that a
+ * kernel which fails them with EAGAIN does not make us spin.
+ */
+static void tap_uring_send(TAPState *s, bool submit)
+{
+    TapUring *u = s->uring;
+    unsigned packets = 0;
+    bool busy = false;
+
+    qemu_net_begin_batch(&s->nc);
+    for (;;) {
+        struct io_uring_cqe *cqe;
+        unsigned delivered = 0;
+
+        if (submit) {
+            tap_uring_submit_reads(s);
+        }
+
+        while (packets < u->size && io_uring_peek_cqe(&u->rx_ring, &cqe) == 0) {
+            unsigned slot = (uintptr_t)io_uring_cqe_get_data(cqe);
+            int size = cqe->res;
+
+            io_uring_cqe_seen(&u->rx_ring, cqe);
+            u->rx_idle[u->rx_nidle++] = slot;
+            packets++;
+            if (size <= 0) {
+                continue;
+            }
+
+            delivered++;
+            if (tap_send_packet(s, u->rx_bufs + (size_t)slot * NET_BUFSIZE,
+                                size) == 0) {
+                busy = true;
+                break;
+            }
+        }
+
+        /* Same quota as tap_send() to avoid hogging the thread */
+        if (busy || !delivered || packets >= u->size || packets >= 50) {
+            break;
+        }
+        submit = true;
+    }
+
+    if (busy) {
+        tap_read_poll(s, false);
+    }
+    qemu_net_end_batch(&s->nc);
 }
 
+static void tap_uring_fd_read(void *opaque)
+{
+    tap_uring_send(opaque, true);
+}
+
+static void tap_uring_cq_read(void *opaque)
+{
+    tap_uring_send(opaque, false);
+}
+
+static void tap_begin_batch(NetClientState *nc)
+{
+    TAPState *s = DO_UPCAST(TAPState, nc, nc);
+
+    if (s->uring) {
+        s->uring->tx_batch++;
+    }
+}
+
+static void tap_end_batch(NetClientState *nc)
+{
+    TAPState *s = DO_UPCAST(TAPState, nc, nc);
+
+    if (s->uring && --s->uring->tx_batch == 0) {
+        tap_uring_submit_tx(s);
+    }
+}
+
+static void tap_uring_cleanup(TAPState *s)
+{
+    TapUring *u = s->uring;
+
+    if (!u) {
+        return;
+    }
+
+    tap_set_fd_handler(s, s->nc.aio_context, false);
+
+    /*
+     * The kernel may still be reading from the write slots, wait for the
+     * writes that were submitted.  Packets not written yet are dropped.
+     */
+    if (io_uring_sq_ready(&u->tx_ring)) {
+        io_uring_submit(&u->tx_ring);
+    }
+    while (u->tx_done + io_uring_sq_ready(&u->tx_ring) < u->tx_inflight) {
+        struct io_uring_cqe *cqe;
+
+        if (io_uring_wait_cqe(&u->tx_ring, &cqe) < 0) {
+            break;
+        }
+        io_uring_cqe_seen(&u->tx_ring, cqe);
+        u->tx_done++;
+    }
+    io_uring_queue_exit(&u->tx_ring);
+    io_uring_queue_exit(&u->rx_ring);
+    g_free(u->tx_bufs);
+    g_free(u->tx_len);
+    g_free(u->tx_res);
+    g_free(u->rx_bufs);
+    g_free(u->rx_idle);
+    g_free(u);
+    s->uring = NULL;
+}
+
+static bool tap_uring_init(TAPState *s, unsigned size, Error **errp)
+{
+    TapUring *u = g_new0(TapUring, 1);
+    unsigned i;
+    int ret;
+
+    ret = io_uring_queue_init(size, &u->rx_ring, 0);
+    if (ret < 0) {
+        error_setg_errno(errp, -ret, "tap: failed to create io_uring");
+        g_free(u);
+        return false;
+    }
+    ret = io_uring_queue_init(size, &u->tx_ring, 0);
+    if (ret < 0) {
+        error_setg_errno(errp, -ret, "tap: failed to create io_uring");
+        io_uring_queue_exit(&u->rx_ring);
+        g_free(u);
+        return false;
+    }
+
+    u->size = size;
+    u->rx_bufs = g_malloc((size_t)size * NET_BUFSIZE);
+    u->tx_bufs = g_malloc((size_t)size * NET_BUFSIZE);
+    u->tx_len = g_new(unsigned, size);
+    u->tx_res = g_new(int, size);
+    u->rx_idle = g_new(unsigned, size);
+    for (i = 0; i < size; i++) {
+        u->rx_idle[u->rx_nidle++] = i;
+    }
+
+    /* Switch the fd handlers over to the batched path */
+    tap_set_fd_handler(s, s->nc.aio_context, false);
+    s->uring = u;
+    tap_update_fd_handler(s);
+    return true;
+}
+#endif
+
 static bool tap_has_ufo(NetClientState *nc)
 {
     TAPState *s = DO_UPCAST(TAPState, nc, nc);
@@ -303,6 +737,9 @@ static void tap_cleanup(NetClientState *nc)
 
     tap_read_poll(s, false);
     tap_write_poll(s, false);
+#ifdef CONFIG_LINUX_IO_URING
+    tap_uring_cleanup(s);
+#endif
     close(s->fd);
     s->fd = -1;
 }
@@ -329,6 +766,14 @@ int tap_get_fd(NetClientState *nc)
     return s->fd;
 }
 
+static void tap_set_aio_context(NetClientState *nc, AioContext *ctx)
+{
+    TAPState *s = DO_UPCAST(TAPState, nc, nc);
+
+    tap_set_fd_handler(s, nc->aio_context, false);
+    tap_set_fd_handler(s, ctx, s->enabled);
+}
+
 /* fd support */
 
 static NetClientInfo net_tap_info = {
@@ -347,6 +792,11 @@ static NetClientInfo net_tap_info = {
     .set_vnet_le = tap_set_vnet_le,
     .set_vnet_be = tap_set_vnet_be,
     .set_steering_ebpf = tap_set_steering_ebpf,
+    .set_aio_context = tap_set_aio_context,
+#ifdef CONFIG_LINUX_IO_URING
+    .begin_batch = tap_begin_batch,
+    .end_batch = tap_end_batch,
+#endif
 };
 
 static TAPState *net_tap_fd_init(NetClientState *peer,
@@ -724,6 +1174,25 @@ static void net_init_tap_one(const NetdevTapOptions *tap, NetClientState *peer,
         goto failed;
     }
 
+    if (tap->has_batch && tap->batch > 1) {
+        if (s->vhost_net) {
+            error_setg(errp, "batch= is not valid with vhost");
+            goto failed;
+        }
+#ifdef CONFIG_LINUX_IO_URING
+        if (tap->batch > TAP_BATCH_MAX) {
+            error_setg(errp, "batch= must not exceed %d", TAP_BATCH_MAX);
+            goto failed;
+        }
+        if (!tap_uring_init(s, tap->batch, errp)) {
+            goto failed;
+        }
+#else
+        error_setg(errp, "batch= requires io_uring support");
+        goto failed;
+#endif
+    }
+
     return;
 
 failed:
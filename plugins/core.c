@@ -283,10 +283,23 @@ void qemu_plugin_vcpu_init_hook(CPUState *cpu)
     async_run_on_cpu(cpu, qemu_plugin_vcpu_init__async, RUN_ON_CPU_NULL);
 }
 
+/* Deliver the pending records of all memory buffers for one vCPU */
+static void plugin_mem_buffers_flush_vcpu(unsigned int vcpu_index)
+{
+    struct qemu_plugin_mem_buffer *buf;
+
+    QLIST_FOREACH_RCU(buf, &plugin.mem_buffers, entry) {
+        plugin_mem_buffer_flush(buf, vcpu_index);
+    }
+}
+
 void qemu_plugin_vcpu_exit_hook(CPUState *cpu)
 {
     bool success;
 
+    if (cpu->cpu_index < plugin.num_vcpus) {
+        plugin_mem_buffers_flush_vcpu(cpu->cpu_index);
+    }
     plugin_vcpu_cb__simple(cpu, QEMU_PLUGIN_EV_VCPU_EXIT);
 
     assert(cpu->cpu_index != UNASSIGNED_CPU_INDEX);
@@ -465,6 +478,41 @@ void plugin_register_vcpu_mem_cb(GArray **arr,
     dyn_cb->regular = regular_cb;
 }
 
+/* Called from generated code to deliver the records of @vcpu_index */
+static void plugin_mem_buffer_flush_helper(unsigned int vcpu_index,
+                                           void *udata)
+{
+    plugin_mem_buffer_flush(udata, vcpu_index);
+}
+
+void plugin_register_vcpu_mem_buffer(GArray **arr,
+                                     enum qemu_plugin_mem_rw rw,
+                                     struct qemu_plugin_mem_buffer *buf,
+                                     uint64_t pc)
+{
+    static TCGHelperInfo info = {
+        .flags = TCG_CALL_NO_RWG,
+        /*
+         * Match plugin_mem_buffer_flush_helper:
+         *   void (*)(uint32_t, void *)
+         */
+        .typemask = (dh_typemask(void, 0) |
+                     dh_typemask(i32, 1) |
+                     dh_typemask(ptr, 2))
+    };
+
+    struct qemu_plugin_dyn_cb *dyn_cb = plugin_get_dyn_cb(arr);
+    struct qemu_plugin_buffer_cb buffer_cb = {
+        .flush = plugin_mem_buffer_flush_helper,
+        .info = &info,
+        .buf = buf,
+        .pc = pc,
+        .rw = rw
+    };
+    dyn_cb->type = PLUGIN_CB_MEM_BUFFER;
+    dyn_cb->buffer = buffer_cb;
+}
+
 /*
  * Disable CFI checks.
  * The callback function has been loaded from an external library so we do not
@@ -536,6 +584,7 @@ void qemu_plugin_vcpu_idle_cb(CPUState *cpu)
 {
     /* idle and resume cb may be called before init, ignore in this case */
     if (cpu->cpu_index < plugin.num_vcpus) {
+        plugin_mem_buffers_flush_vcpu(cpu->cpu_index);
         plugin_vcpu_cb__simple(cpu, QEMU_PLUGIN_EV_VCPU_IDLE);
     }
 }
@@ -601,6 +650,44 @@ void exec_inline_op(enum plugin_dyn_cb_type type,
     }
 }
 
+static struct qemu_plugin_mem_record *
+plugin_mem_buffer_records(struct qemu_plugin_mem_buffer *buf,
+                          unsigned int vcpu_index, uint64_t **count)
+{
+    GArray *arr = buf->score->data;
+    char *entry = arr->data + vcpu_index * g_array_get_element_size(arr);
+
+    *count = (uint64_t *)entry;
+    return (struct qemu_plugin_mem_record *)(entry +
+                                             PLUGIN_MEM_BUFFER_RECORDS);
+}
+
+/*
+ * C equivalent of the code generated for accesses done by helpers. The
+ * number of such accesses is not known at translation time, so room is
+ * made here rather than at the start of the instruction. The generated
+ * code of the instruction may still append its own records without
+ * checking, so flush again when this one took the room kept for them.
+ */
+static void plugin_mem_buffer_append(struct qemu_plugin_buffer_cb *cb,
+                                     unsigned int vcpu_index, uint64_t vaddr,
+                                     qemu_plugin_meminfo_t info)
+{
+    uint64_t *count;
+    struct qemu_plugin_mem_record *rec =
+        plugin_mem_buffer_records(cb->buf, vcpu_index, &count);
+
+    if (*count == cb->buf->n_records) {
+        plugin_mem_buffer_flush(cb->buf, vcpu_index);
+    }
+    rec[(*count)++] = (struct qemu_plugin_mem_record) {
+        .vaddr = vaddr, .pc = cb->pc, .info = info
+    };
+    if (*count > cb->buf->n_records - cb->reserve) {
+        plugin_mem_buffer_flush(cb->buf, vcpu_index);
+    }
+}
+
 void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
                              uint64_t value_low,
                              uint64_t value_high,
@@ -634,6 +721,12 @@ void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
                 exec_inline_op(cb->type, &cb->inline_insn, cpu->cpu_index);
             }
             break;
+        case PLUGIN_CB_MEM_BUFFER:
+            if (rw & cb->buffer.rw) {
+                plugin_mem_buffer_append(&cb->buffer, cpu->cpu_index, vaddr,
+                                         make_plugin_meminfo(oi, rw));
+            }
+            break;
         default:
             g_assert_not_reached();
         }
@@ -642,6 +735,11 @@ void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
 
 void qemu_plugin_atexit_cb(void)
 {
+    int i;
+
+    for (i = 0; i < plugin.num_vcpus; i++) {
+        plugin_mem_buffers_flush_vcpu(i);
+    }
     plugin_cb__udata(QEMU_PLUGIN_EV_ATEXIT);
 }
 
@@ -734,6 +832,7 @@ static void __attribute__((__constructor__)) plugin_init(void)
     plugin.cpu_ht = g_hash_table_new(g_int_hash, g_int_equal);
     QLIST_INIT(&plugin.scoreboards);
     plugin.scoreboard_alloc_size = 16; /* avoid frequent reallocation */
+    QLIST_INIT(&plugin.mem_buffers);
     QTAILQ_INIT(&plugin.ctxs);
     qht_init(&plugin.dyn_cb_arr_ht, plugin_dyn_cb_arr_cmp, 16,
              QHT_MODE_AUTO_RESIZE);
@@ -768,3 +867,60 @@ void plugin_scoreboard_free(struct qemu_plugin_scoreboard *score)
     g_array_free(score->data, TRUE);
     g_free(score);
 }
+
+struct qemu_plugin_mem_buffer *
+plugin_mem_buffer_new(size_t n_records, qemu_plugin_vcpu_mem_buffer_cb_t cb,
+                      void *userdata)
+{
+    struct qemu_plugin_mem_buffer *buf;
+
+    /* generated code stores each field of a record at a fixed offset */
+    QEMU_BUILD_BUG_ON(sizeof(struct qemu_plugin_mem_record) != 24);
+    g_assert(n_records > 0);
+
+    buf = g_new0(struct qemu_plugin_mem_buffer, 1);
+    buf->score = plugin_scoreboard_new(
+        PLUGIN_MEM_BUFFER_RECORDS +
+        n_records * sizeof(struct qemu_plugin_mem_record));
+    buf->n_records = n_records;
+    buf->cb = cb;
+    buf->userdata = userdata;
+
+    qemu_rec_mutex_lock(&plugin.lock);
+    QLIST_INSERT_HEAD_RCU(&plugin.mem_buffers, buf, entry);
+    qemu_rec_mutex_unlock(&plugin.lock);
+
+    return buf;
+}
+
+void plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf)
+{
+    qemu_rec_mutex_lock(&plugin.lock);
+    QLIST_REMOVE_RCU(buf, entry);
+    qemu_rec_mutex_unlock(&plugin.lock);
+
+    plugin_scoreboard_free(buf->score);
+    g_free(buf);
+}
+
+/*
+ * Disable CFI checks.
+ * The callback function has been loaded from an external library so we do not
+ * have type information
+ */
+QEMU_DISABLE_CFI
+void plugin_mem_buffer_flush(struct qemu_plugin_mem_buffer *buf,
+                             unsigned int vcpu_index)
+{
+    uint64_t *count;
+    struct qemu_plugin_mem_record *rec =
+        plugin_mem_buffer_records(buf, vcpu_index, &count);
+    uint64_t n = *count;
+
+    if (n == 0) {
+        return;
+    }
+    /* reset first, in case the callback flushes the buffer itself */
+    *count = 0;
+    buf->cb(vcpu_index, rec, n, buf->userdata);
+}
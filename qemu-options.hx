@@ -185,8 +185,11 @@ DEF("accel", HAS_ARG, QEMU_OPTION_accel,
     "                kernel-irqchip=on|off|split controls accelerated irqchip support (default=on)\n"
     "                kvm-shadow-mem=size of KVM shadow MMU in bytes\n"
     "                one-insn-per-tb=on|off (one guest instruction per TCG translation block)\n"
+    "                speculate=on|off (translate likely TCG translation blocks ahead of time)\n"
     "                split-wx=on|off (enable TCG split w^x mapping)\n"
     "                tb-size=n (TCG translation block cache size)\n"
+    "                trace-threshold=n (retranslate hot TCG translation blocks as traces)\n"
+    "                victim-tlb-size=n (TCG victim TLB entries per MMU mode)\n"
     "                dirty-ring-size=n (KVM dirty ring GFN count, default 0)\n"
     "                eager-split-size=n (KVM Eager Page Split chunk size, default 0, disabled. ARM only)\n"
     "                notify-vmexit=run|internal-error|disable,notify-window=n (enable notify VM exit and set notify window, x86 only)\n"
@@ -221,6 +224,14 @@ SRST
         can be useful in some situations, such as when trying to analyse
         the logs produced by the ``-d`` option.
 
+    ``speculate=on|off``
+        Makes each vCPU remember the possible successors of the
+        translation blocks it translates, and translate them while it
+        is halted, so that it does not have to stop for translation when
+        it runs them later. System emulation only; most effective with
+        ``thread=multi``, where each vCPU thread uses its own idle time.
+        The default is off.
+
     ``split-wx=on|off``
         Controls the use of split w^x mapping for the TCG code generation
         buffer. Some operating systems require this to be enabled, and in
@@ -230,6 +241,13 @@ SRST
     ``tb-size=n``
         Controls the size (in MiB) of the TCG translation block cache.
 
+    ``trace-threshold=n``
+        Makes the TCG accelerator count how often each translation block
+        is entered, and retranslate it once it was entered ``n`` times.
+        The new translation continues across direct jumps where the
+        target supports it, so that guest values stay in host registers.
+        The default of 0 disables this.
+
     ``thread=single|multi``
         Controls number of TCG threads. When the TCG is multi-threaded
         there will be one thread per vCPU therefore taking advantage of
@@ -238,6 +256,13 @@ SRST
         incompatible TCG features have been enabled (e.g.
         icount/replay).
 
+    ``victim-tlb-size=n``
+        Sets the number of entries of the victim TLB that the TCG
+        accelerator keeps for each MMU mode, behind the direct mapped
+        softmmu TLB.  It is organised in sets of 8 entries, so ``n`` must
+        be a power of 2 between 8 and 512; 8 gives a single fully
+        associative set.  The default is 64.
+
     ``dirty-ring-size=n``
         When the KVM accelerator is used, it controls the size of the per-vCPU
         dirty page ring buffer (number of entries for each vCPU). It should
@@ -1493,6 +1518,13 @@ SRST
             images directly on block devices), you should consider enabling
             this option.
 
+        ``cluster-alloc-batch``
+            Allocate data clusters for small writes in batches of this many
+            bytes, so that the refcount blocks only need to be updated once
+            per batch instead of once per allocating write. Clusters that
+            have not been used yet are freed when the image is closed
+            (default: 0, which disables batching).
+
         ``overlap-check``
             Which overlap checks to perform for writes to the image
             (none/constant/cached/all; default: cached). For details or
@@ -2769,7 +2801,7 @@ DEF("netdev", HAS_ARG, QEMU_OPTION_netdev,
     "-netdev tap,id=str[,fd=h][,fds=x:y:...:z][,ifname=name][,script=file][,downscript=dfile]\n"
     "         [,br=bridge][,helper=helper][,sndbuf=nbytes][,vnet_hdr=on|off][,vhost=on|off]\n"
     "         [,vhostfd=h][,vhostfds=x:y:...:z][,vhostforce=on|off][,queues=n]\n"
-    "         [,poll-us=n]\n"
+    "         [,poll-us=n][,batch=n]\n"
     "                configure a host TAP network backend with ID 'str'\n"
     "                connected to a bridge (default=" DEFAULT_BRIDGE_INTERFACE ")\n"
     "                use network scripts 'file' (default=" DEFAULT_NETWORK_SCRIPT ")\n"
@@ -2792,6 +2824,7 @@ DEF("netdev", HAS_ARG, QEMU_OPTION_netdev,
     "                use 'queues=n' to specify the number of queues to be created for multiqueue TAP\n"
     "                use 'poll-us=n' to specify the maximum number of microseconds that could be\n"
     "                spent on busy polling for vhost net\n"
+    "                use 'batch=n' to read and write up to n packets per io_uring submission\n"
     "-netdev bridge,id=str[,br=bridge][,helper=helper]\n"
     "                configure a host TAP network backend with ID 'str' that is\n"
     "                connected to a bridge (default=" DEFAULT_BRIDGE_INTERFACE ")\n"
@@ -2801,7 +2834,7 @@ DEF("netdev", HAS_ARG, QEMU_OPTION_netdev,
     "-netdev l2tpv3,id=str,src=srcaddr,dst=dstaddr[,srcport=srcport][,dstport=dstport]\n"
     "         [,rxsession=rxsession],txsession=txsession[,ipv6=on|off][,udp=on|off]\n"
     "         [,cookie64=on|off][,counter][,pincounter][,txcookie=txcookie]\n"
-    "         [,rxcookie=rxcookie][,offset=offset]\n"
+    "         [,rxcookie=rxcookie][,offset=offset][,offload=on|off]\n"
     "                configure a network backend with ID 'str' connected to\n"
     "                an Ethernet over L2TPv3 pseudowire.\n"
     "                Linux kernel 3.3+ as well as most routers can talk\n"
@@ -2823,6 +2856,7 @@ DEF("netdev", HAS_ARG, QEMU_OPTION_netdev,
     "                use 'counter=off' to force a 'cut-down' L2TPv3 with no counter\n"
     "                use 'pincounter=on' to work around broken counter handling in peer\n"
     "                use 'offset=X' to add an extra offset between header and data\n"
+    "                use 'offload=on|off' to merge and segment TCP packets in software (default: off)\n"
 #endif
     "-netdev socket,id=str[,fd=h][,listen=[host]:port][,connect=host:port]\n"
     "                configure a network backend to connect to another network\n"
@@ -2847,6 +2881,7 @@ DEF("netdev", HAS_ARG, QEMU_OPTION_netdev,
     "-netdev dgram,id=str,local.type=fd,local.str=file-descriptor\n"
     "                configure a network backend to connect to another network\n"
     "                using an UDP tunnel\n"
+    "                use 'offload=on|off' to merge and segment TCP packets in software (default: off)\n"
 #ifdef CONFIG_VDE
     "-netdev vde,id=str[,sock=socketpath][,port=n][,group=groupname][,mode=octalmode]\n"
     "                configure a network backend to connect to port 'n' of a vde switch\n"
@@ -2863,9 +2898,13 @@ DEF("netdev", HAS_ARG, QEMU_OPTION_netdev,
 #ifdef CONFIG_AF_XDP
     "-netdev af-xdp,id=str,ifname=name[,mode=native|skb][,force-copy=on|off]\n"
     "         [,queues=n][,start-queue=m][,inhibit=on|off][,sock-fds=x:y:...:z]\n"
+    "         [,zero-copy=on|off][,memdev=id][,offload=on|off]\n"
     "                attach to the existing network interface 'name' with AF_XDP socket\n"
     "                use 'mode=MODE' to specify an XDP program attach mode\n"
     "                use 'force-copy=on|off' to force XDP copy mode even if device supports zero-copy (default: off)\n"
+    "                use 'zero-copy=on|off' to fail if the device does not support zero-copy (default: off)\n"
+    "                use 'memdev=id' to place the UMEM of all queues in memory backend 'id'\n"
+    "                use 'offload=on|off' to merge and segment TCP packets in software (default: off)\n"
     "                use 'inhibit=on|off' to inhibit loading of a default XDP program (default: off)\n"
     "                with inhibit=on,\n"
     "                  use 'sock-fds' to provide file descriptors for already open AF_XDP sockets\n"
@@ -3480,7 +3519,10 @@ SRST
     ``local.str=file-descriptor``
         File descriptor to use to send packets
 
-``-netdev l2tpv3,id=id,src=srcaddr,dst=dstaddr[,srcport=srcport][,dstport=dstport],txsession=txsession[,rxsession=rxsession][,ipv6=on|off][,udp=on|off][,cookie64=on|off][,counter=on|off][,pincounter=on|off][,txcookie=txcookie][,rxcookie=rxcookie][,offset=offset]``
+    All ``dgram`` variants accept ``offload=on``, which offers checksum
+    and TCP segmentation offloads to the guest like ``af-xdp`` does.
+
+``-netdev l2tpv3,id=id,src=srcaddr,dst=dstaddr[,srcport=srcport][,dstport=dstport],txsession=txsession[,rxsession=rxsession][,ipv6=on|off][,udp=on|off][,cookie64=on|off][,counter=on|off][,pincounter=on|off][,txcookie=txcookie][,rxcookie=rxcookie][,offset=offset][,offload=on|off]``
     Configure a L2TPv3 pseudowire host network backend. L2TPv3 (RFC3931)
     is a popular protocol to transport Ethernet (and other Layer 2) data
     frames between two systems. It is present in routers, firewalls and
@@ -3526,6 +3568,12 @@ SRST
     ``offset=offset``
         Add an extra offset between header and data
 
+    ``offload=on``
+        Offer checksum and TCP segmentation offloads to the guest, like
+        ``af-xdp`` does. TCP segments received from the tunnel are merged
+        and large packets from the guest are segmented before they are
+        encapsulated.
+
     For example, to attach a VM running on host 4.3.2.1 via L2TPv3 to
     the bridge br-lan on the remote Linux host 1.2.3.4:
 
@@ -3564,7 +3612,7 @@ SRST
         # launch QEMU instance
         |qemu_system| linux.img -nic vde,sock=/tmp/myswitch
 
-``-netdev af-xdp,id=str,ifname=name[,mode=native|skb][,force-copy=on|off][,queues=n][,start-queue=m][,inhibit=on|off][,sock-fds=x:y:...:z]``
+``-netdev af-xdp,id=str,ifname=name[,mode=native|skb][,force-copy=on|off][,queues=n][,start-queue=m][,inhibit=on|off][,sock-fds=x:y:...:z][,zero-copy=on|off][,memdev=id][,offload=on|off]``
     Configure AF_XDP backend to connect to a network interface 'name'
     using AF_XDP socket.  A specific program attach mode for a default
     XDP program can be forced with 'mode', defaults to best-effort,
@@ -3613,6 +3661,34 @@ SRST
         |qemu_system| linux.img -device virtio-net-pci,netdev=n1 \\
             -netdev af-xdp,id=n1,ifname=eth0,queues=3,inhibit=on,sock-fds=15:16:17
 
+    'zero-copy=on' makes the socket creation fail instead of silently
+    falling back to copy mode when the driver cannot do zero-copy.  The
+    UMEM that the NIC writes received packets to can be placed in a memory
+    backend with 'memdev', for example to use huge pages on the NUMA node
+    of the NIC; each queue takes a 32 MiB slice.  Each queue can also be
+    processed in its own IOThread together with the matching virtio-net
+    queue pair, using the virtio-net 'iothread-vq-mapping' property.
+
+    .. parsed-literal::
+
+        |qemu_system| linux.img \\
+            -object memory-backend-file,id=umem,size=128M,mem-path=/dev/hugepages,share=on \\
+            -object iothread,id=io0 -object iothread,id=io1 \\
+            -object iothread,id=io2 -object iothread,id=io3 \\
+            -netdev af-xdp,id=n1,ifname=eth0,queues=4,zero-copy=on,memdev=umem \\
+            -device '{"driver":"virtio-net-pci","netdev":"n1","mq":true,"vectors":10,
+                      "iothread-vq-mapping":[{"iothread":"io0","vqs":[0]},
+                                             {"iothread":"io1","vqs":[1]},
+                                             {"iothread":"io2","vqs":[2]},
+                                             {"iothread":"io3","vqs":[3]}]}'
+
+    With 'offload=on' the backend offers checksum and TCP segmentation
+    offloads to the guest, like a tap device with a virtio-net header.
+    Consecutive TCP segments read from the interface are merged into
+    packets of up to 64 KiB, and large packets sent by the guest are split
+    into MTU sized frames just before they are transmitted, so that the
+    guest and the virtio rings handle far fewer packets for bulk flows.
+
 ``-netdev vhost-user,chardev=id[,vhostforce=on|off][,queues=n]``
     Establish a vhost-user netdev, backed by a chardev id. The chardev
     should be a unix domain socket backed one. The vhost-user uses a
@@ -5640,13 +5716,19 @@ SRST
         filter-redirector,id=f2,netdev=hn0,queue=rx,outdev=red1 -object
         filter-rewriter,id=rew0,netdev=hn0,queue=all
 
-    ``-object filter-dump,id=id,netdev=dev[,file=filename][,maxlen=len][,position=head|tail|id=<id>][,insert=behind|before]``
+    ``-object filter-dump,id=id,netdev=dev[,file=filename][,maxlen=len][,pcapng=on|off][,position=head|tail|id=<id>][,insert=behind|before]``
         Dump the network traffic on netdev dev to the file specified by
         filename. At most len bytes (64k by default) per packet are
-        stored. The file format is libpcap, so it can be analyzed with
-        tools such as tcpdump or Wireshark.
+        stored. The file format is libpcap, or pcapng with nanosecond
+        timestamps if pcapng is on, so it can be analyzed with tools such
+        as tcpdump or Wireshark.
+
+        Packets are written to the file by a separate thread.  If the
+        file cannot keep up, packets are left out of the capture instead
+        of slowing down the guest; their number is shown as ``dropped``
+        in ``info network``.
 
-    ``-object colo-compare,id=id,primary_in=chardevid,secondary_in=chardevid,outdev=chardevid,iothread=id[,vnet_hdr_support][,notify_dev=id][,compare_timeout=@var{ms}][,expired_scan_cycle=@var{ms}][,max_queue_size=@var{size}]``
+    ``-object colo-compare,id=id,primary_in=chardevid,secondary_in=chardevid,outdev=chardevid,iothread=id[,vnet_hdr_support][,notify_dev=id][,compare_timeout=@var{ms}][,expired_scan_cycle=@var{ms}][,max_queue_size=@var{size}][,workers=@var{n}]``
         Colo-compare gets packet from primary\_in chardevid and
         secondary\_in, then compare whether the payload of primary packet
         and secondary packet are the same. If same, it will output
@@ -5660,6 +5742,13 @@ SRST
         is to set the period of scanning expired primary node network packets.
         The max\_queue\_size=@var{size} is to set the max compare queue
         size depend on user environment.
+        The workers=@var{n} option spreads the comparison over @var{n}
+        threads besides the iothread. Connections are assigned to a
+        worker by the hash of their addresses and ports, so the packets
+        of one connection are still compared and sent out in order. The
+        default of 0 compares all connections in the iothread. The
+        read-only ``stats`` property reports the packets, released
+        packets, mismatches and tracked connections of each worker.
         If user want to use Xen COLO, need to add the notify\_dev to
         notify Xen colo-frame to do checkpoint.
 
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+
+#  Compare the boot time of a guest under several QEMU binaries, for example
+#  a TCI build before and after a change to the interpreter.
+#  Syntax:
+#  boot-time.py [-h] [-n RUNS] [-m MARKER] [-t TIMEOUT] \
+#           -q <qemu executable> [-q <qemu executable> ...] -- \
+#           <qemu options>
+#
+#  [-h] - Print the script arguments help message.
+#  [-n] - Number of boots with each executable (default 5).
+#  [-m] - Console output that marks the end of the boot (default "login:").
+#  [-t] - Give up on a boot after this many seconds (default 600).
+#
+#  The guest console must be on stdout, e.g. with "-nographic" or
+#  "-display none -serial stdio".  Each boot is timed from the start of
+#  QEMU until the marker is printed, after which QEMU is killed.
+#
+#  Example of usage:
+#  boot-time.py -q old/qemu-system-riscv64 -q new/qemu-system-riscv64 \
+#           -m "Run /init" -- -M virt -nographic -kernel Image
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+import argparse
+import os
+import selectors
+import statistics
+import subprocess
+import sys
+import time
+
+
+def boot_once(command, marker, timeout):
+    """Return the seconds until marker appears in the output of command."""
+    start = time.monotonic()
+    proc = subprocess.Popen(command, stdin=subprocess.DEVNULL,
+                            stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT)
+    sel = selectors.DefaultSelector()
+    sel.register(proc.stdout, selectors.EVENT_READ)
+    output = b''
+    try:
+        while True:
+            left = start + timeout - time.monotonic()
+            if left <= 0:
+                sys.exit(f"{command[0]}: no '{marker.decode()}' "
+                         f"within {timeout} seconds")
+            if not sel.select(left):
+                continue
+            data = os.read(proc.stdout.fileno(), 65536)
+            if not data:
+                sys.exit(f"{command[0]}: exited with {proc.wait()} "
+                         f"before '{marker.decode()}'")
+            # Keep enough of the tail for a marker split across reads
+            output = output[-len(marker):] + data
+            if marker in output:
+                return time.monotonic() - start
+    finally:
+        proc.kill()
+        proc.wait()
+        sel.close()
+
+
+# Parse the command line arguments
+parser = argparse.ArgumentParser(
+    usage='boot-time.py [-h] [-n RUNS] [-m MARKER] [-t TIMEOUT] '
+          '-q <qemu executable> [-q <qemu executable> ...] -- '
+          '<qemu options>')
+
+parser.add_argument('-n', dest='runs', type=int, default=5,
+                    help='Number of boots with each executable.')
+parser.add_argument('-m', dest='marker', type=str, default='login:',
+                    help='Console output that marks the end of the boot.')
+parser.add_argument('-t', dest='timeout', type=int, default=600,
+                    help='Give up on a boot after this many seconds.')
+parser.add_argument('-q', dest='qemu', action='append', required=True,
+                    help='QEMU executable, can be given more than once.')
+parser.add_argument('options', type=str, nargs='*', help=argparse.SUPPRESS)
+
+args = parser.parse_args()
+marker = args.marker.encode()
+
+results = []
+for qemu in args.qemu:
+    times = []
+    for i in range(args.runs):
+        times.append(boot_once([qemu] + args.options, marker, args.timeout))
+        print(f'{qemu}: run {i + 1}: {times[-1]:.2f} s', file=sys.stderr)
+    results.append((qemu, statistics.mean(times),
+                    statistics.stdev(times) if len(times) > 1 else 0))
+
+base = results[0][1]
+for qemu, mean, stdev in results:
+    print(f'{mean:8.2f} s  +- {stdev:5.2f}  {base / mean:5.2f}x  {qemu}')
@@ -2014,6 +2014,17 @@ static void qemu_create_early_backends(void)
  * The remainder of object creation happens after the
  * creation of chardev, fsdev, net clients and device data types.
  */
+/*
+ * Memory backends are created after chardevs, see object_create_early(),
+ * but before the net clients.
+ *
+ * Reason: af-xdp property "memdev"
+ */
+static bool object_create_memory_backend(const char *type)
+{
+    return g_str_has_prefix(type, "memory-backend-");
+}
+
 static bool object_create_late(const char *type)
 {
     return !object_create_early(type) && !object_create_pre_sandbox(type);
@@ -2025,6 +2036,8 @@ static void qemu_create_late_backends(void)
         qtest_server_init(qtest_chrdev, qtest_log, &error_fatal);
     }
 
+    object_option_foreach_add(object_create_memory_backend);
+
     net_init_clients();
 
     object_option_foreach_add(object_create_late);
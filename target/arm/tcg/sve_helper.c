@@ -5652,13 +5652,30 @@ void sve_cont_ldst_mte_check(SVEContLdSt *info, CPUARMState *env,
     }
 }
 
+/*
+ * A little-endian contiguous access to one register without extension
+ * or truncation has the same layout in the register and in memory on a
+ * little-endian host; @be is set by the helpers that byte-swap.  When a
+ * whole predicate word is true and all of its elements are within
+ * [reg_off, reg_last], the 64 bytes it covers can be copied at once.
+ */
+static inline bool sve_cont_bulk(int esz, int msz, bool be, int N,
+                                 uint64_t pg, intptr_t reg_off,
+                                 intptr_t reg_last)
+{
+    return !HOST_BIG_ENDIAN && !be && N == 1 && esz == msz &&
+           (reg_off & 63) == 0 && reg_off + 64 - (1 << esz) <= reg_last &&
+           pg == pred_esz_masks[esz];
+}
+
 /*
  * Common helper for all contiguous 1,2,3,4-register predicated stores.
  */
 static inline QEMU_ALWAYS_INLINE
 void sve_ldN_r(CPUARMState *env, uint64_t *vg, const target_ulong addr,
                uint32_t desc, const uintptr_t retaddr,
-               const int esz, const int msz, const int N, uint32_t mtedesc,
+               const int esz, const int msz, const bool be, const int N,
+               uint32_t mtedesc,
                sve_ldst1_host_fn *host_fn,
                sve_ldst1_tlb_fn *tlb_fn)
 {
@@ -5749,6 +5766,13 @@ void sve_ldN_r(CPUARMState *env, uint64_t *vg, const target_ulong addr,
 
     while (reg_off <= reg_last) {
         uint64_t pg = vg[reg_off >> 6];
+        if (sve_cont_bulk(esz, msz, be, N, pg, reg_off, reg_last)) {
+            memcpy((void *)&env->vfp.zregs[rd & 31] + reg_off,
+                   host + mem_off, 64);
+            reg_off += 64;
+            mem_off += 64;
+            continue;
+        }
         do {
             if ((pg >> (reg_off & 63)) & 1) {
                 for (i = 0; i < N; ++i) {
@@ -5786,6 +5810,13 @@ void sve_ldN_r(CPUARMState *env, uint64_t *vg, const target_ulong addr,
 
         do {
             uint64_t pg = vg[reg_off >> 6];
+            if (sve_cont_bulk(esz, msz, be, N, pg, reg_off, reg_last)) {
+                memcpy((void *)&env->vfp.zregs[rd & 31] + reg_off,
+                       host + mem_off, 64);
+                reg_off += 64;
+                mem_off += 64;
+                continue;
+            }
             do {
                 if ((pg >> (reg_off & 63)) & 1) {
                     for (i = 0; i < N; ++i) {
@@ -5805,7 +5836,7 @@ void sve_ldN_r(CPUARMState *env, uint64_t *vg, const target_ulong addr,
 static inline QEMU_ALWAYS_INLINE
 void sve_ldN_r_mte(CPUARMState *env, uint64_t *vg, target_ulong addr,
                    uint32_t desc, const uintptr_t ra,
-                   const int esz, const int msz, const int N,
+                   const int esz, const int msz, const bool be, const int N,
                    sve_ldst1_host_fn *host_fn,
                    sve_ldst1_tlb_fn *tlb_fn)
 {
@@ -5821,20 +5852,21 @@ void sve_ldN_r_mte(CPUARMState *env, uint64_t *vg, target_ulong addr,
         mtedesc = 0;
     }
 
-    sve_ldN_r(env, vg, addr, desc, ra, esz, msz, N, mtedesc, host_fn, tlb_fn);
+    sve_ldN_r(env, vg, addr, desc, ra, esz, msz, be, N, mtedesc,
+              host_fn, tlb_fn);
 }
 
 #define DO_LD1_1(NAME, ESZ)                                             \
 void HELPER(sve_##NAME##_r)(CPUARMState *env, void *vg,                 \
                             target_ulong addr, uint32_t desc)           \
 {                                                                       \
-    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, MO_8, 1, 0,            \
+    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, MO_8, false, 1, 0,     \
               sve_##NAME##_host, sve_##NAME##_tlb);                     \
 }                                                                       \
 void HELPER(sve_##NAME##_r_mte)(CPUARMState *env, void *vg,             \
                                 target_ulong addr, uint32_t desc)       \
 {                                                                       \
-    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MO_8, 1,           \
+    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MO_8, false, 1,    \
                   sve_##NAME##_host, sve_##NAME##_tlb);                 \
 }
 
@@ -5842,25 +5874,25 @@ void HELPER(sve_##NAME##_r_mte)(CPUARMState *env, void *vg,             \
 void HELPER(sve_##NAME##_le_r)(CPUARMState *env, void *vg,              \
                                target_ulong addr, uint32_t desc)        \
 {                                                                       \
-    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, MSZ, 1, 0,             \
+    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, MSZ, false, 1, 0,      \
               sve_##NAME##_le_host, sve_##NAME##_le_tlb);               \
 }                                                                       \
 void HELPER(sve_##NAME##_be_r)(CPUARMState *env, void *vg,              \
                                target_ulong addr, uint32_t desc)        \
 {                                                                       \
-    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, MSZ, 1, 0,             \
+    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, MSZ, true, 1, 0,       \
               sve_##NAME##_be_host, sve_##NAME##_be_tlb);               \
 }                                                                       \
 void HELPER(sve_##NAME##_le_r_mte)(CPUARMState *env, void *vg,          \
                                    target_ulong addr, uint32_t desc)    \
 {                                                                       \
-    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, 1,            \
+    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, false, 1,     \
                   sve_##NAME##_le_host, sve_##NAME##_le_tlb);           \
 }                                                                       \
 void HELPER(sve_##NAME##_be_r_mte)(CPUARMState *env, void *vg,          \
                                    target_ulong addr, uint32_t desc)    \
 {                                                                       \
-    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, 1,            \
+    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, true, 1,      \
                   sve_##NAME##_be_host, sve_##NAME##_be_tlb);           \
 }
 
@@ -5891,13 +5923,13 @@ DO_LD1_2(ld1dd,  MO_64, MO_64)
 void HELPER(sve_ld##N##bb_r)(CPUARMState *env, void *vg,                \
                              target_ulong addr, uint32_t desc)          \
 {                                                                       \
-    sve_ldN_r(env, vg, addr, desc, GETPC(), MO_8, MO_8, N, 0,           \
+    sve_ldN_r(env, vg, addr, desc, GETPC(), MO_8, MO_8, false, N, 0,    \
               sve_ld1bb_host, sve_ld1bb_tlb);                           \
 }                                                                       \
 void HELPER(sve_ld##N##bb_r_mte)(CPUARMState *env, void *vg,            \
                                  target_ulong addr, uint32_t desc)      \
 {                                                                       \
-    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), MO_8, MO_8, N,          \
+    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), MO_8, MO_8, false, N,   \
                   sve_ld1bb_host, sve_ld1bb_tlb);                       \
 }
 
@@ -5905,25 +5937,25 @@ void HELPER(sve_ld##N##bb_r_mte)(CPUARMState *env, void *vg,            \
 void HELPER(sve_ld##N##SUFF##_le_r)(CPUARMState *env, void *vg,         \
                                     target_ulong addr, uint32_t desc)   \
 {                                                                       \
-    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, ESZ, N, 0,             \
+    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, ESZ, false, N, 0,      \
               sve_ld1##SUFF##_le_host, sve_ld1##SUFF##_le_tlb);         \
 }                                                                       \
 void HELPER(sve_ld##N##SUFF##_be_r)(CPUARMState *env, void *vg,         \
                                     target_ulong addr, uint32_t desc)   \
 {                                                                       \
-    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, ESZ, N, 0,             \
+    sve_ldN_r(env, vg, addr, desc, GETPC(), ESZ, ESZ, true, N, 0,       \
               sve_ld1##SUFF##_be_host, sve_ld1##SUFF##_be_tlb);         \
 }                                                                       \
 void HELPER(sve_ld##N##SUFF##_le_r_mte)(CPUARMState *env, void *vg,     \
                                         target_ulong addr, uint32_t desc) \
 {                                                                       \
-    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, ESZ, N,            \
+    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, ESZ, false, N,     \
                   sve_ld1##SUFF##_le_host, sve_ld1##SUFF##_le_tlb);     \
 }                                                                       \
 void HELPER(sve_ld##N##SUFF##_be_r_mte)(CPUARMState *env, void *vg,     \
                                         target_ulong addr, uint32_t desc) \
 {                                                                       \
-    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, ESZ, N,            \
+    sve_ldN_r_mte(env, vg, addr, desc, GETPC(), ESZ, ESZ, true, N,      \
                   sve_ld1##SUFF##_be_host, sve_ld1##SUFF##_be_tlb);     \
 }
 
@@ -5979,8 +6011,8 @@ static void record_fault(CPUARMState *env, uintptr_t i, uintptr_t oprsz)
 static inline QEMU_ALWAYS_INLINE
 void sve_ldnfff1_r(CPUARMState *env, void *vg, const target_ulong addr,
                    uint32_t desc, const uintptr_t retaddr, uint32_t mtedesc,
-                   const int esz, const int msz, const SVEContFault fault,
-                   sve_ldst1_host_fn *host_fn,
+                   const int esz, const int msz, const bool be,
+                   const SVEContFault fault, sve_ldst1_host_fn *host_fn,
                    sve_ldst1_tlb_fn *tlb_fn)
 {
     const unsigned rd = simd_data(desc);
@@ -6108,6 +6140,13 @@ void sve_ldnfff1_r(CPUARMState *env, void *vg, const target_ulong addr,
 
     do {
         uint64_t pg = *(uint64_t *)(vg + (reg_off >> 3));
+        if (!(flags & TLB_WATCHPOINT) && !mtedesc &&
+            sve_cont_bulk(esz, msz, be, 1, pg, reg_off, reg_last)) {
+            memcpy(vd + reg_off, host + mem_off, 64);
+            reg_off += 64;
+            mem_off += 64;
+            continue;
+        }
         do {
             if ((pg >> (reg_off & 63)) & 1) {
                 if (unlikely(flags & TLB_WATCHPOINT) &&
@@ -6163,8 +6202,8 @@ void sve_ldnfff1_r(CPUARMState *env, void *vg, const target_ulong addr,
 static inline QEMU_ALWAYS_INLINE
 void sve_ldnfff1_r_mte(CPUARMState *env, void *vg, target_ulong addr,
                        uint32_t desc, const uintptr_t retaddr,
-                       const int esz, const int msz, const SVEContFault fault,
-                       sve_ldst1_host_fn *host_fn,
+                       const int esz, const int msz, const bool be,
+                       const SVEContFault fault, sve_ldst1_host_fn *host_fn,
                        sve_ldst1_tlb_fn *tlb_fn)
 {
     uint32_t mtedesc = desc >> (SIMD_DATA_SHIFT + SVE_MTEDESC_SHIFT);
@@ -6180,32 +6219,36 @@ void sve_ldnfff1_r_mte(CPUARMState *env, void *vg, target_ulong addr,
     }
 
     sve_ldnfff1_r(env, vg, addr, desc, retaddr, mtedesc,
-                  esz, msz, fault, host_fn, tlb_fn);
+                  esz, msz, be, fault, host_fn, tlb_fn);
 }
 
 #define DO_LDFF1_LDNF1_1(PART, ESZ)                                     \
 void HELPER(sve_ldff1##PART##_r)(CPUARMState *env, void *vg,            \
                                  target_ulong addr, uint32_t desc)      \
 {                                                                       \
-    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MO_8, FAULT_FIRST, \
+    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MO_8,           \
+                  false, FAULT_FIRST,                                   \
                   sve_ld1##PART##_host, sve_ld1##PART##_tlb);           \
 }                                                                       \
 void HELPER(sve_ldnf1##PART##_r)(CPUARMState *env, void *vg,            \
                                  target_ulong addr, uint32_t desc)      \
 {                                                                       \
-    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MO_8, FAULT_NO, \
+    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MO_8,           \
+                  false, FAULT_NO,                                      \
                   sve_ld1##PART##_host, sve_ld1##PART##_tlb);           \
 }                                                                       \
 void HELPER(sve_ldff1##PART##_r_mte)(CPUARMState *env, void *vg,        \
                                      target_ulong addr, uint32_t desc)  \
 {                                                                       \
-    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MO_8, FAULT_FIRST, \
+    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MO_8,          \
+                      false, FAULT_FIRST,                               \
                       sve_ld1##PART##_host, sve_ld1##PART##_tlb);       \
 }                                                                       \
 void HELPER(sve_ldnf1##PART##_r_mte)(CPUARMState *env, void *vg,        \
                                      target_ulong addr, uint32_t desc)  \
 {                                                                       \
-    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MO_8, FAULT_NO, \
+    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MO_8,          \
+                      false, FAULT_NO,                                  \
                   sve_ld1##PART##_host, sve_ld1##PART##_tlb);           \
 }
 
@@ -6213,49 +6256,57 @@ void HELPER(sve_ldnf1##PART##_r_mte)(CPUARMState *env, void *vg,        \
 void HELPER(sve_ldff1##PART##_le_r)(CPUARMState *env, void *vg,         \
                                     target_ulong addr, uint32_t desc)   \
 {                                                                       \
-    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MSZ, FAULT_FIRST, \
+    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MSZ,            \
+                  false, FAULT_FIRST,                                   \
                   sve_ld1##PART##_le_host, sve_ld1##PART##_le_tlb);     \
 }                                                                       \
 void HELPER(sve_ldnf1##PART##_le_r)(CPUARMState *env, void *vg,         \
                                     target_ulong addr, uint32_t desc)   \
 {                                                                       \
-    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MSZ, FAULT_NO,  \
+    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MSZ,            \
+                  false, FAULT_NO,                                      \
                   sve_ld1##PART##_le_host, sve_ld1##PART##_le_tlb);     \
 }                                                                       \
 void HELPER(sve_ldff1##PART##_be_r)(CPUARMState *env, void *vg,         \
                                     target_ulong addr, uint32_t desc)   \
 {                                                                       \
-    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MSZ, FAULT_FIRST, \
+    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MSZ,            \
+                  true, FAULT_FIRST,                                    \
                   sve_ld1##PART##_be_host, sve_ld1##PART##_be_tlb);     \
 }                                                                       \
 void HELPER(sve_ldnf1##PART##_be_r)(CPUARMState *env, void *vg,         \
                                     target_ulong addr, uint32_t desc)   \
 {                                                                       \
-    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MSZ, FAULT_NO,  \
+    sve_ldnfff1_r(env, vg, addr, desc, GETPC(), 0, ESZ, MSZ,            \
+                  true, FAULT_NO,                                       \
                   sve_ld1##PART##_be_host, sve_ld1##PART##_be_tlb);     \
 }                                                                       \
 void HELPER(sve_ldff1##PART##_le_r_mte)(CPUARMState *env, void *vg,     \
                                         target_ulong addr, uint32_t desc) \
 {                                                                       \
-    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, FAULT_FIRST, \
+    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ,           \
+                      false, FAULT_FIRST,                               \
                       sve_ld1##PART##_le_host, sve_ld1##PART##_le_tlb); \
 }                                                                       \
 void HELPER(sve_ldnf1##PART##_le_r_mte)(CPUARMState *env, void *vg,     \
                                         target_ulong addr, uint32_t desc) \
 {                                                                       \
-    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, FAULT_NO, \
+    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ,           \
+                      false, FAULT_NO,                                  \
                       sve_ld1##PART##_le_host, sve_ld1##PART##_le_tlb); \
 }                                                                       \
 void HELPER(sve_ldff1##PART##_be_r_mte)(CPUARMState *env, void *vg,     \
                                         target_ulong addr, uint32_t desc) \
 {                                                                       \
-    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, FAULT_FIRST, \
+    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ,           \
+                      true, FAULT_FIRST,                                \
                       sve_ld1##PART##_be_host, sve_ld1##PART##_be_tlb); \
 }                                                                       \
 void HELPER(sve_ldnf1##PART##_be_r_mte)(CPUARMState *env, void *vg,     \
                                         target_ulong addr, uint32_t desc) \
 {                                                                       \
-    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, FAULT_NO, \
+    sve_ldnfff1_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ,           \
+                      true, FAULT_NO,                                   \
                       sve_ld1##PART##_be_host, sve_ld1##PART##_be_tlb); \
 }
 
@@ -6289,7 +6340,8 @@ DO_LDFF1_LDNF1_2(dd,  MO_64, MO_64)
 static inline QEMU_ALWAYS_INLINE
 void sve_stN_r(CPUARMState *env, uint64_t *vg, target_ulong addr,
                uint32_t desc, const uintptr_t retaddr,
-               const int esz, const int msz, const int N, uint32_t mtedesc,
+               const int esz, const int msz, const bool be, const int N,
+               uint32_t mtedesc,
                sve_ldst1_host_fn *host_fn,
                sve_ldst1_tlb_fn *tlb_fn)
 {
@@ -6365,6 +6417,13 @@ void sve_stN_r(CPUARMState *env, uint64_t *vg, target_ulong addr,
 
     while (reg_off <= reg_last) {
         uint64_t pg = vg[reg_off >> 6];
+        if (sve_cont_bulk(esz, msz, be, N, pg, reg_off, reg_last)) {
+            memcpy(host + mem_off,
+                   (void *)&env->vfp.zregs[rd & 31] + reg_off, 64);
+            reg_off += 64;
+            mem_off += 64;
+            continue;
+        }
         do {
             if ((pg >> (reg_off & 63)) & 1) {
                 for (i = 0; i < N; ++i) {
@@ -6402,6 +6461,13 @@ void sve_stN_r(CPUARMState *env, uint64_t *vg, target_ulong addr,
 
         do {
             uint64_t pg = vg[reg_off >> 6];
+            if (sve_cont_bulk(esz, msz, be, N, pg, reg_off, reg_last)) {
+                memcpy(host + mem_off,
+                       (void *)&env->vfp.zregs[rd & 31] + reg_off, 64);
+                reg_off += 64;
+                mem_off += 64;
+                continue;
+            }
             do {
                 if ((pg >> (reg_off & 63)) & 1) {
                     for (i = 0; i < N; ++i) {
@@ -6421,7 +6487,7 @@ void sve_stN_r(CPUARMState *env, uint64_t *vg, target_ulong addr,
 static inline QEMU_ALWAYS_INLINE
 void sve_stN_r_mte(CPUARMState *env, uint64_t *vg, target_ulong addr,
                    uint32_t desc, const uintptr_t ra,
-                   const int esz, const int msz, const int N,
+                   const int esz, const int msz, const bool be, const int N,
                    sve_ldst1_host_fn *host_fn,
                    sve_ldst1_tlb_fn *tlb_fn)
 {
@@ -6437,20 +6503,21 @@ void sve_stN_r_mte(CPUARMState *env, uint64_t *vg, target_ulong addr,
         mtedesc = 0;
     }
 
-    sve_stN_r(env, vg, addr, desc, ra, esz, msz, N, mtedesc, host_fn, tlb_fn);
+    sve_stN_r(env, vg, addr, desc, ra, esz, msz, be, N, mtedesc,
+              host_fn, tlb_fn);
 }
 
 #define DO_STN_1(N, NAME, ESZ)                                          \
 void HELPER(sve_st##N##NAME##_r)(CPUARMState *env, void *vg,            \
                                  target_ulong addr, uint32_t desc)      \
 {                                                                       \
-    sve_stN_r(env, vg, addr, desc, GETPC(), ESZ, MO_8, N, 0,            \
+    sve_stN_r(env, vg, addr, desc, GETPC(), ESZ, MO_8, false, N, 0,     \
               sve_st1##NAME##_host, sve_st1##NAME##_tlb);               \
 }                                                                       \
 void HELPER(sve_st##N##NAME##_r_mte)(CPUARMState *env, void *vg,        \
                                      target_ulong addr, uint32_t desc)  \
 {                                                                       \
-    sve_stN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MO_8, N,           \
+    sve_stN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MO_8, false, N,    \
                   sve_st1##NAME##_host, sve_st1##NAME##_tlb);           \
 }
 
@@ -6458,25 +6525,25 @@ void HELPER(sve_st##N##NAME##_r_mte)(CPUARMState *env, void *vg,        \
 void HELPER(sve_st##N##NAME##_le_r)(CPUARMState *env, void *vg,         \
                                     target_ulong addr, uint32_t desc)   \
 {                                                                       \
-    sve_stN_r(env, vg, addr, desc, GETPC(), ESZ, MSZ, N, 0,             \
+    sve_stN_r(env, vg, addr, desc, GETPC(), ESZ, MSZ, false, N, 0,      \
               sve_st1##NAME##_le_host, sve_st1##NAME##_le_tlb);         \
 }                                                                       \
 void HELPER(sve_st##N##NAME##_be_r)(CPUARMState *env, void *vg,         \
                                     target_ulong addr, uint32_t desc)   \
 {                                                                       \
-    sve_stN_r(env, vg, addr, desc, GETPC(), ESZ, MSZ, N, 0,             \
+    sve_stN_r(env, vg, addr, desc, GETPC(), ESZ, MSZ, true, N, 0,       \
               sve_st1##NAME##_be_host, sve_st1##NAME##_be_tlb);         \
 }                                                                       \
 void HELPER(sve_st##N##NAME##_le_r_mte)(CPUARMState *env, void *vg,     \
                                         target_ulong addr, uint32_t desc) \
 {                                                                       \
-    sve_stN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, N,            \
+    sve_stN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, false, N,     \
                   sve_st1##NAME##_le_host, sve_st1##NAME##_le_tlb);     \
 }                                                                       \
 void HELPER(sve_st##N##NAME##_be_r_mte)(CPUARMState *env, void *vg,     \
                                         target_ulong addr, uint32_t desc) \
 {                                                                       \
-    sve_stN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, N,            \
+    sve_stN_r_mte(env, vg, addr, desc, GETPC(), ESZ, MSZ, true, N,      \
                   sve_st1##NAME##_be_host, sve_st1##NAME##_be_tlb);     \
 }
 
@@ -6543,6 +6610,30 @@ static target_ulong off_zd_d(void *reg, intptr_t reg_ofs)
     return *(uint64_t *)(reg + reg_ofs);
 }
 
+/*
+ * Gathers and scatters often have many elements in the same page.
+ * Remember the last page that was probed and found to be plain RAM
+ * without watchpoints, so that the following elements in it can skip
+ * the TLB lookup.  The host address stays valid for the whole helper,
+ * just as with the host[] array of the scatter.
+ */
+typedef struct {
+    target_ulong page;
+    void *host;
+    bool tagged;
+} SVEGatherPage;
+
+static inline void sve_gather_page_save(SVEGatherPage *last,
+                                        const SVEHostPage *info,
+                                        target_ulong addr)
+{
+    if (info->flags == 0) {
+        last->page = addr & TARGET_PAGE_MASK;
+        last->host = info->host - (addr & ~TARGET_PAGE_MASK);
+        last->tagged = info->tagged;
+    }
+}
+
 static inline QEMU_ALWAYS_INLINE
 void sve_ld1_z(CPUARMState *env, void *vd, uint64_t *vg, void *vm,
                target_ulong base, uint32_t desc, uintptr_t retaddr,
@@ -6557,6 +6648,7 @@ void sve_ld1_z(CPUARMState *env, void *vd, uint64_t *vg, void *vm,
     ARMVectorReg scratch;
     intptr_t reg_off;
     SVEHostPage info, info2;
+    SVEGatherPage last = { .page = -1 };
 
     memset(&scratch, 0, reg_max);
     reg_off = 0;
@@ -6567,10 +6659,24 @@ void sve_ld1_z(CPUARMState *env, void *vd, uint64_t *vg, void *vm,
                 target_ulong addr = base + (off_fn(vm, reg_off) << scale);
                 target_ulong in_page = -(addr | TARGET_PAGE_MASK);
 
+                if (likely(in_page >= msize) &&
+                    (addr & TARGET_PAGE_MASK) == last.page) {
+                    /* Same page as a previous element, plain RAM. */
+                    if (mtedesc && last.tagged) {
+                        mte_check(env, mtedesc, addr, retaddr);
+                    }
+                    set_helper_retaddr(retaddr);
+                    host_fn(&scratch, reg_off,
+                            last.host + (addr & ~TARGET_PAGE_MASK));
+                    clear_helper_retaddr();
+                    goto next;
+                }
+
                 sve_probe_page(&info, false, env, addr, 0, MMU_DATA_LOAD,
                                mmu_idx, retaddr);
 
                 if (likely(in_page >= msize)) {
+                    sve_gather_page_save(&last, &info, addr);
                     if (unlikely(info.flags & TLB_WATCHPOINT)) {
                         cpu_check_watchpoint(env_cpu(env), addr, msize,
                                              info.attrs, BP_MEM_READ, retaddr);
@@ -6600,6 +6706,7 @@ void sve_ld1_z(CPUARMState *env, void *vd, uint64_t *vg, void *vm,
                     tlb_fn(env, &scratch, reg_off, addr, retaddr);
                 }
             }
+        next:
             reg_off += esize;
             pg >>= esize;
         } while (reg_off & 63);
@@ -6952,6 +7059,7 @@ void sve_st1_z(CPUARMState *env, void *vd, uint64_t *vg, void *vm,
     void *host[ARM_MAX_VQ * 4];
     intptr_t reg_off, i;
     SVEHostPage info, info2;
+    SVEGatherPage last = { .page = -1 };
 
     /*
      * Probe all of the elements for host addresses and flags.
@@ -6965,12 +7073,22 @@ void sve_st1_z(CPUARMState *env, void *vd, uint64_t *vg, void *vm,
 
             host[i] = NULL;
             if (likely((pg >> (reg_off & 63)) & 1)) {
+                if (likely(in_page >= msize) &&
+                    (addr & TARGET_PAGE_MASK) == last.page) {
+                    /* Same page as a previous element, plain RAM. */
+                    host[i] = last.host + (addr & ~TARGET_PAGE_MASK);
+                    if (mtedesc && last.tagged) {
+                        mte_check(env, mtedesc, addr, retaddr);
+                    }
+                    goto next;
+                }
                 if (likely(in_page >= msize)) {
                     sve_probe_page(&info, false, env, addr, 0, MMU_DATA_STORE,
                                    mmu_idx, retaddr);
                     if (!(info.flags & TLB_MMIO)) {
                         host[i] = info.host;
                     }
+                    sve_gather_page_save(&last, &info, addr);
                 } else {
                     /*
                      * Element crosses the page boundary.
@@ -6993,6 +7111,7 @@ void sve_st1_z(CPUARMState *env, void *vd, uint64_t *vg, void *vm,
                     mte_check(env, mtedesc, addr, retaddr);
                 }
             }
+        next:
             i += 1;
             reg_off += esize;
         } while (reg_off & 63);
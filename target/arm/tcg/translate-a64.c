@@ -1473,10 +1473,24 @@ static inline void gen_check_sp_alignment(DisasContext *s)
  * match up with those in the manual.
  */
 
+/*
+ * Within a trace, keep translating at the destination of a direct
+ * branch instead of ending the TB; see translator_trace_jump().
+ */
+static void gen_goto_tb_or_trace(DisasContext *s, int64_t diff)
+{
+    if (translator_trace_jump(&s->base, s->base.pc_next,
+                              s->pc_curr + diff)) {
+        s->base.pc_next = s->pc_curr + diff;
+    } else {
+        gen_goto_tb(s, 0, diff);
+    }
+}
+
 static bool trans_B(DisasContext *s, arg_i *a)
 {
     reset_btype(s);
-    gen_goto_tb(s, 0, a->imm);
+    gen_goto_tb_or_trace(s, a->imm);
     return true;
 }
 
@@ -1484,7 +1498,7 @@ static bool trans_BL(DisasContext *s, arg_i *a)
 {
     gen_pc_plus_diff(s, cpu_reg(s, 30), curr_insn_len(s));
     reset_btype(s);
-    gen_goto_tb(s, 0, a->imm);
+    gen_goto_tb_or_trace(s, a->imm);
     return true;
 }
 
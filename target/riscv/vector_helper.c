@@ -436,15 +436,74 @@ vext_ldst_us(void *vd, target_ulong base, CPURISCVState *env, uint32_t desc,
 /*
  * masked unit-stride load and store operation will be a special case of
  * stride, stride = NF * sizeof (ETYPE)
+ *
+ * When all the active elements are in one page that is accessible without
+ * going through the slow path, access them through the host pointer
+ * instead.  Masked-off elements must not fault, so the page is probed
+ * without faulting and any problem is left to the strided path.
  */
+static inline QEMU_ALWAYS_INLINE void
+vext_ldst_us_mask(void *vd, void *v0, target_ulong base, CPURISCVState *env,
+                  uint32_t desc, vext_ldst_elem_fn_tlb *ldst_tlb,
+                  vext_ldst_elem_fn_host *ldst_host, uint32_t log2_esz,
+                  uintptr_t ra, bool is_load)
+{
+    uint32_t i, k;
+    uint32_t nf = vext_nf(desc);
+    uint32_t max_elems = vext_max_elems(desc, log2_esz);
+    uint32_t esz = 1 << log2_esz;
+    uint32_t vma = vext_vma(desc);
+    target_ulong addr, size;
+    int mmu_index = riscv_env_mmu_index(env, false);
+    MMUAccessType access_type = is_load ? MMU_DATA_LOAD : MMU_DATA_STORE;
+    void *host;
+    int flags;
+
+    VSTART_CHECK_EARLY_EXIT(env);
+
+    addr = base + ((env->vstart * nf) << log2_esz);
+    size = ((env->vl - env->vstart) * nf) << log2_esz;
+    if (size > -(addr | TARGET_PAGE_MASK)) {
+        goto slow;
+    }
+    flags = probe_access_flags(env, adjust_addr(env, addr), size, access_type,
+                               mmu_index, true, &host, ra);
+    if (flags != 0) {
+        goto slow;
+    }
+
+    for (i = env->vstart; i < env->vl; i++) {
+        if (!vext_elem_mask(v0, i)) {
+            /* set masked-off elements to 1s */
+            for (k = 0; k < nf; k++) {
+                vext_set_elems_1s(vd, vma, (i + k * max_elems) * esz,
+                                  (i + k * max_elems + 1) * esz);
+            }
+            host += nf << log2_esz;
+            continue;
+        }
+        for (k = 0; k < nf; k++) {
+            ldst_host(vd, i + k * max_elems, host);
+            host += esz;
+        }
+    }
+    env->vstart = 0;
+
+    vext_set_tail_elems_1s(env->vl, vd, desc, nf, esz, max_elems);
+    return;
+
+ slow:
+    vext_ldst_stride(vd, v0, base, nf << log2_esz, env, desc, false,
+                     ldst_tlb, log2_esz, ra);
+}
 
 #define GEN_VEXT_LD_US(NAME, ETYPE, LOAD_FN_TLB, LOAD_FN_HOST)      \
 void HELPER(NAME##_mask)(void *vd, void *v0, target_ulong base,     \
                          CPURISCVState *env, uint32_t desc)         \
 {                                                                   \
-    uint32_t stride = vext_nf(desc) << ctzl(sizeof(ETYPE));         \
-    vext_ldst_stride(vd, v0, base, stride, env, desc, false,        \
-                     LOAD_FN_TLB, ctzl(sizeof(ETYPE)), GETPC());    \
+    vext_ldst_us_mask(vd, v0, base, env, desc, LOAD_FN_TLB,         \
+                      LOAD_FN_HOST, ctzl(sizeof(ETYPE)), GETPC(),   \
+                      true);                                        \
 }                                                                   \
                                                                     \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,            \
@@ -463,9 +522,9 @@ GEN_VEXT_LD_US(vle64_v, int64_t, lde_d_tlb, lde_d_host)
 void HELPER(NAME##_mask)(void *vd, void *v0, target_ulong base,          \
                          CPURISCVState *env, uint32_t desc)              \
 {                                                                        \
-    uint32_t stride = vext_nf(desc) << ctzl(sizeof(ETYPE));              \
-    vext_ldst_stride(vd, v0, base, stride, env, desc, false,             \
-                     STORE_FN_TLB, ctzl(sizeof(ETYPE)), GETPC());        \
+    vext_ldst_us_mask(vd, v0, base, env, desc, STORE_FN_TLB,             \
+                      STORE_FN_HOST, ctzl(sizeof(ETYPE)), GETPC(),       \
+                      false);                                            \
 }                                                                        \
                                                                          \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,                 \
@@ -881,6 +940,98 @@ GEN_VEXT_ST_WHOLE(vs8r_v, int8_t, ste_b_tlb, ste_b_host)
 #define DO_SUB(N, M) (N - M)
 #define DO_RSUB(N, M) (M - N)
 
+/*
+ * The simplest integer operations are expanded inline with gvec only when
+ * vl is VLMAX and the instruction is unmasked, and otherwise go through
+ * do_vext_vv/do_vext_vx with an indirect call per element.  Loops with
+ * a tail strip or a mask spend most of their time there, so these helpers
+ * inline the element operation instead, and keep the unmasked loop free of
+ * mask tests so that the compiler can use host SIMD instructions for it.
+ */
+static inline QEMU_ALWAYS_INLINE void
+vext_vv_inline(void *vd, void *v0, void *vs1, void *vs2,
+               CPURISCVState *env, uint32_t desc,
+               opivv2_fn *fn, uint32_t esz)
+{
+    uint32_t vm = vext_vm(desc);
+    uint32_t vl = env->vl;
+    uint32_t total_elems = vext_get_total_elems(env, desc, esz);
+    uint32_t vta = vext_vta(desc);
+    uint32_t vma = vext_vma(desc);
+    uint32_t i;
+
+    VSTART_CHECK_EARLY_EXIT(env);
+
+    if (vm) {
+        for (i = env->vstart; i < vl; i++) {
+            fn(vd, vs1, vs2, i);
+        }
+    } else {
+        for (i = env->vstart; i < vl; i++) {
+            if (!vext_elem_mask(v0, i)) {
+                /* set masked-off elements to 1s */
+                vext_set_elems_1s(vd, vma, i * esz, (i + 1) * esz);
+                continue;
+            }
+            fn(vd, vs1, vs2, i);
+        }
+    }
+    env->vstart = 0;
+    /* set tail elements to 1s */
+    vext_set_elems_1s(vd, vta, vl * esz, total_elems * esz);
+}
+
+static inline QEMU_ALWAYS_INLINE void
+vext_vx_inline(void *vd, void *v0, target_long s1, void *vs2,
+               CPURISCVState *env, uint32_t desc,
+               opivx2_fn *fn, uint32_t esz)
+{
+    uint32_t vm = vext_vm(desc);
+    uint32_t vl = env->vl;
+    uint32_t total_elems = vext_get_total_elems(env, desc, esz);
+    uint32_t vta = vext_vta(desc);
+    uint32_t vma = vext_vma(desc);
+    uint32_t i;
+
+    VSTART_CHECK_EARLY_EXIT(env);
+
+    if (vm) {
+        for (i = env->vstart; i < vl; i++) {
+            fn(vd, s1, vs2, i);
+        }
+    } else {
+        for (i = env->vstart; i < vl; i++) {
+            if (!vext_elem_mask(v0, i)) {
+                /* set masked-off elements to 1s */
+                vext_set_elems_1s(vd, vma, i * esz, (i + 1) * esz);
+                continue;
+            }
+            fn(vd, s1, vs2, i);
+        }
+    }
+    env->vstart = 0;
+    /* set tail elements to 1s */
+    vext_set_elems_1s(vd, vta, vl * esz, total_elems * esz);
+}
+
+#define GEN_VEXT_VV_INLINE(NAME, ESZ)                     \
+void HELPER(NAME)(void *vd, void *v0, void *vs1,          \
+                  void *vs2, CPURISCVState *env,          \
+                  uint32_t desc)                          \
+{                                                         \
+    vext_vv_inline(vd, v0, vs1, vs2, env, desc,           \
+                   do_##NAME, ESZ);                       \
+}
+
+#define GEN_VEXT_VX_INLINE(NAME, ESZ)                     \
+void HELPER(NAME)(void *vd, void *v0, target_ulong s1,    \
+                  void *vs2, CPURISCVState *env,          \
+                  uint32_t desc)                          \
+{                                                         \
+    vext_vx_inline(vd, v0, s1, vs2, env, desc,            \
+                   do_##NAME, ESZ);                       \
+}
+
 RVVCALL(OPIVV2, vadd_vv_b, OP_SSS_B, H1, H1, H1, DO_ADD)
 RVVCALL(OPIVV2, vadd_vv_h, OP_SSS_H, H2, H2, H2, DO_ADD)
 RVVCALL(OPIVV2, vadd_vv_w, OP_SSS_W, H4, H4, H4, DO_ADD)
@@ -890,14 +1041,14 @@ RVVCALL(OPIVV2, vsub_vv_h, OP_SSS_H, H2, H2, H2, DO_SUB)
 RVVCALL(OPIVV2, vsub_vv_w, OP_SSS_W, H4, H4, H4, DO_SUB)
 RVVCALL(OPIVV2, vsub_vv_d, OP_SSS_D, H8, H8, H8, DO_SUB)
 
-GEN_VEXT_VV(vadd_vv_b, 1)
-GEN_VEXT_VV(vadd_vv_h, 2)
-GEN_VEXT_VV(vadd_vv_w, 4)
-GEN_VEXT_VV(vadd_vv_d, 8)
-GEN_VEXT_VV(vsub_vv_b, 1)
-GEN_VEXT_VV(vsub_vv_h, 2)
-GEN_VEXT_VV(vsub_vv_w, 4)
-GEN_VEXT_VV(vsub_vv_d, 8)
+GEN_VEXT_VV_INLINE(vadd_vv_b, 1)
+GEN_VEXT_VV_INLINE(vadd_vv_h, 2)
+GEN_VEXT_VV_INLINE(vadd_vv_w, 4)
+GEN_VEXT_VV_INLINE(vadd_vv_d, 8)
+GEN_VEXT_VV_INLINE(vsub_vv_b, 1)
+GEN_VEXT_VV_INLINE(vsub_vv_h, 2)
+GEN_VEXT_VV_INLINE(vsub_vv_w, 4)
+GEN_VEXT_VV_INLINE(vsub_vv_d, 8)
 
 
 RVVCALL(OPIVX2, vadd_vx_b, OP_SSS_B, H1, H1, DO_ADD)
@@ -913,18 +1064,18 @@ RVVCALL(OPIVX2, vrsub_vx_h, OP_SSS_H, H2, H2, DO_RSUB)
 RVVCALL(OPIVX2, vrsub_vx_w, OP_SSS_W, H4, H4, DO_RSUB)
 RVVCALL(OPIVX2, vrsub_vx_d, OP_SSS_D, H8, H8, DO_RSUB)
 
-GEN_VEXT_VX(vadd_vx_b, 1)
-GEN_VEXT_VX(vadd_vx_h, 2)
-GEN_VEXT_VX(vadd_vx_w, 4)
-GEN_VEXT_VX(vadd_vx_d, 8)
-GEN_VEXT_VX(vsub_vx_b, 1)
-GEN_VEXT_VX(vsub_vx_h, 2)
-GEN_VEXT_VX(vsub_vx_w, 4)
-GEN_VEXT_VX(vsub_vx_d, 8)
-GEN_VEXT_VX(vrsub_vx_b, 1)
-GEN_VEXT_VX(vrsub_vx_h, 2)
-GEN_VEXT_VX(vrsub_vx_w, 4)
-GEN_VEXT_VX(vrsub_vx_d, 8)
+GEN_VEXT_VX_INLINE(vadd_vx_b, 1)
+GEN_VEXT_VX_INLINE(vadd_vx_h, 2)
+GEN_VEXT_VX_INLINE(vadd_vx_w, 4)
+GEN_VEXT_VX_INLINE(vadd_vx_d, 8)
+GEN_VEXT_VX_INLINE(vsub_vx_b, 1)
+GEN_VEXT_VX_INLINE(vsub_vx_h, 2)
+GEN_VEXT_VX_INLINE(vsub_vx_w, 4)
+GEN_VEXT_VX_INLINE(vsub_vx_d, 8)
+GEN_VEXT_VX_INLINE(vrsub_vx_b, 1)
+GEN_VEXT_VX_INLINE(vrsub_vx_h, 2)
+GEN_VEXT_VX_INLINE(vrsub_vx_w, 4)
+GEN_VEXT_VX_INLINE(vrsub_vx_d, 8)
 
 void HELPER(vec_rsubs8)(void *d, void *a, uint64_t b, uint32_t desc)
 {
@@ -1246,18 +1397,18 @@ RVVCALL(OPIVV2, vxor_vv_b, OP_SSS_B, H1, H1, H1, DO_XOR)
 RVVCALL(OPIVV2, vxor_vv_h, OP_SSS_H, H2, H2, H2, DO_XOR)
 RVVCALL(OPIVV2, vxor_vv_w, OP_SSS_W, H4, H4, H4, DO_XOR)
 RVVCALL(OPIVV2, vxor_vv_d, OP_SSS_D, H8, H8, H8, DO_XOR)
-GEN_VEXT_VV(vand_vv_b, 1)
-GEN_VEXT_VV(vand_vv_h, 2)
-GEN_VEXT_VV(vand_vv_w, 4)
-GEN_VEXT_VV(vand_vv_d, 8)
-GEN_VEXT_VV(vor_vv_b, 1)
-GEN_VEXT_VV(vor_vv_h, 2)
-GEN_VEXT_VV(vor_vv_w, 4)
-GEN_VEXT_VV(vor_vv_d, 8)
-GEN_VEXT_VV(vxor_vv_b, 1)
-GEN_VEXT_VV(vxor_vv_h, 2)
-GEN_VEXT_VV(vxor_vv_w, 4)
-GEN_VEXT_VV(vxor_vv_d, 8)
+GEN_VEXT_VV_INLINE(vand_vv_b, 1)
+GEN_VEXT_VV_INLINE(vand_vv_h, 2)
+GEN_VEXT_VV_INLINE(vand_vv_w, 4)
+GEN_VEXT_VV_INLINE(vand_vv_d, 8)
+GEN_VEXT_VV_INLINE(vor_vv_b, 1)
+GEN_VEXT_VV_INLINE(vor_vv_h, 2)
+GEN_VEXT_VV_INLINE(vor_vv_w, 4)
+GEN_VEXT_VV_INLINE(vor_vv_d, 8)
+GEN_VEXT_VV_INLINE(vxor_vv_b, 1)
+GEN_VEXT_VV_INLINE(vxor_vv_h, 2)
+GEN_VEXT_VV_INLINE(vxor_vv_w, 4)
+GEN_VEXT_VV_INLINE(vxor_vv_d, 8)
 
 RVVCALL(OPIVX2, vand_vx_b, OP_SSS_B, H1, H1, DO_AND)
 RVVCALL(OPIVX2, vand_vx_h, OP_SSS_H, H2, H2, DO_AND)
@@ -1271,18 +1422,18 @@ RVVCALL(OPIVX2, vxor_vx_b, OP_SSS_B, H1, H1, DO_XOR)
 RVVCALL(OPIVX2, vxor_vx_h, OP_SSS_H, H2, H2, DO_XOR)
 RVVCALL(OPIVX2, vxor_vx_w, OP_SSS_W, H4, H4, DO_XOR)
 RVVCALL(OPIVX2, vxor_vx_d, OP_SSS_D, H8, H8, DO_XOR)
-GEN_VEXT_VX(vand_vx_b, 1)
-GEN_VEXT_VX(vand_vx_h, 2)
-GEN_VEXT_VX(vand_vx_w, 4)
-GEN_VEXT_VX(vand_vx_d, 8)
-GEN_VEXT_VX(vor_vx_b, 1)
-GEN_VEXT_VX(vor_vx_h, 2)
-GEN_VEXT_VX(vor_vx_w, 4)
-GEN_VEXT_VX(vor_vx_d, 8)
-GEN_VEXT_VX(vxor_vx_b, 1)
-GEN_VEXT_VX(vxor_vx_h, 2)
-GEN_VEXT_VX(vxor_vx_w, 4)
-GEN_VEXT_VX(vxor_vx_d, 8)
+GEN_VEXT_VX_INLINE(vand_vx_b, 1)
+GEN_VEXT_VX_INLINE(vand_vx_h, 2)
+GEN_VEXT_VX_INLINE(vand_vx_w, 4)
+GEN_VEXT_VX_INLINE(vand_vx_d, 8)
+GEN_VEXT_VX_INLINE(vor_vx_b, 1)
+GEN_VEXT_VX_INLINE(vor_vx_h, 2)
+GEN_VEXT_VX_INLINE(vor_vx_w, 4)
+GEN_VEXT_VX_INLINE(vor_vx_d, 8)
+GEN_VEXT_VX_INLINE(vxor_vx_b, 1)
+GEN_VEXT_VX_INLINE(vxor_vx_h, 2)
+GEN_VEXT_VX_INLINE(vxor_vx_w, 4)
+GEN_VEXT_VX_INLINE(vxor_vx_d, 8)
 
 /* Vector Single-Width Bit Shift Instructions */
 #define DO_SLL(N, M)  (N << (M))
@@ -1564,22 +1715,22 @@ RVVCALL(OPIVV2, vmax_vv_b, OP_SSS_B, H1, H1, H1, DO_MAX)
 RVVCALL(OPIVV2, vmax_vv_h, OP_SSS_H, H2, H2, H2, DO_MAX)
 RVVCALL(OPIVV2, vmax_vv_w, OP_SSS_W, H4, H4, H4, DO_MAX)
 RVVCALL(OPIVV2, vmax_vv_d, OP_SSS_D, H8, H8, H8, DO_MAX)
-GEN_VEXT_VV(vminu_vv_b, 1)
-GEN_VEXT_VV(vminu_vv_h, 2)
-GEN_VEXT_VV(vminu_vv_w, 4)
-GEN_VEXT_VV(vminu_vv_d, 8)
-GEN_VEXT_VV(vmin_vv_b, 1)
-GEN_VEXT_VV(vmin_vv_h, 2)
-GEN_VEXT_VV(vmin_vv_w, 4)
-GEN_VEXT_VV(vmin_vv_d, 8)
-GEN_VEXT_VV(vmaxu_vv_b, 1)
-GEN_VEXT_VV(vmaxu_vv_h, 2)
-GEN_VEXT_VV(vmaxu_vv_w, 4)
-GEN_VEXT_VV(vmaxu_vv_d, 8)
-GEN_VEXT_VV(vmax_vv_b, 1)
-GEN_VEXT_VV(vmax_vv_h, 2)
-GEN_VEXT_VV(vmax_vv_w, 4)
-GEN_VEXT_VV(vmax_vv_d, 8)
+GEN_VEXT_VV_INLINE(vminu_vv_b, 1)
+GEN_VEXT_VV_INLINE(vminu_vv_h, 2)
+GEN_VEXT_VV_INLINE(vminu_vv_w, 4)
+GEN_VEXT_VV_INLINE(vminu_vv_d, 8)
+GEN_VEXT_VV_INLINE(vmin_vv_b, 1)
+GEN_VEXT_VV_INLINE(vmin_vv_h, 2)
+GEN_VEXT_VV_INLINE(vmin_vv_w, 4)
+GEN_VEXT_VV_INLINE(vmin_vv_d, 8)
+GEN_VEXT_VV_INLINE(vmaxu_vv_b, 1)
+GEN_VEXT_VV_INLINE(vmaxu_vv_h, 2)
+GEN_VEXT_VV_INLINE(vmaxu_vv_w, 4)
+GEN_VEXT_VV_INLINE(vmaxu_vv_d, 8)
+GEN_VEXT_VV_INLINE(vmax_vv_b, 1)
+GEN_VEXT_VV_INLINE(vmax_vv_h, 2)
+GEN_VEXT_VV_INLINE(vmax_vv_w, 4)
+GEN_VEXT_VV_INLINE(vmax_vv_d, 8)
 
 RVVCALL(OPIVX2, vminu_vx_b, OP_UUU_B, H1, H1, DO_MIN)
 RVVCALL(OPIVX2, vminu_vx_h, OP_UUU_H, H2, H2, DO_MIN)
@@ -1597,22 +1748,22 @@ RVVCALL(OPIVX2, vmax_vx_b, OP_SSS_B, H1, H1, DO_MAX)
 RVVCALL(OPIVX2, vmax_vx_h, OP_SSS_H, H2, H2, DO_MAX)
 RVVCALL(OPIVX2, vmax_vx_w, OP_SSS_W, H4, H4, DO_MAX)
 RVVCALL(OPIVX2, vmax_vx_d, OP_SSS_D, H8, H8, DO_MAX)
-GEN_VEXT_VX(vminu_vx_b, 1)
-GEN_VEXT_VX(vminu_vx_h, 2)
-GEN_VEXT_VX(vminu_vx_w, 4)
-GEN_VEXT_VX(vminu_vx_d, 8)
-GEN_VEXT_VX(vmin_vx_b, 1)
-GEN_VEXT_VX(vmin_vx_h, 2)
-GEN_VEXT_VX(vmin_vx_w, 4)
-GEN_VEXT_VX(vmin_vx_d, 8)
-GEN_VEXT_VX(vmaxu_vx_b, 1)
-GEN_VEXT_VX(vmaxu_vx_h, 2)
-GEN_VEXT_VX(vmaxu_vx_w, 4)
-GEN_VEXT_VX(vmaxu_vx_d, 8)
-GEN_VEXT_VX(vmax_vx_b, 1)
-GEN_VEXT_VX(vmax_vx_h, 2)
-GEN_VEXT_VX(vmax_vx_w, 4)
-GEN_VEXT_VX(vmax_vx_d, 8)
+GEN_VEXT_VX_INLINE(vminu_vx_b, 1)
+GEN_VEXT_VX_INLINE(vminu_vx_h, 2)
+GEN_VEXT_VX_INLINE(vminu_vx_w, 4)
+GEN_VEXT_VX_INLINE(vminu_vx_d, 8)
+GEN_VEXT_VX_INLINE(vmin_vx_b, 1)
+GEN_VEXT_VX_INLINE(vmin_vx_h, 2)
+GEN_VEXT_VX_INLINE(vmin_vx_w, 4)
+GEN_VEXT_VX_INLINE(vmin_vx_d, 8)
+GEN_VEXT_VX_INLINE(vmaxu_vx_b, 1)
+GEN_VEXT_VX_INLINE(vmaxu_vx_h, 2)
+GEN_VEXT_VX_INLINE(vmaxu_vx_w, 4)
+GEN_VEXT_VX_INLINE(vmaxu_vx_d, 8)
+GEN_VEXT_VX_INLINE(vmax_vx_b, 1)
+GEN_VEXT_VX_INLINE(vmax_vx_h, 2)
+GEN_VEXT_VX_INLINE(vmax_vx_w, 4)
+GEN_VEXT_VX_INLINE(vmax_vx_d, 8)
 
 /* Vector Single-Width Integer Multiply Instructions */
 #define DO_MUL(N, M) (N * M)
@@ -1620,10 +1771,10 @@ RVVCALL(OPIVV2, vmul_vv_b, OP_SSS_B, H1, H1, H1, DO_MUL)
 RVVCALL(OPIVV2, vmul_vv_h, OP_SSS_H, H2, H2, H2, DO_MUL)
 RVVCALL(OPIVV2, vmul_vv_w, OP_SSS_W, H4, H4, H4, DO_MUL)
 RVVCALL(OPIVV2, vmul_vv_d, OP_SSS_D, H8, H8, H8, DO_MUL)
-GEN_VEXT_VV(vmul_vv_b, 1)
-GEN_VEXT_VV(vmul_vv_h, 2)
-GEN_VEXT_VV(vmul_vv_w, 4)
-GEN_VEXT_VV(vmul_vv_d, 8)
+GEN_VEXT_VV_INLINE(vmul_vv_b, 1)
+GEN_VEXT_VV_INLINE(vmul_vv_h, 2)
+GEN_VEXT_VV_INLINE(vmul_vv_w, 4)
+GEN_VEXT_VV_INLINE(vmul_vv_d, 8)
 
 static int8_t do_mulh_b(int8_t s2, int8_t s1)
 {
@@ -1756,10 +1907,10 @@ RVVCALL(OPIVX2, vmulhsu_vx_b, OP_SUS_B, H1, H1, do_mulhsu_b)
 RVVCALL(OPIVX2, vmulhsu_vx_h, OP_SUS_H, H2, H2, do_mulhsu_h)
 RVVCALL(OPIVX2, vmulhsu_vx_w, OP_SUS_W, H4, H4, do_mulhsu_w)
 RVVCALL(OPIVX2, vmulhsu_vx_d, OP_SUS_D, H8, H8, do_mulhsu_d)
-GEN_VEXT_VX(vmul_vx_b, 1)
-GEN_VEXT_VX(vmul_vx_h, 2)
-GEN_VEXT_VX(vmul_vx_w, 4)
-GEN_VEXT_VX(vmul_vx_d, 8)
+GEN_VEXT_VX_INLINE(vmul_vx_b, 1)
+GEN_VEXT_VX_INLINE(vmul_vx_h, 2)
+GEN_VEXT_VX_INLINE(vmul_vx_w, 4)
+GEN_VEXT_VX_INLINE(vmul_vx_d, 8)
 GEN_VEXT_VX(vmulh_vx_b, 1)
 GEN_VEXT_VX(vmulh_vx_h, 2)
 GEN_VEXT_VX(vmulh_vx_w, 4)
@@ -57,6 +57,9 @@ struct tcg_region_tree {
  * dynamically allocate from as demand dictates. Given appropriate region
  * sizing, this minimizes flushes even when some TCG threads generate a lot
  * more code than others.
+ *
+ * Once all regions are handed out, the oldest full region can be evicted
+ * and reused instead of flushing the whole buffer; see tcg_region_evict().
  */
 struct tcg_region_state {
     QemuMutex lock;
@@ -70,8 +73,9 @@ struct tcg_region_state {
     size_t total_size; /* size of entire buffer, >= n * stride */
 
     /* fields protected by the lock */
-    size_t current; /* current region index */
     size_t agg_size_full; /* aggregate size of full regions */
+    uint64_t gen; /* number of region allocations so far */
+    uint64_t *region_gen; /* .gen when each region was allocated, 0 if free */
 };
 
 static struct tcg_region_state region;
@@ -191,10 +195,24 @@ static void tcg_region_trees_init(void)
     }
 }
 
-static struct tcg_region_tree *tc_ptr_to_region_tree(const void *p)
+/* @p must point into the rw view of the buffer */
+static size_t tc_ptr_to_region_idx(const void *p)
 {
-    size_t region_idx;
+    ptrdiff_t offset;
+
+    if (p < region.start_aligned) {
+        return 0;
+    }
 
+    offset = p - region.start_aligned;
+    if (offset > region.stride * (region.n - 1)) {
+        return region.n - 1;
+    }
+    return offset / region.stride;
+}
+
+static struct tcg_region_tree *tc_ptr_to_region_tree(const void *p)
+{
     /*
      * Like tcg_splitwx_to_rw, with no assert.  The pc may come from
      * a signal handler over which the caller has no control.
@@ -206,18 +224,7 @@ static struct tcg_region_tree *tc_ptr_to_region_tree(const void *p)
         }
     }
 
-    if (p < region.start_aligned) {
-        region_idx = 0;
-    } else {
-        ptrdiff_t offset = p - region.start_aligned;
-
-        if (offset > region.stride * (region.n - 1)) {
-            region_idx = region.n - 1;
-        } else {
-            region_idx = offset / region.stride;
-        }
-    }
-    return region_trees + region_idx * tree_size;
+    return region_trees + tc_ptr_to_region_idx(p) * tree_size;
 }
 
 void tcg_tb_insert(TranslationBlock *tb)
@@ -311,6 +318,14 @@ size_t tcg_nb_tbs(void)
     return nb_tbs;
 }
 
+/* Call with the tree's lock held */
+static void tcg_region_tree_reset(struct tcg_region_tree *rt)
+{
+    /* Increment the refcount first so that destroy acts as a reset */
+    q_tree_ref(rt->tree);
+    q_tree_destroy(rt->tree);
+}
+
 static void tcg_region_tree_reset_all(void)
 {
     size_t i;
@@ -319,9 +334,7 @@ static void tcg_region_tree_reset_all(void)
     for (i = 0; i < region.n; i++) {
         struct tcg_region_tree *rt = region_trees + i * tree_size;
 
-        /* Increment the refcount first so that destroy acts as a reset */
-        q_tree_ref(rt->tree);
-        q_tree_destroy(rt->tree);
+        tcg_region_tree_reset(rt);
     }
     tcg_region_tree_unlock_all();
 }
@@ -357,13 +370,28 @@ static void tcg_region_assign(TCGContext *s, size_t curr_region)
     s->code_gen_highwater = end - TCG_HIGHWATER;
 }
 
+/* Returns the lowest free region, or region.n if there is none */
+static size_t tcg_region_find_free__locked(void)
+{
+    size_t i;
+
+    for (i = 0; i < region.n; i++) {
+        if (!region.region_gen[i]) {
+            break;
+        }
+    }
+    return i;
+}
+
 static bool tcg_region_alloc__locked(TCGContext *s)
 {
-    if (region.current == region.n) {
+    size_t i = tcg_region_find_free__locked();
+
+    if (i == region.n) {
         return true;
     }
-    tcg_region_assign(s, region.current);
-    region.current++;
+    tcg_region_assign(s, i);
+    region.region_gen[i] = ++region.gen;
     return false;
 }
 
@@ -410,8 +438,8 @@ void tcg_region_reset_all(void)
     unsigned int i;
 
     qemu_mutex_lock(&region.lock);
-    region.current = 0;
     region.agg_size_full = 0;
+    memset(region.region_gen, 0, region.n * sizeof(*region.region_gen));
 
     for (i = 0; i < n_ctxs; i++) {
         TCGContext *s = qatomic_read(&tcg_ctxs[i]);
@@ -422,6 +450,61 @@ void tcg_region_reset_all(void)
     tcg_region_tree_reset_all();
 }
 
+/*
+ * Evict the oldest full region, i.e. the one that was allocated first
+ * and is not in use by any TCG context, so that it can be reused.
+ * @func is called for every TB in the region before its code is dropped;
+ * it must make the TB unreachable.
+ *
+ * Returns 1 if a region was evicted, 0 if a region is free already and
+ * nothing was done, or -1 if no region can be evicted, in which case the
+ * caller has to flush the whole buffer.
+ *
+ * Call from a safe-work context.
+ */
+int tcg_region_evict(GTraverseFunc func, gpointer user_data)
+{
+    unsigned int n_ctxs = qatomic_read(&tcg_cur_ctxs);
+    g_autofree bool *in_use = g_new0(bool, region.n);
+    struct tcg_region_tree *rt;
+    size_t i, victim = region.n;
+    void *start, *end;
+
+    qemu_mutex_lock(&region.lock);
+    if (tcg_region_find_free__locked() != region.n) {
+        qemu_mutex_unlock(&region.lock);
+        return 0;
+    }
+
+    for (i = 0; i < n_ctxs; i++) {
+        const TCGContext *s = qatomic_read(&tcg_ctxs[i]);
+
+        in_use[tc_ptr_to_region_idx(s->code_gen_buffer)] = true;
+    }
+    for (i = 0; i < region.n; i++) {
+        if (!in_use[i] && (victim == region.n ||
+                           region.region_gen[i] < region.region_gen[victim])) {
+            victim = i;
+        }
+    }
+    if (victim == region.n) {
+        qemu_mutex_unlock(&region.lock);
+        return -1;
+    }
+
+    tcg_region_bounds(victim, &start, &end);
+    region.agg_size_full -= end - start - TCG_HIGHWATER;
+    region.region_gen[victim] = 0;
+    qemu_mutex_unlock(&region.lock);
+
+    rt = region_trees + victim * tree_size;
+    qemu_mutex_lock(&rt->lock);
+    q_tree_foreach(rt->tree, func, user_data);
+    tcg_region_tree_reset(rt);
+    qemu_mutex_unlock(&rt->lock);
+    return 1;
+}
+
 static size_t tcg_n_regions(size_t tb_size, unsigned max_cpus)
 {
 #ifdef CONFIG_USER_ONLY
@@ -435,9 +518,12 @@ static size_t tcg_n_regions(size_t tb_size, unsigned max_cpus)
      * being of reasonable size. If that's not possible we make do by evenly
      * dividing the code_gen_buffer among the vCPUs.
      */
-    /* Use a single region if all we have is one vCPU thread */
+    /*
+     * With a single vCPU thread, still use a few regions so that a full
+     * buffer can be recycled one region at a time rather than flushed.
+     */
     if (max_cpus == 1 || !qemu_tcg_mttcg_enabled()) {
-        return 1;
+        return MAX(MIN(tb_size / (2 * MiB), 8), 1);
     }
 
     /*
@@ -808,6 +894,7 @@ void tcg_region_init(size_t tb_size, int splitwx, unsigned max_cpus)
 
     /* init the region struct */
     qemu_mutex_init(&region.lock);
+    region.region_gen = g_new0(uint64_t, region.n);
 
     /*
      * Set guard pages in the rw buffer, as that's the one into which
@@ -352,6 +352,33 @@ static void tci_qemu_st(CPUArchState *env, uint64_t taddr, uint64_t val,
 # define CASE_64(x)
 #endif
 
+/*
+ * Threaded dispatch.  The most frequent opcodes, listed in the dispatch
+ * table of tcg_qemu_tb_exec, end by jumping straight to the handler of
+ * the next opcode instead of going back to the switch.  Each of them thus
+ * has its own indirect branch, which the host predicts far better than
+ * the single one shared by all opcodes.  The remaining opcodes still go
+ * through the switch.
+ */
+#if TCG_TARGET_REG_BITS == 64
+# define DISPATCH_32_64(x, label) \
+        [glue(glue(INDEX_op_, x), _i32)] = &&label, \
+        [glue(glue(INDEX_op_, x), _i64)] = &&label,
+# define DISPATCH_64(x, label) \
+        [glue(glue(INDEX_op_, x), _i64)] = &&label,
+#else
+# define DISPATCH_32_64(x, label) \
+        [glue(glue(INDEX_op_, x), _i32)] = &&label,
+# define DISPATCH_64(x, label)
+#endif
+
+#define NEXT()                                  \
+    do {                                        \
+        insn = *tb_ptr++;                       \
+        opc = extract32(insn, 0, 8);            \
+        goto *dispatch[opc];                    \
+    } while (0)
+
 /* Interpret pseudo code in tb. */
 /*
  * Disable CFI checks.
@@ -365,6 +392,49 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
     tcg_target_ulong regs[TCG_TARGET_NB_REGS];
     uint64_t stack[(TCG_STATIC_CALL_ARGS_SIZE + TCG_STATIC_FRAME_SIZE)
                    / sizeof(uint64_t)];
+    static const void * const dispatch[NB_OPS] = {
+        [0 ... NB_OPS - 1] = &&do_switch,
+        [INDEX_op_br] = &&op_br,
+        DISPATCH_32_64(mov, op_mov)
+        [INDEX_op_tci_movi] = &&op_movi,
+        [INDEX_op_tci_movl] = &&op_movl,
+        DISPATCH_32_64(ld8u, op_ld8u)
+        DISPATCH_32_64(ld8s, op_ld8s)
+        DISPATCH_32_64(ld16u, op_ld16u)
+        DISPATCH_32_64(ld16s, op_ld16s)
+        [INDEX_op_ld_i32] = &&op_ld32u,
+        DISPATCH_64(ld32u, op_ld32u)
+        DISPATCH_32_64(st8, op_st8)
+        DISPATCH_32_64(st16, op_st16)
+        [INDEX_op_st_i32] = &&op_st32,
+        DISPATCH_64(st32, op_st32)
+        DISPATCH_32_64(add, op_add)
+        DISPATCH_32_64(sub, op_sub)
+        DISPATCH_32_64(and, op_and)
+        DISPATCH_32_64(or, op_or)
+        DISPATCH_32_64(xor, op_xor)
+        [INDEX_op_shl_i32] = &&op_shl_i32,
+        [INDEX_op_shr_i32] = &&op_shr_i32,
+        [INDEX_op_sar_i32] = &&op_sar_i32,
+        [INDEX_op_brcond_i32] = &&op_brcond_i32,
+        [INDEX_op_tci_ld32_add] = &&op_ld32_add,
+        [INDEX_op_tci_brcond_i32] = &&op_setcond_brcond_i32,
+#if TCG_TARGET_REG_BITS == 64
+        [INDEX_op_ld32s_i64] = &&op_ld32s_i64,
+        [INDEX_op_ld_i64] = &&op_ld_i64,
+        [INDEX_op_st_i64] = &&op_st_i64,
+        [INDEX_op_shl_i64] = &&op_shl_i64,
+        [INDEX_op_shr_i64] = &&op_shr_i64,
+        [INDEX_op_sar_i64] = &&op_sar_i64,
+        [INDEX_op_brcond_i64] = &&op_brcond_i64,
+        [INDEX_op_ext32s_i64] = &&op_ext32s_i64,
+        [INDEX_op_ext_i32_i64] = &&op_ext32s_i64,
+        [INDEX_op_ext32u_i64] = &&op_ext32u_i64,
+        [INDEX_op_extu_i32_i64] = &&op_ext32u_i64,
+        [INDEX_op_tci_ld64_add] = &&op_ld64_add,
+        [INDEX_op_tci_brcond_i64] = &&op_setcond_brcond_i64,
+#endif
+    };
 
     regs[TCG_AREG0] = (tcg_target_ulong)env;
     regs[TCG_REG_CALL_STACK] = (uintptr_t)stack;
@@ -386,7 +456,9 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
 
         insn = *tb_ptr++;
         opc = extract32(insn, 0, 8);
+        goto *dispatch[opc];
 
+    do_switch:
         switch (opc) {
         case INDEX_op_call:
             {
@@ -442,9 +514,10 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             break;
 
         case INDEX_op_br:
+        op_br:
             tci_args_l(insn, tb_ptr, &ptr);
             tb_ptr = ptr;
-            continue;
+            NEXT();
         case INDEX_op_setcond_i32:
             tci_args_rrrc(insn, &r0, &r1, &r2, &condition);
             regs[r0] = tci_compare32(regs[r1], regs[r2], condition);
@@ -473,89 +546,113 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             break;
 #endif
         CASE_32_64(mov)
+        op_mov:
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = regs[r1];
-            break;
+            NEXT();
         case INDEX_op_tci_movi:
+        op_movi:
             tci_args_ri(insn, &r0, &t1);
             regs[r0] = t1;
-            break;
+            NEXT();
         case INDEX_op_tci_movl:
+        op_movl:
             tci_args_rl(insn, tb_ptr, &r0, &ptr);
             regs[r0] = *(tcg_target_ulong *)ptr;
-            break;
+            NEXT();
 
             /* Load/store operations (32 bit). */
 
         CASE_32_64(ld8u)
+        op_ld8u:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(uint8_t *)ptr;
-            break;
+            NEXT();
         CASE_32_64(ld8s)
+        op_ld8s:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(int8_t *)ptr;
-            break;
+            NEXT();
         CASE_32_64(ld16u)
+        op_ld16u:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(uint16_t *)ptr;
-            break;
+            NEXT();
         CASE_32_64(ld16s)
+        op_ld16s:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(int16_t *)ptr;
-            break;
+            NEXT();
         case INDEX_op_ld_i32:
         CASE_64(ld32u)
+        op_ld32u:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(uint32_t *)ptr;
-            break;
+            NEXT();
+        case INDEX_op_tci_ld32_add:
+        op_ld32_add:
+            /* ld_i32 or ld32u_i64, then the add in the next word */
+            tci_args_rrs(insn, &r0, &r1, &ofs);
+            ptr = (void *)(regs[r1] + ofs);
+            regs[r0] = *(uint32_t *)ptr;
+            insn = *tb_ptr++;
+            goto op_add;
         CASE_32_64(st8)
+        op_st8:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(uint8_t *)ptr = regs[r0];
-            break;
+            NEXT();
         CASE_32_64(st16)
+        op_st16:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(uint16_t *)ptr = regs[r0];
-            break;
+            NEXT();
         case INDEX_op_st_i32:
         CASE_64(st32)
+        op_st32:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(uint32_t *)ptr = regs[r0];
-            break;
+            NEXT();
 
             /* Arithmetic operations (mixed 32/64 bit). */
 
         CASE_32_64(add)
+        op_add:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] + regs[r2];
-            break;
+            NEXT();
         CASE_32_64(sub)
+        op_sub:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] - regs[r2];
-            break;
+            NEXT();
         CASE_32_64(mul)
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] * regs[r2];
             break;
         CASE_32_64(and)
+        op_and:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] & regs[r2];
-            break;
+            NEXT();
         CASE_32_64(or)
+        op_or:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] | regs[r2];
-            break;
+            NEXT();
         CASE_32_64(xor)
+        op_xor:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] ^ regs[r2];
-            break;
+            NEXT();
 #if TCG_TARGET_HAS_andc_i32 || TCG_TARGET_HAS_andc_i64
         CASE_32_64(andc)
             tci_args_rrr(insn, &r0, &r1, &r2);
@@ -629,17 +726,20 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             /* Shift/rotate operations (32 bit). */
 
         case INDEX_op_shl_i32:
+        op_shl_i32:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (uint32_t)regs[r1] << (regs[r2] & 31);
-            break;
+            NEXT();
         case INDEX_op_shr_i32:
+        op_shr_i32:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (uint32_t)regs[r1] >> (regs[r2] & 31);
-            break;
+            NEXT();
         case INDEX_op_sar_i32:
+        op_sar_i32:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (int32_t)regs[r1] >> (regs[r2] & 31);
-            break;
+            NEXT();
 #if TCG_TARGET_HAS_rot_i32
         case INDEX_op_rotl_i32:
             tci_args_rrr(insn, &r0, &r1, &r2);
@@ -669,11 +769,23 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             break;
 #endif
         case INDEX_op_brcond_i32:
+        op_brcond_i32:
             tci_args_rl(insn, tb_ptr, &r0, &ptr);
             if ((uint32_t)regs[r0]) {
                 tb_ptr = ptr;
             }
-            break;
+            NEXT();
+        case INDEX_op_tci_brcond_i32:
+        op_setcond_brcond_i32:
+            /* setcond_i32 into the brcond in the next word, which is taken */
+            tci_args_rrrc(insn, &r0, &r1, &r2, &condition);
+            tmp32 = tci_compare32(regs[r1], regs[r2], condition);
+            insn = *tb_ptr++;
+            tci_args_rl(insn, tb_ptr, &r0, &ptr);
+            if (tmp32) {
+                tb_ptr = ptr;
+            }
+            NEXT();
 #if TCG_TARGET_REG_BITS == 32 || TCG_TARGET_HAS_add2_i32
         case INDEX_op_add2_i32:
             tci_args_rrrrrr(insn, &r0, &r1, &r2, &r3, &r4, &r5);
@@ -755,20 +867,30 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             /* Load/store operations (64 bit). */
 
         case INDEX_op_ld32s_i64:
+        op_ld32s_i64:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(int32_t *)ptr;
-            break;
+            NEXT();
         case INDEX_op_ld_i64:
+        op_ld_i64:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(uint64_t *)ptr;
-            break;
+            NEXT();
+        case INDEX_op_tci_ld64_add:
+        op_ld64_add:
+            tci_args_rrs(insn, &r0, &r1, &ofs);
+            ptr = (void *)(regs[r1] + ofs);
+            regs[r0] = *(uint64_t *)ptr;
+            insn = *tb_ptr++;
+            goto op_add;
         case INDEX_op_st_i64:
+        op_st_i64:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(uint64_t *)ptr = regs[r0];
-            break;
+            NEXT();
 
             /* Arithmetic operations (64 bit). */
 
@@ -840,17 +962,20 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             /* Shift/rotate operations (64 bit). */
 
         case INDEX_op_shl_i64:
+        op_shl_i64:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] << (regs[r2] & 63);
-            break;
+            NEXT();
         case INDEX_op_shr_i64:
+        op_shr_i64:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] >> (regs[r2] & 63);
-            break;
+            NEXT();
         case INDEX_op_sar_i64:
+        op_sar_i64:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (int64_t)regs[r1] >> (regs[r2] & 63);
-            break;
+            NEXT();
 #if TCG_TARGET_HAS_rot_i64
         case INDEX_op_rotl_i64:
             tci_args_rrr(insn, &r0, &r1, &r2);
@@ -880,21 +1005,34 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             break;
 #endif
         case INDEX_op_brcond_i64:
+        op_brcond_i64:
             tci_args_rl(insn, tb_ptr, &r0, &ptr);
             if (regs[r0]) {
                 tb_ptr = ptr;
             }
-            break;
+            NEXT();
+        case INDEX_op_tci_brcond_i64:
+        op_setcond_brcond_i64:
+            tci_args_rrrc(insn, &r0, &r1, &r2, &condition);
+            tmp32 = tci_compare64(regs[r1], regs[r2], condition);
+            insn = *tb_ptr++;
+            tci_args_rl(insn, tb_ptr, &r0, &ptr);
+            if (tmp32) {
+                tb_ptr = ptr;
+            }
+            NEXT();
         case INDEX_op_ext32s_i64:
         case INDEX_op_ext_i32_i64:
+        op_ext32s_i64:
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = (int32_t)regs[r1];
-            break;
+            NEXT();
         case INDEX_op_ext32u_i64:
         case INDEX_op_extu_i32_i64:
+        op_ext32u_i64:
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = (uint32_t)regs[r1];
-            break;
+            NEXT();
 #if TCG_TARGET_HAS_bswap64_i64
         case INDEX_op_bswap64_i64:
             tci_args_rr(insn, &r0, &r1);
@@ -1116,6 +1254,8 @@ int print_insn_tci(bfd_vma addr, disassemble_info *info)
 
     case INDEX_op_setcond_i32:
     case INDEX_op_setcond_i64:
+    case INDEX_op_tci_brcond_i32:
+    case INDEX_op_tci_brcond_i64:
         tci_args_rrrc(insn, &r0, &r1, &r2, &c);
         info->fprintf_func(info->stream, "%-12s  %s, %s, %s, %s",
                            op_name, str_r(r0), str_r(r1), str_r(r2), str_c(c));
@@ -1152,6 +1292,8 @@ int print_insn_tci(bfd_vma addr, disassemble_info *info)
     case INDEX_op_st32_i64:
     case INDEX_op_st_i32:
     case INDEX_op_st_i64:
+    case INDEX_op_tci_ld32_add:
+    case INDEX_op_tci_ld64_add:
         tci_args_rrs(insn, &r0, &r1, &s2);
         info->fprintf_func(info->stream, "%-12s  %s, %s, %d",
                            op_name, str_r(r0), str_r(r1), s2);
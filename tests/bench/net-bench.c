@@ -0,0 +1,460 @@
+/*
+ * Benchmark of the net/ packet path with stand-in endpoints
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * A synthetic source sends UDP frames through a chain of filters and a
+ * hub to one or more sinks.  Each sink copies the frames, behind a virtio
+ * net header, into a fake receive ring that a "guest" drains after every
+ * burst.  When a ring is full the sink refuses the frame and it waits in
+ * the sink's NetQueue until the guest made room, as with virtio-net.
+ *
+ * The NetQueue is the real one, net/queue.c is built into the benchmark.
+ * The filters and the hub do the per-packet work of net/filter.c and
+ * net/hub.c but are stand-ins, since those only link with the emulator.
+ */
+#include "qemu/osdep.h"
+#include "qemu/iov.h"
+#include "qemu/timer.h"
+#include "net/net.h"
+#include "net/eth.h"
+#include "net/queue.h"
+#include "standard-headers/linux/virtio_net.h"
+
+#define MAX_SINKS 16
+#define MAX_SIZES 16
+#define FRAME_HDR_LEN (sizeof(struct eth_header) + sizeof(struct ip_header) + \
+                       sizeof(struct udp_hdr))
+
+typedef struct BenchRing {
+    uint8_t *buf;
+    size_t slot_size;
+    unsigned int size;
+    unsigned int used;
+} BenchRing;
+
+typedef struct BenchSink {
+    NetClientState nc;
+    BenchRing ring;
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t checksum;
+} BenchSink;
+
+typedef struct BenchHubPort {
+    NetClientState nc;
+} BenchHubPort;
+
+static unsigned int duration = 1;
+static unsigned int n_filters;
+static bool copy_filters;
+static unsigned int n_sinks = 1;
+static unsigned int ring_size = 256;
+static unsigned int burst = 64;
+static size_t sizes[MAX_SIZES] = { 64, 512, 1514 };
+static unsigned int n_sizes = 3;
+
+static NetClientState source;
+static BenchHubPort hub_ports[MAX_SINKS + 1];
+static BenchSink sinks[MAX_SINKS];
+static uint8_t filter_scratch[NET_BUFSIZE];
+static bool source_blocked;
+
+static const char commands_string[] =
+    " -d = duration of each run, in seconds\n"
+    " -f = number of filters on the source\n"
+    " -c = filters copy the packet, like filter-mirror, instead of\n"
+    "      only walking it, like filter-buffer with no interval\n"
+    " -n = number of sinks behind the hub (at most 16)\n"
+    " -r = receive ring size of each sink, in packets\n"
+    " -b = packets sent by the source before the guest drains the rings\n"
+    " -s = comma separated list of frame sizes (at most 16)";
+
+static void usage_complete(int argc, char *argv[])
+{
+    fprintf(stderr, "Usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "options:\n%s\n", commands_string);
+    exit(-1);
+}
+
+/* Same checks as in net/net.c, minus the VM run state */
+int qemu_can_send_packet(NetClientState *sender)
+{
+    NetClientState *peer = sender->peer;
+
+    if (!peer) {
+        return 1;
+    }
+    if (peer->receive_disabled) {
+        return 0;
+    }
+    if (peer->info->can_receive && !peer->info->can_receive(peer)) {
+        return 0;
+    }
+    return 1;
+}
+
+static ssize_t bench_deliver(NetClientState *sender, unsigned flags,
+                             const struct iovec *iov, int iovcnt,
+                             void *opaque)
+{
+    NetClientState *nc = opaque;
+    ssize_t ret;
+
+    if (nc->receive_disabled) {
+        return 0;
+    }
+
+    ret = nc->info->receive_iov(nc, iov, iovcnt);
+    if (ret == 0) {
+        nc->receive_disabled = 1;
+    }
+
+    return ret;
+}
+
+static void bench_filters(const struct iovec *iov, int iovcnt)
+{
+    unsigned int i;
+
+    for (i = 0; i < n_filters; i++) {
+        if (copy_filters) {
+            iov_to_buf(iov, iovcnt, 0, filter_scratch, sizeof(filter_scratch));
+        } else if (!iov_size(iov, iovcnt)) {
+            return;
+        }
+    }
+}
+
+static ssize_t bench_sendv(NetClientState *sender, const struct iovec *iov,
+                           int iovcnt, NetPacketSent *sent_cb)
+{
+    if (sender == &source) {
+        bench_filters(iov, iovcnt);
+    }
+
+    return qemu_net_queue_send_iov(sender->peer->incoming_queue, sender,
+                                   QEMU_NET_PACKET_FLAG_NONE, iov, iovcnt,
+                                   sent_cb);
+}
+
+static ssize_t hub_port_receive_iov(NetClientState *nc,
+                                    const struct iovec *iov, int iovcnt)
+{
+    BenchHubPort *port = container_of(nc, BenchHubPort, nc);
+    unsigned int i;
+
+    for (i = 0; i <= n_sinks; i++) {
+        if (&hub_ports[i] != port) {
+            bench_sendv(&hub_ports[i].nc, iov, iovcnt, NULL);
+        }
+    }
+
+    return iov_size(iov, iovcnt);
+}
+
+static bool hub_port_can_receive(NetClientState *nc)
+{
+    unsigned int i;
+
+    for (i = 0; i <= n_sinks; i++) {
+        if (&hub_ports[i].nc != nc &&
+            qemu_can_send_packet(&hub_ports[i].nc)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool sink_can_receive(NetClientState *nc)
+{
+    BenchSink *sink = container_of(nc, BenchSink, nc);
+
+    return sink->ring.used < sink->ring.size;
+}
+
+static ssize_t sink_receive_iov(NetClientState *nc,
+                                const struct iovec *iov, int iovcnt)
+{
+    BenchSink *sink = container_of(nc, BenchSink, nc);
+    BenchRing *ring = &sink->ring;
+    struct virtio_net_hdr_mrg_rxbuf *hdr;
+    size_t size;
+
+    if (ring->used == ring->size) {
+        return 0;
+    }
+
+    hdr = (void *)(ring->buf + ring->used * ring->slot_size);
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->num_buffers = 1;
+    size = iov_to_buf(iov, iovcnt, 0, hdr + 1,
+                      ring->slot_size - sizeof(*hdr));
+    ring->used++;
+
+    sink->packets++;
+    sink->bytes += size;
+
+    return size;
+}
+
+static NetClientInfo source_info = {
+    .type = NET_CLIENT_DRIVER_NONE,
+    .size = sizeof(NetClientState),
+};
+
+static NetClientInfo hub_port_info = {
+    .type = NET_CLIENT_DRIVER_HUBPORT,
+    .size = sizeof(BenchHubPort),
+    .can_receive = hub_port_can_receive,
+    .receive_iov = hub_port_receive_iov,
+};
+
+static NetClientInfo sink_info = {
+    .type = NET_CLIENT_DRIVER_NIC,
+    .size = sizeof(BenchSink),
+    .can_receive = sink_can_receive,
+    .receive_iov = sink_receive_iov,
+};
+
+static void bench_client_init(NetClientState *nc, NetClientInfo *info,
+                              NetClientState *peer)
+{
+    nc->info = info;
+    nc->peer = peer;
+    peer->peer = nc;
+    nc->incoming_queue = qemu_new_net_queue(bench_deliver, nc);
+}
+
+static void bench_init(void)
+{
+    unsigned int i;
+
+    bench_client_init(&source, &source_info, &hub_ports[0].nc);
+    hub_ports[0].nc.info = &hub_port_info;
+    hub_ports[0].nc.incoming_queue = qemu_new_net_queue(bench_deliver,
+                                                        &hub_ports[0].nc);
+
+    for (i = 0; i < n_sinks; i++) {
+        BenchSink *sink = &sinks[i];
+
+        bench_client_init(&sink->nc, &sink_info, &hub_ports[i + 1].nc);
+        hub_ports[i + 1].nc.info = &hub_port_info;
+        hub_ports[i + 1].nc.incoming_queue =
+            qemu_new_net_queue(bench_deliver, &hub_ports[i + 1].nc);
+
+        sink->ring.slot_size = sizeof(struct virtio_net_hdr_mrg_rxbuf) +
+                               NET_BUFSIZE;
+        sink->ring.size = ring_size;
+        sink->ring.buf = g_malloc0(sink->ring.slot_size * ring_size);
+    }
+}
+
+static void bench_cleanup(void)
+{
+    unsigned int i;
+
+    qemu_del_net_queue(source.incoming_queue);
+    for (i = 0; i <= n_sinks; i++) {
+        qemu_del_net_queue(hub_ports[i].nc.incoming_queue);
+    }
+    for (i = 0; i < n_sinks; i++) {
+        qemu_del_net_queue(sinks[i].nc.incoming_queue);
+        g_free(sinks[i].ring.buf);
+    }
+}
+
+/* Consume the ring like a guest driver would, then refill it */
+static void bench_guest_drain(BenchSink *sink)
+{
+    BenchRing *ring = &sink->ring;
+    unsigned int i;
+
+    for (i = 0; i < ring->used; i++) {
+        uint8_t *frame = ring->buf + i * ring->slot_size +
+                         sizeof(struct virtio_net_hdr_mrg_rxbuf);
+
+        sink->checksum += ldl_be_p(frame + FRAME_HDR_LEN);
+    }
+    ring->used = 0;
+
+    sink->nc.receive_disabled = 0;
+    qemu_net_queue_flush(sink->nc.incoming_queue);
+}
+
+static void bench_guest_drain_all(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < n_sinks; i++) {
+        bench_guest_drain(&sinks[i]);
+    }
+
+    /* The hub can take packets again, release what the source queued */
+    hub_ports[0].nc.receive_disabled = 0;
+    qemu_net_queue_flush(hub_ports[0].nc.incoming_queue);
+}
+
+static void source_sent(NetClientState *nc, ssize_t len)
+{
+    source_blocked = false;
+}
+
+static void build_frame(uint8_t *buf, size_t size)
+{
+    struct eth_header *eh = (struct eth_header *)buf;
+    struct ip_header *ip = (struct ip_header *)(eh + 1);
+    struct udp_hdr *udp = (struct udp_hdr *)(ip + 1);
+    static const uint8_t src_mac[ETH_ALEN] = { 0x52, 0x54, 0x00, 0, 0, 1 };
+    static const uint8_t dst_mac[ETH_ALEN] = { 0x52, 0x54, 0x00, 0, 0, 2 };
+
+    memset(buf, 0, size);
+    memcpy(eh->h_source, src_mac, ETH_ALEN);
+    memcpy(eh->h_dest, dst_mac, ETH_ALEN);
+    eh->h_proto = cpu_to_be16(ETH_P_IP);
+
+    ip->ip_ver_len = 0x45;
+    ip->ip_len = cpu_to_be16(size - sizeof(*eh));
+    ip->ip_ttl = 64;
+    ip->ip_p = IP_PROTO_UDP;
+    ip->ip_src = cpu_to_be32(0x0a000001);
+    ip->ip_dst = cpu_to_be32(0x0a000002);
+
+    udp->uh_sport = cpu_to_be16(4000);
+    udp->uh_dport = cpu_to_be16(5000);
+    udp->uh_ulen = cpu_to_be16(size - sizeof(*eh) - sizeof(*ip));
+}
+
+static void run(size_t size)
+{
+    g_autofree uint8_t *frame = g_malloc(size);
+    struct iovec iov = { .iov_base = frame, .iov_len = size };
+    uint64_t sent = 0, blocked = 0, packets = 0, bytes = 0;
+    NetQueueStats stats, total = { 0 };
+    int64_t start, now, end, ticks;
+    unsigned int i, seq = 0;
+    bool idle;
+
+    build_frame(frame, size);
+    for (i = 0; i < n_sinks; i++) {
+        sinks[i].packets = 0;
+        sinks[i].bytes = 0;
+    }
+
+    start = get_clock();
+    end = start + duration * NANOSECONDS_PER_SECOND;
+    ticks = cpu_get_host_ticks();
+    do {
+        for (i = 0; i < burst && !source_blocked; i++) {
+            stl_be_p(frame + FRAME_HDR_LEN, seq++);
+            if (bench_sendv(&source, &iov, 1, source_sent) == 0) {
+                source_blocked = true;
+                blocked++;
+            }
+            sent++;
+        }
+        bench_guest_drain_all();
+        now = get_clock();
+    } while (now < end);
+
+    /* Let the guest take what is still queued */
+    do {
+        bench_guest_drain_all();
+        idle = !source_blocked;
+        for (i = 0; i < n_sinks; i++) {
+            idle &= sinks[i].ring.used == 0;
+        }
+    } while (!idle);
+    ticks = cpu_get_host_ticks() - ticks;
+    now = get_clock();
+
+    for (i = 0; i < n_sinks; i++) {
+        packets += sinks[i].packets;
+        bytes += sinks[i].bytes;
+        qemu_net_queue_get_stats(sinks[i].nc.incoming_queue, &stats);
+        total.queued += stats.queued;
+        total.dropped += stats.dropped;
+        total.pool_exhausted += stats.pool_exhausted;
+    }
+
+    printf("%6zu %12.0f %12.0f %10.1f %12.1f %10" PRIu64 " %10" PRIu64
+           " %10" PRIu64 "\n",
+           size, sent * 1e9 / (now - start), packets * 1e9 / (now - start),
+           bytes * 8 / 1e6 * 1e3 / (now - start), (double)ticks / sent,
+           total.queued, total.dropped, blocked);
+}
+
+static void parse_sizes(const char *arg)
+{
+    g_auto(GStrv) list = g_strsplit(arg, ",", MAX_SIZES);
+    unsigned int i;
+
+    for (i = 0; list[i]; i++) {
+        sizes[i] = MIN(MAX(atol(list[i]), FRAME_HDR_LEN + 4), NET_BUFSIZE);
+    }
+    n_sizes = i;
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    int c;
+
+    for (;;) {
+        c = getopt(argc, argv, "b:cd:f:hn:r:s:");
+        if (c < 0) {
+            break;
+        }
+        switch (c) {
+        case 'b':
+            burst = MAX(atoi(optarg), 1);
+            break;
+        case 'c':
+            copy_filters = true;
+            break;
+        case 'd':
+            duration = atoi(optarg);
+            break;
+        case 'f':
+            n_filters = atoi(optarg);
+            break;
+        case 'h':
+            usage_complete(argc, argv);
+            exit(0);
+        case 'n':
+            n_sinks = MIN(MAX(atoi(optarg), 1), MAX_SINKS);
+            break;
+        case 'r':
+            ring_size = MAX(atoi(optarg), 1);
+            break;
+        case 's':
+            parse_sizes(optarg);
+            break;
+        default:
+            usage_complete(argc, argv);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int i;
+
+    parse_args(argc, argv);
+    bench_init();
+
+    printf("filters: %u (%s), sinks: %u, ring: %u, burst: %u, duration: %us\n",
+           n_filters, copy_filters ? "copy" : "walk", n_sinks, ring_size,
+           burst, duration);
+    printf("%6s %12s %12s %10s %12s %10s %10s %10s\n",
+           "size", "sent pps", "rx pps", "rx Mbit/s", "ticks/pkt",
+           "queued", "dropped", "blocked");
+    for (i = 0; i < n_sizes; i++) {
+        run(sizes[i]);
+    }
+
+    bench_cleanup();
+    return 0;
+}
@@ -34,6 +34,10 @@ enum op {
     OP_FMA,
     OP_SQRT,
     OP_CMP,
+    OP_MAX,
+    OP_TO_INT,
+    OP_FROM_INT,
+    OP_CVT,
     OP_MAX_NR,
 };
 
@@ -45,6 +49,10 @@ static const char * const op_names[] = {
     [OP_FMA] = "mulAdd",
     [OP_SQRT] = "sqrt",
     [OP_CMP] = "cmp",
+    [OP_MAX] = "max",
+    [OP_TO_INT] = "toint",
+    [OP_FROM_INT] = "fromint",
+    [OP_CVT] = "cvt",
     [OP_MAX_NR] = NULL,
 };
 
@@ -55,6 +63,8 @@ enum precision {
     PREC_FLOAT32,
     PREC_FLOAT64,
     PREC_FLOAT128,
+    PREC_FLOAT16,
+    PREC_BFLOAT16,
     PREC_MAX_NR,
 };
 
@@ -90,6 +100,8 @@ static const char * const tester_names[] = {
 union fp {
     float f;
     double d;
+    float16 f16;
+    bfloat16 bf16;
     float32 f32;
     float64 f64;
     float128 f128;
@@ -171,6 +183,24 @@ static void update_random_ops(int n_ops, enum precision prec)
             random_ops[i] = r;
             break;
         }
+        case PREC_FLOAT16:
+        {
+            uint64_t r = random_ops[i];
+            do {
+                r = xorshift64star(r);
+            } while (!float16_is_normal(r));
+            random_ops[i] = r;
+            break;
+        }
+        case PREC_BFLOAT16:
+        {
+            uint64_t r = random_ops[i];
+            do {
+                r = xorshift64star(r);
+            } while (!bfloat16_is_normal(r));
+            random_ops[i] = r;
+            break;
+        }
         case PREC_QUAD:
         case PREC_FLOAT128:
         {
@@ -219,6 +249,61 @@ static void fill_random(union fp *ops, int n_ops, enum precision prec,
                 ops[i].f128 = float128_chs(ops[i].f128);
             }
             break;
+        case PREC_FLOAT16:
+            ops[i].f16 = make_float16(random_ops[i]);
+            if (no_neg && float16_is_neg(ops[i].f16)) {
+                ops[i].f16 = float16_chs(ops[i].f16);
+            }
+            break;
+        case PREC_BFLOAT16:
+            ops[i].bf16 = random_ops[i];
+            if (no_neg && bfloat16_is_neg(ops[i].bf16)) {
+                ops[i].bf16 = bfloat16_chs(ops[i].bf16);
+            }
+            break;
+        default:
+            g_assert_not_reached();
+        }
+    }
+}
+
+/*
+ * Random normals are mostly out of the range of integers, so conversions
+ * use 24-bit signed integers instead: as is for OP_FROM_INT, and divided
+ * by 256 for OP_TO_INT so that most conversions are inexact.
+ */
+static void fill_random_int(union fp *ops, int n_ops, enum precision prec,
+                            enum op op)
+{
+    int i;
+
+    for (i = 0; i < n_ops; i++) {
+        int32_t v = (int32_t)random_ops[i] >> 8;
+
+        if (op == OP_FROM_INT) {
+            ops[i].u64 = (int64_t)v;
+            continue;
+        }
+        switch (prec) {
+        case PREC_SINGLE:
+        case PREC_FLOAT32:
+            ops[i].f32 = int32_to_float32_scalbn(v, -8, &soft_status);
+            break;
+        case PREC_DOUBLE:
+        case PREC_FLOAT64:
+            ops[i].f64 = int32_to_float64_scalbn(v, -8, &soft_status);
+            break;
+        case PREC_QUAD:
+        case PREC_FLOAT128:
+            ops[i].f128 = float128_scalbn(int32_to_float128(v, &soft_status),
+                                          -8, &soft_status);
+            break;
+        case PREC_FLOAT16:
+            ops[i].f16 = int32_to_float16_scalbn(v, -8, &soft_status);
+            break;
+        case PREC_BFLOAT16:
+            ops[i].bf16 = int32_to_bfloat16_scalbn(v, -8, &soft_status);
+            break;
         default:
             g_assert_not_reached();
         }
@@ -239,9 +324,13 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
         int i;
 
         update_random_ops(n_ops, prec);
+        if (op == OP_TO_INT || op == OP_FROM_INT) {
+            fill_random_int(ops, n_ops, prec, op);
+        } else {
+            fill_random(ops, n_ops, prec, no_neg);
+        }
         switch (prec) {
         case PREC_SINGLE:
-            fill_random(ops, n_ops, prec, no_neg);
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 float a = ops[0].f;
@@ -270,13 +359,24 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = isgreater(a, b);
                     break;
+                case OP_MAX:
+                    res.f = fmaxf(a, b);
+                    break;
+                case OP_TO_INT:
+                    res.u64 = llrintf(a);
+                    break;
+                case OP_FROM_INT:
+                    res.f = (int64_t)ops[0].u64;
+                    break;
+                case OP_CVT:
+                    res.d = a;
+                    break;
                 default:
                     g_assert_not_reached();
                 }
             }
             break;
         case PREC_DOUBLE:
-            fill_random(ops, n_ops, prec, no_neg);
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 double a = ops[0].d;
@@ -305,13 +405,24 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = isgreater(a, b);
                     break;
+                case OP_MAX:
+                    res.d = fmax(a, b);
+                    break;
+                case OP_TO_INT:
+                    res.u64 = llrint(a);
+                    break;
+                case OP_FROM_INT:
+                    res.d = (int64_t)ops[0].u64;
+                    break;
+                case OP_CVT:
+                    res.f = a;
+                    break;
                 default:
                     g_assert_not_reached();
                 }
             }
             break;
         case PREC_FLOAT32:
-            fill_random(ops, n_ops, prec, no_neg);
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 float32 a = ops[0].f32;
@@ -340,13 +451,24 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = float32_compare_quiet(a, b, &soft_status);
                     break;
+                case OP_MAX:
+                    res.f32 = float32_maxnum(a, b, &soft_status);
+                    break;
+                case OP_TO_INT:
+                    res.u64 = float32_to_int64(a, &soft_status);
+                    break;
+                case OP_FROM_INT:
+                    res.f32 = int64_to_float32(ops[0].u64, &soft_status);
+                    break;
+                case OP_CVT:
+                    res.f64 = float32_to_float64(a, &soft_status);
+                    break;
                 default:
                     g_assert_not_reached();
                 }
             }
             break;
         case PREC_FLOAT64:
-            fill_random(ops, n_ops, prec, no_neg);
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 float64 a = ops[0].f64;
@@ -375,13 +497,24 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = float64_compare_quiet(a, b, &soft_status);
                     break;
+                case OP_MAX:
+                    res.f64 = float64_maxnum(a, b, &soft_status);
+                    break;
+                case OP_TO_INT:
+                    res.u64 = float64_to_int64(a, &soft_status);
+                    break;
+                case OP_FROM_INT:
+                    res.f64 = int64_to_float64(ops[0].u64, &soft_status);
+                    break;
+                case OP_CVT:
+                    res.f32 = float64_to_float32(a, &soft_status);
+                    break;
                 default:
                     g_assert_not_reached();
                 }
             }
             break;
         case PREC_FLOAT128:
-            fill_random(ops, n_ops, prec, no_neg);
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 float128 a = ops[0].f128;
@@ -410,6 +543,110 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = float128_compare_quiet(a, b, &soft_status);
                     break;
+                case OP_MAX:
+                    res.f128 = float128_maxnum(a, b, &soft_status);
+                    break;
+                case OP_TO_INT:
+                    res.u64 = float128_to_int64(a, &soft_status);
+                    break;
+                case OP_FROM_INT:
+                    res.f128 = int64_to_float128(ops[0].u64, &soft_status);
+                    break;
+                case OP_CVT:
+                    res.f64 = float128_to_float64(a, &soft_status);
+                    break;
+                default:
+                    g_assert_not_reached();
+                }
+            }
+            break;
+        case PREC_FLOAT16:
+            t0 = get_clock();
+            for (i = 0; i < OPS_PER_ITER; i++) {
+                float16 a = ops[0].f16;
+                float16 b = ops[1].f16;
+                float16 c = ops[2].f16;
+
+                switch (op) {
+                case OP_ADD:
+                    res.f16 = float16_add(a, b, &soft_status);
+                    break;
+                case OP_SUB:
+                    res.f16 = float16_sub(a, b, &soft_status);
+                    break;
+                case OP_MUL:
+                    res.f16 = float16_mul(a, b, &soft_status);
+                    break;
+                case OP_DIV:
+                    res.f16 = float16_div(a, b, &soft_status);
+                    break;
+                case OP_FMA:
+                    res.f16 = float16_muladd(a, b, c, 0, &soft_status);
+                    break;
+                case OP_SQRT:
+                    res.f16 = float16_sqrt(a, &soft_status);
+                    break;
+                case OP_CMP:
+                    res.u64 = float16_compare_quiet(a, b, &soft_status);
+                    break;
+                case OP_MAX:
+                    res.f16 = float16_maxnum(a, b, &soft_status);
+                    break;
+                case OP_TO_INT:
+                    res.u64 = float16_to_int64(a, &soft_status);
+                    break;
+                case OP_FROM_INT:
+                    res.f16 = int64_to_float16(ops[0].u64, &soft_status);
+                    break;
+                case OP_CVT:
+                    res.f32 = float16_to_float32(a, true, &soft_status);
+                    break;
+                default:
+                    g_assert_not_reached();
+                }
+            }
+            break;
+        case PREC_BFLOAT16:
+            t0 = get_clock();
+            for (i = 0; i < OPS_PER_ITER; i++) {
+                bfloat16 a = ops[0].bf16;
+                bfloat16 b = ops[1].bf16;
+                bfloat16 c = ops[2].bf16;
+
+                switch (op) {
+                case OP_ADD:
+                    res.bf16 = bfloat16_add(a, b, &soft_status);
+                    break;
+                case OP_SUB:
+                    res.bf16 = bfloat16_sub(a, b, &soft_status);
+                    break;
+                case OP_MUL:
+                    res.bf16 = bfloat16_mul(a, b, &soft_status);
+                    break;
+                case OP_DIV:
+                    res.bf16 = bfloat16_div(a, b, &soft_status);
+                    break;
+                case OP_FMA:
+                    res.bf16 = bfloat16_muladd(a, b, c, 0, &soft_status);
+                    break;
+                case OP_SQRT:
+                    res.bf16 = bfloat16_sqrt(a, &soft_status);
+                    break;
+                case OP_CMP:
+                    res.u64 = bfloat16_compare_quiet(a, b, &soft_status);
+                    break;
+                case OP_MAX:
+                    res.bf16 = bfloat16_maxnum(a, b, &soft_status);
+                    break;
+                case OP_TO_INT:
+                    res.u64 = bfloat16_to_int64(a, &soft_status);
+                    break;
+                case OP_FROM_INT:
+                    res.bf16 = int64_to_bfloat16(ops[0].u64, &soft_status);
+                    break;
+                case OP_CVT:
+                    res.f32 = bfloat16_to_float32(a, &soft_status);
+                    break;
                 default:
                     g_assert_not_reached();
                 }
@@ -440,7 +677,9 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
     GEN_BENCH(bench_ ## opname ## _double, double, PREC_DOUBLE, op, n_ops) \
     GEN_BENCH(bench_ ## opname ## _float32, float32, PREC_FLOAT32, op, n_ops) \
     GEN_BENCH(bench_ ## opname ## _float64, float64, PREC_FLOAT64, op, n_ops) \
-    GEN_BENCH(bench_ ## opname ## _float128, float128, PREC_FLOAT128, op, n_ops)
+    GEN_BENCH(bench_ ## opname ## _float128, float128, PREC_FLOAT128, op, n_ops) \
+    GEN_BENCH(bench_ ## opname ## _float16, float16, PREC_FLOAT16, op, n_ops) \
+    GEN_BENCH(bench_ ## opname ## _bfloat16, bfloat16, PREC_BFLOAT16, op, n_ops)
 
 GEN_BENCH_ALL_TYPES(add, OP_ADD, 2)
 GEN_BENCH_ALL_TYPES(sub, OP_SUB, 2)
@@ -448,6 +687,10 @@ GEN_BENCH_ALL_TYPES(mul, OP_MUL, 2)
 GEN_BENCH_ALL_TYPES(div, OP_DIV, 2)
 GEN_BENCH_ALL_TYPES(fma, OP_FMA, 3)
 GEN_BENCH_ALL_TYPES(cmp, OP_CMP, 2)
+GEN_BENCH_ALL_TYPES(max, OP_MAX, 2)
+GEN_BENCH_ALL_TYPES(toint, OP_TO_INT, 1)
+GEN_BENCH_ALL_TYPES(fromint, OP_FROM_INT, 1)
+GEN_BENCH_ALL_TYPES(cvt, OP_CVT, 1)
 #undef GEN_BENCH_ALL_TYPES
 
 #define GEN_BENCH_ALL_TYPES_NO_NEG(name, op, n)                         \
@@ -455,7 +698,9 @@ GEN_BENCH_ALL_TYPES(cmp, OP_CMP, 2)
     GEN_BENCH_NO_NEG(bench_ ## name ## _double, double, PREC_DOUBLE, op, n) \
     GEN_BENCH_NO_NEG(bench_ ## name ## _float32, float32, PREC_FLOAT32, op, n) \
     GEN_BENCH_NO_NEG(bench_ ## name ## _float64, float64, PREC_FLOAT64, op, n) \
-    GEN_BENCH_NO_NEG(bench_ ## name ## _float128, float128, PREC_FLOAT128, op, n)
+    GEN_BENCH_NO_NEG(bench_ ## name ## _float128, float128, PREC_FLOAT128, op, n) \
+    GEN_BENCH_NO_NEG(bench_ ## name ## _float16, float16, PREC_FLOAT16, op, n) \
+    GEN_BENCH_NO_NEG(bench_ ## name ## _bfloat16, bfloat16, PREC_BFLOAT16, op, n)
 
 GEN_BENCH_ALL_TYPES_NO_NEG(sqrt, OP_SQRT, 1)
 #undef GEN_BENCH_ALL_TYPES_NO_NEG
@@ -470,6 +715,8 @@ GEN_BENCH_ALL_TYPES_NO_NEG(sqrt, OP_SQRT, 1)
         [PREC_FLOAT32]   = bench_ ## opname ## _float32,        \
         [PREC_FLOAT64]   = bench_ ## opname ## _float64,        \
         [PREC_FLOAT128]   = bench_ ## opname ## _float128,      \
+        [PREC_FLOAT16]   = bench_ ## opname ## _float16,        \
+        [PREC_BFLOAT16]  = bench_ ## opname ## _bfloat16,       \
     }
 
 static const bench_func_t bench_funcs[OP_MAX_NR][PREC_MAX_NR] = {
@@ -480,6 +727,10 @@ static const bench_func_t bench_funcs[OP_MAX_NR][PREC_MAX_NR] = {
     GEN_BENCH_FUNCS(fma, OP_FMA),
     GEN_BENCH_FUNCS(sqrt, OP_SQRT),
     GEN_BENCH_FUNCS(cmp, OP_CMP),
+    GEN_BENCH_FUNCS(max, OP_MAX),
+    GEN_BENCH_FUNCS(toint, OP_TO_INT),
+    GEN_BENCH_FUNCS(fromint, OP_FROM_INT),
+    GEN_BENCH_FUNCS(cvt, OP_CVT),
 };
 
 #undef GEN_BENCH_FUNCS
@@ -498,7 +749,11 @@ static void run_bench(void)
     set_float_default_nan_pattern(0b01000000, &soft_status);
 
     f = bench_funcs[operation][precision];
-    g_assert(f);
+    if (!f) {
+        fprintf(stderr, "fatal: '%s' not supported for this precision "
+                "and tester\n", op_names[operation]);
+        exit(EXIT_FAILURE);
+    }
     f();
 }
 
@@ -527,7 +782,8 @@ static void usage_complete(int argc, char *argv[])
     fprintf(stderr, " -h = show this help message.\n");
     fprintf(stderr, " -o = floating point operation (%s). Default: %s\n",
             op_list, op_names[0]);
-    fprintf(stderr, " -p = floating point precision (single, double, quad[soft only]). "
+    fprintf(stderr, " -p = floating point precision (single, double, "
+            "quad[soft only], half[soft only], bfloat16[soft only]). "
             "Default: single\n");
     fprintf(stderr, " -r = rounding mode (even, zero, down, up, tieaway). "
             "Default: even\n");
@@ -650,6 +906,10 @@ static void parse_args(int argc, char *argv[])
                 precision = PREC_DOUBLE;
             } else if (!strcmp(optarg, "quad")) {
                 precision = PREC_QUAD;
+            } else if (!strcmp(optarg, "half")) {
+                precision = PREC_FLOAT16;
+            } else if (!strcmp(optarg, "bfloat16")) {
+                precision = PREC_BFLOAT16;
             } else {
                 fprintf(stderr, "Unsupported precision '%s'\n", optarg);
                 exit(EXIT_FAILURE);
@@ -682,6 +942,11 @@ static void parse_args(int argc, char *argv[])
     /* set precision and rounding mode based on the tester */
     switch (tester) {
     case TESTER_HOST:
+        if (precision == PREC_FLOAT16 || precision == PREC_BFLOAT16) {
+            fprintf(stderr, "fatal: precision not supported by the host "
+                    "tester\n");
+            exit(EXIT_FAILURE);
+        }
         set_host_precision(rounding);
         break;
     case TESTER_SOFT:
@@ -696,6 +961,9 @@ static void parse_args(int argc, char *argv[])
         case PREC_QUAD:
             precision = PREC_FLOAT128;
             break;
+        case PREC_FLOAT16:
+        case PREC_BFLOAT16:
+            break;
         default:
             g_assert_not_reached();
         }
@@ -0,0 +1,225 @@
+/*
+ * SVE memcpy, strlen and gather kernels
+ *
+ * Contiguous loads and stores of each element size, first-fault loads and
+ * gathers, run at each supported vector length.  The results are checked
+ * and the throughput of each kernel is printed, which gives a rough idea
+ * of how fast these instructions are emulated.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/prctl.h>
+
+#define N       (64 * 1024 + 3)
+#define REPEAT  20
+
+static uint8_t src[N], dst[N];
+static uint64_t table[N / 8], idx[N / 8];
+
+static void sve_memcpy(void *d, const void *s, size_t n)
+{
+    size_t i = 0;
+
+    asm volatile("1: whilelo p0.b, %[i], %[n]\n\t"
+                 "b.none 2f\n\t"
+                 "ld1b {z0.b}, p0/z, [%[s], %[i]]\n\t"
+                 "st1b {z0.b}, p0, [%[d], %[i]]\n\t"
+                 "incb %[i]\n\t"
+                 "b 1b\n"
+                 "2:"
+                 : [i] "+r"(i)
+                 : [s] "r"(s), [d] "r"(d), [n] "r"(n)
+                 : "z0", "p0", "memory", "cc");
+}
+
+/*
+ * Copies and sums of 16, 32 and 64-bit elements.  The sums check that the
+ * loads produce the element values and not just the bytes in memory.
+ */
+#define SVE_ELEM(SUFF, ESZ, SHIFT)                                      \
+static void sve_memcpy_##SUFF(void *d, const void *s, size_t n)         \
+{                                                                       \
+    size_t i = 0;                                                       \
+                                                                        \
+    asm volatile("1: whilelo p0." ESZ ", %[i], %[n]\n\t"                \
+                 "b.none 2f\n\t"                                        \
+                 "ld1" #SUFF " {z0." ESZ "}, p0/z, "                    \
+                 "[%[s], %[i], lsl #" #SHIFT "]\n\t"                    \
+                 "st1" #SUFF " {z0." ESZ "}, p0, "                      \
+                 "[%[d], %[i], lsl #" #SHIFT "]\n\t"                    \
+                 "inc" #SUFF " %[i]\n\t"                                \
+                 "b 1b\n"                                               \
+                 "2:"                                                   \
+                 : [i] "+r"(i)                                          \
+                 : [s] "r"(s), [d] "r"(d), [n] "r"(n)                   \
+                 : "z0", "p0", "memory", "cc");                         \
+}                                                                       \
+static uint64_t sve_sum_##SUFF(const void *a, size_t n)                 \
+{                                                                       \
+    size_t i = 0;                                                       \
+    uint64_t sum = 0, part;                                             \
+                                                                        \
+    asm volatile("1: whilelo p0." ESZ ", %[i], %[n]\n\t"                \
+                 "b.none 2f\n\t"                                        \
+                 "ld1" #SUFF " {z0." ESZ "}, p0/z, "                    \
+                 "[%[a], %[i], lsl #" #SHIFT "]\n\t"                    \
+                 "uaddv d1, p0, z0." ESZ "\n\t"                         \
+                 "fmov %[part], d1\n\t"                                 \
+                 "add %[sum], %[sum], %[part]\n\t"                      \
+                 "inc" #SUFF " %[i]\n\t"                                \
+                 "b 1b\n"                                               \
+                 "2:"                                                   \
+                 : [i] "+r"(i), [sum] "+r"(sum), [part] "=&r"(part)     \
+                 : [a] "r"(a), [n] "r"(n)                               \
+                 : "z0", "z1", "p0", "memory", "cc");                   \
+    return sum;                                                         \
+}
+
+SVE_ELEM(h, "h", 1)
+SVE_ELEM(w, "s", 2)
+SVE_ELEM(d, "d", 3)
+
+static size_t sve_strlen(const char *s)
+{
+    size_t i = 0;
+
+    asm volatile("ptrue p0.b\n"
+                 "1: setffr\n\t"
+                 "ldff1b {z0.b}, p0/z, [%[s], %[i]]\n\t"
+                 "rdffrs p1.b, p0/z\n\t"
+                 "b.nlast 2f\n\t"
+                 "cmpeq p2.b, p0/z, z0.b, #0\n\t"
+                 "b.any 3f\n\t"
+                 "incb %[i]\n\t"
+                 "b 1b\n"
+                 "2: cmpeq p2.b, p1/z, z0.b, #0\n\t"
+                 "b.any 3f\n\t"
+                 "incp %[i], p1.b\n\t"
+                 "b 1b\n"
+                 "3: brkb p2.b, p0/z, p2.b\n\t"
+                 "incp %[i], p2.b"
+                 : [i] "+r"(i)
+                 : [s] "r"(s)
+                 : "z0", "p0", "p1", "p2", "memory", "cc");
+    return i;
+}
+
+static uint64_t sve_gather_sum(const uint64_t *a, const uint64_t *ix,
+                               size_t n)
+{
+    size_t i = 0;
+    uint64_t sum;
+
+    asm volatile("mov z1.d, #0\n\t"
+                 "ptrue p1.d\n"
+                 "1: whilelo p0.d, %[i], %[n]\n\t"
+                 "b.none 2f\n\t"
+                 "ld1d {z0.d}, p0/z, [%[ix], %[i], lsl #3]\n\t"
+                 "ld1d {z0.d}, p0/z, [%[a], z0.d, lsl #3]\n\t"
+                 "add z1.d, p0/m, z1.d, z0.d\n\t"
+                 "incd %[i]\n\t"
+                 "b 1b\n"
+                 "2: uaddv d1, p1, z1.d\n\t"
+                 "fmov %[sum], d1"
+                 : [i] "+r"(i), [sum] "=r"(sum)
+                 : [a] "r"(a), [ix] "r"(ix), [n] "r"(n)
+                 : "z0", "z1", "p0", "p1", "memory", "cc");
+    return sum;
+}
+
+static double elapsed(struct timespec *t0)
+{
+    struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) * 1e-9;
+}
+
+#define TEST_ELEM(SUFF, T)                                              \
+    do {                                                                \
+        size_t n = N / sizeof(T);                                       \
+        uint64_t sum = 0;                                               \
+        T v;                                                            \
+                                                                        \
+        for (i = 0; i < n; i++) {                                       \
+            memcpy(&v, src + i * sizeof(T), sizeof(T));                 \
+            sum += v;                                                   \
+        }                                                               \
+        memset(dst, 0, sizeof(dst));                                    \
+        clock_gettime(CLOCK_MONOTONIC, &t0);                            \
+        for (r = 0; r < REPEAT; r++) {                                  \
+            sve_memcpy_##SUFF(dst, src, n);                             \
+            assert(sve_sum_##SUFF(src, n) == sum);                      \
+        }                                                               \
+        secs = elapsed(&t0);                                            \
+        assert(memcmp(dst, src, n * sizeof(T)) == 0);                   \
+        printf("vl %3d: ld1" #SUFF "/st1" #SUFF " %.1f MB/s\n",         \
+               vl, n * sizeof(T) * REPEAT / secs / 1e6);                \
+    } while (0)
+
+static void test(int vl)
+{
+    struct timespec t0;
+    uint64_t expect = 0;
+    double secs;
+    size_t i;
+    int r;
+
+    memset(dst, 0, sizeof(dst));
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < REPEAT; r++) {
+        sve_memcpy(dst, src, N);
+    }
+    secs = elapsed(&t0);
+    assert(memcmp(dst, src, N) == 0);
+    printf("vl %3d: memcpy %.1f MB/s\n", vl, N * REPEAT / secs / 1e6);
+
+    TEST_ELEM(h, uint16_t);
+    TEST_ELEM(w, uint32_t);
+    TEST_ELEM(d, uint64_t);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < REPEAT; r++) {
+        assert(sve_strlen((const char *)src) == N - 1);
+    }
+    secs = elapsed(&t0);
+    printf("vl %3d: strlen %.1f MB/s\n", vl, N * REPEAT / secs / 1e6);
+
+    for (i = 0; i < N / 8; i++) {
+        expect += table[idx[i]];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < REPEAT; r++) {
+        assert(sve_gather_sum(table, idx, N / 8) == expect);
+    }
+    secs = elapsed(&t0);
+    printf("vl %3d: gather %.1f Melem/s\n", vl, N / 8 * REPEAT / secs / 1e6);
+}
+
+int main(void)
+{
+    size_t i;
+    int vl;
+
+    for (i = 0; i < N - 1; i++) {
+        src[i] = i % 255 + 1;
+    }
+    src[N - 1] = 0;
+    /* Mostly nearby entries, so that gathers hit few pages at a time */
+    for (i = 0; i < N / 8; i++) {
+        table[i] = i * 3 + 1;
+        idx[i] = (i ^ (i >> 3 & 7)) % (N / 8);
+    }
+
+    for (vl = 16; vl <= 256; vl += 16) {
+        if (prctl(PR_SVE_SET_VL, vl, 0, 0, 0, 0) == vl) {
+            test(vl);
+        }
+    }
+    return 0;
+}
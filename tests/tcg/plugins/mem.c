@@ -28,6 +28,7 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
 typedef struct {
     uint64_t mem_count;
     uint64_t io_count;
+    uint64_t buffered_count;
 } CPUCount;
 
 typedef struct {
@@ -59,7 +60,11 @@ typedef struct {
 static struct qemu_plugin_scoreboard *counts;
 static qemu_plugin_u64 mem_count;
 static qemu_plugin_u64 io_count;
+static qemu_plugin_u64 buffered_count;
+static struct qemu_plugin_mem_buffer *buffer;
 static bool do_inline, do_callback, do_print_accesses, do_region_summary;
+static bool do_buffer;
+static size_t buffer_size = 1024;
 static bool do_haddr;
 static enum qemu_plugin_mem_rw rw = QEMU_PLUGIN_MEM_RW;
 
@@ -88,8 +93,19 @@ static void plugin_exit(qemu_plugin_id_t id, void *p)
         g_string_append_printf(out, "io accesses: %" PRIu64 "\n",
                                qemu_plugin_u64_sum(io_count));
     }
+    if (do_buffer) {
+        g_string_append_printf(out, "buffered accesses: %" PRIu64 "\n",
+                               qemu_plugin_u64_sum(buffered_count));
+    }
     qemu_plugin_outs(out->str);
 
+    /* every access counted must also have been delivered in a buffer */
+    if (do_buffer && (do_inline || do_callback)) {
+        g_assert(qemu_plugin_u64_sum(buffered_count) ==
+                 qemu_plugin_u64_sum(mem_count) +
+                 qemu_plugin_u64_sum(io_count));
+    }
+
 
     if (do_region_summary) {
         GList *counts = g_hash_table_get_values(regions);
@@ -115,6 +131,9 @@ static void plugin_exit(qemu_plugin_id_t id, void *p)
     }
 
     qemu_plugin_scoreboard_free(counts);
+    if (buffer) {
+        qemu_plugin_mem_buffer_free(buffer);
+    }
 }
 
 /*
@@ -253,6 +272,20 @@ static void vcpu_mem(unsigned int cpu_index, qemu_plugin_meminfo_t meminfo,
     }
 }
 
+static void vcpu_mem_records(unsigned int cpu_index,
+                             const struct qemu_plugin_mem_record *records,
+                             size_t n, void *udata)
+{
+    /* inline and helper appends must both leave room for each other */
+    g_assert(n <= buffer_size);
+    for (size_t i = 0; i < n; i++) {
+        g_assert(records[i].pc != 0);
+        g_assert(rw & (qemu_plugin_mem_is_store(records[i].info)
+                       ? QEMU_PLUGIN_MEM_W : QEMU_PLUGIN_MEM_R));
+    }
+    qemu_plugin_u64_add(buffered_count, cpu_index, n);
+}
+
 static void print_access(unsigned int cpu_index, qemu_plugin_meminfo_t meminfo,
                          uint64_t vaddr, void *udata)
 {
@@ -305,6 +338,9 @@ static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
                 QEMU_PLUGIN_INLINE_ADD_U64,
                 mem_count, 1);
         }
+        if (do_buffer) {
+            qemu_plugin_register_vcpu_mem_buffer(insn, rw, buffer);
+        }
         if (do_callback || do_region_summary) {
             qemu_plugin_register_vcpu_mem_cb(insn, vcpu_mem,
                                              QEMU_PLUGIN_CB_NO_REGS,
@@ -358,6 +394,17 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
                 fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
                 return -1;
             }
+        } else if (g_strcmp0(tokens[0], "buffer") == 0) {
+            if (!qemu_plugin_bool_parse(tokens[0], tokens[1], &do_buffer)) {
+                fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
+                return -1;
+            }
+        } else if (g_strcmp0(tokens[0], "buffer-size") == 0) {
+            buffer_size = g_ascii_strtoull(tokens[1], NULL, 10);
+            if (!buffer_size) {
+                fprintf(stderr, "invalid buffer size: %s\n", opt);
+                return -1;
+            }
         } else if (g_strcmp0(tokens[0], "print-accesses") == 0) {
             if (!qemu_plugin_bool_parse(tokens[0], tokens[1],
                                         &do_print_accesses)) {
@@ -399,6 +446,12 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
     mem_count = qemu_plugin_scoreboard_u64_in_struct(
         counts, CPUCount, mem_count);
     io_count = qemu_plugin_scoreboard_u64_in_struct(counts, CPUCount, io_count);
+    buffered_count = qemu_plugin_scoreboard_u64_in_struct(
+        counts, CPUCount, buffered_count);
+    if (do_buffer) {
+        buffer = qemu_plugin_mem_buffer_new(buffer_size, vcpu_mem_records,
+                                            NULL);
+    }
     qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
     qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
     return 0;
@@ -0,0 +1,127 @@
+/*
+ * Integer loop kernels, run with hot TBs retranslated as traces
+ *
+ * Each kernel is repeated until its blocks become hot and are
+ * retranslated across the jal instructions of calls and unconditional
+ * branches, and its result is checked every time.  Timing a run with
+ * and without -trace-threshold gives a rough idea of the speedup.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#define REPEAT 50
+
+static uint32_t lcg_state;
+
+static uint32_t __attribute__((noinline)) lcg(void)
+{
+    lcg_state = lcg_state * 1103515245 + 12345;
+    return lcg_state >> 8;
+}
+
+static unsigned __attribute__((noinline)) sieve(void)
+{
+    static uint8_t composite[8192];
+    unsigned i, j, count = 0;
+
+    memset(composite, 0, sizeof(composite));
+    for (i = 2; i < sizeof(composite); i++) {
+        if (composite[i]) {
+            continue;
+        }
+        count++;
+        for (j = i * 2; j < sizeof(composite); j += i) {
+            composite[j] = 1;
+        }
+    }
+    return count;
+}
+
+static uint32_t __attribute__((noinline)) crc32(const uint8_t *buf, size_t len)
+{
+    uint32_t crc = ~0u;
+    size_t i;
+    int k;
+
+    for (i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t __attribute__((noinline)) crc_kernel(void)
+{
+    static uint8_t buf[4096];
+    size_t i;
+
+    lcg_state = 1;
+    for (i = 0; i < sizeof(buf); i++) {
+        buf[i] = lcg();
+    }
+    return crc32(buf, sizeof(buf));
+}
+
+static int64_t __attribute__((noinline)) matmul(void)
+{
+    static int32_t a[16][16], b[16][16], c[16][16];
+    int64_t trace = 0;
+    int i, j, k;
+
+    lcg_state = 7;
+    for (i = 0; i < 16; i++) {
+        for (j = 0; j < 16; j++) {
+            a[i][j] = (int32_t)(lcg() & 0xff) - 128;
+            b[i][j] = (int32_t)(lcg() & 0xff) - 128;
+        }
+    }
+    for (i = 0; i < 16; i++) {
+        for (j = 0; j < 16; j++) {
+            int32_t sum = 0;
+
+            for (k = 0; k < 16; k++) {
+                sum += a[i][k] * b[k][j];
+            }
+            c[i][j] = sum;
+        }
+    }
+    for (i = 0; i < 16; i++) {
+        trace += c[i][i] * (i + 1);
+    }
+    return trace;
+}
+
+static uint64_t __attribute__((noinline)) collatz_step(uint64_t n)
+{
+    return n & 1 ? 3 * n + 1 : n / 2;
+}
+
+static uint64_t __attribute__((noinline)) collatz(void)
+{
+    uint64_t total = 0, i, n;
+
+    for (i = 1; i <= 5000; i++) {
+        for (n = i; n != 1; n = collatz_step(n)) {
+            total++;
+        }
+    }
+    return total;
+}
+
+int main(void)
+{
+    int i;
+
+    for (i = 0; i < REPEAT; i++) {
+        assert(sieve() == 1028);
+        assert(crc_kernel() == 0xbe8b6eb1);
+        assert(matmul() == -1015487);
+        assert(collatz() == 387968);
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Vector unit-stride loads, stores and integer adds
+ *
+ * Each kernel adds two arrays with vle/vadd/vse for one element width,
+ * either unmasked or under a mask, with an array length that leaves a
+ * last strip shorter than VLMAX.  The results are checked and the
+ * throughput of each kernel is printed, which gives a rough idea of how
+ * fast these instructions are emulated.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define N       4099
+#define REPEAT  200
+
+static uint8_t mask[(N + 7) / 8];
+
+#define GEN_VADD(ETYPE, SEW)                                            \
+static void vadd##SEW(ETYPE *d, const ETYPE *a, const ETYPE *b,         \
+                      size_t n)                                         \
+{                                                                       \
+    size_t vl;                                                          \
+                                                                        \
+    for (; n; n -= vl, a += vl, b += vl, d += vl) {                     \
+        asm volatile("vsetvli %0, %1, e" #SEW ", m4, ta, ma\n\t"        \
+                     "vle" #SEW ".v v8, (%2)\n\t"                       \
+                     "vle" #SEW ".v v12, (%3)\n\t"                      \
+                     "vadd.vv v8, v8, v12\n\t"                          \
+                     "vse" #SEW ".v v8, (%4)"                           \
+                     : "=&r"(vl)                                        \
+                     : "r"(n), "r"(a), "r"(b), "r"(d)                   \
+                     : "memory", "v8", "v9", "v10", "v11",              \
+                       "v12", "v13", "v14", "v15");                     \
+    }                                                                   \
+}                                                                       \
+                                                                        \
+static void vadd##SEW##_mask(ETYPE *d, const ETYPE *a, const ETYPE *b,  \
+                             size_t n)                                  \
+{                                                                       \
+    const uint8_t *m = mask;                                            \
+    size_t vl;                                                          \
+                                                                        \
+    for (; n; n -= vl, a += vl, b += vl, d += vl, m += vl / 8) {        \
+        asm volatile("vsetvli %0, %1, e" #SEW ", m4, ta, mu\n\t"        \
+                     "vlm.v v0, (%5)\n\t"                               \
+                     "vle" #SEW ".v v8, (%2), v0.t\n\t"                 \
+                     "vle" #SEW ".v v12, (%3), v0.t\n\t"                \
+                     "vadd.vv v8, v8, v12, v0.t\n\t"                    \
+                     "vse" #SEW ".v v8, (%4), v0.t"                     \
+                     : "=&r"(vl)                                        \
+                     : "r"(n), "r"(a), "r"(b), "r"(d), "r"(m)           \
+                     : "memory", "v0", "v8", "v9", "v10", "v11",        \
+                       "v12", "v13", "v14", "v15");                     \
+    }                                                                   \
+}                                                                       \
+                                                                        \
+static void test##SEW(void)                                             \
+{                                                                       \
+    static ETYPE a[N], b[N], d[N];                                      \
+    struct timespec t0, t1;                                             \
+    double secs;                                                        \
+    size_t i;                                                           \
+    int r;                                                              \
+                                                                        \
+    for (i = 0; i < N; i++) {                                           \
+        a[i] = i * 7 + 3;                                               \
+        b[i] = i * 13 + 5;                                              \
+    }                                                                   \
+                                                                        \
+    clock_gettime(CLOCK_MONOTONIC, &t0);                                \
+    for (r = 0; r < REPEAT; r++) {                                      \
+        vadd##SEW(d, a, b, N);                                          \
+    }                                                                   \
+    clock_gettime(CLOCK_MONOTONIC, &t1);                                \
+    for (i = 0; i < N; i++) {                                           \
+        assert(d[i] == (ETYPE)(a[i] + b[i]));                           \
+    }                                                                   \
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;  \
+    printf("vadd e" #SEW ": %.1f Melem/s\n", N * REPEAT / secs / 1e6);  \
+                                                                        \
+    memset(d, 0, sizeof(d));                                            \
+    clock_gettime(CLOCK_MONOTONIC, &t0);                                \
+    for (r = 0; r < REPEAT; r++) {                                      \
+        vadd##SEW##_mask(d, a, b, N);                                   \
+    }                                                                   \
+    clock_gettime(CLOCK_MONOTONIC, &t1);                                \
+    for (i = 0; i < N; i++) {                                           \
+        if (mask[i / 8] & (1 << (i % 8))) {                             \
+            assert(d[i] == (ETYPE)(a[i] + b[i]));                       \
+        } else {                                                        \
+            assert(d[i] == 0);                                          \
+        }                                                               \
+    }                                                                   \
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;  \
+    printf("vadd e" #SEW " masked: %.1f Melem/s\n",                     \
+           N * REPEAT / secs / 1e6);                                    \
+}
+
+GEN_VADD(uint8_t, 8)
+GEN_VADD(uint16_t, 16)
+GEN_VADD(uint32_t, 32)
+GEN_VADD(uint64_t, 64)
+
+int main(void)
+{
+    size_t i;
+
+    /* VLMAX is a multiple of 8 at LMUL=4, so each strip starts on a byte */
+    for (i = 0; i < N; i++) {
+        if (i % 3) {
+            mask[i / 8] |= 1 << (i % 8);
+        }
+    }
+
+    test8();
+    test16();
+    test32();
+    test64();
+    return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * Unit tests for the software GRO/GSO of net backends
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/bswap.h"
+#include "qemu/iov.h"
+#include "net/checksum.h"
+#include "net/eth.h"
+#include "net/offload.h"
+#include "standard-headers/linux/virtio_net.h"
+
+#define MSS         1000
+#define L3_OFF      ETH_HLEN
+#define L4_OFF      (L3_OFF + sizeof(struct ip_header))
+#define HDR_LEN     (L4_OFF + sizeof(struct tcp_header))
+
+/* Packets that net_gro_receive() and net_gro_flush() sent to the peer */
+static GPtrArray *delivered;
+
+ssize_t qemu_sendv_packet_async(NetClientState *nc, const struct iovec *iov,
+                                int iovcnt, NetPacketSent *sent_cb)
+{
+    size_t size = iov_size(iov, iovcnt);
+    GByteArray *pkt = g_byte_array_sized_new(size);
+
+    g_byte_array_set_size(pkt, size);
+    iov_to_buf(iov, iovcnt, 0, pkt->data, size);
+    g_ptr_array_add(delivered, pkt);
+    return size;
+}
+
+ssize_t qemu_send_packet_async(NetClientState *nc, const uint8_t *buf,
+                               int size, NetPacketSent *sent_cb)
+{
+    struct iovec iov = { .iov_base = (void *)buf, .iov_len = size };
+
+    return qemu_sendv_packet_async(nc, &iov, 1, sent_cb);
+}
+
+/* Frames that net_gso_send() put on the wire */
+static bool gso_output(void *opaque, const uint8_t *buf, size_t size)
+{
+    GPtrArray *frames = opaque;
+
+    g_ptr_array_add(frames, g_byte_array_append(g_byte_array_new(),
+                                                buf, size));
+    return true;
+}
+
+static void offload_setup(NetOffload *o)
+{
+    delivered = g_ptr_array_new_with_free_func(
+        (GDestroyNotify)g_byte_array_unref);
+    net_offload_init(o, NULL, NULL);
+    net_offload_set_vnet_hdr_len(o, sizeof(struct virtio_net_hdr));
+    net_offload_set_offload(o, 1, 1, 0);
+}
+
+static void offload_teardown(NetOffload *o)
+{
+    net_offload_cleanup(o);
+    g_ptr_array_unref(delivered);
+    delivered = NULL;
+}
+
+/*
+ * Build an IPv4 TCP frame with @opt_len bytes of options filled with
+ * @opt_fill and a payload that continues the byte stream at @seq.
+ */
+static size_t build_tcp4(uint8_t *buf, uint16_t ip_id, uint32_t seq,
+                         uint32_t ack, uint8_t flags, size_t opt_len,
+                         uint8_t opt_fill, size_t payload)
+{
+    uint8_t *ip = buf + L3_OFF, *tcp = buf + L4_OFF;
+    size_t hdr_len = HDR_LEN + opt_len;
+    size_t l4_len = hdr_len - L4_OFF + payload;
+    size_t i;
+
+    memset(buf, 0, hdr_len);
+    memcpy(buf, "\x52\x54\x00\x12\x34\x56\x52\x54\x00\x65\x43\x21", 12);
+    stw_be_p(buf + 12, ETH_P_IP);
+
+    ip[0] = 0x45;
+    stw_be_p(ip + 2, hdr_len - L3_OFF + payload);
+    stw_be_p(ip + 4, ip_id);
+    stw_be_p(ip + 6, IP_DF);
+    ip[8] = 64;
+    ip[9] = IP_PROTO_TCP;
+    memcpy(ip + 12, "\x0a\x00\x00\x01\x0a\x00\x00\x02", 8);
+    stw_be_p(ip + 10, net_raw_checksum(ip, sizeof(struct ip_header)));
+
+    stw_be_p(tcp, 40000);
+    stw_be_p(tcp + 2, 80);
+    stl_be_p(tcp + 4, seq);
+    stl_be_p(tcp + 8, ack);
+    tcp[12] = (hdr_len - L4_OFF) << 2;
+    tcp[13] = flags;
+    stw_be_p(tcp + 14, 0xffff);
+    memset(tcp + sizeof(struct tcp_header), opt_fill, opt_len);
+    for (i = 0; i < payload; i++) {
+        buf[hdr_len + i] = seq + i;
+    }
+    stw_be_p(tcp + 16, net_checksum_tcpudp(l4_len, IP_PROTO_TCP, ip + 12,
+                                           tcp));
+
+    return hdr_len + payload;
+}
+
+static void check_ip4_csum(uint8_t *frame)
+{
+    g_assert_cmpuint(net_raw_checksum(frame + L3_OFF,
+                                      sizeof(struct ip_header)), ==, 0);
+}
+
+static void check_tcp4_csum(uint8_t *frame, size_t size)
+{
+    g_assert_cmpuint(net_checksum_tcpudp(size - L4_OFF, IP_PROTO_TCP,
+                                         frame + L3_OFF + 12,
+                                         frame + L4_OFF), ==, 0);
+}
+
+static void check_payload(const uint8_t *frame, size_t hdr_len, size_t size,
+                          uint32_t seq)
+{
+    size_t i;
+
+    for (i = hdr_len; i < size; i++) {
+        g_assert_cmpuint(frame[i], ==, (uint8_t)(seq + i - hdr_len));
+    }
+}
+
+static void test_gro_merge(void)
+{
+    NetOffload o;
+    uint8_t frame[ETH_HLEN + 1500];
+    struct virtio_net_hdr *hdr;
+    GByteArray *pkt;
+    uint8_t *eth;
+    size_t size, len;
+    int i;
+
+    offload_setup(&o);
+
+    for (i = 0; i < 3; i++) {
+        size = build_tcp4(frame, 100 + i, 1000 + i * MSS, 5000, TH_ACK,
+                          0, 0, MSS);
+        g_assert_cmpint(net_gro_receive(&o, frame, size), ==, size);
+    }
+    g_assert_cmpuint(delivered->len, ==, 0);
+    net_gro_flush(&o);
+    g_assert_cmpuint(delivered->len, ==, 1);
+
+    pkt = g_ptr_array_index(delivered, 0);
+    hdr = (struct virtio_net_hdr *)pkt->data;
+    eth = pkt->data + sizeof(*hdr);
+    len = pkt->len - sizeof(*hdr);
+    g_assert_cmpuint(len, ==, HDR_LEN + 3 * MSS);
+    g_assert_cmpuint(hdr->flags, ==, VIRTIO_NET_HDR_F_NEEDS_CSUM);
+    g_assert_cmpuint(hdr->gso_type, ==, VIRTIO_NET_HDR_GSO_TCPV4);
+    g_assert_cmpuint(hdr->gso_size, ==, MSS);
+    g_assert_cmpuint(hdr->hdr_len, ==, HDR_LEN);
+    g_assert_cmpuint(hdr->csum_start, ==, L4_OFF);
+    g_assert_cmpuint(hdr->csum_offset, ==, 16);
+
+    g_assert_cmpuint(lduw_be_p(eth + L3_OFF + 2), ==, len - L3_OFF);
+    check_ip4_csum(eth);
+    g_assert_cmpuint(ldl_be_p(eth + L4_OFF + 4), ==, 1000);
+    check_payload(eth, HDR_LEN, len, 1000);
+
+    /* Complete the partial checksum the way the receiver would */
+    stw_be_p(eth + hdr->csum_start + hdr->csum_offset,
+             net_checksum_finish_nozero(
+                 net_checksum_add(len - hdr->csum_start,
+                                  eth + hdr->csum_start)));
+    check_tcp4_csum(eth, len);
+
+    offload_teardown(&o);
+}
+
+/* The second segment must not be merged into the first */
+static void check_gro_refused(size_t size1, const uint8_t *frame1,
+                              size_t size2, const uint8_t *frame2)
+{
+    NetOffload o;
+    struct virtio_net_hdr *hdr;
+    GByteArray *pkt;
+    int i;
+
+    offload_setup(&o);
+    net_gro_receive(&o, frame1, size1);
+    net_gro_receive(&o, frame2, size2);
+    net_gro_flush(&o);
+
+    g_assert_cmpuint(delivered->len, ==, 2);
+    for (i = 0; i < 2; i++) {
+        pkt = g_ptr_array_index(delivered, i);
+        hdr = (struct virtio_net_hdr *)pkt->data;
+        g_assert_cmpuint(hdr->gso_type, ==, VIRTIO_NET_HDR_GSO_NONE);
+        g_assert_cmpuint(hdr->flags, ==, VIRTIO_NET_HDR_F_DATA_VALID);
+        g_assert_cmpuint(pkt->len - sizeof(*hdr), ==, i ? size2 : size1);
+    }
+
+    offload_teardown(&o);
+}
+
+static void test_gro_refuse(void)
+{
+    uint8_t frame1[ETH_HLEN + 1500], frame2[ETH_HLEN + 1500];
+    size_t size1, size2;
+
+    /* Different ack */
+    size1 = build_tcp4(frame1, 1, 1000, 5000, TH_ACK, 0, 0, MSS);
+    size2 = build_tcp4(frame2, 2, 1000 + MSS, 6000, TH_ACK, 0, 0, MSS);
+    check_gro_refused(size1, frame1, size2, frame2);
+
+    /* Different options */
+    size1 = build_tcp4(frame1, 1, 1000, 5000, TH_ACK, 12, 1, MSS);
+    size2 = build_tcp4(frame2, 2, 1000 + MSS, 5000, TH_ACK, 12, 2, MSS);
+    check_gro_refused(size1, frame1, size2, frame2);
+
+    /* Out of sequence */
+    size1 = build_tcp4(frame1, 1, 1000, 5000, TH_ACK, 0, 0, MSS);
+    size2 = build_tcp4(frame2, 2, 1000 + 2 * MSS, 5000, TH_ACK, 0, 0, MSS);
+    check_gro_refused(size1, frame1, size2, frame2);
+}
+
+static void test_gso_split(void)
+{
+    static const size_t payloads[] = { MSS, MSS, 500 };
+    NetOffload o;
+    struct virtio_net_hdr hdr = {
+        .flags = VIRTIO_NET_HDR_F_NEEDS_CSUM,
+        .gso_type = VIRTIO_NET_HDR_GSO_TCPV4,
+        .hdr_len = HDR_LEN,
+        .gso_size = MSS,
+        .csum_start = L4_OFF,
+        .csum_offset = 16,
+    };
+    g_autofree uint8_t *frame = g_malloc(HDR_LEN + 2 * MSS + 500);
+    g_autoptr(GPtrArray) frames = g_ptr_array_new_with_free_func(
+        (GDestroyNotify)g_byte_array_unref);
+    struct iovec iov[2];
+    uint32_t seq = 1000;
+    size_t size, i;
+
+    offload_setup(&o);
+
+    size = build_tcp4(frame, 0x1234, seq, 5000, TH_ACK | TH_PUSH, 0, 0,
+                      2 * MSS + 500);
+    iov[0] = (struct iovec) { .iov_base = &hdr, .iov_len = sizeof(hdr) };
+    iov[1] = (struct iovec) { .iov_base = frame, .iov_len = size };
+    g_assert_cmpint(net_gso_send(&o, iov, 2, gso_output, frames), ==,
+                    sizeof(hdr) + size);
+
+    g_assert_cmpuint(frames->len, ==, ARRAY_SIZE(payloads));
+    for (i = 0; i < ARRAY_SIZE(payloads); i++) {
+        GByteArray *f = g_ptr_array_index(frames, i);
+        uint8_t *tcp = f->data + L4_OFF;
+
+        g_assert_cmpuint(f->len, ==, HDR_LEN + payloads[i]);
+        g_assert_cmpuint(lduw_be_p(f->data + L3_OFF + 2), ==,
+                         f->len - L3_OFF);
+        g_assert_cmpuint(lduw_be_p(f->data + L3_OFF + 4), ==, 0x1234 + i);
+        check_ip4_csum(f->data);
+
+        g_assert_cmpuint(ldl_be_p(tcp + 4), ==, seq);
+        g_assert_cmpuint(tcp[13], ==,
+                         i == ARRAY_SIZE(payloads) - 1 ? TH_ACK | TH_PUSH
+                                                       : TH_ACK);
+        check_tcp4_csum(f->data, f->len);
+        check_payload(f->data, HDR_LEN, f->len, seq);
+        seq += payloads[i];
+    }
+
+    offload_teardown(&o);
+}
+
+static void test_gso_bad_vnet_hdr(void)
+{
+    NetOffload o;
+    struct virtio_net_hdr hdr = {
+        .flags = VIRTIO_NET_HDR_F_NEEDS_CSUM,
+        .gso_type = VIRTIO_NET_HDR_GSO_TCPV4,
+        .hdr_len = HDR_LEN,
+        .gso_size = MSS,
+        .csum_start = L4_OFF,
+        .csum_offset = 16,
+    };
+    uint8_t frame[ETH_HLEN + 1500];
+    g_autoptr(GPtrArray) frames = g_ptr_array_new_with_free_func(
+        (GDestroyNotify)g_byte_array_unref);
+    struct iovec iov[2];
+    size_t size;
+
+    offload_setup(&o);
+    size = build_tcp4(frame, 1, 1000, 5000, TH_ACK, 0, 0, MSS);
+    iov[1] = (struct iovec) { .iov_base = frame, .iov_len = size };
+
+    /* Shorter than the vnet header */
+    iov[0] = (struct iovec) { .iov_base = &hdr, .iov_len = sizeof(hdr) - 2 };
+    g_assert_cmpint(net_gso_send(&o, iov, 1, gso_output, frames), ==,
+                    sizeof(hdr) - 2);
+
+    /* TCP header past the end of the frame */
+    iov[0].iov_len = sizeof(hdr);
+    hdr.csum_start = size;
+    g_assert_cmpint(net_gso_send(&o, iov, 2, gso_output, frames), ==,
+                    sizeof(hdr) + size);
+
+    /* TCP header starting inside the IP header */
+    hdr.csum_start = L3_OFF + 4;
+    g_assert_cmpint(net_gso_send(&o, iov, 2, gso_output, frames), ==,
+                    sizeof(hdr) + size);
+
+    /* No segment size */
+    hdr.csum_start = L4_OFF;
+    hdr.gso_size = 0;
+    g_assert_cmpint(net_gso_send(&o, iov, 2, gso_output, frames), ==,
+                    sizeof(hdr) + size);
+
+    /* UDP fragmentation is not negotiated */
+    hdr.gso_size = MSS;
+    hdr.gso_type = VIRTIO_NET_HDR_GSO_UDP;
+    g_assert_cmpint(net_gso_send(&o, iov, 2, gso_output, frames), ==,
+                    sizeof(hdr) + size);
+
+    /* All of them are dropped */
+    g_assert_cmpuint(frames->len, ==, 0);
+
+    offload_teardown(&o);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/net/offload/gro/merge", test_gro_merge);
+    g_test_add_func("/net/offload/gro/refuse", test_gro_refuse);
+    g_test_add_func("/net/offload/gso/split", test_gso_split);
+    g_test_add_func("/net/offload/gso/bad-vnet-hdr", test_gso_bad_vnet_hdr);
+    return g_test_run();
+}
@@ -35,6 +35,7 @@
 
 #define INDIRECTION_TABLE_SIZE 128
 #define HASH_CALCULATION_BUFFER_SIZE 36
+#define FLOW_TABLE_SIZE 16384
 
 struct rss_config_t {
     __u8 redirect;
@@ -49,6 +50,19 @@ struct toeplitz_key_data_t {
     __u8 next_byte[HASH_CALCULATION_BUFFER_SIZE];
 };
 
+/*
+ * A TCP or UDP flow as seen on receive.  IPv4 addresses use the first
+ * four bytes of src and dst, the rest is zero.
+ */
+struct flow_key_t {
+    __u8 src[16];
+    __u8 dst[16];
+    __be16 src_port;
+    __be16 dst_port;
+    __u8 protocol;
+    __u8 pad[3];
+} __attribute__((packed));
+
 struct packet_hash_info_t {
     __u8 is_ipv4;
     __u8 is_ipv6;
@@ -100,6 +114,17 @@ struct {
     __uint(map_flags, BPF_F_MMAPABLE);
 } tap_rss_map_indirection_table SEC(".maps");
 
+/*
+ * Flows pinned to the queue that the guest transmits them on, maintained
+ * by QEMU.  Takes precedence over the indirection table.
+ */
+struct {
+    __uint(type, BPF_MAP_TYPE_LRU_HASH);
+    __uint(key_size, sizeof(struct flow_key_t));
+    __uint(value_size, sizeof(__u16));
+    __uint(max_entries, FLOW_TABLE_SIZE);
+} tap_rss_map_flow_table SEC(".maps");
+
 static inline void net_rx_rss_add_chunk(__u8 *rss_input, size_t *bytes_written,
                                         const void *ptr, size_t size) {
     __builtin_memcpy(&rss_input[*bytes_written], ptr, size);
@@ -380,10 +405,30 @@ error:
     return err;
 }
 
+static inline void fill_flow_key(struct packet_hash_info_t *info,
+                                 struct flow_key_t *flow)
+{
+    if (!info->is_tcp && !info->is_udp) {
+        return;
+    }
+
+    if (info->is_ipv4) {
+        __builtin_memcpy(flow->src, &info->in_src, sizeof(info->in_src));
+        __builtin_memcpy(flow->dst, &info->in_dst, sizeof(info->in_dst));
+    } else {
+        __builtin_memcpy(flow->src, &info->in6_src, sizeof(info->in6_src));
+        __builtin_memcpy(flow->dst, &info->in6_dst, sizeof(info->in6_dst));
+    }
+    flow->src_port = info->src_port;
+    flow->dst_port = info->dst_port;
+    flow->protocol = info->is_tcp ? IPPROTO_TCP : IPPROTO_UDP;
+}
+
 static inline bool calculate_rss_hash(struct __sk_buff *skb,
                                       struct rss_config_t *config,
                                       struct toeplitz_key_data_t *toe,
-                                      __u32 *result)
+                                      __u32 *result,
+                                      struct flow_key_t *flow)
 {
     __u8 rss_input[HASH_CALCULATION_BUFFER_SIZE] = {};
     size_t bytes_written = 0;
@@ -395,6 +440,8 @@ static inline bool calculate_rss_hash(struct __sk_buff *skb,
         return false;
     }
 
+    fill_flow_key(&packet_info, flow);
+
     if (packet_info.is_ipv4) {
         if (packet_info.is_tcp &&
             config->hash_types & VIRTIO_NET_RSS_HASH_TYPE_TCPv4) {
@@ -551,15 +598,27 @@ int tun_rss_steering_prog(struct __sk_buff *skb)
         return 0;
     }
 
-    if (config->redirect && calculate_rss_hash(skb, config, toe, &hash)) {
-        __u32 table_idx = hash % config->indirections_len;
+    if (config->redirect) {
+        struct flow_key_t flow = {};
+        bool hashed = calculate_rss_hash(skb, config, toe, &hash, &flow);
         __u16 *queue = 0;
 
-        queue = bpf_map_lookup_elem(&tap_rss_map_indirection_table,
-                                    &table_idx);
+        if (flow.protocol) {
+            queue = bpf_map_lookup_elem(&tap_rss_map_flow_table, &flow);
+            if (queue) {
+                return *queue;
+            }
+        }
+
+        if (hashed) {
+            __u32 table_idx = hash % config->indirections_len;
 
-        if (queue) {
-            return *queue;
+            queue = bpf_map_lookup_elem(&tap_rss_map_indirection_table,
+                                        &table_idx);
+
+            if (queue) {
+                return *queue;
+            }
         }
     }
 